@@ -70,3 +70,11 @@ void serdec_arena_reset(SerdecArena* arena);
  * @return Total bytes allocated.
  */
 size_t serdec_arena_used(const SerdecArena* arena);
+
+/**
+ * @brief Return total bytes of the blocks the arena holds, used or not.
+ *
+ * @param arena Arena to query.
+ * @return Total block capacity, at least serdec_arena_used().
+ */
+size_t serdec_arena_reserved(const SerdecArena* arena);
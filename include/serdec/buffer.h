@@ -15,8 +15,13 @@ SerdecBuffer* serdec_buffer_from_string(const char* str, size_t len);
 /**
  * @brief Create a buffer by reading a file.
  *
+ * A regular file is memory-mapped read-only rather than copied, so opening a file of any
+ * size is immediate and its pages are read as they are accessed; the data is zero-padded
+ * like a copied buffer. The file must not be truncated or modified while the buffer is
+ * alive. Where mapping is unavailable the file is read into memory.
+ *
  * @param path     Path to the file.
- * @param max_size Maximum bytes to read. 0 for no limit.
+ * @param max_size Maximum bytes to read. 0 for no limit. Larger files fail.
  * @return New buffer with refcount 1, or NULL on failure.
  */
 SerdecBuffer* serdec_buffer_from_file(const char* path, size_t max_size);
@@ -33,6 +38,8 @@ SerdecBuffer* serdec_buffer_from_stream(FILE* fp, size_t max_size);
 /**
  * @brief Increment the buffer's reference count.
  *
+ * The count is atomic: threads may retain and release the same buffer concurrently.
+ *
  * @param buf Buffer to retain.
  * @return The same buffer.
  */
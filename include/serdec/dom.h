@@ -0,0 +1,732 @@
+#pragma once
+
+#include <serdec/types.h>
+#include <serdec/error.h>
+
+/**
+ * @brief JSON value types.
+ */
+typedef enum {
+    SERDEC_TYPE_NULL,
+    SERDEC_TYPE_BOOL,
+    SERDEC_TYPE_NUMBER,
+    SERDEC_TYPE_STRING,
+    SERDEC_TYPE_ARRAY,
+    SERDEC_TYPE_OBJECT,
+} SerdecValueType;
+
+/**
+ * @brief Create a key intern table.
+ *
+ * An intern table stores one copy of every distinct key, with its hash, and hands out
+ * a stable pointer per key. Documents parsed with the same table (see
+ * SerdecParseConfig.keys) share key storage, and serdec_get_interned() compares keys
+ * by address. A table can serve any number of parsers and documents, one call at a time;
+ * it is not safe to use from several threads at once.
+ *
+ * @param arena Arena for the key bytes. Must outlive the table and every document
+ *              parsed with it.
+ * @return New table, or NULL on failure.
+ */
+SerdecInternTable* serdec_intern_table_create(SerdecArena* arena);
+
+/**
+ * @brief Destroy an intern table. Interned keys stay valid until their arena is freed.
+ *
+ * @param table Table to destroy.
+ */
+void serdec_intern_table_destroy(SerdecInternTable* table);
+
+/**
+ * @brief Return the number of distinct keys in a table.
+ *
+ * @param table Table to query.
+ * @return Key count, or 0 if table is invalid.
+ */
+size_t serdec_intern_table_size(const SerdecInternTable* table);
+
+/**
+ * @brief Intern a key.
+ *
+ * @param table Table to intern into.
+ * @param key   Key bytes (decoded, no escapes).
+ * @param len   Length of key in bytes.
+ * @return Canonical NUL-terminated copy, the same pointer for equal keys, or NULL on
+ *         failure.
+ */
+const char* serdec_intern(SerdecInternTable* table, const char* key, size_t len);
+
+/**
+ * @brief What serdec_document_parse() does with a key repeated within one object.
+ */
+typedef enum {
+    SERDEC_DUPLICATES_ALLOW = 0,  /**< Keep every member; lookups find the first. */
+    SERDEC_DUPLICATES_FIRST_WINS, /**< Keep the first member, drop later ones. */
+    SERDEC_DUPLICATES_LAST_WINS,  /**< Keep the first member's position, last value. */
+    SERDEC_DUPLICATES_REJECT,     /**< Fail with SERDEC_ERR_DUPLICATE_KEY. */
+} SerdecDuplicateKeys;
+
+/**
+ * @brief Configuration for serdec_document_parse(). Zero-initialized fields use defaults.
+ */
+typedef struct {
+    size_t max_depth;         /**< Maximum container nesting. Default: 1024. */
+    bool exact_size;          /**< Two-pass build into one allocation. Default: false. */
+    SerdecInternTable* keys;  /**< Intern object keys here. Default: keys borrow the input. */
+    bool shapes;              /**< Share key lists between objects. Default: false. */
+    bool typed_arrays;        /**< Pack all-number arrays. Default: false. */
+    bool lazy;                /**< Expand containers on first access. Default: false. */
+    SerdecDuplicateKeys duplicates; /**< Duplicate key policy. Default: allow. */
+} SerdecParseConfig;
+
+/**
+ * @brief Parse a complete JSON document into an arena-backed value tree.
+ *
+ * Every value is a 16-byte node. The children of an array or object are stored as one
+ * contiguous run of nodes, so indexing is O(1) and iteration is a linear scan. Numbers
+ * are stored inline. Strings are borrowed slices into json, which must outlive the
+ * document; object keys containing escapes are decoded into the arena.
+ *
+ * With config->exact_size, a structural pre-pass first counts the nodes, the children
+ * of every container and the bytes of escaped keys. The tree is then written in place
+ * into a single allocation of exactly that size, at the cost of reading the input twice.
+ *
+ * With config->shapes, objects with the same keys in the same order share one shape:
+ * the key list plus, for 16 or more keys, a hash index built once. Each object then
+ * stores only its values, which halves the nodes of arrays of uniform records and
+ * turns key lookup into one search per shape.
+ *
+ * With config->typed_arrays, an array of 2 or more numbers is stored as a packed
+ * int64_t[] if every element is an integer that fits, or as a double[] if every integer
+ * in it is exact as a double; see serdec_as_int64_array() and serdec_as_double_array().
+ * Other arrays keep one node per element.
+ *
+ * With config->lazy, only the root container is parsed up front. Every container nested
+ * in it is kept as the offset of its opening bracket after a structural skip, and is
+ * parsed one level deep the first time it is accessed through serdec_value_size(),
+ * serdec_get(), serdec_index(), serdec_member() or the typed-array getters. Parts of
+ * the document that are never visited cost only that skip. The skip checks brackets but
+ * not syntax, so a syntax error inside a container is reported by the first accessor
+ * that expands it. Expansion writes to the document, so a lazy document must not be
+ * read from several threads at once until it is frozen; see serdec_document_freeze().
+ * A lazy document keeps a copy of json for expansion; release it with
+ * serdec_document_destroy().
+ *
+ * With a config->duplicates policy other than SERDEC_DUPLICATES_ALLOW, every key is
+ * checked against the earlier keys of its object as it is parsed: linearly in objects
+ * of fewer than 16 members, through a hash of the keys seen so far in wider ones, so
+ * the check costs O(1) amortized per key. Objects then hold distinct keys only. A
+ * rejected key is reported at its offset; in a lazy document, when its container is
+ * expanded.
+ *
+ * exact_size is ignored when shapes, typed_arrays, lazy or a duplicates policy is set.
+ *
+ * The document itself is allocated from arena and is released with it.
+ *
+ * @param arena  Arena that owns the document and its nodes.
+ * @param json   Input text.
+ * @param len    Length of input in bytes.
+ * @param config Optional configuration. NULL uses defaults.
+ * @param doc    Output document.
+ * @param err    Optional error detail.
+ * @return SERDEC_OK on success, or an error code.
+ */
+SerdecError serdec_document_parse(SerdecArena* arena, const char* json, size_t len,
+                                  const SerdecParseConfig* config, SerdecDocument** doc,
+                                  SerdecErrorInfo* err);
+
+/**
+ * @brief Release the resources a document holds outside its arena.
+ *
+ * Only lazy and mapped documents hold any; for other documents this is optional.
+ * Containers of a lazy document that were not expanded before this call can no longer be
+ * expanded, and their accessors return SERDEC_ERR_INVALID_HANDLE. The nodes themselves
+ * are released with the arena. A mapped document is unmapped, and its values with it.
+ *
+ * @param doc Document to destroy.
+ */
+void serdec_document_destroy(SerdecDocument* doc);
+
+/**
+ * @brief Freeze a document so that any number of threads can read it without locks.
+ *
+ * Reads normally defer some work to first use and write its result into the document:
+ * lazy containers are expanded, large objects get their hash index, and packed arrays
+ * get element nodes for serdec_index(). Freezing does all of that work up front, so
+ * that afterwards no query function writes to the document or its arena. The query
+ * functions (serdec_document_root(), serdec_value_type(), serdec_value_size(),
+ * serdec_get(), serdec_get_interned(), serdec_index(), serdec_member(), the typed-array
+ * getters, serdec_as_*(), serdec_value_equal(), serdec_value_hash() and
+ * serdec_pointer_get()) may then be called concurrently from any thread.
+ *
+ * Freezing walks the whole tree and costs about what an eager parse of the unexpanded
+ * parts would, plus the indexes and element nodes, which double the memory of packed
+ * arrays. The caller must make the frozen document visible to other threads with the
+ * usual synchronization, e.g. by starting them afterwards or through a mutex. Freezing
+ * twice is a no-op. The arena and any intern table the document uses must not be
+ * modified while other threads read it.
+ *
+ * @param doc Document to freeze.
+ * @return SERDEC_OK, SERDEC_ERR_OUT_OF_MEMORY, or a parse error from expanding a lazy
+ *         container. On failure the document stays unfrozen but usable.
+ */
+SerdecError serdec_document_freeze(SerdecDocument* doc);
+
+/**
+ * @brief Return the root value of a document.
+ *
+ * @param doc Document to query.
+ * @return Root value, or NULL if doc is invalid.
+ */
+const SerdecValue* serdec_document_root(const SerdecDocument* doc);
+
+/**
+ * @brief Memory footprint of a document, from serdec_document_stats().
+ */
+typedef struct {
+    size_t nodes[SERDEC_TYPE_OBJECT + 1]; /**< Values per SerdecValueType; keys excluded. */
+    size_t members;          /**< Object members, i.e. keys. */
+    size_t unexpanded;       /**< Lazy or mapped containers not expanded yet; their
+                                  contents are not counted. */
+    size_t shapes;           /**< Distinct object shapes in use. */
+    size_t packed_arrays;    /**< Arrays stored as packed numbers. */
+    size_t largest_object;   /**< Most members of one object. */
+    size_t largest_array;    /**< Most elements of one array. */
+    size_t max_depth;        /**< Deepest nesting; 0 for a scalar root. */
+    size_t borrowed_bytes;   /**< String and key bytes pointing into the input. */
+    size_t copied_bytes;     /**< String and key bytes stored elsewhere, e.g. decoded keys. */
+    size_t interned_keys;    /**< Members whose key bytes live in an intern table. */
+    size_t arena_used;       /**< serdec_arena_used() of the document's arena. */
+    size_t arena_reserved;   /**< serdec_arena_reserved() of the document's arena. */
+} SerdecDocumentStats;
+
+/**
+ * @brief Report what a document holds and how much memory it takes.
+ *
+ * Walks the tree as it is, without expanding lazy containers or building indexes. Keys
+ * of shaped objects are counted once per shape. The arena figures cover everything in
+ * the arena, including other documents and nodes replaced by edits.
+ *
+ * @param doc Document to measure.
+ * @param out Output statistics.
+ * @return SERDEC_OK, SERDEC_ERR_INVALID_HANDLE, or SERDEC_ERR_OUT_OF_MEMORY.
+ */
+SerdecError serdec_document_stats(const SerdecDocument* doc, SerdecDocumentStats* out);
+
+/**
+ * @brief Write a document to a file as an image for serdec_document_map().
+ *
+ * The image is the DOM itself with offsets in place of pointers: its nodes, shapes and
+ * packed arrays, the hash index of every object with 16 or more members, and a pool
+ * holding each distinct string once. Lazy containers are expanded first. Interned keys
+ * are stored as plain strings, strings with escapes keep them, and arrays built by edits
+ * lose their spare capacity.
+ *
+ * An image can only be mapped by a build with the same byte order, pointer size and
+ * image version; serdec_document_map() refuses any other.
+ *
+ * @param doc  Document to save.
+ * @param path File to create or overwrite.
+ * @return SERDEC_OK, SERDEC_ERR_FILE_NOT_FOUND if path cannot be opened for writing,
+ *         SERDEC_ERR_IO if writing fails, SERDEC_ERR_OUT_OF_MEMORY, or a parse error from
+ *         expanding a lazy container.
+ */
+SerdecError serdec_document_save(const SerdecDocument* doc, const char* path);
+
+/**
+ * @brief Open an image written by serdec_document_save(), without parsing.
+ *
+ * The file is memory-mapped privately and its nodes are used where they are. Opening
+ * reads the header and the shapes only. Each container turns the offsets of its children
+ * into pointers the first time it is accessed, once, much as a lazy document parses one
+ * level; only the pages of visited containers are read, and those are copied on that
+ * write. Accessors then read the mapping directly, and large objects use the stored
+ * index. As with a lazy document, freeze a mapped document before reading it from
+ * several threads at once; see serdec_document_freeze().
+ *
+ * Opening checks the header, the root and the shapes. Each container checks its block
+ * when it is first accessed: its children, the strings they refer to and any stored
+ * index must lie within the image. A damaged image makes opening fail or, inside a
+ * container, makes the accessors that expand it return SERDEC_ERR_IO; it never makes
+ * them read or write outside the mapping. The checks do not verify that the content is
+ * what was saved.
+ *
+ * Values of a mapped document live in the mapping, not in arena: they, and any values
+ * built from them by edits, are valid until serdec_document_destroy(), which must be
+ * called to unmap the file. Copy what must outlive it with serdec_value_clone() and
+ * SERDEC_CLONE_COPY_STRINGS.
+ *
+ * @param arena Arena for the document and for element nodes built on access.
+ * @param path  Image file.
+ * @param doc   Output document.
+ * @return SERDEC_OK, SERDEC_ERR_FILE_NOT_FOUND, SERDEC_ERR_IO if the file cannot be
+ *         mapped or is not an image this build can map, or SERDEC_ERR_OUT_OF_MEMORY.
+ */
+SerdecError serdec_document_map(SerdecArena* arena, const char* path, SerdecDocument** doc);
+
+/**
+ * @brief Parse a complete JSON document with default options and return its root.
+ *
+ * Shorthand for serdec_document_parse() followed by serdec_document_root().
+ *
+ * @param arena Arena that owns the nodes.
+ * @param json  Input text.
+ * @param len   Length of input in bytes.
+ * @param root  Output root value.
+ * @param err   Optional error detail.
+ * @return SERDEC_OK on success, or an error code.
+ */
+SerdecError serdec_parse(SerdecArena* arena, const char* json, size_t len,
+                         const SerdecValue** root, SerdecErrorInfo* err);
+
+/**
+ * @brief Return the type of a value.
+ *
+ * @param value Value to query.
+ * @return Value type. SERDEC_TYPE_NULL for a NULL pointer.
+ */
+SerdecValueType serdec_value_type(const SerdecValue* value);
+
+/**
+ * @brief Return the number of elements of an array or members of an object.
+ *
+ * @param value Value to query.
+ * @return Child count, or 0 for scalars and for lazy containers that fail to expand.
+ */
+size_t serdec_value_size(const SerdecValue* value);
+
+/**
+ * @brief Look up an object member by key.
+ *
+ * Keys are compared by their decoded bytes. With duplicate keys, the first one wins.
+ *
+ * Small objects are scanned linearly. The first lookup in an object with 16 or more
+ * members builds an open-addressing hash index in the document's arena, so later
+ * lookups are O(1) on average; member order is unchanged. Because of that first write,
+ * lookups in the same large object must not race with each other unless the document
+ * has been frozen with serdec_document_freeze().
+ *
+ * @param object Object to search.
+ * @param key    NUL-terminated key.
+ * @param out    Output member value.
+ * @return SERDEC_OK, SERDEC_ERR_TYPE_MISMATCH if object is not an object,
+ *         SERDEC_ERR_NOT_FOUND, or a parse error from expanding a lazy object.
+ */
+SerdecError serdec_get(const SerdecValue* object, const char* key, const SerdecValue** out);
+
+/**
+ * @brief Look up an object member by an interned key.
+ *
+ * Same as serdec_get(), but skips hashing and, for documents parsed with the same
+ * table, compares keys by address instead of by bytes. Keys of other documents, parsed
+ * with another table or none, are compared by bytes.
+ *
+ * @param object Object to search.
+ * @param key    Key returned by serdec_intern().
+ * @param out    Output member value.
+ * @return SERDEC_OK, SERDEC_ERR_TYPE_MISMATCH if object is not an object, or
+ *         SERDEC_ERR_NOT_FOUND.
+ */
+SerdecError serdec_get_interned(const SerdecValue* object, const char* key,
+                                const SerdecValue** out);
+
+/**
+ * @brief Return an array element by index, in O(1).
+ *
+ * Indexing a packed numeric array builds element nodes for it in the document's arena
+ * the first time; use serdec_as_int64_array() or serdec_as_double_array() to avoid that.
+ *
+ * @param array Array to index.
+ * @param index Element index.
+ * @param out   Output element.
+ * @return SERDEC_OK, SERDEC_ERR_TYPE_MISMATCH if array is not an array,
+ *         SERDEC_ERR_NOT_FOUND if index is out of range, SERDEC_ERR_OUT_OF_MEMORY, or a
+ *         parse error from expanding a lazy array.
+ */
+SerdecError serdec_index(const SerdecValue* array, size_t index, const SerdecValue** out);
+
+/**
+ * @brief Return the packed elements of an int64_t array.
+ *
+ * Only arrays packed by a parse with SerdecParseConfig.typed_arrays qualify. The data
+ * lives in the document's arena and is never copied.
+ *
+ * @param array Array to read.
+ * @param data  Output pointer to the elements.
+ * @param count Output element count.
+ * @return SERDEC_OK, or SERDEC_ERR_TYPE_MISMATCH if array is not a packed int64_t array.
+ */
+SerdecError serdec_as_int64_array(const SerdecValue* array, const int64_t** data,
+                                  size_t* count);
+
+/**
+ * @brief Return the packed elements of a double array.
+ *
+ * @param array Array to read.
+ * @param data  Output pointer to the elements.
+ * @param count Output element count.
+ * @return SERDEC_OK, or SERDEC_ERR_TYPE_MISMATCH if array is not a packed double array.
+ * @see serdec_as_int64_array()
+ */
+SerdecError serdec_as_double_array(const SerdecValue* array, const double** data,
+                                   size_t* count);
+
+/**
+ * @brief Return an object member by position, in document order.
+ *
+ * @param object Object to query.
+ * @param index  Member index.
+ * @param key    Optional output key. Never has escapes.
+ * @param out    Output member value.
+ * @return SERDEC_OK, SERDEC_ERR_TYPE_MISMATCH, or SERDEC_ERR_NOT_FOUND.
+ */
+SerdecError serdec_member(const SerdecValue* object, size_t index, SerdecString* key,
+                          const SerdecValue** out);
+
+/**
+ * @brief Return a copy of an object with one member set.
+ *
+ * Edits never change their input: they return a new container node that shares every
+ * unchanged child subtree with the original, and allocate only the new node and its
+ * run of children from arena. The original document stays valid and unchanged, so a
+ * nested edit rebuilds just the containers on the path to it, e.g. set a member in a
+ * child object, then set that child in its parent. Values can come from any document
+ * or from serdec_parse() of a JSON snippet; the new container borrows them and their
+ * arenas must outlive it.
+ *
+ * If key is present, its first occurrence gets the new value; otherwise the member is
+ * appended. The key is looked up through the object's hash index, if it has one. The
+ * result has the same members in the same order. Objects returned by an edit keep spare
+ * capacity: like serdec_array_insert(), appending a member to the latest version of such
+ * an object fills that space in place, and the versions share one hash index, which the
+ * append extends. Adding members one at a time thus costs amortized O(1) each. Edits
+ * of the same object must not race with each other or with lookups in its versions.
+ *
+ * @param arena  Arena for the new nodes.
+ * @param object Object to edit.
+ * @param key    NUL-terminated key. Copied into arena if it is new.
+ * @param value  New member value.
+ * @param out    Output object.
+ * @return SERDEC_OK, SERDEC_ERR_TYPE_MISMATCH, SERDEC_ERR_OUT_OF_MEMORY, or a parse error
+ *         from expanding a lazy object.
+ */
+SerdecError serdec_object_set(SerdecArena* arena, const SerdecValue* object, const char* key,
+                              const SerdecValue* value, const SerdecValue** out);
+
+/**
+ * @brief Return a copy of an object without any member named key.
+ *
+ * @param arena  Arena for the new nodes.
+ * @param object Object to edit.
+ * @param key    NUL-terminated key.
+ * @param out    Output object.
+ * @return SERDEC_OK, SERDEC_ERR_TYPE_MISMATCH, SERDEC_ERR_NOT_FOUND, or
+ *         SERDEC_ERR_OUT_OF_MEMORY.
+ * @see serdec_object_set()
+ */
+SerdecError serdec_object_remove(SerdecArena* arena, const SerdecValue* object, const char* key,
+                                 const SerdecValue** out);
+
+/**
+ * @brief Return a copy of an array with a value inserted before index.
+ *
+ * An index equal to the array size appends. Arrays returned by an edit keep spare
+ * capacity: appending to the latest version of such an array writes into that space
+ * instead of copying the elements, so building an array by repeated appends costs
+ * amortized O(1) per element. Earlier versions keep their size and contents. Because
+ * such an append writes to memory shared between versions, edits of the same array must
+ * not race with each other.
+ *
+ * @param arena Arena for the new nodes.
+ * @param array Array to edit.
+ * @param index Position of the new element, at most the array size.
+ * @param value New element.
+ * @param out   Output array.
+ * @return SERDEC_OK, SERDEC_ERR_TYPE_MISMATCH, SERDEC_ERR_NOT_FOUND if index is past the
+ *         end, or SERDEC_ERR_OUT_OF_MEMORY.
+ * @see serdec_object_set()
+ */
+SerdecError serdec_array_insert(SerdecArena* arena, const SerdecValue* array, size_t index,
+                                const SerdecValue* value, const SerdecValue** out);
+
+/**
+ * @brief Return a copy of an array with the element at index replaced.
+ *
+ * @param arena Arena for the new nodes.
+ * @param array Array to edit.
+ * @param index Element to replace.
+ * @param value New element.
+ * @param out   Output array.
+ * @return SERDEC_OK, SERDEC_ERR_TYPE_MISMATCH, SERDEC_ERR_NOT_FOUND, or
+ *         SERDEC_ERR_OUT_OF_MEMORY.
+ * @see serdec_object_set()
+ */
+SerdecError serdec_array_replace(SerdecArena* arena, const SerdecValue* array, size_t index,
+                                 const SerdecValue* value, const SerdecValue** out);
+
+/**
+ * @brief Return a copy of an array without the element at index.
+ *
+ * @param arena Arena for the new nodes.
+ * @param array Array to edit.
+ * @param index Element to remove.
+ * @param out   Output array.
+ * @return SERDEC_OK, SERDEC_ERR_TYPE_MISMATCH, SERDEC_ERR_NOT_FOUND, or
+ *         SERDEC_ERR_OUT_OF_MEMORY.
+ * @see serdec_object_set()
+ */
+SerdecError serdec_array_remove(SerdecArena* arena, const SerdecValue* array, size_t index,
+                                const SerdecValue** out);
+
+/**
+ * @brief Options for serdec_value_clone().
+ */
+typedef enum {
+    SERDEC_CLONE_BORROW_STRINGS = 0,      /**< Strings keep pointing at their source. */
+    SERDEC_CLONE_COPY_STRINGS   = 1 << 0, /**< Copy string bytes into the clone. */
+} SerdecCloneFlags;
+
+/**
+ * @brief Deep-copy a value into another arena.
+ *
+ * A first pass sizes the whole clone, expanding lazy containers on the way, and the
+ * clone is then written into one allocation: nodes, packed arrays, shapes and copied
+ * hash indexes first, followed by the string bytes. Each run of children is copied with
+ * one memcpy and only its strings and containers are fixed up afterwards. The layout is
+ * kept: shaped objects still share their (copied) shapes, packed arrays stay packed and
+ * object indexes built in the source are not rebuilt. Arrays and objects made by edits
+ * lose their spare capacity, and such objects build a new index on their first lookup.
+ *
+ * With SERDEC_CLONE_BORROW_STRINGS, string values and keys keep pointing into the
+ * source input and, for keys with escapes, the source arena, so both must outlive the
+ * clone. With SERDEC_CLONE_COPY_STRINGS, every string is copied into the clone, which
+ * then only depends on arena. Interned keys are never copied; their intern table must
+ * outlive the clone either way.
+ *
+ * @param arena Destination arena.
+ * @param value Value to copy.
+ * @param flags SerdecCloneFlags.
+ * @param out   Output copy.
+ * @return SERDEC_OK, SERDEC_ERR_OUT_OF_MEMORY, or a parse error from expanding a lazy
+ *         container.
+ */
+SerdecError serdec_value_clone(SerdecArena* arena, const SerdecValue* value, unsigned flags,
+                               const SerdecValue** out);
+
+/**
+ * @brief Compare two values by content.
+ *
+ * Numbers compare by value, so 1, 1.0 and 1e0 are equal. Strings compare after decoding
+ * escapes. Objects compare as unordered sets of members; a duplicate key after the first
+ * one is ignored, matching what serdec_get() returns. Arrays compare in order, whatever
+ * their representation. Containers that share their children are equal without being
+ * walked.
+ *
+ * Lazy containers are expanded. If that fails, the values are unequal. Nesting is walked
+ * with a heap stack rather than recursion; values nested too deeply to allocate it are
+ * unequal too.
+ *
+ * Members are looked up as by serdec_get(), so comparing objects of 16 or more members
+ * may build their hash indexes. Like expansion, that writes to the document's arena:
+ * values of a document that is not frozen must not be compared or hashed from several
+ * threads at once; see serdec_document_freeze().
+ *
+ * @param a First value, or NULL.
+ * @param b Second value, or NULL.
+ * @return true if the values are equal. Two NULLs are equal; NULL and a value are not.
+ */
+bool serdec_value_equal(const SerdecValue* a, const SerdecValue* b);
+
+/**
+ * @brief Hash a value by content.
+ *
+ * Consistent with serdec_value_equal(): equal values have equal hashes. Object members
+ * are combined independently of their order. The hash is stable within a build, not
+ * across versions of the library.
+ *
+ * Lazy containers are expanded. If that fails, or the stack for walking deeper runs out of
+ * memory, the container hashes as empty.
+ * Hashing expands containers and builds indexes as serdec_value_equal() does, with
+ * the same need to freeze a document shared between threads.
+ *
+ * @param value Value to hash, or NULL (hashes as a JSON null).
+ * @return 64-bit hash.
+ */
+uint64_t serdec_value_hash(const SerdecValue* value);
+
+/**
+ * @brief When serdec_iter_next() reports containers relative to their children. At least
+ *        one flag must be set.
+ */
+typedef enum {
+    SERDEC_ITER_POSTORDER = 1 << 0, /**< Containers after their children. */
+    SERDEC_ITER_PREORDER  = 1 << 1, /**< Containers before their children. */
+    SERDEC_ITER_BOTH      = SERDEC_ITER_PREORDER | SERDEC_ITER_POSTORDER,
+                                    /**< Containers before and after their children. */
+} SerdecIterOrder;
+
+/**
+ * @brief One step of a traversal.
+ */
+typedef struct {
+    const SerdecValue* value;    /**< Node visited, or NULL once the traversal is done. */
+    SerdecString       key;      /**< Member key if the parent is an object, else ptr NULL. */
+    size_t             index;    /**< Position in the parent; 0 for the root. */
+    size_t             depth;    /**< 0 for the root. */
+    bool               leave;    /**< A container whose children were already visited. */
+    /**
+     * Child storage of a container, for prefetching: the child values are children[0],
+     * children[stride], ... NULL for scalars, empty containers and packed numeric arrays
+     * (see serdec_as_int64_array()).
+     */
+    const SerdecValue* children;
+    size_t             stride;
+} SerdecVisit;
+
+/**
+ * @brief Create a depth-first iterator over a value and everything below it.
+ *
+ * The traversal keeps its own stack instead of recursing, so documents of any depth
+ * are walked in constant C stack. The iterator and its stack are allocated from arena
+ * and released with it; there is nothing to destroy. Lazy containers are expanded as
+ * they are entered.
+ *
+ * @param arena Arena for the iterator.
+ * @param root  Value to traverse.
+ * @param order SerdecIterOrder flags.
+ * @return New iterator, or NULL if order has no flag or an unknown one, or on failure.
+ */
+SerdecIterator* serdec_iter_create(SerdecArena* arena, const SerdecValue* root,
+                                   unsigned order);
+
+/**
+ * @brief Advance to the next node, in document order.
+ *
+ * Elements of packed numeric arrays are reported through a node owned by the iterator,
+ * which is overwritten by the next call.
+ *
+ * @param it  Iterator.
+ * @param out Output step. out->value is NULL once every node was visited.
+ * @return SERDEC_OK, SERDEC_ERR_OUT_OF_MEMORY, or a parse error from expanding a lazy
+ *         container. The traversal cannot continue after an error.
+ */
+SerdecError serdec_iter_next(SerdecIterator* it, SerdecVisit* out);
+
+/**
+ * @brief Skip the children of the container the last step entered.
+ *
+ * Has no effect unless the last step was the preorder visit of a container. With
+ * SERDEC_ITER_BOTH the container is still reported again after the skipped children.
+ *
+ * @param it Iterator.
+ */
+void serdec_iter_skip(SerdecIterator* it);
+
+/**
+ * @brief Callback for serdec_value_walk(). Return SERDEC_OK to continue.
+ *
+ * @param user  Opaque pointer passed to serdec_value_walk().
+ * @param visit The current step.
+ */
+typedef SerdecError (*SerdecVisitCallback)(void* user, const SerdecVisit* visit);
+
+/**
+ * @brief Call cb for every node below and including root, as serdec_iter_next() would
+ *        report them.
+ *
+ * @param arena Arena for the traversal stack.
+ * @param root  Value to traverse.
+ * @param order SerdecIterOrder flags.
+ * @param cb    Callback invoked once per step.
+ * @param user  Opaque pointer passed to cb.
+ * @return SERDEC_OK, SERDEC_ERR_INVALID_HANDLE if order is not a valid SerdecIterOrder,
+ *         an error from serdec_iter_next(), or the callback's return value.
+ */
+SerdecError serdec_value_walk(SerdecArena* arena, const SerdecValue* root, unsigned order,
+                              SerdecVisitCallback cb, void* user);
+
+/**
+ * @brief Read a string value.
+ *
+ * @param value Value to read.
+ * @param out   Output slice. If out->has_escapes, decode it with
+ *              serdec_json_string_materialize().
+ * @return SERDEC_OK or SERDEC_ERR_TYPE_MISMATCH.
+ */
+SerdecError serdec_as_string(const SerdecValue* value, SerdecString* out);
+
+/**
+ * @brief Read a boolean value.
+ *
+ * @param value Value to read.
+ * @param out   Output boolean.
+ * @return SERDEC_OK or SERDEC_ERR_TYPE_MISMATCH.
+ */
+SerdecError serdec_as_bool(const SerdecValue* value, bool* out);
+
+/**
+ * @brief Read an integer that fits int64_t.
+ *
+ * @param value Value to read.
+ * @param out   Output integer.
+ * @return SERDEC_OK, SERDEC_ERR_TYPE_MISMATCH for non-integers, or
+ *         SERDEC_ERR_NUMBER_OVERFLOW if the integer does not fit.
+ */
+SerdecError serdec_as_int64(const SerdecValue* value, int64_t* out);
+
+/**
+ * @brief Read a non-negative integer that fits uint64_t.
+ *
+ * @param value Value to read.
+ * @param out   Output integer.
+ * @return SERDEC_OK, SERDEC_ERR_TYPE_MISMATCH for non-integers, or
+ *         SERDEC_ERR_NUMBER_OVERFLOW for negative integers.
+ */
+SerdecError serdec_as_uint64(const SerdecValue* value, uint64_t* out);
+
+/**
+ * @brief Read any number as a double. Integers beyond 2^53 lose precision.
+ *
+ * @param value Value to read.
+ * @param out   Output double.
+ * @return SERDEC_OK or SERDEC_ERR_TYPE_MISMATCH.
+ */
+SerdecError serdec_as_double(const SerdecValue* value, double* out);
+
+/**
+ * @brief Callback for serdec_json_select(). Return SERDEC_OK to continue.
+ *
+ * @param user  Opaque pointer passed to serdec_json_select().
+ * @param path  Index of the matching path in the paths array.
+ * @param value The matched subtree. Its nodes are allocated from the select arena; its
+ *              strings borrow the parser's input, as with serdec_document_parse().
+ */
+typedef SerdecError (*SerdecSelectCallback)(void* user, size_t path, const SerdecValue* value);
+
+/**
+ * @brief Stream a document and build values only for subtrees matching a path.
+ *
+ * Paths use a small JSONPath subset: `$` for the root, then any number of `.key`,
+ * `[index]`, `.*` or `[*]` steps, e.g. `$.users[*].name`. Containers that no path can
+ * reach are skipped with serdec_json_skip() instead of being parsed into events.
+ * When paths nest, the outer match is reported first and inner paths are then
+ * resolved inside the built subtree.
+ *
+ * Matched values are built as serdec_document_parse() builds them: string values and
+ * keys without escapes are borrowed slices of the parser's input, and string values
+ * with escapes are kept raw and decoded on access. The input must outlive every matched
+ * value. Object keys containing escapes are decoded into arena, both inside matches and
+ * on the way to them, so they accumulate there across matches until the caller resets it.
+ *
+ * @param parser Parser positioned before the root value.
+ * @param arena  Arena for matched subtrees and decoded keys. Never reset by this function.
+ * @param paths  Paths to match.
+ * @param count  Number of paths.
+ * @param cb     Callback invoked once per match, in document order.
+ * @param user   Opaque pointer passed to cb.
+ * @return SERDEC_OK, SERDEC_ERR_INVALID_PATH, a parse error (see
+ *         serdec_json_parser_error()), or the callback's return value.
+ */
+SerdecError serdec_json_select(SerdecParser* parser, SerdecArena* arena,
+                               const char* const* paths, size_t count,
+                               SerdecSelectCallback cb, void* user);
@@ -13,6 +13,7 @@ typedef enum SerdecError {
     SERDEC_ERR_UNEXPECTED_EOF,         /**< Input ended before value was complete. */
     SERDEC_ERR_INVALID_VALUE,          /**< Value did not match any JSON type. */
     SERDEC_ERR_TRAILING_CHARS,         /**< Non-whitespace characters after root value. */
+    SERDEC_ERR_DUPLICATE_KEY,          /**< Object key repeated; see SerdecDuplicateKeys. */
 
     // String errors (200-299)
     SERDEC_ERR_INVALID_ESCAPE = 200,   /**< Unknown or malformed escape sequence. */
@@ -34,6 +35,11 @@ typedef enum SerdecError {
 
     // Internal errors (600)
     SERDEC_ERR_INVALID_HANDLE = 600,   /**< Corrupted or invalid struct passed. */
+
+    // Query errors (700-799)
+    SERDEC_ERR_TYPE_MISMATCH = 700,    /**< Value is not of the requested type. */
+    SERDEC_ERR_NOT_FOUND,              /**< Key or index does not exist. */
+    SERDEC_ERR_INVALID_PATH,           /**< Query path could not be parsed. */
 } SerdecError;
 
 /**
@@ -49,6 +55,11 @@ typedef struct SerdecErrorInfo {
     char        context[128]; /**< Snippet of input around the error. */
 } SerdecErrorInfo;
 
+/**
+ * @brief An ordered collection of errors, e.g. bad records skipped in recovery mode.
+ */
+typedef struct SerdecErrorList SerdecErrorList;
+
 /**
  * @brief Return a short string description of an error code.
  *
@@ -65,3 +76,41 @@ const char* serdec_error_string(SerdecError code);
  * @param bufsize Size of output buffer in bytes.
  */
 void serdec_error_format(const SerdecErrorInfo* info, char* buf, size_t bufsize);
+
+/**
+ * @brief Create an empty error list.
+ *
+ * @return New list, or NULL on allocation failure.
+ */
+SerdecErrorList* serdec_error_list_create(void);
+
+/**
+ * @brief Destroy an error list.
+ *
+ * @param list List to destroy.
+ */
+void serdec_error_list_destroy(SerdecErrorList* list);
+
+/**
+ * @brief Return the number of errors in the list.
+ *
+ * @param list List to query.
+ * @return Error count, or 0 for an invalid list.
+ */
+size_t serdec_error_list_count(const SerdecErrorList* list);
+
+/**
+ * @brief Return an error by index. Errors are ordered by input offset.
+ *
+ * @param list  List to query.
+ * @param index Error index.
+ * @return Pointer to the error, valid until the list is modified, or NULL if out of range.
+ */
+const SerdecErrorInfo* serdec_error_list_get(const SerdecErrorList* list, size_t index);
+
+/**
+ * @brief Remove all errors, keeping the allocation.
+ *
+ * @param list List to clear.
+ */
+void serdec_error_list_clear(SerdecErrorList* list);
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <serdec/types.h>
+#include <serdec/error.h>
+
+/**
+ * @brief Structural index configuration.
+ */
+typedef struct {
+    size_t depth;   /**< Container levels whose children are indexed: 1 indexes the
+                         elements or members of the root, 2 also those of its children,
+                         and so on. Default: 1. */
+} SerdecJsonIndexConfig;
+
+/**
+ * @brief Index where each element of a JSON text starts, down to a configured depth.
+ *
+ * One quote-aware structural scan records, for every container up to config->depth
+ * levels deep, where it opens and closes and where each of its elements or members
+ * starts. The scan checks that brackets balance, not syntax; a parse started from the
+ * index reports any error in what it reads. The index takes 8 bytes per indexed child
+ * and 32 per indexed container, and does not keep a reference to buf.
+ *
+ * @param buf    Input, typically from serdec_buffer_from_file().
+ * @param config Configuration, or NULL for defaults.
+ * @param out    Output index. Destroy with serdec_json_index_destroy().
+ * @return SERDEC_OK, SERDEC_ERR_UNEXPECTED_EOF for an unclosed string or container,
+ *         SERDEC_ERR_UNEXPECTED_CHAR for an unmatched closing bracket, or
+ *         SERDEC_ERR_OUT_OF_MEMORY.
+ */
+SerdecError serdec_json_index_build(const SerdecBuffer* buf, const SerdecJsonIndexConfig* config,
+                                    SerdecJsonIndex** out);
+
+/**
+ * @brief Write an index to a file, typically next to the input it describes.
+ *
+ * The file records the input's size and a hash of its first and last 4 KB, which
+ * serdec_json_index_load() checks. Index files are not portable across byte orders.
+ *
+ * @param index Index to save.
+ * @param path  File to create or overwrite.
+ * @return SERDEC_OK, SERDEC_ERR_FILE_NOT_FOUND if path cannot be opened for writing, or
+ *         SERDEC_ERR_IO if writing fails.
+ */
+SerdecError serdec_json_index_save(const SerdecJsonIndex* index, const char* path);
+
+/**
+ * @brief Read an index written by serdec_json_index_save() for the input in buf.
+ *
+ * @param path Index file.
+ * @param buf  The input the index was built from.
+ * @param out  Output index. Destroy with serdec_json_index_destroy().
+ * @return SERDEC_OK, SERDEC_ERR_FILE_NOT_FOUND, SERDEC_ERR_IO if the file is not an
+ *         index, is damaged, or was built from a different input, or
+ *         SERDEC_ERR_OUT_OF_MEMORY.
+ */
+SerdecError serdec_json_index_load(const char* path, const SerdecBuffer* buf,
+                                   SerdecJsonIndex** out);
+
+/**
+ * @brief Destroy an index.
+ *
+ * @param index Index to destroy.
+ */
+void serdec_json_index_destroy(SerdecJsonIndex* index);
+
+/**
+ * @brief Return the number of elements or members of the container at a path.
+ *
+ * A path is a list of child positions from the root: {7000000} is element 7,000,000 of
+ * the root array, {2, 0} the first member of the root's third child. Each step costs a
+ * binary search over the indexed containers.
+ *
+ * @param index Index to query.
+ * @param path  Child positions, or NULL if depth is 0.
+ * @param depth Steps in path; less than the indexed depth.
+ * @param count Output child count.
+ * @return SERDEC_OK, SERDEC_ERR_NOT_FOUND if a position is out of range,
+ *         SERDEC_ERR_TYPE_MISMATCH if the path runs through or ends at a scalar, or
+ *         SERDEC_ERR_INVALID_PATH if it is deeper than the index.
+ */
+SerdecError serdec_json_index_count(const SerdecJsonIndex* index, const size_t* path,
+                                    size_t depth, size_t* count);
+
+/**
+ * @brief Return the byte offset at which the value at a path starts.
+ *
+ * For a member of an object, this is the offset of its key.
+ *
+ * @param index  Index to query.
+ * @param path   Child positions, or NULL if depth is 0.
+ * @param depth  Steps in path; at most the indexed depth.
+ * @param offset Output byte offset.
+ * @return As serdec_json_index_count().
+ */
+SerdecError serdec_json_index_offset(const SerdecJsonIndex* index, const size_t* path,
+                                     size_t depth, size_t* offset);
+
+/**
+ * @brief Restart a parser at the value at a path, without reading what precedes it.
+ *
+ * The parser, created over the indexed input with serdec_json_parser_from_buffer(),
+ * then produces the value at path and every later sibling of it, followed by
+ * SERDEC_EVENT_END where its container closes. For a member of an object, each
+ * member starts with its SERDEC_EVENT_KEY. An empty path restarts the parser on the
+ * whole document. Event offsets are offsets in the input; lines in error details count
+ * from the start of the value, and so do columns more than 64 KB into a line.
+ *
+ * @param index  Index of the parser's input.
+ * @param parser Parser to reposition.
+ * @param path   Child positions, or NULL if depth is 0.
+ * @param depth  Steps in path; at most the indexed depth.
+ * @return As serdec_json_index_count(), or SERDEC_ERR_INVALID_HANDLE if the parser's input
+ *         is not the size of the indexed one.
+ */
+SerdecError serdec_json_index_seek(const SerdecJsonIndex* index, SerdecParser* parser,
+                                   const size_t* path, size_t depth);
@@ -6,15 +6,27 @@
 /**
  * @brief Create a JSON event iterator parser.
  *
+ * The input is copied into a padded buffer owned by the parser.
+ *
  * @param input Pointer to input buffer.
  * @param len   Length of input in bytes.
  * @return New parser, or NULL on allocation failure.
  *
- * @note The input buffer must outlive all SerdecString values produced
- *       from this parser.
+ * @note SerdecString values produced from this parser point into the parser's
+ *       copy and are valid until the parser is destroyed.
  */
 SerdecParser* serdec_json_parser_create(const char* input, size_t len);
 
+/**
+ * @brief Create a JSON event iterator parser over an existing buffer (zero-copy).
+ *
+ * @param buf Input buffer. The parser retains a reference.
+ * @return New parser, or NULL on allocation failure or invalid buffer.
+ *
+ * @note SerdecString values point into buf and are valid while buf is alive.
+ */
+SerdecParser* serdec_json_parser_from_buffer(SerdecBuffer* buf);
+
 /**
  * @brief Destroy a parser and free its resources.
  *
@@ -32,6 +44,46 @@ void serdec_json_parser_destroy(SerdecParser* parser);
  */
 SerdecError serdec_json_event_next(SerdecParser* parser, SerdecEvent* ev);
 
+/**
+ * @brief Skip the rest of the container opened by the last event.
+ *
+ * Call right after SERDEC_EVENT_START_OBJECT or SERDEC_EVENT_START_ARRAY. The next
+ * event is the one following the matching close bracket; the END_OBJECT/END_ARRAY
+ * event itself is not produced. The skipped bytes are found with a structural scan:
+ * strings and bracket nesting are checked, other content is not validated. After any
+ * other event this is a no-op.
+ *
+ * @param parser Parser instance.
+ * @return SERDEC_OK, or SERDEC_ERR_UNEXPECTED_EOF / SERDEC_ERR_UNEXPECTED_CHAR if the
+ *         container is not closed or closed by the wrong bracket.
+ */
+SerdecError serdec_json_skip(SerdecParser* parser);
+
+/**
+ * @brief Decode a string slice produced by the parser.
+ *
+ * @param arena   Arena for the decoded bytes. Only used if s.has_escapes is true.
+ * @param s       Slice to decode.
+ * @param out     Output bytes: s.ptr itself when there are no escapes.
+ * @param out_len Output length.
+ * @return SERDEC_OK, SERDEC_ERR_INVALID_ESCAPE, or SERDEC_ERR_OUT_OF_MEMORY.
+ */
+SerdecError serdec_json_string_materialize(SerdecArena* arena, SerdecString s,
+                                           const char** out, size_t* out_len);
+
+/**
+ * @brief Accept a stream of concatenated root values instead of a single one.
+ *
+ * Values may be separated by whitespace or directly adjacent where the grammar allows
+ * it (e.g. `{"a":1}{"a":2}`, `[1]"x"`). Events for each value follow one another and
+ * SERDEC_EVENT_END follows the last one. Set before the first call to
+ * serdec_json_event_next().
+ *
+ * @param parser   Parser instance.
+ * @param sequence true to accept zero or more root values, false for exactly one.
+ */
+void serdec_json_parser_set_sequence(SerdecParser* parser, bool sequence);
+
 /**
  * @brief Retrieve the last error detail from the parser.
  *
@@ -0,0 +1,242 @@
+#pragma once
+
+#include <serdec/types.h>
+#include <serdec/error.h>
+
+/**
+ * @brief A single NDJSON record parsed by a worker thread.
+ *
+ * Event strings are borrowed slices into the input buffer.
+ */
+typedef struct {
+    size_t             offset;  /**< Byte offset of the record in the input. */
+    size_t             line;    /**< Line number of the record (1-indexed). */
+    const SerdecEvent* events;  /**< Parsed events, excluding SERDEC_EVENT_END. */
+    size_t             count;   /**< Number of events. */
+    SerdecArena*       arena;   /**< Worker-local scratch arena, reset between chunks. */
+    unsigned           worker;  /**< Index of the worker that parsed the record. */
+} SerdecNdjsonRecord;
+
+/**
+ * @brief Per-record callback. Return SERDEC_OK to continue, anything else to stop.
+ *
+ * In unordered mode the callback runs concurrently on all worker threads.
+ * In ordered mode calls are serialized and follow input order.
+ */
+typedef SerdecError (*SerdecNdjsonCallback)(void* user, const SerdecNdjsonRecord* record);
+
+/**
+ * @brief How records are delimited in the input stream.
+ */
+typedef enum {
+    SERDEC_FRAMING_NDJSON,    /**< One value per line. */
+    SERDEC_FRAMING_JSON_SEQ,  /**< RFC 7464 text sequence: each value follows an RS (0x1E). */
+    SERDEC_FRAMING_CONCAT,    /**< Back-to-back values, optionally whitespace-separated. */
+} SerdecFraming;
+
+/**
+ * @brief Parallel NDJSON driver configuration.
+ */
+typedef struct {
+    unsigned      threads;     /**< Worker threads. Default: online CPUs. */
+    size_t        chunk_size;  /**< Target bytes per work unit. Default: 1MB. */
+    bool          ordered;     /**< Deliver records in input order. Default: false. */
+    SerdecFraming framing;     /**< Record framing. Default: SERDEC_FRAMING_NDJSON. */
+
+    SerdecErrorList* errors;      /**< Recovery mode: collect bad records here and continue. */
+    size_t           max_errors;  /**< Recovery mode: give up after adding this many to errors
+                                       in one call. Default: no limit. */
+
+    const SerdecNdjsonIndex* index;  /**< Line index of the input: chunks are cut at indexed
+                                          records instead of scanning for newlines. */
+    size_t                   first;  /**< With index: first record to parse. Default: 0. */
+    size_t                   count;  /**< With index: records to parse. Default: all from first. */
+
+    const SerdecNdjsonFilter* filter;  /**< Deliver only records that pass this filter. */
+} SerdecNdjsonConfig;
+
+/**
+ * @brief Parse newline-delimited JSON across a pool of worker threads.
+ *
+ * The input is split on record boundaries into chunks. Each worker owns a parser
+ * and an arena and parses whole chunks; blank records are skipped. The first parse or
+ * callback error stops all workers.
+ *
+ * Framing decides the boundaries. NDJSON splits on newlines and JSON_SEQ on RS bytes;
+ * neither can occur unescaped inside a JSON text. A JSON_SEQ record whose top-level
+ * number is not followed by whitespace may have been truncated and is rejected, as
+ * RFC 7464 requires. CONCAT chunk boundaries come from a quote-aware structural scan
+ * of each chunk; the parser then reads the values in a chunk as one sequence.
+ * All framings parse in place without copying records out of the buffer.
+ *
+ * With config->index, only records [first, first + count) are parsed, and chunks are
+ * cut at record boundaries taken from the index, so the input is not scanned before the
+ * workers start. Framing must then be NDJSON.
+ *
+ * In recovery mode (config->errors set), a record that fails to parse is skipped and
+ * its error, with a context snippet, is appended to the list; parsing resumes at the
+ * next record. With CONCAT framing, the next record starts after the bad value's
+ * closing bracket or at the next whitespace at the root level. Errors added by one
+ * call are sorted by offset. Callback errors, running out of memory, and exceeding
+ * max_errors still stop the parse. With several threads, which max_errors errors were
+ * collected before stopping depends on scheduling.
+ *
+ * With config->filter, records are tested as serdec_ndjson_filter_test() describes before
+ * they are parsed into events, and only those that pass reach the callback. A rejected
+ * record is read only as far as needed to reject it, so a syntax error after that point
+ * goes unreported. Framing must then be NDJSON or JSON_SEQ.
+ *
+ * @param buf    Input buffer. Must not be released until the call returns.
+ * @param config Configuration, or NULL for defaults.
+ * @param cb     Callback invoked once per record.
+ * @param user   Opaque pointer passed to cb.
+ * @param err    Optional error detail. In unordered mode, the earliest of the errors
+ *               observed before the workers stopped.
+ * @return SERDEC_OK, the first parse error, or the callback's return value. In recovery
+ *         mode, SERDEC_OK when every bad record was collected. SERDEC_ERR_NOT_FOUND if
+ *         the indexed range runs past the last record; SERDEC_ERR_INVALID_HANDLE if the
+ *         index was built from another input or framing is not NDJSON, or if a filter
+ *         is set with CONCAT framing.
+ */
+SerdecError serdec_ndjson_parallel(SerdecBuffer* buf, const SerdecNdjsonConfig* config,
+                                   SerdecNdjsonCallback cb, void* user, SerdecErrorInfo* err);
+
+/**
+ * @brief Compile a record filter: predicates on fields that every record must satisfy.
+ *
+ * The filter is one or more terms joined by "&&". A term is "@" for the record, followed by
+ * ".name" or "['name']" steps down to a member, and optionally a comparison with a string,
+ * number, true, false or null literal, as in `@.status == 500 && @.req['path'] != "/"`.
+ * Without a comparison, the term requires the member to exist. Comparisons follow
+ * serdec_query_compile() filters: values of other types are unequal, "!=" holds for a
+ * missing member, and only numbers and strings are ordered.
+ *
+ * Before a record is lexed, its bytes are searched for text every passing record
+ * contains: the quoted last key of each term other than "!=" terms, which a record
+ * missing the member passes, and the literal of each "==" term with a string, true, false
+ * or null literal. A record without it is rejected unless it has a backslash, since an
+ * escape could spell the same key or string differently.
+ *
+ * @param text Filter text.
+ * @param out  Output filter. Destroy with serdec_ndjson_filter_destroy().
+ * @return SERDEC_OK, SERDEC_ERR_INVALID_PATH if text is malformed or has more than 64
+ *         terms, or SERDEC_ERR_OUT_OF_MEMORY.
+ */
+SerdecError serdec_ndjson_filter_compile(const char* text, SerdecNdjsonFilter** out);
+
+/**
+ * @brief Destroy a record filter.
+ *
+ * @param filter Filter to destroy.
+ */
+void serdec_ndjson_filter_destroy(SerdecNdjsonFilter* filter);
+
+/**
+ * @brief Test the parser's next value against a filter.
+ *
+ * Only members on the path of some term are read into events; other members are passed
+ * over with serdec_json_skip(). Reading stops as soon as a term fails or every term has
+ * held, and terms whose member was not found are then tested as missing. The raw-byte
+ * search of serdec_ndjson_filter_compile() is not applied. Afterwards, the parser may be
+ * anywhere inside the value.
+ *
+ * @param filter Compiled filter.
+ * @param parser Parser positioned before the value.
+ * @param pass   Output: whether the value passes.
+ * @return SERDEC_OK, SERDEC_ERR_NOT_FOUND if the parser has no value left, or a parse
+ *         error (see serdec_json_parser_error()).
+ */
+SerdecError serdec_ndjson_filter_test(const SerdecNdjsonFilter* filter, SerdecParser* parser,
+                                      bool* pass);
+
+/**
+ * @brief Where one record of an indexed NDJSON input lies.
+ */
+typedef struct {
+    size_t offset;  /**< Byte offset of the start of the record's line. */
+    size_t length;  /**< Bytes up to the next record: the line, its newline, and any blank
+                         lines that follow. */
+    size_t line;    /**< Line number of the record (1-indexed). */
+} SerdecNdjsonSpan;
+
+/**
+ * @brief Index where each record of an NDJSON input starts.
+ *
+ * Blank lines are not records, so record i is the i-th line that holds anything but
+ * whitespace. Offsets are stored in blocks of 128 as a base plus fixed-width deltas,
+ * about 2 bytes per record for lines of a few hundred bytes, and record i is found
+ * without decoding its neighbours. Lines are found with memchr. Records are not
+ * parsed, and the index does not keep a reference to buf.
+ *
+ * @param buf Input.
+ * @param out Output index. Destroy with serdec_ndjson_index_destroy().
+ * @return SERDEC_OK or SERDEC_ERR_OUT_OF_MEMORY.
+ */
+SerdecError serdec_ndjson_index_build(const SerdecBuffer* buf, SerdecNdjsonIndex** out);
+
+/**
+ * @brief Write a line index to a file.
+ *
+ * As with serdec_json_index_save(), the file records the input's size and a hash of
+ * its first and last 4 KB, and is not portable across byte orders.
+ *
+ * @param index Index to save.
+ * @param path  File to create or overwrite.
+ * @return SERDEC_OK, SERDEC_ERR_FILE_NOT_FOUND, or SERDEC_ERR_IO.
+ */
+SerdecError serdec_ndjson_index_save(const SerdecNdjsonIndex* index, const char* path);
+
+/**
+ * @brief Read a line index written by serdec_ndjson_index_save() for the input in buf.
+ *
+ * @param path File to read.
+ * @param buf  The input the index was built from.
+ * @param out  Output index. Destroy with serdec_ndjson_index_destroy().
+ * @return SERDEC_OK, SERDEC_ERR_FILE_NOT_FOUND, SERDEC_ERR_IO if the file is not a line
+ *         index, is damaged, or was built from a different input, or
+ *         SERDEC_ERR_OUT_OF_MEMORY.
+ */
+SerdecError serdec_ndjson_index_load(const char* path, const SerdecBuffer* buf,
+                                     SerdecNdjsonIndex** out);
+
+/**
+ * @brief Destroy a line index.
+ *
+ * @param index Index to destroy.
+ */
+void serdec_ndjson_index_destroy(SerdecNdjsonIndex* index);
+
+/**
+ * @brief Return the number of records in a line index.
+ *
+ * @param index Index to query.
+ * @return Record count, or 0 for an invalid handle.
+ */
+size_t serdec_ndjson_index_count(const SerdecNdjsonIndex* index);
+
+/**
+ * @brief Locate record i.
+ *
+ * @param index Index to query.
+ * @param i     Record number (0-indexed).
+ * @param out   Output span.
+ * @return SERDEC_OK, or SERDEC_ERR_NOT_FOUND if i is not below the record count.
+ */
+SerdecError serdec_ndjson_index_record(const SerdecNdjsonIndex* index, size_t i,
+                                       SerdecNdjsonSpan* out);
+
+/**
+ * @brief Restart a parser on record i alone.
+ *
+ * The parser, created over the indexed input with serdec_json_parser_from_buffer(),
+ * produces the record's events followed by SERDEC_EVENT_END. Offsets and line numbers
+ * are those of the input.
+ *
+ * @param index  Index of the parser's input.
+ * @param parser Parser to reposition.
+ * @param i      Record number (0-indexed).
+ * @return SERDEC_OK, SERDEC_ERR_NOT_FOUND, or SERDEC_ERR_INVALID_HANDLE if the parser's
+ *         input is not the size of the indexed one.
+ */
+SerdecError serdec_ndjson_index_seek(const SerdecNdjsonIndex* index, SerdecParser* parser,
+                                     size_t i);
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <serdec/types.h>
+#include <serdec/error.h>
+#include <serdec/arena.h>
+
+/**
+ * @brief The full event sequence of a document, stored as ordered segments.
+ *
+ * Segments live in per-worker arenas owned by the tape. Event strings are borrowed
+ * slices into the input buffer, which the tape retains.
+ */
+typedef struct SerdecEventTape SerdecEventTape;
+
+/**
+ * @brief Parallel single-document parse configuration.
+ */
+typedef struct {
+    unsigned          threads;    /**< Worker threads. Default: online CPUs. */
+    size_t            min_range;  /**< Minimum bytes per parallel range. Default: 1MB. */
+    SerdecArenaConfig arena;      /**< Per-worker event arena. Zero fields use arena defaults. */
+} SerdecParallelConfig;
+
+/**
+ * @brief Parse one JSON document into an event tape, in parallel when possible.
+ *
+ * A top-level array is split into element-aligned ranges found with a quote-aware
+ * structural scan, and the ranges are parsed concurrently. If any range fails to
+ * parse, the split is discarded and the document is parsed sequentially, so errors
+ * and results are identical to a sequential parse. Other roots are parsed sequentially.
+ *
+ * @param buf    Input buffer. The tape retains a reference.
+ * @param config Configuration, or NULL for defaults.
+ * @param out    Output tape. Destroy with serdec_event_tape_destroy().
+ * @param err    Optional error detail.
+ * @return SERDEC_OK on success, or an error code.
+ */
+SerdecError serdec_json_parse_parallel(SerdecBuffer* buf, const SerdecParallelConfig* config,
+                                       SerdecEventTape** out, SerdecErrorInfo* err);
+
+/**
+ * @brief Return the total number of events, excluding SERDEC_EVENT_END.
+ *
+ * @param tape Tape to query.
+ * @return Event count, or 0 for an invalid tape.
+ */
+size_t serdec_event_tape_count(const SerdecEventTape* tape);
+
+/**
+ * @brief Return the number of segments in the tape.
+ *
+ * @param tape Tape to query.
+ * @return Segment count, or 0 for an invalid tape.
+ */
+size_t serdec_event_tape_segments(const SerdecEventTape* tape);
+
+/**
+ * @brief Return one segment of the tape. Segments are in document order.
+ *
+ * @param tape  Tape to query.
+ * @param index Segment index.
+ * @param count Output: number of events in the segment.
+ * @return Pointer to the segment's events, or NULL if index is out of range.
+ */
+const SerdecEvent* serdec_event_tape_segment(const SerdecEventTape* tape, size_t index,
+                                             size_t* count);
+
+/**
+ * @brief Return whether the tape was produced by the parallel path.
+ *
+ * @param tape Tape to query.
+ * @return true if ranges were parsed concurrently, false after a sequential parse.
+ */
+bool serdec_event_tape_is_parallel(const SerdecEventTape* tape);
+
+/**
+ * @brief Destroy a tape, its arenas, and its reference to the input buffer.
+ *
+ * @param tape Tape to destroy.
+ */
+void serdec_event_tape_destroy(SerdecEventTape* tape);
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <serdec/types.h>
+#include <serdec/error.h>
+
+/**
+ * @brief Compile a JSON Pointer (RFC 6901) for repeated resolution.
+ *
+ * The pointer is split into reference tokens once: `~1` and `~0` are decoded to `/`
+ * and `~`, each token's key hash is computed, and tokens that are array indices are
+ * converted to numbers. A compiled pointer is read-only, so one pointer may be resolved
+ * against any number of documents, from several threads.
+ *
+ * Resolving against a DOM follows the rules of serdec_get(): the first lookup in an
+ * object of 16 or more members builds its hash index in the document's arena, and lazy
+ * and mapped containers are expanded. Only on a document frozen with
+ * serdec_document_freeze() does resolving allocate nothing and write nothing, so that
+ * several threads may resolve against it at once.
+ *
+ * @param text Pointer: "" for the whole document, else one or more "/token".
+ * @param out  Output pointer. Destroy with serdec_pointer_destroy().
+ * @return SERDEC_OK, SERDEC_ERR_INVALID_PATH if text is not a JSON Pointer, or
+ *         SERDEC_ERR_OUT_OF_MEMORY.
+ */
+SerdecError serdec_pointer_compile(const char* text, SerdecPointer** out);
+
+/**
+ * @brief Destroy a compiled pointer.
+ *
+ * @param pointer Pointer to destroy.
+ */
+void serdec_pointer_destroy(SerdecPointer* pointer);
+
+/**
+ * @brief Resolve a pointer against a DOM value.
+ *
+ * Object members are found through the same hash indexes as serdec_get(), with the hash
+ * computed at compile time, and with the same need to freeze a document shared between
+ * threads. A token refers to an array element only if it is "0" or a
+ * number without leading zeros; "-" never refers to an existing element.
+ *
+ * @param pointer Compiled pointer.
+ * @param root    Value the pointer is relative to.
+ * @param out     Output value.
+ * @return SERDEC_OK, SERDEC_ERR_NOT_FOUND if a member or element does not exist, or
+ *         SERDEC_ERR_TYPE_MISMATCH if a token is applied to a scalar.
+ */
+SerdecError serdec_pointer_get(const SerdecPointer* pointer, const SerdecValue* root,
+                               const SerdecValue** out);
+
+/**
+ * @brief Resolve a pointer against an event stream.
+ *
+ * Reads events up to the first event of the value the pointer refers to. Members and
+ * elements before it are passed over with serdec_json_skip(), so their contents are not
+ * parsed into events. Keys are compared without decoding them into memory. After
+ * SERDEC_OK, the parser continues with the rest of the value: for a container, its
+ * contents and closing event, which serdec_json_skip() passes over.
+ *
+ * @param pointer Compiled pointer.
+ * @param parser  Parser positioned before the value the pointer is relative to.
+ * @param out     Output: the first event of the value.
+ * @return SERDEC_OK, SERDEC_ERR_NOT_FOUND, SERDEC_ERR_TYPE_MISMATCH, or a parse error
+ *         (see serdec_json_parser_error()).
+ */
+SerdecError serdec_pointer_find(const SerdecPointer* pointer, SerdecParser* parser,
+                                SerdecEvent* out);
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <serdec/types.h>
+#include <serdec/error.h>
+
+/**
+ * @brief A value matched by a query: its JSON text, borrowed from the parser's input.
+ */
+typedef struct {
+    SerdecEventKind kind;   /**< First event of the value */
+    size_t offset;          /**< Byte offset of the value in the input */
+    const char* ptr;        /**< JSON text of the value, as in the input */
+    size_t len;             /**< Length of the text, quotes and brackets included */
+} SerdecQueryMatch;
+
+/**
+ * @brief Callback for serdec_query_run(). Return SERDEC_OK to continue.
+ *
+ * @param user  Opaque pointer passed to serdec_query_run().
+ * @param match The matched value. Valid during the call; match->ptr while the input is.
+ */
+typedef SerdecError (*SerdecQueryCallback)(void* user, const SerdecQueryMatch* match);
+
+/**
+ * @brief Compile a JSONPath query for streaming evaluation.
+ *
+ * Queries start with `$`, followed by any number of segments:
+ *
+ * - `.name`, `['name']` or `["name"]`: the member with that key
+ * - `.*` or `[*]`: every member or element
+ * - `[3]`, `[start:end]` or `[start:end:step]`: elements by position; start, end and
+ *   step are optional and must not be negative, as the length of an array is not known
+ *   while it streams
+ * - `[?(@.name op literal)]`: elements or members for which the comparison holds, where
+ *   op is one of `==`, `!=`, `<`, `<=`, `>`, `>=` and literal a number, a string in
+ *   single or double quotes, `true`, `false` or `null`. `@` alone compares the element
+ *   itself, and `[?(@.name)]` tests that a member exists. The parentheses are optional.
+ * - `..` before any of the above: apply it to all descendants, not only children, as in
+ *   `$..name` or `$..[0]`
+ *
+ * Comparisons follow RFC 9535: a missing member or a value of another type is unequal,
+ * and only numbers and strings are ordered. Queries have at most 63 segments.
+ *
+ * @param text Query text.
+ * @param out  Output query. Destroy with serdec_query_destroy().
+ * @return SERDEC_OK, SERDEC_ERR_INVALID_PATH, or SERDEC_ERR_OUT_OF_MEMORY.
+ */
+SerdecError serdec_query_compile(const char* text, SerdecQuery** out);
+
+/**
+ * @brief Destroy a compiled query.
+ *
+ * @param query Query to destroy.
+ */
+void serdec_query_destroy(SerdecQuery* query);
+
+/**
+ * @brief Run a query over every remaining root value of a parser, in one pass.
+ *
+ * The query runs as an automaton over serdec_json_event_next(): each open container
+ * holds the set of segments that led to it, so memory grows with nesting depth, not
+ * with input size, and no DOM is built. Containers no segment can reach are passed
+ * over with serdec_json_skip().
+ *
+ * A match is reported when its value ends, so a match nested in another is reported
+ * first. A filter on members is decided when the element it tests closes; if segments
+ * follow the filter, the element is then read a second time, from the input, to apply
+ * them.
+ *
+ * @param query  Compiled query. One query may run on several parsers at once.
+ * @param parser Parser positioned before a root value, or in sequence mode.
+ * @param cb     Callback invoked once per match.
+ * @param user   Opaque pointer passed to cb.
+ * @return SERDEC_OK, a parse error (see serdec_json_parser_error()), the callback's
+ *         return value, or SERDEC_ERR_OUT_OF_MEMORY.
+ */
+SerdecError serdec_query_run(const SerdecQuery* query, SerdecParser* parser,
+                             SerdecQueryCallback cb, void* user);
@@ -6,3 +6,9 @@
 #include <serdec/buffer.h>                                                    
 #include <serdec/arena.h>                             
 #include <serdec/json.h>
+#include <serdec/dom.h>
+#include <serdec/ndjson.h>
+#include <serdec/parallel.h>
+#include <serdec/index.h>
+#include <serdec/pointer.h>
+#include <serdec/query.h>
@@ -4,11 +4,18 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-typedef struct SerdecBuffer   SerdecBuffer;
-typedef struct SerdecArena    SerdecArena;
-typedef struct SerdecDocument SerdecDocument;
-typedef struct SerdecValue    SerdecValue;
-typedef struct SerdecParser   SerdecParser;
+typedef struct SerdecBuffer       SerdecBuffer;
+typedef struct SerdecArena        SerdecArena;
+typedef struct SerdecDocument     SerdecDocument;
+typedef struct SerdecValue        SerdecValue;
+typedef struct SerdecParser       SerdecParser;
+typedef struct SerdecInternTable  SerdecInternTable;
+typedef struct SerdecIterator     SerdecIterator;
+typedef struct SerdecJsonIndex    SerdecJsonIndex;
+typedef struct SerdecNdjsonIndex  SerdecNdjsonIndex;
+typedef struct SerdecPointer      SerdecPointer;
+typedef struct SerdecQuery        SerdecQuery;
+typedef struct SerdecNdjsonFilter SerdecNdjsonFilter;
 
 /**
  * @brief A string slice pointing into the input buffer (borrowed by default).
@@ -117,14 +117,25 @@ void* serdec_arena_alloc(SerdecArena* arena, size_t size) {
 }
 
 void* serdec_arena_alloc_aligned(SerdecArena* arena, size_t size, size_t align) {
-    if (!arena || !size || !align ||
+    if (!arena || !size || !align || (align & (align - 1)) ||
         arena->magic != SERDEC_MAGIC_ARENA) return NULL;
     
-    uintptr_t aligned_ptr = (uintptr_t) (arena->current->data + arena->current->used);
+    ArenaBlock* block = arena->current;
+    uintptr_t aligned_ptr = (uintptr_t) (block->data + block->used);
     size_t padding = (align - (aligned_ptr % align)) % align;
-    arena->current->used += padding;
-    
-    return serdec_arena_alloc(arena, size);
+    size_t available = block->size - block->used;
+
+    if (padding <= available && size <= available - padding) {
+        block->used += padding;
+        return serdec_arena_alloc(arena, size);
+    }
+
+    // Doesn't fit in the current block: over-allocate and align within the new space
+    if (size > SIZE_MAX - align) return NULL;
+    char* raw = (char*) serdec_arena_alloc(arena, size + align - 1);
+    if (!raw) return NULL;
+
+    return (void*) (((uintptr_t) raw + align - 1) & ~((uintptr_t) align - 1));
 }
 
 char* serdec_arena_strdup(SerdecArena* arena, const char* str, size_t len) {
@@ -167,3 +178,12 @@ size_t serdec_arena_used(const SerdecArena* arena) {
 
     return used_memory;
 }
+
+size_t serdec_arena_reserved(const SerdecArena* arena) {
+    if (!arena || arena->magic != SERDEC_MAGIC_ARENA) return SIZE_MAX;
+
+    size_t reserved = 0;
+    for (const ArenaBlock* block = arena->first; block; block = block->next)
+        reserved += block->size;
+    return reserved;
+}
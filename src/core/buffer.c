@@ -1,11 +1,19 @@
 #include "serdec/types.h"
 #include "internal.h"
 
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
 #define PADDING 64
 
 SerdecBuffer* serdec_buffer_from_string(const char* str, size_t len) {
@@ -33,13 +41,71 @@ SerdecBuffer* serdec_buffer_from_string(const char* str, size_t len) {
     return buf;
 }
 
-// TODO: Implement serdec_buffer_from_file
+#ifdef _WIN32
+
 SerdecBuffer* serdec_buffer_from_file(const char* path, size_t max_size) {
-    (void) path;
-    (void) max_size;
-    return NULL;
+    if (!path) return NULL;
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return NULL;
+
+    SerdecBuffer* buf = NULL;
+    long end = (fseek(fp, 0, SEEK_END) == 0) ? ftell(fp) : -1;
+    if (end >= 0 && (!max_size || (size_t) end <= max_size) && fseek(fp, 0, SEEK_SET) == 0) {
+        char* data = malloc((size_t) end + 1);
+        if (data && fread(data, 1, (size_t) end, fp) == (size_t) end)
+            buf = serdec_buffer_from_string(data, (size_t) end);
+        free(data);
+    }
+    fclose(fp);
+    return buf;
 }
 
+#else
+
+// Maps the file over the start of a zeroed anonymous region, so that PADDING zero bytes
+// follow the data as they do in a copied buffer. Pages are read on first access.
+SerdecBuffer* serdec_buffer_from_file(const char* path, size_t max_size) {
+    if (!path) return NULL;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    SerdecBuffer* buf = NULL;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+        (max_size && (uint64_t) st.st_size > max_size)) {
+        close(fd);
+        return NULL;
+    }
+    size_t size = (size_t) st.st_size;
+    if (!size) {
+        close(fd);
+        return serdec_buffer_from_string("", 0);
+    }
+
+    char* data = mmap(NULL, size + PADDING, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data != MAP_FAILED &&
+        mmap(data, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) != MAP_FAILED) {
+        buf = malloc(sizeof(*buf));
+    }
+    close(fd);
+
+    if (!buf) {
+        if (data != MAP_FAILED) munmap(data, size + PADDING);
+        return NULL;
+    }
+    *buf = (SerdecBuffer) {
+        .magic = SERDEC_MAGIC_BUFFER,
+        .ref_count = 1,
+        .data = data,
+        .size = size,
+        .capacity = size,
+        .mapped = true,
+    };
+    return buf;
+}
+
+#endif
+
 // TODO: Implement serdec_buffer_from_stream
 SerdecBuffer* serdec_buffer_from_stream(FILE* fp, size_t max_size) {
     (void) fp;
@@ -47,23 +113,25 @@ SerdecBuffer* serdec_buffer_from_stream(FILE* fp, size_t max_size) {
     return NULL;
 }
 
-// TODO: Make reference counting thread-safe
+// Retains may be relaxed: the caller already holds a reference. The final release
+// must see every write made through the other references before it frees the data.
 SerdecBuffer* serdec_buffer_retain(SerdecBuffer* buf) {
     if (!buf || buf->magic != SERDEC_MAGIC_BUFFER) return NULL;
-    buf->ref_count++;
+    atomic_fetch_add_explicit(&buf->ref_count, 1, memory_order_relaxed);
     return buf;
 }
 
 void serdec_buffer_release(SerdecBuffer* buf) {
     if (!buf || buf->magic != SERDEC_MAGIC_BUFFER) return;
+    if (atomic_fetch_sub_explicit(&buf->ref_count, 1, memory_order_acq_rel) != 1) return;
 
-    buf->ref_count--;
-
-    if (buf->ref_count == 0) {
-        buf->magic = SERDEC_MAGIC_FREED;
+    buf->magic = SERDEC_MAGIC_FREED;
+#ifndef _WIN32
+    if (buf->mapped) munmap(buf->data, buf->size + PADDING);
+    else
+#endif
         serdec_aligned_free(buf->data);
-        free(buf);
-    }
+    free(buf);
 }
 
 const char* serdec_buffer_data(const SerdecBuffer* buf) {
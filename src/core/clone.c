@@ -0,0 +1,294 @@
+#include "internal.h"
+#include <serdec/dom.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Every piece of a clone except string bytes starts on a node boundary.
+static size_t block_size(size_t bytes) {
+    return (bytes + sizeof(SerdecValue) - 1) & ~(sizeof(SerdecValue) - 1);
+}
+
+typedef struct {
+    const SerdecShape* from;
+    SerdecShape* to;          // NULL until the copy pass reaches the shape
+} ShapeEntry;
+
+typedef struct {
+    const SerdecValue* src;
+    SerdecValue* dst;         // NULL while measuring
+} CloneItem;
+
+typedef struct {
+    bool copy_strings;
+    CloneItem* stack;
+    size_t depth;
+    size_t stack_capacity;
+    ShapeEntry* shapes;       // Open-addressed by address
+    size_t shape_count;
+    size_t shape_capacity;
+    size_t blocks;            // Measure: bytes of node-aligned pieces
+    size_t bytes;             // Measure: bytes of strings
+    char* block_next;         // Copy: next node-aligned piece
+    char* byte_next;          // Copy: next string byte
+    SerdecArena* arena;
+} Cloner;
+
+static bool push(Cloner* c, const SerdecValue* src, SerdecValue* dst) {
+    if (c->depth == c->stack_capacity) {
+        size_t grown = c->stack_capacity ? c->stack_capacity * 2 : 64;
+        CloneItem* items = realloc(c->stack, grown * sizeof(*items));
+        if (!items) return false;
+        c->stack = items;
+        c->stack_capacity = grown;
+    }
+    c->stack[c->depth++] = (CloneItem) { src, dst };
+    return true;
+}
+
+static size_t shape_slot(const Cloner* c, const SerdecShape* shape) {
+    size_t mask = c->shape_capacity - 1;
+    size_t slot = (size_t) (((uintptr_t) shape >> 4) * 0x9E3779B97F4A7C15ull) & mask;
+    while (c->shapes[slot].from && c->shapes[slot].from != shape) slot = (slot + 1) & mask;
+    return slot;
+}
+
+// Adds shape to the map. Returns false when out of memory; *added is false if present.
+static bool add_shape(Cloner* c, const SerdecShape* shape, bool* added) {
+    *added = false;
+    if (c->shape_capacity && c->shapes[shape_slot(c, shape)].from) return true;
+
+    if (2 * (c->shape_count + 1) > c->shape_capacity) {
+        size_t capacity = c->shape_capacity ? c->shape_capacity * 2 : 16;
+        ShapeEntry* shapes = (ShapeEntry*) calloc(capacity, sizeof(*shapes));
+        if (!shapes) return false;
+
+        ShapeEntry* old = c->shapes;
+        size_t old_capacity = c->shape_capacity;
+        c->shapes = shapes;
+        c->shape_capacity = capacity;
+        for (size_t i = 0; i < old_capacity; i++) {
+            if (old[i].from) c->shapes[shape_slot(c, old[i].from)] = old[i];
+        }
+        free(old);
+    }
+
+    c->shapes[shape_slot(c, shape)].from = shape;
+    c->shape_count++;
+    *added = true;
+    return true;
+}
+
+static size_t string_bytes(const Cloner* c, const SerdecValue* node) {
+    if (!c->copy_strings || serdec_tag_sub(node) == SERDEC_STRING_INTERNED) return 0;
+    return serdec_tag_len(node) + 1;
+}
+
+// Index table of an indexed object, to be copied. Edited objects share theirs between
+// versions, with members past the count, so their clones build their own on first lookup.
+static const uint32_t* source_table(const SerdecValue* object) {
+    if (serdec_tag_sub(object) == SERDEC_OBJECT_GROWABLE) return NULL;
+    return ((const SerdecObjectIndex*) (object->children - 1))->table;
+}
+
+static size_t table_bytes(size_t count) {
+    return block_size(serdec_index_capacity(count) * sizeof(uint32_t));
+}
+
+// First pass: expands lazy containers and sizes the clone.
+static SerdecError measure(Cloner* c, const SerdecValue* root) {
+    c->blocks = sizeof(SerdecValue);
+    const SerdecValue* value = root;
+
+    for (;;) {
+        SerdecValueType type = serdec_tag_type(value);
+        if (type == SERDEC_TYPE_STRING) c->bytes += string_bytes(c, value);
+
+        if (type == SERDEC_TYPE_ARRAY || type == SERDEC_TYPE_OBJECT) {
+            SerdecError status = serdec_dom_expand(value);
+            if (status != SERDEC_OK) return status;
+
+            size_t count = serdec_tag_len(value);
+            const SerdecShape* shape = (type == SERDEC_TYPE_OBJECT) ? serdec_object_shape(value)
+                                                                    : NULL;
+            const SerdecValue* child = value->children;
+            size_t stride = 1;
+
+            if (type == SERDEC_TYPE_ARRAY && serdec_is_packed(value)) {
+                c->blocks += block_size(sizeof(SerdecPackedArray) + count * sizeof(uint64_t));
+                count = 0;
+            } else if (shape) {
+                bool added;
+                if (!add_shape(c, shape, &added)) return SERDEC_ERR_OUT_OF_MEMORY;
+                if (added) {
+                    c->blocks += block_size(sizeof(SerdecShape)) + count * sizeof(SerdecValue);
+                    if (shape->table) c->blocks += table_bytes(count);
+                    for (size_t i = 0; i < count; i++)
+                        c->bytes += string_bytes(c, &shape->keys[i]);
+                }
+                c->blocks += (count + 1) * sizeof(SerdecValue);
+            } else if (type == SERDEC_TYPE_OBJECT) {
+                bool indexed = serdec_has_index(type, count);
+                c->blocks += (2 * count + indexed) * sizeof(SerdecValue);
+                if (indexed && source_table(value)) c->blocks += table_bytes(count);
+                for (size_t i = 0; i < count; i++) c->bytes += string_bytes(c, &child[2 * i]);
+                child++;
+                stride = 2;
+            } else {
+                c->blocks += count * sizeof(SerdecValue);
+            }
+
+            for (size_t i = 0; i < count; i++, child += stride) {
+                SerdecValueType t = serdec_tag_type(child);
+                if (t == SERDEC_TYPE_STRING) {
+                    c->bytes += string_bytes(c, child);
+                } else if ((t == SERDEC_TYPE_ARRAY || t == SERDEC_TYPE_OBJECT) &&
+                           !push(c, child, NULL)) {
+                    return SERDEC_ERR_OUT_OF_MEMORY;
+                }
+            }
+        }
+        if (!c->depth) return SERDEC_OK;
+        value = c->stack[--c->depth].src;
+    }
+}
+
+static void* take_block(Cloner* c, size_t bytes) {
+    void* block = c->block_next;
+    c->block_next += block_size(bytes);
+    return block;
+}
+
+static void copy_string(Cloner* c, SerdecValue* node) {
+    size_t len = serdec_tag_len(node);
+    if (!string_bytes(c, node)) return;
+    memcpy(c->byte_next, node->str, len);
+    c->byte_next[len] = '\0';
+    node->str = c->byte_next;
+    c->byte_next += len + 1;
+}
+
+static const SerdecShape* copy_shape(Cloner* c, const SerdecShape* shape) {
+    ShapeEntry* entry = &c->shapes[shape_slot(c, shape)];   // Added by measure()
+    if (entry->to) return entry->to;
+
+    SerdecShape* copy = (SerdecShape*) take_block(c, sizeof(SerdecShape));
+    SerdecValue* keys = (SerdecValue*) take_block(c, shape->count * sizeof(SerdecValue));
+    memcpy(keys, shape->keys, shape->count * sizeof(*keys));
+    for (size_t i = 0; i < shape->count; i++) copy_string(c, &keys[i]);
+
+    uint32_t* table = NULL;
+    if (shape->table) {
+        size_t bytes = serdec_index_capacity(shape->count) * sizeof(uint32_t);
+        table = (uint32_t*) take_block(c, bytes);
+        memcpy(table, shape->table, bytes);
+    }
+    *copy = (SerdecShape) { .count = shape->count, .keys = keys, .table = table,
+                            .hash = shape->hash };
+    entry->to = copy;
+    return copy;
+}
+
+// Second pass: copies each container's run of children in one piece, then fixes up the
+// strings and containers in it.
+static void copy(Cloner* c, const SerdecValue* root, SerdecValue* out) {
+    *out = *root;
+    if (serdec_tag_type(out) == SERDEC_TYPE_STRING) copy_string(c, out);
+
+    const SerdecValue* src = root;
+    SerdecValue* dst = out;
+    for (;;) {
+        SerdecValueType type = serdec_tag_type(src);
+        if (type == SERDEC_TYPE_ARRAY || type == SERDEC_TYPE_OBJECT) {
+            size_t count = serdec_tag_len(src);
+            const SerdecShape* shape = (type == SERDEC_TYPE_OBJECT) ? serdec_object_shape(src)
+                                                                    : NULL;
+            SerdecValue* children = NULL;
+            size_t slots = count;
+            size_t first = 0;
+            size_t stride = 1;
+
+            if (type == SERDEC_TYPE_ARRAY && serdec_is_packed(src)) {
+                size_t bytes = sizeof(SerdecPackedArray) + count * sizeof(uint64_t);
+                SerdecPackedArray* packed = (SerdecPackedArray*) take_block(c, bytes);
+                memcpy(packed + 1, serdec_packed_data(src->packed), count * sizeof(uint64_t));
+                *packed = (SerdecPackedArray) { .arena = c->arena };
+                dst->packed = packed;
+                slots = 0;
+            } else if (shape) {
+                const SerdecShape* copied = copy_shape(c, shape);
+                children = (SerdecValue*) take_block(c, (count + 1) * sizeof(SerdecValue)) + 1;
+                ((const SerdecShape**) children)[-1] = copied;
+            } else if (type == SERDEC_TYPE_OBJECT) {
+                bool indexed = serdec_has_index(type, count);
+                children = (SerdecValue*) take_block(c, (2 * count + indexed) *
+                                                            sizeof(SerdecValue)) + indexed;
+                if (indexed) {
+                    const uint32_t* from = source_table(src);
+                    uint32_t* table = NULL;
+                    if (from) {
+                        size_t bytes = serdec_index_capacity(count) * sizeof(uint32_t);
+                        table = (uint32_t*) take_block(c, bytes);
+                        memcpy(table, from, bytes);
+                    }
+                    *(SerdecObjectIndex*) (children - 1) = (SerdecObjectIndex) {
+                        .arena = c->arena, .table = table
+                    };
+                }
+                for (size_t i = 0; i < count; i++) {
+                    children[2 * i] = src->children[2 * i];
+                    copy_string(c, &children[2 * i]);
+                }
+                dst->tag = serdec_tag(SERDEC_TYPE_OBJECT, 0, count);
+                slots = 2 * count;
+                first = 1;
+                stride = 2;
+            } else {
+                // Growable arrays lose their spare capacity
+                children = (SerdecValue*) take_block(c, count * sizeof(SerdecValue));
+                dst->tag = serdec_tag(SERDEC_TYPE_ARRAY, 0, count);
+            }
+
+            if (children) dst->children = slots ? children : NULL;
+            if (slots && stride == 1) memcpy(children, src->children, slots * sizeof(*children));
+            for (size_t i = first; i < slots; i += stride) {
+                if (stride == 2) children[i] = src->children[i];
+                SerdecValueType t = serdec_tag_type(&children[i]);
+                if (t == SERDEC_TYPE_STRING) copy_string(c, &children[i]);
+                else if (t == SERDEC_TYPE_ARRAY || t == SERDEC_TYPE_OBJECT)
+                    push(c, &src->children[i], &children[i]);   // Capacity from measure()
+            }
+        }
+        if (!c->depth) return;
+        CloneItem item = c->stack[--c->depth];
+        src = item.src;
+        dst = item.dst;
+    }
+}
+
+SerdecError serdec_value_clone(SerdecArena* arena, const SerdecValue* value, unsigned flags,
+                               const SerdecValue** out) {
+    if (!arena || arena->magic != SERDEC_MAGIC_ARENA || !value || !out)
+        return SERDEC_ERR_INVALID_HANDLE;
+
+    Cloner c = { .copy_strings = (flags & SERDEC_CLONE_COPY_STRINGS) != 0, .arena = arena };
+    SerdecError status = measure(&c, value);
+
+    char* memory = NULL;
+    if (status == SERDEC_OK) {
+        memory = (char*) serdec_arena_alloc_aligned(arena, c.blocks + c.bytes,
+                                                    _Alignof(SerdecValue));
+        if (!memory) status = SERDEC_ERR_OUT_OF_MEMORY;
+    }
+    if (status == SERDEC_OK) {
+        c.block_next = memory + sizeof(SerdecValue);
+        c.byte_next = memory + c.blocks;
+        copy(&c, value, (SerdecValue*) memory);
+        *out = (const SerdecValue*) memory;
+    }
+
+    free(c.stack);
+    free(c.shapes);
+    return status;
+}
@@ -0,0 +1,908 @@
+#include "internal.h"
+#include <serdec/dom.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static SerdecString rebase(const SerdecParser* parser, const char* origin, SerdecString s) {
+    if (origin) s.ptr = origin + (s.ptr - parser->lexer->start);
+    return s;
+}
+
+#define NO_TARGET  SIZE_MAX         // The next value is pushed as usual
+#define DROP_VALUE (SIZE_MAX - 1)   // The next value belongs to a dropped duplicate key
+
+// Finished children of every open container, in document order. A container's run
+// of children is copied into the arena in one piece when it closes.
+typedef struct {
+    size_t begin;             // Index of the container's first child in nodes
+    bool object;
+    size_t target;            // Member the next value replaces, or NO_TARGET/DROP_VALUE
+    uint32_t* seen;           // Duplicate check of wide objects: member + 1 by key hash
+    size_t seen_capacity;
+} BuildFrame;
+
+typedef struct {
+    SerdecValue* nodes;
+    size_t count;
+    size_t capacity;
+    BuildFrame* frames;
+    size_t depth;
+    size_t frame_capacity;
+    SerdecInternTable* keys;  // Intern keys here, if set
+    bool shapes;
+    bool typed_arrays;
+    SerdecShapeSet* shape_set;
+    SerdecDocument* lazy;     // Leave nested containers as spans of this document, if set
+    SerdecDuplicateKeys duplicates;
+} Builder;
+
+static bool push_node(Builder* b, SerdecValue node) {
+    if (b->count == b->capacity) {
+        size_t grown = b->capacity ? b->capacity * 2 : 64;
+        SerdecValue* items = realloc(b->nodes, grown * sizeof(*items));
+        if (!items) return false;
+        b->nodes = items;
+        b->capacity = grown;
+    }
+    b->nodes[b->count++] = node;
+    return true;
+}
+
+static bool push_frame(Builder* b, bool object) {
+    if (b->depth == b->frame_capacity) {
+        size_t grown = b->frame_capacity ? b->frame_capacity * 2 : 16;
+        BuildFrame* items = realloc(b->frames, grown * sizeof(*items));
+        if (!items) return false;
+        b->frames = items;
+        b->frame_capacity = grown;
+    }
+    b->frames[b->depth++] = (BuildFrame) { .begin = b->count, .object = object,
+                                           .target = NO_TARGET };
+    return true;
+}
+
+// Rebuilds the key hash of a wide object with room for as many members again.
+static bool rehash_keys(Builder* b, BuildFrame* frame, size_t members) {
+    size_t capacity = serdec_index_capacity(2 * (members + 1));
+    uint32_t* seen = (uint32_t*) calloc(capacity, sizeof(*seen));
+    if (!seen) return false;
+
+    const SerdecValue* keys = b->nodes + frame->begin;
+    for (size_t i = 0; i < members; i++) {
+        size_t slot = serdec_key_hash(&keys[2 * i]) & (capacity - 1);
+        while (seen[slot]) slot = (slot + 1) & (capacity - 1);
+        seen[slot] = (uint32_t) (i + 1);
+    }
+    free(frame->seen);
+    frame->seen = seen;
+    frame->seen_capacity = capacity;
+    return true;
+}
+
+// Looks key up among the members of the innermost object so far, which are distinct
+// whenever a policy is set. Narrow objects are scanned; wide ones keep a hash of their
+// keys, which also records key as the next member if it is new.
+static SerdecError find_duplicate(Builder* b, const SerdecValue* key, size_t* index) {
+    BuildFrame* frame = &b->frames[b->depth - 1];
+    const SerdecValue* keys = b->nodes + frame->begin;
+    size_t members = (b->count - frame->begin) / 2;
+    *index = SIZE_MAX;
+
+    if (members < SERDEC_INDEX_THRESHOLD || members >= UINT32_MAX) {
+        for (size_t i = 0; i < members && *index == SIZE_MAX; i++) {
+            if (serdec_keys_equal(&keys[2 * i], key)) *index = i;
+        }
+        return SERDEC_OK;
+    }
+
+    if (2 * (members + 1) > frame->seen_capacity && !rehash_keys(b, frame, members))
+        return SERDEC_ERR_OUT_OF_MEMORY;
+    size_t mask = frame->seen_capacity - 1;
+    size_t slot = serdec_key_hash(key) & mask;
+    for (; frame->seen[slot]; slot = (slot + 1) & mask) {
+        size_t i = frame->seen[slot] - 1;
+        if (serdec_keys_equal(&keys[2 * i], key)) {
+            *index = i;
+            return SERDEC_OK;
+        }
+    }
+    frame->seen[slot] = (uint32_t) (members + 1);
+    return SERDEC_OK;
+}
+
+// Stores an object's values behind a pointer to its shape; the keys live in the shape.
+static SerdecError close_shaped(Builder* b, SerdecArena* arena, size_t begin, size_t count,
+                                SerdecValue* node) {
+    const SerdecShape* shape;
+    SerdecError status = serdec_shape_get(b->shape_set, arena, b->nodes + begin, 2, count,
+                                          &shape);
+    if (status != SERDEC_OK) return status;
+
+    const SerdecShape** block = (const SerdecShape**) serdec_arena_alloc_aligned(
+        arena, sizeof(*block) + count * sizeof(SerdecValue), _Alignof(SerdecValue));
+    if (!block) return SERDEC_ERR_OUT_OF_MEMORY;
+
+    *block = shape;
+    SerdecValue* values = (SerdecValue*) (block + 1);
+    for (size_t i = 0; i < count; i++) values[i] = b->nodes[begin + 2 * i + 1];
+
+    *node = (SerdecValue) { .tag = serdec_tag(SERDEC_TYPE_OBJECT, SERDEC_OBJECT_SHAPED, count),
+                            .children = values };
+    return SERDEC_OK;
+}
+
+// Returns the packed kind the elements fit without loss, or 0 if they must stay nodes.
+// Integers go to int64_t; any fraction makes the array double, as long as every
+// integer in it is exact as a double.
+static unsigned packed_kind(const SerdecValue* nodes, size_t count) {
+    bool integers = true;
+    bool doubles = true;
+    const uint64_t exact = 1ull << 53;
+
+    for (size_t i = 0; i < count; i++) {
+        const SerdecValue* v = &nodes[i];
+        if (serdec_tag_type(v) != SERDEC_TYPE_NUMBER) return 0;
+        switch (serdec_tag_sub(v)) {
+        case SERDEC_NUMBER_UINT:
+            if (v->u64 > (uint64_t) INT64_MAX) integers = false;
+            if (v->u64 > exact) doubles = false;
+            break;
+        case SERDEC_NUMBER_INT:
+            if (v->i64 < -(int64_t) exact) doubles = false;
+            break;
+        default:
+            integers = false;
+            break;
+        }
+    }
+
+    if (integers) return SERDEC_ARRAY_I64;
+    return doubles ? SERDEC_ARRAY_F64 : 0;
+}
+
+static SerdecError close_packed(SerdecArena* arena, const SerdecValue* nodes, size_t count,
+                                unsigned kind, SerdecValue* node) {
+    SerdecPackedArray* packed = (SerdecPackedArray*) serdec_arena_alloc_aligned(
+        arena, sizeof(*packed) + count * sizeof(uint64_t), _Alignof(SerdecPackedArray));
+    if (!packed) return SERDEC_ERR_OUT_OF_MEMORY;
+
+    *packed = (SerdecPackedArray) { .arena = arena };
+    if (kind == SERDEC_ARRAY_I64) {
+        int64_t* data = (int64_t*) serdec_packed_data(packed);
+        for (size_t i = 0; i < count; i++) {
+            const SerdecValue* v = &nodes[i];
+            data[i] = (serdec_tag_sub(v) == SERDEC_NUMBER_INT) ? v->i64 : (int64_t) v->u64;
+        }
+    } else {
+        double* data = (double*) serdec_packed_data(packed);
+        for (size_t i = 0; i < count; i++) serdec_as_double(&nodes[i], &data[i]);
+    }
+
+    *node = (SerdecValue) { .tag = serdec_tag(SERDEC_TYPE_ARRAY, kind, count),
+                            .packed = packed };
+    return SERDEC_OK;
+}
+
+// Moves the children of the innermost open container into the arena.
+static SerdecError close_container(Builder* b, SerdecArena* arena, SerdecValue* node) {
+    BuildFrame frame = b->frames[--b->depth];
+    free(frame.seen);
+    size_t count = b->count - frame.begin;
+    bool indexed = frame.object && serdec_has_index(SERDEC_TYPE_OBJECT, count / 2);
+    SerdecValue* children = NULL;
+
+    if (frame.object && b->shapes && count) {
+        SerdecError status = close_shaped(b, arena, frame.begin, count / 2, node);
+        b->count = frame.begin;
+        return status;
+    }
+
+    unsigned kind = 0;
+    if (!frame.object && b->typed_arrays && count >= SERDEC_PACKED_MIN)
+        kind = packed_kind(b->nodes + frame.begin, count);
+    if (kind) {
+        SerdecError status = close_packed(arena, b->nodes + frame.begin, count, kind, node);
+        b->count = frame.begin;
+        return status;
+    }
+
+    if (count) {
+        size_t slots = count + indexed;
+        children = (SerdecValue*) serdec_arena_alloc_aligned(arena, slots * sizeof(*children),
+                                                             _Alignof(SerdecValue));
+        if (!children) return SERDEC_ERR_OUT_OF_MEMORY;
+        if (indexed) {
+            *(SerdecObjectIndex*) children = (SerdecObjectIndex) { .arena = arena };
+            children++;
+        }
+        memcpy(children, b->nodes + frame.begin, count * sizeof(*children));
+    }
+    b->count = frame.begin;
+
+    if (frame.object) {
+        *node = (SerdecValue) { .tag = serdec_tag(SERDEC_TYPE_OBJECT, 0, count / 2),
+                                .children = children };
+    } else {
+        *node = (SerdecValue) { .tag = serdec_tag(SERDEC_TYPE_ARRAY, 0, count),
+                                .children = children };
+    }
+    return SERDEC_OK;
+}
+
+// Fills a scalar node from the current event and the parser's last number token.
+static void make_scalar(const SerdecParser* parser, const SerdecEvent* ev, const char* origin,
+                        SerdecValue* node) {
+    switch (ev->kind) {
+    case SERDEC_EVENT_BOOL:
+        *node = (SerdecValue) { .tag = serdec_tag(SERDEC_TYPE_BOOL, 0, 0),
+                                .boolean = ev->boolean };
+        break;
+    case SERDEC_EVENT_STRING: {
+        SerdecString s = rebase(parser, origin, ev->string);
+        unsigned sub = s.has_escapes ? SERDEC_STRING_ESCAPED : 0;
+        *node = (SerdecValue) { .tag = serdec_tag(SERDEC_TYPE_STRING, sub, s.len),
+                                .str = s.ptr };
+        break;
+    }
+    case SERDEC_EVENT_NUMBER: {
+        const SerdecToken* tok = &parser->token;
+        if (!tok->number.is_integer) {
+            *node = (SerdecValue) { .tag = serdec_tag(SERDEC_TYPE_NUMBER, SERDEC_NUMBER_DOUBLE, 0),
+                                    .f64 = tok->number.value.f64 };
+        } else if (tok->number.is_negative) {
+            *node = (SerdecValue) { .tag = serdec_tag(SERDEC_TYPE_NUMBER, SERDEC_NUMBER_INT, 0),
+                                    .i64 = tok->number.value.i64 };
+        } else {
+            *node = (SerdecValue) { .tag = serdec_tag(SERDEC_TYPE_NUMBER, SERDEC_NUMBER_UINT, 0),
+                                    .u64 = tok->number.value.u64 };
+        }
+        break;
+    }
+    default:
+        *node = (SerdecValue) { .tag = serdec_tag(SERDEC_TYPE_NULL, 0, 0) };
+        break;
+    }
+}
+
+static SerdecError intern_key(SerdecInternTable* keys, SerdecString raw, SerdecValue* node) {
+    const char* ptr;
+    SerdecError status = serdec_intern_string(keys, raw, &ptr);
+    if (status != SERDEC_OK) return status;
+
+    size_t len = serdec_intern_entry(ptr)->len;
+    *node = (SerdecValue) { .tag = serdec_tag(SERDEC_TYPE_STRING, SERDEC_STRING_INTERNED, len),
+                            .str = ptr };
+    return SERDEC_OK;
+}
+
+// Builds one value into *out. Containers nested in it are lazy spans if b->lazy is set.
+static SerdecError build_node(Builder* b, SerdecParser* parser, SerdecArena* arena,
+                              const SerdecEvent* first, const char* origin, SerdecValue* out) {
+    SerdecError status = SERDEC_OK;
+    SerdecEvent ev = *first;
+
+    for (;;) {
+        SerdecValue node;
+        bool complete = true;   // node holds a finished key or value
+
+        switch (ev.kind) {
+        case SERDEC_EVENT_KEY: {
+            SerdecString raw = rebase(parser, origin, ev.string);
+            if (b->keys) {
+                status = intern_key(b->keys, raw, &node);
+            } else {
+                const char* ptr;
+                size_t len;
+                status = serdec_string_materialize(arena, raw, &ptr, &len);
+                node = (SerdecValue) { .tag = serdec_tag(SERDEC_TYPE_STRING, 0, len),
+                                       .str = ptr };
+            }
+            if (status != SERDEC_OK || b->duplicates == SERDEC_DUPLICATES_ALLOW) break;
+
+            size_t index;
+            status = find_duplicate(b, &node, &index);
+            if (status != SERDEC_OK || index == SIZE_MAX) break;
+            if (b->duplicates == SERDEC_DUPLICATES_REJECT) {
+                status = serdec_json_parser_fail(parser, SERDEC_ERR_DUPLICATE_KEY, ev.offset,
+                                                 "duplicate object key");
+                break;
+            }
+            // The key is not pushed; its value replaces or is dropped
+            b->frames[b->depth - 1].target = (b->duplicates == SERDEC_DUPLICATES_LAST_WINS)
+                                           ? index : DROP_VALUE;
+            complete = false;
+            break;
+        }
+        case SERDEC_EVENT_START_OBJECT:
+        case SERDEC_EVENT_START_ARRAY: {
+            SerdecValueType type = (ev.kind == SERDEC_EVENT_START_OBJECT) ? SERDEC_TYPE_OBJECT
+                                                                          : SERDEC_TYPE_ARRAY;
+            if (b->lazy && b->depth) {
+                node = (SerdecValue) {
+                    .tag = serdec_tag(type, SERDEC_CONTAINER_LAZY, ev.offset), .document = b->lazy
+                };
+                status = serdec_json_skip(parser);
+                break;
+            }
+            if (!push_frame(b, type == SERDEC_TYPE_OBJECT)) status = SERDEC_ERR_OUT_OF_MEMORY;
+            complete = false;
+            break;
+        }
+        case SERDEC_EVENT_END_OBJECT:
+        case SERDEC_EVENT_END_ARRAY:
+            if (!b->depth) status = SERDEC_ERR_INVALID_HANDLE;
+            else status = close_container(b, arena, &node);
+            break;
+        case SERDEC_EVENT_END:
+        case SERDEC_EVENT_ERROR:
+            status = SERDEC_ERR_INVALID_HANDLE;
+            break;
+        default:
+            make_scalar(parser, &ev, origin, &node);
+            break;
+        }
+        if (status != SERDEC_OK) break;
+
+        if (complete && !b->depth) {
+            *out = node;
+            break;
+        }
+        if (complete) {
+            BuildFrame* parent = &b->frames[b->depth - 1];
+            if (parent->target == NO_TARGET) {
+                if (!push_node(b, node)) {
+                    status = SERDEC_ERR_OUT_OF_MEMORY;
+                    break;
+                }
+            } else {
+                if (parent->target != DROP_VALUE)
+                    b->nodes[parent->begin + 2 * parent->target + 1] = node;
+                parent->target = NO_TARGET;
+            }
+        }
+
+        status = serdec_json_event_next(parser, &ev);
+        if (status != SERDEC_OK) break;
+    }
+
+    for (size_t i = 0; i < b->depth; i++) free(b->frames[i].seen);
+    free(b->nodes);
+    free(b->frames);
+    return status;
+}
+
+SerdecError serdec_dom_build(SerdecParser* parser, SerdecArena* arena,
+                             const SerdecParseConfig* config, const SerdecEvent* first,
+                             const char* origin, SerdecValue** out) {
+    SerdecShapeSet shapes = { 0 };
+    Builder b = {
+        .keys = config ? config->keys : NULL,
+        .shapes = config && config->shapes,
+        .typed_arrays = config && config->typed_arrays,
+        .shape_set = &shapes,
+        .duplicates = config ? config->duplicates : SERDEC_DUPLICATES_ALLOW,
+    };
+    SerdecValue node;
+    SerdecError status = build_node(&b, parser, arena, first, origin, &node);
+    serdec_shape_set_free(&shapes);
+    if (status != SERDEC_OK) return status;
+
+    SerdecValue* root = (SerdecValue*) serdec_arena_alloc_aligned(arena, sizeof(*root),
+                                                                  _Alignof(SerdecValue));
+    if (!root) return SERDEC_ERR_OUT_OF_MEMORY;
+    *root = node;
+    *out = root;
+    return SERDEC_OK;
+}
+
+// Parses one level of a lazy container and overwrites its node in place; containers
+// inside it become lazy spans in turn. On failure the node stays lazy. Mapped containers
+// are relocated instead. Both subtypes sort above every other, so expanded containers
+// cost one comparison.
+SerdecError serdec_dom_expand(const SerdecValue* value) {
+    if (serdec_tag_sub(value) < SERDEC_CONTAINER_MAPPED) return SERDEC_OK;
+    if (serdec_tag_sub(value) == SERDEC_CONTAINER_MAPPED) return serdec_snapshot_expand(value);
+
+    SerdecDocument* doc = value->document;
+    if (!doc->parser) return SERDEC_ERR_INVALID_HANDLE;   // Document destroyed
+
+    Builder b = {
+        .keys = doc->config.keys,
+        .shapes = doc->config.shapes,
+        .typed_arrays = doc->config.typed_arrays,
+        .shape_set = &doc->shapes,
+        .lazy = doc,
+        .duplicates = doc->config.duplicates,
+    };
+    SerdecEvent ev;
+    SerdecValue node;
+    serdec_json_parser_reset(doc->parser, serdec_tag_len(value), doc->len, 1);
+    SerdecError status = serdec_json_event_next(doc->parser, &ev);
+    if (status == SERDEC_OK)
+        status = build_node(&b, doc->parser, doc->arena, &ev, doc->input, &node);
+    if (status != SERDEC_OK) return status;
+
+    // Nodes live in arena memory, which is writable; only the API hands them out as const
+    *(SerdecValue*) value = node;
+    return SERDEC_OK;
+}
+
+typedef struct {
+    SerdecValue* slots;       // Children reserved for this container
+    size_t next;
+    size_t count;
+} FillFrame;
+
+// Builds into one allocation sized by serdec_scan_measure(): size->nodes nodes, index
+// slots included, followed by size->key_bytes of decoded keys. Each container reserves
+// its run of children when it opens, so every node is written once, in place.
+static SerdecError build_exact(SerdecParser* parser, SerdecArena* arena,
+                               SerdecInternTable* keys, const SerdecEvent* first,
+                               const char* origin, const SerdecDomSize* size,
+                               SerdecValue** out) {
+    SerdecValue* nodes = (SerdecValue*) serdec_arena_alloc_aligned(
+        arena, size->nodes * sizeof(SerdecValue) + size->key_bytes, _Alignof(SerdecValue));
+    if (!nodes) return SERDEC_ERR_OUT_OF_MEMORY;
+
+    char* decoded = (char*) (nodes + size->nodes);
+    size_t used = 1;          // nodes[0] is the root
+    size_t key_used = 0;
+    size_t container = 0;
+    FillFrame* frames = NULL;
+    size_t depth = 0;
+    size_t capacity = 0;
+    SerdecError status = SERDEC_OK;
+    SerdecEvent ev = *first;
+
+    // A count that does not match the events is an internal error: the measure is exact
+    // for every prefix the parser accepts.
+    for (;;) {
+        if (ev.kind == SERDEC_EVENT_END_OBJECT || ev.kind == SERDEC_EVENT_END_ARRAY) {
+            if (!depth) {
+                status = SERDEC_ERR_INVALID_HANDLE;
+                break;
+            }
+            depth--;
+        } else if (ev.kind == SERDEC_EVENT_END || ev.kind == SERDEC_EVENT_ERROR) {
+            status = SERDEC_ERR_INVALID_HANDLE;
+            break;
+        } else {
+            SerdecValue* node = nodes;
+            if (depth) {
+                FillFrame* top = &frames[depth - 1];
+                if (top->next == top->count) {
+                    status = SERDEC_ERR_INVALID_HANDLE;
+                    break;
+                }
+                node = &top->slots[top->next++];
+            }
+
+            if (ev.kind == SERDEC_EVENT_KEY && keys) {
+                status = intern_key(keys, rebase(parser, origin, ev.string), node);
+                if (status != SERDEC_OK) break;
+            } else if (ev.kind == SERDEC_EVENT_KEY) {
+                SerdecString raw = rebase(parser, origin, ev.string);
+                const char* ptr = raw.ptr;
+                size_t len = raw.len;
+                if (raw.has_escapes) {
+                    if (raw.len + 1 > size->key_bytes - key_used) {
+                        status = SERDEC_ERR_INVALID_HANDLE;
+                        break;
+                    }
+                    ptr = decoded + key_used;
+                    status = serdec_string_unescape_to(decoded + key_used, raw.ptr, raw.len,
+                                                       &len);
+                    if (status != SERDEC_OK) break;
+                    key_used += raw.len + 1;
+                }
+                *node = (SerdecValue) { .tag = serdec_tag(SERDEC_TYPE_STRING, 0, len),
+                                        .str = ptr };
+            } else if (ev.kind == SERDEC_EVENT_START_OBJECT ||
+                       ev.kind == SERDEC_EVENT_START_ARRAY) {
+                bool object = (ev.kind == SERDEC_EVENT_START_OBJECT);
+                size_t count = (container < size->containers) ? size->children[container] : 0;
+                size_t slots = object ? 2 * count : count;
+                bool indexed = object && serdec_has_index(SERDEC_TYPE_OBJECT, count);
+                if (container++ == size->containers || slots + indexed > size->nodes - used) {
+                    status = SERDEC_ERR_INVALID_HANDLE;
+                    break;
+                }
+                if (indexed) {
+                    *(SerdecObjectIndex*) (nodes + used) = (SerdecObjectIndex) { .arena = arena };
+                    used++;
+                }
+                if (depth == capacity) {
+                    size_t grown = capacity ? capacity * 2 : 16;
+                    FillFrame* items = realloc(frames, grown * sizeof(*items));
+                    if (!items) {
+                        status = SERDEC_ERR_OUT_OF_MEMORY;
+                        break;
+                    }
+                    frames = items;
+                    capacity = grown;
+                }
+
+                SerdecValueType type = object ? SERDEC_TYPE_OBJECT : SERDEC_TYPE_ARRAY;
+                *node = (SerdecValue) { .tag = serdec_tag(type, 0, count),
+                                        .children = slots ? nodes + used : NULL };
+                frames[depth++] = (FillFrame) { .slots = nodes + used, .count = slots };
+                used += slots;
+            } else {
+                make_scalar(parser, &ev, origin, node);
+            }
+        }
+        if (!depth) break;
+
+        status = serdec_json_event_next(parser, &ev);
+        if (status != SERDEC_OK) break;
+    }
+
+    free(frames);
+    if (status == SERDEC_OK) *out = nodes;
+    return status;
+}
+
+SerdecError serdec_document_parse(SerdecArena* arena, const char* json, size_t len,
+                                  const SerdecParseConfig* config, SerdecDocument** doc,
+                                  SerdecErrorInfo* err) {
+    if (!arena || arena->magic != SERDEC_MAGIC_ARENA || !json || !doc)
+        return SERDEC_ERR_INVALID_HANDLE;
+
+    size_t max_depth = SERDEC_DEFAULT_MAX_DEPTH;
+    if (config && config->max_depth) max_depth = config->max_depth;
+
+    SerdecInternTable* keys = config ? config->keys : NULL;
+    if (keys && keys->magic != SERDEC_MAGIC_INTERN) return SERDEC_ERR_INVALID_HANDLE;
+
+    // Lazy nodes point at the document, so it is allocated before the build
+    SerdecDocument* document = (SerdecDocument*) serdec_arena_alloc_aligned(
+        arena, sizeof(*document), _Alignof(SerdecDocument));
+    if (!document) return SERDEC_ERR_OUT_OF_MEMORY;
+    *document = (SerdecDocument) {
+        .arena = arena,
+        .input = json,
+        .len = len,
+    };
+    if (config) document->config = *config;
+
+    SerdecParser* parser = serdec_json_parser_create(json, len);
+    if (!parser) return SERDEC_ERR_OUT_OF_MEMORY;
+    if (max_depth != SERDEC_DEFAULT_MAX_DEPTH &&
+        !serdec_json_parser_set_max_depth(parser, max_depth)) {
+        serdec_json_parser_destroy(parser);
+        return SERDEC_ERR_OUT_OF_MEMORY;
+    }
+
+    bool lazy = config && config->lazy;
+    SerdecDomSize size = { 0 };
+    bool exact = config && config->exact_size && !config->shapes && !config->typed_arrays &&
+                 !lazy && config->duplicates == SERDEC_DUPLICATES_ALLOW;
+    if (exact && !serdec_scan_measure(json, len, &size)) {
+        serdec_json_parser_destroy(parser);
+        return SERDEC_ERR_OUT_OF_MEMORY;
+    }
+    if (keys) size.key_bytes = 0;   // Keys live in the table
+
+    SerdecValue* root = NULL;
+    SerdecEvent ev;
+    SerdecError status = serdec_json_event_next(parser, &ev);
+    if (status == SERDEC_OK) {
+        if (exact) {
+            status = build_exact(parser, arena, keys, &ev, json, &size, &root);
+        } else if (lazy) {
+            Builder b = {
+                .keys = keys,
+                .shapes = config->shapes,
+                .typed_arrays = config->typed_arrays,
+                .shape_set = &document->shapes,
+                .lazy = document,
+                .duplicates = config->duplicates,
+            };
+            root = (SerdecValue*) serdec_arena_alloc_aligned(arena, sizeof(*root),
+                                                             _Alignof(SerdecValue));
+            if (!root) status = SERDEC_ERR_OUT_OF_MEMORY;
+            else status = build_node(&b, parser, arena, &ev, json, root);
+        } else {
+            status = serdec_dom_build(parser, arena, config, &ev, json, &root);
+        }
+    }
+    if (status == SERDEC_OK) status = serdec_json_event_next(parser, &ev);
+    free(size.children);
+
+    if (status != SERDEC_OK && err) {
+        const SerdecErrorInfo* info = serdec_json_parser_error(parser);
+        if (info->code == status) *err = *info;
+        else *err = (SerdecErrorInfo) { .code = status, .offset = ev.offset, .line = 1,
+                                        .column = 1 };
+    }
+    if (status != SERDEC_OK || !lazy) {
+        serdec_json_parser_destroy(parser);
+        parser = NULL;
+    }
+    if (status != SERDEC_OK) {
+        serdec_shape_set_free(&document->shapes);
+        return status;
+    }
+
+    document->magic = SERDEC_MAGIC_DOCUMENT;
+    document->root = root;
+    document->parser = parser;
+    *doc = document;
+    return SERDEC_OK;
+}
+
+void serdec_document_destroy(SerdecDocument* doc) {
+    if (!doc || doc->magic != SERDEC_MAGIC_DOCUMENT) return;
+    serdec_json_parser_destroy(doc->parser);
+    serdec_shape_set_free(&doc->shapes);
+    if (doc->mapped) serdec_snapshot_release(doc);
+    doc->parser = NULL;
+    doc->magic = 0;
+}
+
+const SerdecValue* serdec_document_root(const SerdecDocument* doc) {
+    if (!doc || doc->magic != SERDEC_MAGIC_DOCUMENT) return NULL;
+    return doc->root;
+}
+
+SerdecError serdec_parse(SerdecArena* arena, const char* json, size_t len,
+                         const SerdecValue** root, SerdecErrorInfo* err) {
+    if (!root) return SERDEC_ERR_INVALID_HANDLE;
+
+    SerdecDocument* doc = NULL;
+    SerdecError status = serdec_document_parse(arena, json, len, NULL, &doc, err);
+    if (status == SERDEC_OK) *root = doc->root;
+    return status;
+}
+
+SerdecValueType serdec_value_type(const SerdecValue* value) {
+    return value ? serdec_tag_type(value) : SERDEC_TYPE_NULL;
+}
+
+size_t serdec_value_size(const SerdecValue* value) {
+    if (!value) return 0;
+    SerdecValueType type = serdec_tag_type(value);
+    if (type != SERDEC_TYPE_ARRAY && type != SERDEC_TYPE_OBJECT) return 0;
+    if (serdec_dom_expand(value) != SERDEC_OK) return 0;
+    return serdec_tag_len(value);
+}
+
+static const uint32_t* object_index(const SerdecValue* object, size_t count) {
+    SerdecObjectIndex* index = (SerdecObjectIndex*) (object->children - 1);
+    if (serdec_tag_sub(object) == SERDEC_OBJECT_GROWABLE) count = serdec_object_block(object)->used;
+    if (!index->table) index->table = serdec_key_table_build(index->arena, object->children, 2,
+                                                             count);
+    return index->table;
+}
+
+// Large objects probe a hash index, and fall back to a scan if it cannot be built.
+SerdecError serdec_dom_find(const SerdecValue* object, const char* key, size_t len,
+                            bool interned, const uint64_t* hash, const SerdecValue** out) {
+    SerdecError status = serdec_dom_expand(object);
+    if (status != SERDEC_OK) return status;
+
+    size_t count = serdec_tag_len(object);
+    const SerdecShape* shape = serdec_object_shape(object);
+    size_t i;
+
+    if (shape) {
+        i = serdec_key_find(shape->keys, 1, count, shape->table, key, len, interned, hash);
+        if (i == SIZE_MAX) return SERDEC_ERR_NOT_FOUND;
+        *out = &object->children[i];
+        return SERDEC_OK;
+    }
+
+    const uint32_t* table = serdec_has_index(SERDEC_TYPE_OBJECT, count)
+                                ? object_index(object, count) : NULL;
+    i = serdec_key_find(object->children, 2, count, table, key, len, interned, hash);
+    if (i == SIZE_MAX) return SERDEC_ERR_NOT_FOUND;
+    *out = &object->children[2 * i + 1];
+    return SERDEC_OK;
+}
+
+SerdecError serdec_get(const SerdecValue* object, const char* key, const SerdecValue** out) {
+    if (!object || !key || !out) return SERDEC_ERR_INVALID_HANDLE;
+    if (serdec_tag_type(object) != SERDEC_TYPE_OBJECT) return SERDEC_ERR_TYPE_MISMATCH;
+    return serdec_dom_find(object, key, strlen(key), false, NULL, out);
+}
+
+SerdecError serdec_get_interned(const SerdecValue* object, const char* key,
+                                const SerdecValue** out) {
+    if (!object || !key || !out) return SERDEC_ERR_INVALID_HANDLE;
+    if (serdec_tag_type(object) != SERDEC_TYPE_OBJECT) return SERDEC_ERR_TYPE_MISMATCH;
+    return serdec_dom_find(object, key, serdec_intern_entry(key)->len, true, NULL, out);
+}
+
+// Builds element nodes for a packed array the first time it is indexed.
+static const SerdecValue* packed_nodes(const SerdecValue* array) {
+    SerdecPackedArray* packed = array->packed;
+    if (packed->nodes) return packed->nodes;
+
+    size_t count = serdec_tag_len(array);
+    SerdecValue* nodes = (SerdecValue*) serdec_arena_alloc_aligned(
+        packed->arena, count * sizeof(*nodes), _Alignof(SerdecValue));
+    if (!nodes) return NULL;
+
+    for (size_t i = 0; i < count; i++) nodes[i] = serdec_packed_node(array, i);
+
+    packed->nodes = nodes;
+    return nodes;
+}
+
+SerdecError serdec_index(const SerdecValue* array, size_t index, const SerdecValue** out) {
+    if (!array || !out) return SERDEC_ERR_INVALID_HANDLE;
+    if (serdec_tag_type(array) != SERDEC_TYPE_ARRAY) return SERDEC_ERR_TYPE_MISMATCH;
+    SerdecError status = serdec_dom_expand(array);
+    if (status != SERDEC_OK) return status;
+    if (index >= serdec_tag_len(array)) return SERDEC_ERR_NOT_FOUND;
+
+    if (serdec_is_packed(array)) {
+        const SerdecValue* nodes = packed_nodes(array);
+        if (!nodes) return SERDEC_ERR_OUT_OF_MEMORY;
+        *out = &nodes[index];
+        return SERDEC_OK;
+    }
+
+    *out = &array->children[index];
+    return SERDEC_OK;
+}
+
+SerdecError serdec_as_int64_array(const SerdecValue* array, const int64_t** data,
+                                  size_t* count) {
+    if (!array || !data || !count) return SERDEC_ERR_INVALID_HANDLE;
+    if (serdec_tag_type(array) != SERDEC_TYPE_ARRAY) return SERDEC_ERR_TYPE_MISMATCH;
+    SerdecError status = serdec_dom_expand(array);
+    if (status != SERDEC_OK) return status;
+    if (serdec_tag_sub(array) != SERDEC_ARRAY_I64) return SERDEC_ERR_TYPE_MISMATCH;
+
+    *data = (const int64_t*) serdec_packed_data(array->packed);
+    *count = serdec_tag_len(array);
+    return SERDEC_OK;
+}
+
+SerdecError serdec_as_double_array(const SerdecValue* array, const double** data,
+                                   size_t* count) {
+    if (!array || !data || !count) return SERDEC_ERR_INVALID_HANDLE;
+    if (serdec_tag_type(array) != SERDEC_TYPE_ARRAY) return SERDEC_ERR_TYPE_MISMATCH;
+    SerdecError status = serdec_dom_expand(array);
+    if (status != SERDEC_OK) return status;
+    if (serdec_tag_sub(array) != SERDEC_ARRAY_F64) return SERDEC_ERR_TYPE_MISMATCH;
+
+    *data = (const double*) serdec_packed_data(array->packed);
+    *count = serdec_tag_len(array);
+    return SERDEC_OK;
+}
+
+SerdecError serdec_member(const SerdecValue* object, size_t index, SerdecString* key,
+                          const SerdecValue** out) {
+    if (!object || !out) return SERDEC_ERR_INVALID_HANDLE;
+    if (serdec_tag_type(object) != SERDEC_TYPE_OBJECT) return SERDEC_ERR_TYPE_MISMATCH;
+    SerdecError status = serdec_dom_expand(object);
+    if (status != SERDEC_OK) return status;
+    if (index >= serdec_tag_len(object)) return SERDEC_ERR_NOT_FOUND;
+
+    const SerdecValue* name = serdec_member_key(object, index);
+    if (key) *key = (SerdecString) { name->str, serdec_tag_len(name), false };
+    *out = serdec_member_value(object, index);
+    return SERDEC_OK;
+}
+
+static bool push_value(const SerdecValue*** stack, size_t* depth, size_t* capacity,
+                       const SerdecValue* value) {
+    if (*depth == *capacity) {
+        size_t grown = *capacity ? *capacity * 2 : 64;
+        const SerdecValue** items = realloc(*stack, grown * sizeof(*items));
+        if (!items) return false;
+        *stack = items;
+        *capacity = grown;
+    }
+    (*stack)[(*depth)++] = value;
+    return true;
+}
+
+// Performs every write a read could otherwise make: expands lazy containers, builds the
+// hash index of large objects and the element nodes of packed arrays.
+SerdecError serdec_document_freeze(SerdecDocument* doc) {
+    if (!doc || doc->magic != SERDEC_MAGIC_DOCUMENT) return SERDEC_ERR_INVALID_HANDLE;
+    if (doc->frozen) return SERDEC_OK;
+
+    const SerdecValue** stack = NULL;
+    size_t depth = 0;
+    size_t capacity = 0;
+    const SerdecValue* value = doc->root;
+    SerdecError status = SERDEC_OK;
+
+    for (;;) {
+        SerdecValueType type = serdec_tag_type(value);
+        if (type == SERDEC_TYPE_ARRAY || type == SERDEC_TYPE_OBJECT) {
+            status = serdec_dom_expand(value);
+            if (status != SERDEC_OK) break;
+
+            size_t count = serdec_tag_len(value);
+            const SerdecValue* child = value->children;
+            size_t stride = 1;
+            if (type == SERDEC_TYPE_ARRAY && serdec_is_packed(value)) {
+                if (!packed_nodes(value)) status = SERDEC_ERR_OUT_OF_MEMORY;
+                count = 0;    // Numbers only
+            } else if (type == SERDEC_TYPE_OBJECT && !serdec_object_shape(value)) {
+                if (serdec_has_index(type, count) && !object_index(value, count))
+                    status = SERDEC_ERR_OUT_OF_MEMORY;
+                child++;
+                stride = 2;
+            }
+            for (size_t i = 0; i < count && status == SERDEC_OK; i++, child += stride) {
+                SerdecValueType t = serdec_tag_type(child);
+                if ((t == SERDEC_TYPE_ARRAY || t == SERDEC_TYPE_OBJECT) &&
+                    !push_value(&stack, &depth, &capacity, child))
+                    status = SERDEC_ERR_OUT_OF_MEMORY;
+            }
+            if (status != SERDEC_OK) break;
+        }
+        if (!depth) break;
+        value = stack[--depth];
+    }
+    free(stack);
+    if (status != SERDEC_OK) return status;
+
+    // Nothing is left to expand
+    serdec_json_parser_destroy(doc->parser);
+    serdec_shape_set_free(&doc->shapes);
+    doc->parser = NULL;
+    doc->frozen = true;
+    return SERDEC_OK;
+}
+
+SerdecError serdec_as_string(const SerdecValue* value, SerdecString* out) {
+    if (!value || !out) return SERDEC_ERR_INVALID_HANDLE;
+    if (serdec_tag_type(value) != SERDEC_TYPE_STRING) return SERDEC_ERR_TYPE_MISMATCH;
+    *out = (SerdecString) { value->str, serdec_tag_len(value),
+                            serdec_tag_sub(value) == SERDEC_STRING_ESCAPED };
+    return SERDEC_OK;
+}
+
+SerdecError serdec_as_bool(const SerdecValue* value, bool* out) {
+    if (!value || !out) return SERDEC_ERR_INVALID_HANDLE;
+    if (serdec_tag_type(value) != SERDEC_TYPE_BOOL) return SERDEC_ERR_TYPE_MISMATCH;
+    *out = value->boolean;
+    return SERDEC_OK;
+}
+
+SerdecError serdec_as_int64(const SerdecValue* value, int64_t* out) {
+    if (!value || !out) return SERDEC_ERR_INVALID_HANDLE;
+    if (serdec_tag_type(value) != SERDEC_TYPE_NUMBER ||
+        serdec_tag_sub(value) == SERDEC_NUMBER_DOUBLE)
+        return SERDEC_ERR_TYPE_MISMATCH;
+
+    if (serdec_tag_sub(value) == SERDEC_NUMBER_INT) {
+        *out = value->i64;
+    } else {
+        if (value->u64 > (uint64_t) INT64_MAX) return SERDEC_ERR_NUMBER_OVERFLOW;
+        *out = (int64_t) value->u64;
+    }
+    return SERDEC_OK;
+}
+
+SerdecError serdec_as_uint64(const SerdecValue* value, uint64_t* out) {
+    if (!value || !out) return SERDEC_ERR_INVALID_HANDLE;
+    if (serdec_tag_type(value) != SERDEC_TYPE_NUMBER ||
+        serdec_tag_sub(value) == SERDEC_NUMBER_DOUBLE)
+        return SERDEC_ERR_TYPE_MISMATCH;
+    if (serdec_tag_sub(value) == SERDEC_NUMBER_INT) return SERDEC_ERR_NUMBER_OVERFLOW;
+
+    *out = value->u64;
+    return SERDEC_OK;
+}
+
+SerdecError serdec_as_double(const SerdecValue* value, double* out) {
+    if (!value || !out) return SERDEC_ERR_INVALID_HANDLE;
+    if (serdec_tag_type(value) != SERDEC_TYPE_NUMBER) return SERDEC_ERR_TYPE_MISMATCH;
+
+    switch (serdec_tag_sub(value)) {
+    case SERDEC_NUMBER_UINT: *out = (double) value->u64; break;
+    case SERDEC_NUMBER_INT:  *out = (double) value->i64; break;
+    default:                 *out = value->f64; break;
+    }
+    return SERDEC_OK;
+}
@@ -0,0 +1,243 @@
+#include "internal.h"
+#include <serdec/dom.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+static const SerdecValue* new_node(SerdecArena* arena, SerdecValue node) {
+    SerdecValue* copy = (SerdecValue*) serdec_arena_alloc_aligned(arena, sizeof(*copy),
+                                                                  _Alignof(SerdecValue));
+    if (copy) *copy = node;
+    return copy;
+}
+
+static SerdecError check_container(SerdecArena* arena, const SerdecValue* value,
+                                   SerdecValueType type, const SerdecValue** out) {
+    if (!arena || arena->magic != SERDEC_MAGIC_ARENA || !value || !out)
+        return SERDEC_ERR_INVALID_HANDLE;
+    if (serdec_tag_type(value) != type) return SERDEC_ERR_TYPE_MISMATCH;
+    return serdec_dom_expand(value);
+}
+
+// --- Arrays ---
+
+static SerdecValue* alloc_elements(SerdecArena* arena, size_t capacity) {
+    SerdecArrayBlock* block = (SerdecArrayBlock*) serdec_arena_alloc_aligned(
+        arena, sizeof(SerdecValue) + capacity * sizeof(SerdecValue), _Alignof(SerdecValue));
+    if (!block) return NULL;
+    *block = (SerdecArrayBlock) { .capacity = capacity };
+    return (SerdecValue*) block + 1;
+}
+
+// Copies elements [begin, end) of any array representation to dst.
+static void copy_elements(SerdecValue* dst, const SerdecValue* array, size_t begin, size_t end) {
+    if (!serdec_is_packed(array)) {
+        if (end > begin) memcpy(dst, array->children + begin, (end - begin) * sizeof(*dst));
+        return;
+    }
+    for (size_t i = begin; i < end; i++) *dst++ = serdec_packed_node(array, i);
+}
+
+// Replaces `removed` elements at index with `added` copies of *value (0 or 1), into a new
+// block. Inserts leave spare capacity so that later appends to the result are in place.
+static SerdecError splice(SerdecArena* arena, const SerdecValue* array, size_t index,
+                          size_t removed, size_t added, const SerdecValue* value,
+                          const SerdecValue** out) {
+    size_t count = serdec_tag_len(array);
+    size_t result = count - removed + added;
+    size_t capacity = result;
+    if (added > removed) capacity = (result < 8) ? 8 : 2 * result;
+
+    SerdecValue* elements = alloc_elements(arena, capacity);
+    if (!elements) return SERDEC_ERR_OUT_OF_MEMORY;
+
+    copy_elements(elements, array, 0, index);
+    if (added) elements[index] = *value;
+    copy_elements(elements + index + added, array, index + removed, count);
+    ((SerdecArrayBlock*) (elements - 1))->used = result;
+
+    *out = new_node(arena, (SerdecValue) {
+        .tag = serdec_tag(SERDEC_TYPE_ARRAY, SERDEC_ARRAY_GROWABLE, result),
+        .children = elements,
+    });
+    return *out ? SERDEC_OK : SERDEC_ERR_OUT_OF_MEMORY;
+}
+
+SerdecError serdec_array_insert(SerdecArena* arena, const SerdecValue* array, size_t index,
+                                const SerdecValue* value, const SerdecValue** out) {
+    SerdecError status = check_container(arena, array, SERDEC_TYPE_ARRAY, out);
+    if (status != SERDEC_OK) return status;
+    if (!value) return SERDEC_ERR_INVALID_HANDLE;
+
+    size_t count = serdec_tag_len(array);
+    if (index > count) return SERDEC_ERR_NOT_FOUND;
+
+    // Appending to the newest version of a growable array fills its next free slot. Older
+    // versions keep their length and never see the slot.
+    if (index == count && serdec_tag_sub(array) == SERDEC_ARRAY_GROWABLE) {
+        SerdecArrayBlock* block = serdec_array_block(array);
+        if (block->used == count && count < block->capacity) {
+            const SerdecValue* node = new_node(arena, (SerdecValue) {
+                .tag = serdec_tag(SERDEC_TYPE_ARRAY, SERDEC_ARRAY_GROWABLE, count + 1),
+                .children = array->children,
+            });
+            if (!node) return SERDEC_ERR_OUT_OF_MEMORY;
+            array->children[count] = *value;
+            block->used++;
+            *out = node;
+            return SERDEC_OK;
+        }
+    }
+    return splice(arena, array, index, 0, 1, value, out);
+}
+
+SerdecError serdec_array_replace(SerdecArena* arena, const SerdecValue* array, size_t index,
+                                 const SerdecValue* value, const SerdecValue** out) {
+    SerdecError status = check_container(arena, array, SERDEC_TYPE_ARRAY, out);
+    if (status != SERDEC_OK) return status;
+    if (!value) return SERDEC_ERR_INVALID_HANDLE;
+    if (index >= serdec_tag_len(array)) return SERDEC_ERR_NOT_FOUND;
+    return splice(arena, array, index, 1, 1, value, out);
+}
+
+SerdecError serdec_array_remove(SerdecArena* arena, const SerdecValue* array, size_t index,
+                                const SerdecValue** out) {
+    SerdecError status = check_container(arena, array, SERDEC_TYPE_ARRAY, out);
+    if (status != SERDEC_OK) return status;
+    if (index >= serdec_tag_len(array)) return SERDEC_ERR_NOT_FOUND;
+    return splice(arena, array, index, 1, 0, NULL, out);
+}
+
+// --- Objects ---
+
+static bool key_is(const SerdecValue* node, const char* key, size_t len) {
+    return serdec_tag_len(node) == len && memcmp(node->str, key, len) == 0;
+}
+
+// Allocates room for `capacity` members of a growable object, behind its block slot and
+// its index slot.
+static SerdecValue* alloc_members(SerdecArena* arena, size_t capacity) {
+    SerdecValue* slots = (SerdecValue*) serdec_arena_alloc_aligned(
+        arena, (2 + 2 * capacity) * sizeof(SerdecValue), _Alignof(SerdecValue));
+    if (!slots) return NULL;
+
+    *(SerdecArrayBlock*) slots = (SerdecArrayBlock) { .capacity = capacity };
+    *(SerdecObjectIndex*) (slots + 1) = (SerdecObjectIndex) { .arena = arena };
+    return slots + 2;
+}
+
+// Capacity of a copy that is about to grow to count members. Versions of an object share
+// one index table, so the counts of those with an index must share one table size: a power
+// of two holds counts above its half, which all get the same serdec_index_capacity().
+static size_t member_capacity(size_t count) {
+    size_t capacity = 8;
+    while (capacity < count) capacity <<= 1;
+    return capacity;
+}
+
+static SerdecError finish_object(SerdecArena* arena, SerdecValue* children, size_t count,
+                                 const SerdecValue** out) {
+    ((SerdecArrayBlock*) (children - 2))->used = count;
+    *out = new_node(arena, (SerdecValue) {
+        .tag = serdec_tag(SERDEC_TYPE_OBJECT, SERDEC_OBJECT_GROWABLE, count),
+        .children = children,
+    });
+    return *out ? SERDEC_OK : SERDEC_ERR_OUT_OF_MEMORY;
+}
+
+// Fills the next free member slot of the newest version of a growable object, if it has
+// one, and returns the new version. Its index, if built, gets the new key in place.
+static const SerdecValue* append_in_place(SerdecArena* arena, const SerdecValue* object,
+                                          const SerdecValue* key, const SerdecValue* value) {
+    size_t count = serdec_tag_len(object);
+    if (serdec_tag_sub(object) != SERDEC_OBJECT_GROWABLE) return NULL;
+    SerdecArrayBlock* block = serdec_object_block(object);
+    if (block->used != count || count == block->capacity) return NULL;
+
+    const SerdecValue* node = new_node(arena, (SerdecValue) {
+        .tag = serdec_tag(SERDEC_TYPE_OBJECT, SERDEC_OBJECT_GROWABLE, count + 1),
+        .children = object->children,
+    });
+    if (!node) return NULL;
+
+    object->children[2 * count] = *key;
+    object->children[2 * count + 1] = *value;
+    uint32_t* table = ((SerdecObjectIndex*) (object->children - 1))->table;
+    if (table) {
+        size_t mask = serdec_index_capacity(block->capacity) - 1;
+        size_t slot = serdec_key_hash(key) & mask;
+        while (table[slot]) slot = (slot + 1) & mask;
+        table[slot] = (uint32_t) (count + 1);
+    }
+    block->used++;
+    return node;
+}
+
+SerdecError serdec_object_set(SerdecArena* arena, const SerdecValue* object, const char* key,
+                              const SerdecValue* value, const SerdecValue** out) {
+    SerdecError status = check_container(arena, object, SERDEC_TYPE_OBJECT, out);
+    if (status != SERDEC_OK) return status;
+    if (!key || !value) return SERDEC_ERR_INVALID_HANDLE;
+
+    size_t count = serdec_tag_len(object);
+    size_t len = strlen(key);
+    const SerdecValue* found;
+    status = serdec_dom_find(object, key, len, false, NULL, &found);
+    if (status != SERDEC_OK && status != SERDEC_ERR_NOT_FOUND) return status;
+
+    size_t index = count;
+    SerdecValue name;
+    if (status == SERDEC_OK) {
+        index = (size_t) (found - object->children);
+        if (!serdec_object_shape(object)) index /= 2;
+    } else {
+        char* copy = serdec_arena_strdup(arena, key, len);
+        if (!copy) return SERDEC_ERR_OUT_OF_MEMORY;
+        name = (SerdecValue) { .tag = serdec_tag(SERDEC_TYPE_STRING, 0, len), .str = copy };
+
+        // Adding a member to the newest version of an edited object is in place
+        *out = append_in_place(arena, object, &name, value);
+        if (*out) return SERDEC_OK;
+    }
+
+    size_t result = count + (index == count);
+    SerdecValue* children = alloc_members(arena, (index == count) ? member_capacity(result)
+                                                                  : result);
+    if (!children) return SERDEC_ERR_OUT_OF_MEMORY;
+
+    for (size_t i = 0; i < count; i++) {
+        children[2 * i] = *serdec_member_key(object, i);
+        children[2 * i + 1] = *serdec_member_value(object, i);
+    }
+    if (index == count) children[2 * count] = name;
+    children[2 * index + 1] = *value;
+    return finish_object(arena, children, result, out);
+}
+
+SerdecError serdec_object_remove(SerdecArena* arena, const SerdecValue* object, const char* key,
+                                 const SerdecValue** out) {
+    SerdecError status = check_container(arena, object, SERDEC_TYPE_OBJECT, out);
+    if (status != SERDEC_OK) return status;
+    if (!key) return SERDEC_ERR_INVALID_HANDLE;
+
+    size_t count = serdec_tag_len(object);
+    size_t len = strlen(key);
+    size_t matches = 0;
+    for (size_t i = 0; i < count; i++)
+        matches += key_is(serdec_member_key(object, i), key, len);
+    if (!matches) return SERDEC_ERR_NOT_FOUND;
+
+    size_t result = count - matches;
+    SerdecValue* children = alloc_members(arena, result);
+    if (!children) return SERDEC_ERR_OUT_OF_MEMORY;
+
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++) {
+        const SerdecValue* name = serdec_member_key(object, i);
+        if (key_is(name, key, len)) continue;
+        children[2 * n] = *name;
+        children[2 * n + 1] = *serdec_member_value(object, i);
+        n++;
+    }
+    return finish_object(arena, children, result, out);
+}
@@ -0,0 +1,351 @@
+#include "internal.h"
+#include <serdec/dom.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Finalizer of MurmurHash3: every input bit affects every output bit.
+static uint64_t mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+static uint64_t type_seed(SerdecValueType type) {
+    return 0x9E3779B97F4A7C15ull * ((uint64_t) type + 1);
+}
+
+// --- Numbers ---
+
+// Returns a number with any integral double turned into the integer it equals, so that
+// 1, 1.0 and 1e0 compare and hash the same.
+static SerdecValue canonical_number(const SerdecValue* v) {
+    if (serdec_tag_sub(v) != SERDEC_NUMBER_DOUBLE || v->f64 != trunc(v->f64)) return *v;
+
+    double d = v->f64;
+    if (d >= 0 && d < 18446744073709551616.0) {
+        return (SerdecValue) { .tag = serdec_tag(SERDEC_TYPE_NUMBER, SERDEC_NUMBER_UINT, 0),
+                               .u64 = (uint64_t) d };
+    }
+    if (d < 0 && d >= -9223372036854775808.0) {
+        return (SerdecValue) { .tag = serdec_tag(SERDEC_TYPE_NUMBER, SERDEC_NUMBER_INT, 0),
+                               .i64 = (int64_t) d };
+    }
+    return *v;
+}
+
+static bool number_equal(const SerdecValue* a, const SerdecValue* b) {
+    SerdecValue x = canonical_number(a);
+    SerdecValue y = canonical_number(b);
+    if (serdec_tag_sub(&x) != serdec_tag_sub(&y)) return false;
+    return (serdec_tag_sub(&x) == SERDEC_NUMBER_DOUBLE) ? x.f64 == y.f64 : x.u64 == y.u64;
+}
+
+static uint64_t number_hash(const SerdecValue* v) {
+    SerdecValue x = canonical_number(v);
+    return mix(x.u64 ^ (type_seed(SERDEC_TYPE_NUMBER) + serdec_tag_sub(&x)));
+}
+
+// --- Strings ---
+
+// Decoded bytes of a string node. Strings with escapes are decoded into small, or into
+// heap if they do not fit.
+typedef struct {
+    const char* ptr;
+    size_t len;
+    char* heap;
+    char small[256];
+} StringView;
+
+static void view_string(const SerdecValue* v, StringView* s) {
+    s->ptr = v->str;
+    s->len = serdec_tag_len(v);
+    s->heap = NULL;
+    if (serdec_tag_sub(v) != SERDEC_STRING_ESCAPED) return;
+
+    char* dst = (s->len < sizeof(s->small)) ? s->small : (s->heap = malloc(s->len + 1));
+    size_t len;
+    // The parser validated the escapes; if decoding still fails the raw bytes stand in
+    if (dst && serdec_string_unescape_to(dst, v->str, s->len, &len) == SERDEC_OK) {
+        s->ptr = dst;
+        s->len = len;
+    }
+}
+
+static bool string_equal(const SerdecValue* a, const SerdecValue* b) {
+    if (a->str == b->str && a->tag == b->tag) return true;
+    if (serdec_tag_sub(a) != SERDEC_STRING_ESCAPED && serdec_tag_sub(b) != SERDEC_STRING_ESCAPED)
+        return serdec_tag_len(a) == serdec_tag_len(b) &&
+               memcmp(a->str, b->str, serdec_tag_len(a)) == 0;
+
+    StringView x, y;
+    view_string(a, &x);
+    view_string(b, &y);
+    bool equal = x.len == y.len && memcmp(x.ptr, y.ptr, x.len) == 0;
+    free(x.heap);
+    free(y.heap);
+    return equal;
+}
+
+static uint64_t string_hash(const SerdecValue* v) {
+    if (serdec_tag_sub(v) == SERDEC_STRING_INTERNED) return serdec_intern_entry(v->str)->hash;
+
+    StringView s;
+    view_string(v, &s);
+    uint64_t hash = serdec_hash(s.ptr, s.len);
+    free(s.heap);
+    return hash;
+}
+
+// --- Containers ---
+
+static const SerdecValue* element(const SerdecValue* array, size_t i, SerdecValue* scratch) {
+    if (!serdec_is_packed(array)) return &array->children[i];
+    *scratch = serdec_packed_node(array, i);
+    return scratch;
+}
+
+// True unless an earlier member of object has the same key. Later duplicates are
+// invisible to lookups, so they do not take part in equality or hashing either.
+static bool visible_member(const SerdecValue* object, size_t i) {
+    if (!i) return true;
+    const SerdecValue* key = serdec_member_key(object, i);
+    const SerdecValue* found;
+    bool interned = serdec_tag_sub(key) == SERDEC_STRING_INTERNED;
+    return serdec_dom_find(object, key->str, serdec_tag_len(key), interned, NULL,
+                           &found) == SERDEC_OK &&
+           found == serdec_member_value(object, i);
+}
+
+static size_t visible_count(const SerdecValue* object) {
+    size_t count = 0;
+    for (size_t i = 0; i < serdec_tag_len(object); i++) count += visible_member(object, i);
+    return count;
+}
+
+// Containers being walked, innermost last. The first frames live in `local`, so shallow
+// values are walked without allocating.
+#define WALK_LOCAL_FRAMES 32
+
+typedef struct {
+    const SerdecValue* a;     // Container being compared or hashed
+    const SerdecValue* b;     // Equality: the container it is compared with
+    size_t index;             // Next child of a
+    size_t visible;           // Equality of objects: visible members of a so far
+    uint64_t hash;            // Hashing: children combined so far
+    uint64_t key;             // Hashing of objects: key hash of member index - 1
+} WalkFrame;
+
+typedef struct {
+    WalkFrame* frames;
+    size_t depth;
+    size_t capacity;
+    WalkFrame local[WALK_LOCAL_FRAMES];
+} WalkStack;
+
+static void walk_init(WalkStack* s) {
+    s->frames = s->local;
+    s->depth = 0;
+    s->capacity = WALK_LOCAL_FRAMES;
+}
+
+static void walk_free(WalkStack* s) {
+    if (s->frames != s->local) free(s->frames);
+}
+
+static WalkFrame* walk_push(WalkStack* s, WalkFrame frame) {
+    if (s->depth == s->capacity) {
+        WalkFrame* frames = (WalkFrame*) malloc(2 * s->capacity * sizeof(*frames));
+        if (!frames) return NULL;
+        memcpy(frames, s->frames, s->depth * sizeof(*frames));
+        walk_free(s);
+        s->frames = frames;
+        s->capacity *= 2;
+    }
+    s->frames[s->depth] = frame;
+    return &s->frames[s->depth++];
+}
+
+static bool is_container(SerdecValueType type) {
+    return type == SERDEC_TYPE_ARRAY || type == SERDEC_TYPE_OBJECT;
+}
+
+// Compares a and b without looking at their children. Sets *walk if they are containers
+// whose children must be compared.
+static bool shallow_equal(const SerdecValue* a, const SerdecValue* b, bool* walk) {
+    *walk = false;
+    if (a == b) return true;
+    if (!a || !b) return false;
+
+    SerdecValueType type = serdec_tag_type(a);
+    if (type != serdec_tag_type(b)) return false;
+
+    switch (type) {
+    case SERDEC_TYPE_NULL:
+        return true;
+    case SERDEC_TYPE_BOOL:
+        return a->boolean == b->boolean;
+    case SERDEC_TYPE_NUMBER:
+        return number_equal(a, b);
+    case SERDEC_TYPE_STRING:
+        return string_equal(a, b);
+    default:
+        break;
+    }
+
+    if (serdec_dom_expand(a) != SERDEC_OK || serdec_dom_expand(b) != SERDEC_OK) return false;
+    if (a->tag == b->tag && a->children == b->children) return true;   // Shared subtree
+
+    size_t count = serdec_tag_len(a);
+    if (type == SERDEC_TYPE_ARRAY) {
+        if (count != serdec_tag_len(b)) return false;
+        if (serdec_tag_sub(a) == SERDEC_ARRAY_I64 && serdec_tag_sub(b) == SERDEC_ARRAY_I64) {
+            return memcmp(serdec_packed_data(a->packed), serdec_packed_data(b->packed),
+                          count * sizeof(int64_t)) == 0;
+        }
+    }
+    *walk = true;
+    return true;
+}
+
+// Next pair of children of the container on top of the stack to compare, or false once
+// it has none left. Objects pair each visible member of a with b's member of that key;
+// *equal turns false if b lacks it, or if b has keys that a does not.
+static bool next_pair(WalkFrame* f, const SerdecValue** x, const SerdecValue** y,
+                      SerdecValue scratch[2], bool* equal) {
+    size_t count = serdec_tag_len(f->a);
+    if (serdec_tag_type(f->a) == SERDEC_TYPE_ARRAY) {
+        if (f->index == count) return false;
+        *x = element(f->a, f->index, &scratch[0]);
+        *y = element(f->b, f->index, &scratch[1]);
+        f->index++;
+        return true;
+    }
+
+    for (; f->index < count; f->index++) {
+        if (!visible_member(f->a, f->index)) continue;
+        f->visible++;
+
+        const SerdecValue* key = serdec_member_key(f->a, f->index);
+        bool interned = serdec_tag_sub(key) == SERDEC_STRING_INTERNED;
+        if (serdec_dom_find(f->b, key->str, serdec_tag_len(key), interned, NULL,
+                            y) != SERDEC_OK) {
+            *equal = false;
+            return false;
+        }
+        *x = serdec_member_value(f->a, f->index++);
+        return true;
+    }
+
+    // Every visible key of a is in b; the key sets match if b has no others
+    if (f->visible != count || count != serdec_tag_len(f->b))
+        *equal = (f->visible == visible_count(f->b));
+    return false;
+}
+
+bool serdec_value_equal(const SerdecValue* a, const SerdecValue* b) {
+    WalkStack stack;
+    walk_init(&stack);
+    SerdecValue scratch[2];
+    bool equal = true;
+
+    for (;;) {
+        bool walk;
+        equal = shallow_equal(a, b, &walk);
+        if (walk && !walk_push(&stack, (WalkFrame) { .a = a, .b = b })) equal = false;
+        if (!equal) break;
+
+        // Move on to the next pair, leaving the containers that are done
+        while (stack.depth &&
+               !next_pair(&stack.frames[stack.depth - 1], &a, &b, scratch, &equal)) {
+            if (!equal) break;
+            stack.depth--;
+        }
+        if (!equal || !stack.depth) break;
+    }
+
+    walk_free(&stack);
+    return equal;
+}
+
+static uint64_t scalar_hash(const SerdecValue* value, SerdecValueType type) {
+    uint64_t seed = type_seed(type);
+    switch (type) {
+    case SERDEC_TYPE_BOOL:
+        return mix(seed + value->boolean);
+    case SERDEC_TYPE_NUMBER:
+        return number_hash(value);
+    case SERDEC_TYPE_STRING:
+        return mix(seed ^ string_hash(value));
+    default:
+        return mix(seed);
+    }
+}
+
+// Combines the hash of the child the frame last handed out.
+static void add_child_hash(WalkFrame* f, uint64_t hash) {
+    if (serdec_tag_type(f->a) == SERDEC_TYPE_ARRAY) {
+        f->hash = mix(f->hash ^ hash) + (f->index - 1);
+        return;
+    }
+    // Members combine by addition, so the hash does not depend on their order
+    f->hash += mix(mix(f->key) ^ hash);
+}
+
+// Next child of the container on top of the stack to hash, or NULL once it has none left.
+static const SerdecValue* next_child(WalkFrame* f, SerdecValue* scratch) {
+    size_t count = serdec_tag_len(f->a);
+    if (serdec_tag_type(f->a) == SERDEC_TYPE_ARRAY)
+        return (f->index < count) ? element(f->a, f->index++, scratch) : NULL;
+
+    for (; f->index < count; f->index++) {
+        if (!visible_member(f->a, f->index)) continue;
+        f->key = string_hash(serdec_member_key(f->a, f->index));
+        return serdec_member_value(f->a, f->index++);
+    }
+    return NULL;
+}
+
+uint64_t serdec_value_hash(const SerdecValue* value) {
+    WalkStack stack;
+    walk_init(&stack);
+    SerdecValue scratch;
+    uint64_t hash;
+
+    for (;;) {
+        SerdecValueType type = serdec_value_type(value);
+        if (is_container(type)) {
+            // A container that fails to expand hashes as empty, as serdec_value_size()
+            // reports, and so does one too deep to walk
+            bool walk = serdec_dom_expand(value) == SERDEC_OK && serdec_tag_len(value);
+            if (walk && walk_push(&stack, (WalkFrame) { .a = value, .hash = type_seed(type) })) {
+                value = next_child(&stack.frames[stack.depth - 1], &scratch);
+                if (value) continue;
+                stack.depth--;
+            }
+            hash = mix(type_seed(type));
+        } else {
+            hash = scalar_hash(value, type);
+        }
+
+        // Fold finished containers into their parents until one has a child left
+        value = NULL;
+        while (stack.depth) {
+            WalkFrame* f = &stack.frames[stack.depth - 1];
+            add_child_hash(f, hash);
+            value = next_child(f, &scratch);
+            if (value) break;
+            hash = mix(f->hash);
+            stack.depth--;
+        }
+        if (!value) break;
+    }
+
+    walk_free(&stack);
+    return hash;
+}
@@ -1,6 +1,7 @@
 #include "internal.h"
 #include <stddef.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 const char* serdec_error_string(SerdecError code) {
     switch (code) {
@@ -10,6 +11,7 @@ const char* serdec_error_string(SerdecError code) {
     case SERDEC_ERR_UNEXPECTED_EOF:      return "Unexpected EOF";
     case SERDEC_ERR_INVALID_VALUE:       return "Invalid Value";
     case SERDEC_ERR_TRAILING_CHARS:      return "Trailing Characters";
+    case SERDEC_ERR_DUPLICATE_KEY:       return "Duplicate Key";
 
     case SERDEC_ERR_INVALID_ESCAPE:      return "Invalid Escape";
     case SERDEC_ERR_INVALID_UTF8:        return "Invalid UTF-8";
@@ -27,6 +29,10 @@ const char* serdec_error_string(SerdecError code) {
 
     case SERDEC_ERR_INVALID_HANDLE:      return "Invalid Handle";
 
+    case SERDEC_ERR_TYPE_MISMATCH:       return "Type Mismatch";
+    case SERDEC_ERR_NOT_FOUND:           return "Not Found";
+    case SERDEC_ERR_INVALID_PATH:        return "Invalid Path";
+
     default:                             return "Unknown Error";
     }
 }
@@ -53,3 +59,75 @@ void serdec_error_format(const SerdecErrorInfo *info, char *buf, size_t bufsize)
     if (info->message[0] != '\0')
         snprintf(buf + pos, bufsize - pos, "Message: %s", info->message);
 }
+
+SerdecErrorList* serdec_error_list_create(void) {
+    SerdecErrorList* list = (SerdecErrorList*) malloc(sizeof(*list));
+    if (!list) return NULL;
+
+    *list = (SerdecErrorList) { .magic = SERDEC_MAGIC_ERRORS };
+    return list;
+}
+
+void serdec_error_list_destroy(SerdecErrorList* list) {
+    if (!list || list->magic != SERDEC_MAGIC_ERRORS) return;
+
+    list->magic = SERDEC_MAGIC_FREED;
+    free(list->items);
+    free(list);
+}
+
+size_t serdec_error_list_count(const SerdecErrorList* list) {
+    if (!list || list->magic != SERDEC_MAGIC_ERRORS) return 0;
+    return list->count;
+}
+
+const SerdecErrorInfo* serdec_error_list_get(const SerdecErrorList* list, size_t index) {
+    if (!list || list->magic != SERDEC_MAGIC_ERRORS || index >= list->count) return NULL;
+    return &list->items[index];
+}
+
+void serdec_error_list_clear(SerdecErrorList* list) {
+    if (!list || list->magic != SERDEC_MAGIC_ERRORS) return;
+    list->count = 0;
+}
+
+bool serdec_error_list_push(SerdecErrorList* list, const SerdecErrorInfo* info) {
+    if (!list || list->magic != SERDEC_MAGIC_ERRORS || !info) return false;
+
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 16;
+        SerdecErrorInfo* items = realloc(list->items, capacity * sizeof(*items));
+        if (!items) return false;
+        list->items = items;
+        list->capacity = capacity;
+    }
+
+    list->items[list->count++] = *info;
+    return true;
+}
+
+static int compare_offset(const void* a, const void* b) {
+    size_t lhs = ((const SerdecErrorInfo*) a)->offset;
+    size_t rhs = ((const SerdecErrorInfo*) b)->offset;
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+void serdec_error_list_sort(SerdecErrorList* list, size_t from) {
+    if (!list || list->magic != SERDEC_MAGIC_ERRORS || from >= list->count) return;
+    qsort(list->items + from, list->count - from, sizeof(SerdecErrorInfo), compare_offset);
+}
+
+void serdec_error_set_context(SerdecErrorInfo* info, const char* data, size_t begin, size_t end) {
+    if (!info || !data || begin > end) return;
+
+    size_t max = sizeof(info->context) - 1;
+    size_t from = (info->offset > begin + max / 2) ? info->offset - max / 2 : begin;
+    size_t to = (end - from > max) ? from + max : end;
+
+    size_t len = 0;
+    for (size_t i = from; i < to; i++) {
+        unsigned char c = (unsigned char) data[i];
+        info->context[len++] = (c < 0x20) ? ' ' : (char) c;
+    }
+    info->context[len] = '\0';
+}
@@ -0,0 +1,289 @@
+#include "internal.h"
+#include <serdec/ndjson.h>
+#include <serdec/json.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Terms are tracked one bit each
+#define FILTER_MAX_TERMS 64
+
+// Bytes ordered from most to least common in typical JSON logs. Bytes not listed are rarer
+// still. The prefilter searches for the rarest byte of each needle.
+static const char FILTER_COMMON_BYTES[] = "\"e:,tas0roi1nl2dc3u5m4p9h6_78.-/TZ";
+
+typedef struct {
+    const char* key;
+    size_t len;
+} FilterKey;
+
+typedef struct {
+    size_t first_key;         // Member path: keys [first_key, first_key + depth)
+    size_t depth;             // 0 tests the record itself
+    SerdecComparison compare;
+} FilterTerm;
+
+// Bytes every passing record contains, unless it has escapes.
+typedef struct {
+    const char* text;
+    size_t len;
+    size_t anchor;            // Position of the rarest byte of text
+} FilterNeedle;
+
+struct SerdecNdjsonFilter {
+    uint32_t magic;           // 0x5EDEC016 for validation
+    size_t count;
+    size_t needle_count;
+    FilterTerm* terms;        // The arrays follow the struct, then decoded keys and literals
+    FilterNeedle* needles;
+    FilterKey* keys;
+};
+
+static uint64_t bit(size_t term) {
+    return (uint64_t) 1 << term;
+}
+
+static uint64_t all_terms(const SerdecNdjsonFilter* filter) {
+    return (filter->count == FILTER_MAX_TERMS) ? UINT64_MAX : bit(filter->count) - 1;
+}
+
+static size_t byte_rank(char c) {
+    const char* found = c ? strchr(FILTER_COMMON_BYTES, c) : NULL;
+    return found ? (size_t) (found - FILTER_COMMON_BYTES) : sizeof(FILTER_COMMON_BYTES);
+}
+
+static void add_needle(SerdecNdjsonFilter* filter, const char* text, size_t len) {
+    size_t anchor = 0;
+    for (size_t i = 1; i < len; i++) {
+        if (byte_rank(text[i]) > byte_rank(text[anchor])) anchor = i;
+    }
+    filter->needles[filter->needle_count++] = (FilterNeedle) {
+        .text = text, .len = len, .anchor = anchor,
+    };
+}
+
+// Reads a key after an opening quote, so that the key and its quotes can serve as a needle
+// once quote_string() replaces the NUL after it.
+static SerdecError read_key(SerdecQueryText* c, bool quoted, const char** out, size_t* len) {
+    *c->strings++ = '"';
+    return quoted ? serdec_query_read_quoted(c, out, len)
+                  : serdec_query_read_name(c, " \t.[<>=!&", out, len);
+}
+
+// Returns text between quotes. text must follow a reserved quote byte.
+static const char* quote_string(const char* text, size_t len) {
+    char* quoted = (char*) text - 1;
+    quoted[len + 1] = '"';
+    return quoted;
+}
+
+// "@", a member path of ".name" and "['name']" steps, and an optional comparison.
+static SerdecError read_term(SerdecQueryText* c, SerdecNdjsonFilter* filter,
+                             size_t* key_count) {
+    FilterTerm* term = &filter->terms[filter->count];
+    *term = (FilterTerm) { .first_key = *key_count };
+
+    serdec_query_skip_space(c);
+    if (*c->p++ != '@') return SERDEC_ERR_INVALID_PATH;
+
+    SerdecError status = SERDEC_OK;
+    while (status == SERDEC_OK && (*c->p == '.' || *c->p == '[')) {
+        FilterKey* key = &filter->keys[(*key_count)++];
+        if (*c->p++ == '.') {
+            status = read_key(c, false, &key->key, &key->len);
+            continue;
+        }
+        serdec_query_skip_space(c);
+        if (*c->p != '\'' && *c->p != '"') return SERDEC_ERR_INVALID_PATH;
+        status = read_key(c, true, &key->key, &key->len);
+        serdec_query_skip_space(c);
+        if (status == SERDEC_OK && *c->p++ != ']') return SERDEC_ERR_INVALID_PATH;
+    }
+    if (status != SERDEC_OK) return status;
+    term->depth = *key_count - term->first_key;
+
+    // Room for the opening quote of a string literal
+    *c->strings++ = '"';
+    status = serdec_query_read_comparison(c, &term->compare);
+    if (status != SERDEC_OK) return status;
+
+    // A passing record holds the last key, unless the term holds for a missing value
+    SerdecComparison* cmp = &term->compare;
+    if (term->depth && cmp->op != SERDEC_COMPARE_NE) {
+        const FilterKey* last = &filter->keys[*key_count - 1];
+        add_needle(filter, quote_string(last->key, last->len), last->len + 2);
+    }
+    // Numbers are not searched for: 5e2 and 500.0 equal 500
+    if (cmp->op == SERDEC_COMPARE_EQ && cmp->type == SERDEC_EVENT_STRING)
+        add_needle(filter, quote_string(cmp->text, cmp->text_len), cmp->text_len + 2);
+    else if (cmp->op == SERDEC_COMPARE_EQ && cmp->type == SERDEC_EVENT_BOOL)
+        add_needle(filter, cmp->boolean ? "true" : "false", cmp->boolean ? 4 : 5);
+    else if (cmp->op == SERDEC_COMPARE_EQ && cmp->type == SERDEC_EVENT_NULL)
+        add_needle(filter, "null", 4);
+
+    filter->count++;
+    return SERDEC_OK;
+}
+
+SerdecError serdec_ndjson_filter_compile(const char* text, SerdecNdjsonFilter** out) {
+    if (!text || !out) return SERDEC_ERR_INVALID_HANDLE;
+    *out = NULL;
+
+    // Every term starts with '@' and every key with '.' or '['. Decoded strings are no
+    // longer than their source, plus a NUL each, one byte serdec_string_unescape_to() may
+    // write, and an opening quote.
+    size_t len = strlen(text);
+    size_t terms = 1;
+    size_t keys = 0;
+    for (const char* p = text; *p; p++) {
+        terms += (*p == '@');
+        keys += (*p == '.' || *p == '[');
+    }
+    SerdecNdjsonFilter* filter = (SerdecNdjsonFilter*) malloc(
+        sizeof(*filter) + terms * (sizeof(FilterTerm) + 2 * sizeof(FilterNeedle)) +
+        keys * sizeof(FilterKey) + len + 3 * (keys + terms));
+    if (!filter) return SERDEC_ERR_OUT_OF_MEMORY;
+    filter->magic = SERDEC_MAGIC_FILTER;
+    filter->count = 0;
+    filter->needle_count = 0;
+    filter->terms = (FilterTerm*) (filter + 1);
+    filter->needles = (FilterNeedle*) (filter->terms + terms);
+    filter->keys = (FilterKey*) (filter->needles + 2 * terms);
+
+    SerdecQueryText c = { .p = text, .strings = (char*) (filter->keys + keys) };
+    size_t key_count = 0;
+    SerdecError status = SERDEC_OK;
+    for (;;) {
+        if (filter->count == FILTER_MAX_TERMS) status = SERDEC_ERR_INVALID_PATH;
+        else status = read_term(&c, filter, &key_count);
+        if (status != SERDEC_OK || strncmp(c.p, "&&", 2) != 0) break;
+        c.p += 2;
+    }
+    if (status == SERDEC_OK && *c.p) status = SERDEC_ERR_INVALID_PATH;
+    if (status != SERDEC_OK) {
+        free(filter);
+        return status;
+    }
+
+    *out = filter;
+    return SERDEC_OK;
+}
+
+void serdec_ndjson_filter_destroy(SerdecNdjsonFilter* filter) {
+    if (!filter || filter->magic != SERDEC_MAGIC_FILTER) return;
+    filter->magic = SERDEC_MAGIC_FREED;
+    free(filter);
+}
+
+bool serdec_ndjson_filter_valid(const SerdecNdjsonFilter* filter) {
+    return filter && filter->magic == SERDEC_MAGIC_FILTER;
+}
+
+static bool contains(const FilterNeedle* needle, const char* data, size_t len) {
+    if (len < needle->len) return false;
+
+    // Candidate positions of the anchor byte; the last byte is checked before the rest
+    const char* p = data + needle->anchor;
+    const char* end = data + len - needle->len + needle->anchor + 1;
+    char last = needle->text[needle->len - 1];
+    while (p < end && (p = memchr(p, needle->text[needle->anchor], (size_t) (end - p)))) {
+        const char* start = p - needle->anchor;
+        if (start[needle->len - 1] == last && memcmp(start, needle->text, needle->len) == 0)
+            return true;
+        p++;
+    }
+    return false;
+}
+
+bool serdec_ndjson_filter_prefilter(const SerdecNdjsonFilter* filter, const char* data,
+                                    size_t len) {
+    for (size_t i = 0; i < filter->needle_count; i++) {
+        // An escape may spell a needle differently
+        if (!contains(&filter->needles[i], data, len)) return memchr(data, '\\', len) != NULL;
+    }
+    return true;
+}
+
+typedef struct {
+    const SerdecNdjsonFilter* filter;
+    SerdecParser* parser;
+    uint64_t open;            // Terms not decided yet
+    bool pass;
+} FilterWalk;
+
+// Reads the value whose first event is ev, depth members below the record. `path` holds
+// the terms whose first depth keys lead here. Returns early once the record is decided.
+static SerdecError walk(FilterWalk* fw, SerdecEvent* ev, size_t depth, uint64_t path) {
+    const SerdecNdjsonFilter* filter = fw->filter;
+
+    uint64_t deeper = 0;
+    uint64_t rest = path & fw->open;
+    for (size_t i = 0; rest; i++, rest >>= 1) {
+        if (!(rest & 1)) continue;
+        const FilterTerm* term = &filter->terms[i];
+        if (term->depth > depth) {
+            deeper |= bit(i);
+            continue;
+        }
+        fw->open &= ~bit(i);
+        if (!serdec_comparison_test(&term->compare, ev, fw->parser)) {
+            fw->pass = false;
+            return SERDEC_OK;
+        }
+    }
+
+    if (ev->kind != SERDEC_EVENT_START_OBJECT && ev->kind != SERDEC_EVENT_START_ARRAY)
+        return SERDEC_OK;
+    if (!fw->open) return SERDEC_OK;
+    if (ev->kind != SERDEC_EVENT_START_OBJECT || !deeper) return serdec_json_skip(fw->parser);
+
+    for (;;) {
+        SerdecError status = serdec_json_event_next(fw->parser, ev);
+        if (status != SERDEC_OK || ev->kind == SERDEC_EVENT_END_OBJECT) return status;
+
+        uint64_t next = 0;
+        rest = deeper & fw->open;
+        for (size_t i = 0; rest; i++, rest >>= 1) {
+            if (!(rest & 1)) continue;
+            // Only terms deeper than depth have a key at this level
+            const FilterKey* key = &filter->keys[filter->terms[i].first_key + depth];
+            if (serdec_string_equals(ev->string, key->key, key->len)) next |= bit(i);
+        }
+
+        status = serdec_json_event_next(fw->parser, ev);
+        if (status == SERDEC_OK && next) {
+            status = walk(fw, ev, depth + 1, next);
+            if (!fw->pass || !fw->open) return status;
+        } else if (status == SERDEC_OK && (ev->kind == SERDEC_EVENT_START_OBJECT ||
+                                           ev->kind == SERDEC_EVENT_START_ARRAY)) {
+            status = serdec_json_skip(fw->parser);
+        }
+        if (status != SERDEC_OK) return status;
+    }
+}
+
+SerdecError serdec_ndjson_filter_test(const SerdecNdjsonFilter* filter, SerdecParser* parser,
+                                      bool* pass) {
+    if (!serdec_ndjson_filter_valid(filter) || !parser || parser->magic != SERDEC_MAGIC_PARSER ||
+        !pass)
+        return SERDEC_ERR_INVALID_HANDLE;
+
+    SerdecEvent ev;
+    SerdecError status = serdec_json_event_next(parser, &ev);
+    if (status != SERDEC_OK) return status;
+    if (ev.kind == SERDEC_EVENT_END) return SERDEC_ERR_NOT_FOUND;
+
+    FilterWalk fw = { .filter = filter, .parser = parser, .open = all_terms(filter),
+                      .pass = true };
+    status = walk(&fw, &ev, 0, fw.open);
+    if (status != SERDEC_OK) return status;
+
+    // Terms whose value was not found apply to a missing value
+    for (size_t i = 0; fw.pass && i < filter->count; i++) {
+        if ((fw.open & bit(i)) && !serdec_comparison_test(&filter->terms[i].compare, NULL, parser))
+            fw.pass = false;
+    }
+    *pass = fw.pass;
+    return SERDEC_OK;
+}
@@ -0,0 +1,407 @@
+#include "internal.h"
+#include <serdec/index.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INDEX_VERSION 1
+
+// A container whose children are indexed.
+typedef struct {
+    uint64_t open;            // Offset of '[' or '{'
+    uint64_t close;           // Offset of the matching bracket
+    uint64_t first;           // Position of its first child in offsets
+    uint64_t count;
+} IndexContainer;
+
+struct SerdecJsonIndex {
+    uint32_t magic;           // 0x5EDEC012 for validation
+    size_t depth;
+    uint64_t input_size;
+    uint64_t input_hash;
+    uint64_t root;            // Offset of the root value
+    IndexContainer* containers;   // Sorted by opening offset
+    size_t container_count;
+    uint64_t* offsets;        // Child starts; the children of a container are contiguous
+    size_t offset_count;
+};
+
+typedef struct {
+    char magic[8];            // "SERDECI"
+    uint32_t version;
+    uint32_t byte_order;      // 0x01020304 as written
+    uint64_t depth;
+    uint64_t input_size;
+    uint64_t input_hash;
+    uint64_t root;
+    uint64_t container_count;
+    uint64_t offset_count;
+} IndexHeader;
+
+static const char index_magic[8] = "SERDECI";
+
+// --- Building ---
+
+// Children of the open container at one level, until it closes.
+typedef struct {
+    uint64_t* items;
+    size_t count;
+    size_t capacity;
+    size_t container;         // Its position in containers
+} IndexLevel;
+
+typedef struct {
+    SerdecJsonIndex* index;
+    size_t container_capacity;
+    size_t offset_capacity;
+    IndexLevel* levels;
+} Builder;
+
+static bool add_child(IndexLevel* level, uint64_t offset) {
+    if (!serdec_sidecar_grow((void**) &level->items, &level->capacity, level->count,
+                             sizeof(uint64_t)))
+        return false;
+    level->items[level->count++] = offset;
+    return true;
+}
+
+static bool open_container(Builder* b, IndexLevel* level, uint64_t offset) {
+    SerdecJsonIndex* index = b->index;
+    if (!serdec_sidecar_grow((void**) &index->containers, &b->container_capacity,
+                             index->container_count, sizeof(IndexContainer)))
+        return false;
+    level->container = index->container_count;
+    level->count = 0;
+    index->containers[index->container_count++] = (IndexContainer) { .open = offset };
+    return true;
+}
+
+static bool close_container(Builder* b, IndexLevel* level, uint64_t offset) {
+    SerdecJsonIndex* index = b->index;
+    size_t needed = index->offset_count + level->count;
+    if (needed > b->offset_capacity) {
+        size_t capacity = b->offset_capacity ? b->offset_capacity : 64;
+        while (capacity < needed) capacity *= 2;
+        uint64_t* offsets = realloc(index->offsets, capacity * sizeof(*offsets));
+        if (!offsets) return false;
+        index->offsets = offsets;
+        b->offset_capacity = capacity;
+    }
+
+    IndexContainer* c = &index->containers[level->container];
+    c->close = offset;
+    c->first = index->offset_count;
+    c->count = level->count;
+    if (level->count)
+        memcpy(index->offsets + index->offset_count, level->items, level->count * sizeof(uint64_t));
+    index->offset_count = needed;
+    return true;
+}
+
+// One pass over the input. A child starts at the first byte that is not whitespace after
+// the opening bracket or a comma of an indexed container; strings are skipped whole so
+// brackets and commas inside them are not structure.
+static SerdecError scan(Builder* b, const char* data, size_t size) {
+    size_t max = b->index->depth;
+    size_t depth = 0;
+    bool pending = false;     // The next value starts a child at level depth - 1
+    bool root = true;
+
+    for (size_t i = 0; i < size; i++) {
+        char c = data[i];
+        switch (c) {
+        case ' ': case '\t': case '\n': case '\r': case ':':
+            continue;
+        default:
+            break;
+        }
+
+        if (root) {
+            b->index->root = i;
+            root = false;
+        }
+        // A bracket right after the opening one closes an empty container
+        if (pending && c != ']' && c != '}' && !add_child(&b->levels[depth - 1], i))
+            return SERDEC_ERR_OUT_OF_MEMORY;
+        pending = false;
+
+        switch (c) {
+        case '"': {
+            const char* quote = data + i;
+            do {
+                quote = memchr(quote + 1, '"', (size_t) (data + size - quote - 1));
+            } while (quote && serdec_scan_escaped_at(data, (size_t) (quote - data)));
+            if (!quote) return SERDEC_ERR_UNEXPECTED_EOF;
+            i = (size_t) (quote - data);
+            break;
+        }
+        case '[': case '{':
+            if (depth < max) {
+                if (!open_container(b, &b->levels[depth], i)) return SERDEC_ERR_OUT_OF_MEMORY;
+                pending = true;
+            }
+            depth++;
+            break;
+        case ']': case '}':
+            if (!depth) return SERDEC_ERR_UNEXPECTED_CHAR;
+            depth--;
+            if (depth < max && !close_container(b, &b->levels[depth], i))
+                return SERDEC_ERR_OUT_OF_MEMORY;
+            break;
+        case ',':
+            pending = depth && depth <= max;
+            break;
+        default:
+            break;
+        }
+    }
+    if (root) b->index->root = size;
+    return depth ? SERDEC_ERR_UNEXPECTED_EOF : SERDEC_OK;
+}
+
+SerdecError serdec_json_index_build(const SerdecBuffer* buf, const SerdecJsonIndexConfig* config,
+                                    SerdecJsonIndex** out) {
+    if (!buf || !out) return SERDEC_ERR_INVALID_HANDLE;
+    *out = NULL;
+
+    SerdecJsonIndex* index = calloc(1, sizeof(*index));
+    if (!index) return SERDEC_ERR_OUT_OF_MEMORY;
+    index->magic = SERDEC_MAGIC_INDEX;
+    index->depth = (config && config->depth) ? config->depth : 1;
+
+    const char* data = serdec_buffer_data(buf);
+    size_t size = serdec_buffer_size(buf);
+    index->input_size = size;
+    index->input_hash = serdec_input_hash(data, size);
+
+    Builder b = { .index = index, .levels = calloc(index->depth, sizeof(IndexLevel)) };
+    SerdecError status = b.levels ? scan(&b, data, size) : SERDEC_ERR_OUT_OF_MEMORY;
+    if (b.levels) {
+        for (size_t i = 0; i < index->depth; i++) free(b.levels[i].items);
+        free(b.levels);
+    }
+
+    if (status != SERDEC_OK) {
+        serdec_json_index_destroy(index);
+        return status;
+    }
+    *out = index;
+    return SERDEC_OK;
+}
+
+void serdec_json_index_destroy(SerdecJsonIndex* index) {
+    if (!index || index->magic != SERDEC_MAGIC_INDEX) return;
+    index->magic = SERDEC_MAGIC_FREED;
+    free(index->containers);
+    free(index->offsets);
+    free(index);
+}
+
+// --- Persistence ---
+
+SerdecError serdec_json_index_save(const SerdecJsonIndex* index, const char* path) {
+    if (!index || index->magic != SERDEC_MAGIC_INDEX || !path) return SERDEC_ERR_INVALID_HANDLE;
+
+    IndexHeader header = {
+        .version = INDEX_VERSION,
+        .byte_order = 0x01020304,
+        .depth = index->depth,
+        .input_size = index->input_size,
+        .input_hash = index->input_hash,
+        .root = index->root,
+        .container_count = index->container_count,
+        .offset_count = index->offset_count,
+    };
+    memcpy(header.magic, index_magic, sizeof(header.magic));
+
+    FILE* fp = fopen(path, "wb");
+    if (!fp) return SERDEC_ERR_FILE_NOT_FOUND;
+    size_t containers = index->container_count;
+    size_t offsets = index->offset_count;
+    bool written =
+        fwrite(&header, sizeof(header), 1, fp) == 1 &&
+        (!containers ||
+         fwrite(index->containers, sizeof(IndexContainer), containers, fp) == containers) &&
+        (!offsets || fwrite(index->offsets, sizeof(uint64_t), offsets, fp) == offsets);
+    if (fclose(fp) != 0 || !written) return SERDEC_ERR_IO;
+    return SERDEC_OK;
+}
+
+// Everything a loaded index points at lies within the input: containers are sorted and
+// their brackets in order, and each child lies within offsets and between its brackets.
+// Queries and seeks then need no bounds checks.
+static bool index_valid(const SerdecJsonIndex* index) {
+    uint64_t size = index->input_size;
+    if (index->root > size) return false;
+    for (size_t i = 0; i < index->offset_count; i++) {
+        if (index->offsets[i] >= size) return false;
+    }
+
+    for (size_t i = 0; i < index->container_count; i++) {
+        const IndexContainer* c = &index->containers[i];
+        if (c->open >= c->close || c->close >= size ||
+            (i && c->open <= index->containers[i - 1].open))
+            return false;
+        if (c->first > index->offset_count || c->count > index->offset_count - c->first)
+            return false;
+        for (uint64_t j = c->first; j < c->first + c->count; j++) {
+            if (index->offsets[j] <= c->open || index->offsets[j] >= c->close) return false;
+        }
+    }
+    return true;
+}
+
+static SerdecError read_index(FILE* fp, const SerdecBuffer* buf, SerdecJsonIndex* index) {
+    IndexHeader header;
+    if (fread(&header, sizeof(header), 1, fp) != 1) return SERDEC_ERR_IO;
+
+    const char* data = serdec_buffer_data(buf);
+    size_t size = serdec_buffer_size(buf);
+    if (memcmp(header.magic, index_magic, sizeof(header.magic)) != 0 ||
+        header.version != INDEX_VERSION || header.byte_order != 0x01020304 || !header.depth ||
+        header.input_size != size || header.input_hash != serdec_input_hash(data, size) ||
+        header.container_count > SIZE_MAX / sizeof(IndexContainer) ||
+        header.offset_count > SIZE_MAX / sizeof(uint64_t))
+        return SERDEC_ERR_IO;
+
+    index->depth = header.depth;
+    index->input_size = header.input_size;
+    index->input_hash = header.input_hash;
+    index->root = header.root;
+    index->container_count = header.container_count;
+    index->offset_count = header.offset_count;
+
+    if (!serdec_sidecar_fits(fp, (uint64_t[]) { header.container_count, header.offset_count },
+                             (size_t[]) { sizeof(IndexContainer), sizeof(uint64_t) }, 2))
+        return SERDEC_ERR_IO;
+
+    if (index->container_count) {
+        index->containers = malloc(index->container_count * sizeof(IndexContainer));
+        if (!index->containers) return SERDEC_ERR_OUT_OF_MEMORY;
+    }
+    if (index->offset_count) {
+        index->offsets = malloc(index->offset_count * sizeof(uint64_t));
+        if (!index->offsets) return SERDEC_ERR_OUT_OF_MEMORY;
+    }
+    size_t containers = index->container_count;
+    size_t offsets = index->offset_count;
+    if ((containers &&
+         fread(index->containers, sizeof(IndexContainer), containers, fp) != containers) ||
+        (offsets && fread(index->offsets, sizeof(uint64_t), offsets, fp) != offsets))
+        return SERDEC_ERR_IO;
+    return index_valid(index) ? SERDEC_OK : SERDEC_ERR_IO;
+}
+
+SerdecError serdec_json_index_load(const char* path, const SerdecBuffer* buf,
+                                   SerdecJsonIndex** out) {
+    if (!path || !buf || !out) return SERDEC_ERR_INVALID_HANDLE;
+    *out = NULL;
+
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return SERDEC_ERR_FILE_NOT_FOUND;
+
+    SerdecJsonIndex* index = calloc(1, sizeof(*index));
+    SerdecError status = SERDEC_ERR_OUT_OF_MEMORY;
+    if (index) {
+        index->magic = SERDEC_MAGIC_INDEX;
+        status = read_index(fp, buf, index);
+    }
+    fclose(fp);
+
+    if (status != SERDEC_OK) {
+        serdec_json_index_destroy(index);
+        return status;
+    }
+    *out = index;
+    return SERDEC_OK;
+}
+
+// --- Queries ---
+
+// The container opened at offset, or NULL if the value there is not an indexed container.
+static const IndexContainer* find_container(const SerdecJsonIndex* index, uint64_t offset) {
+    size_t low = 0;
+    size_t high = index->container_count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (index->containers[mid].open < offset) low = mid + 1;
+        else high = mid;
+    }
+    if (low < index->container_count && index->containers[low].open == offset)
+        return &index->containers[low];
+    return NULL;
+}
+
+// Follows path from the root. On success *offset is where the value at path starts and
+// *parent the container holding it, or NULL for the empty path.
+static SerdecError walk(const SerdecJsonIndex* index, const size_t* path, size_t depth,
+                        const IndexContainer** parent, uint64_t* offset) {
+    if (depth > index->depth) return SERDEC_ERR_INVALID_PATH;
+    *parent = NULL;
+    *offset = index->root;
+
+    for (size_t i = 0; i < depth; i++) {
+        const IndexContainer* c = find_container(index, *offset);
+        if (!c) return SERDEC_ERR_TYPE_MISMATCH;
+        if (path[i] >= c->count) return SERDEC_ERR_NOT_FOUND;
+        *parent = c;
+        *offset = index->offsets[c->first + path[i]];
+    }
+    return SERDEC_OK;
+}
+
+SerdecError serdec_json_index_count(const SerdecJsonIndex* index, const size_t* path,
+                                    size_t depth, size_t* count) {
+    if (!index || index->magic != SERDEC_MAGIC_INDEX || (depth && !path) || !count)
+        return SERDEC_ERR_INVALID_HANDLE;
+    if (depth >= index->depth) return SERDEC_ERR_INVALID_PATH;
+
+    const IndexContainer* parent;
+    uint64_t offset;
+    SerdecError status = walk(index, path, depth, &parent, &offset);
+    if (status != SERDEC_OK) return status;
+
+    const IndexContainer* c = find_container(index, offset);
+    if (!c) return SERDEC_ERR_TYPE_MISMATCH;
+    *count = c->count;
+    return SERDEC_OK;
+}
+
+SerdecError serdec_json_index_offset(const SerdecJsonIndex* index, const size_t* path,
+                                     size_t depth, size_t* offset) {
+    if (!index || index->magic != SERDEC_MAGIC_INDEX || (depth && !path) || !offset)
+        return SERDEC_ERR_INVALID_HANDLE;
+
+    const IndexContainer* parent;
+    uint64_t start;
+    SerdecError status = walk(index, path, depth, &parent, &start);
+    if (status != SERDEC_OK) return status;
+    *offset = start;
+    return SERDEC_OK;
+}
+
+SerdecError serdec_json_index_seek(const SerdecJsonIndex* index, SerdecParser* parser,
+                                   const size_t* path, size_t depth) {
+    if (!index || index->magic != SERDEC_MAGIC_INDEX || (depth && !path) ||
+        !parser || parser->magic != SERDEC_MAGIC_PARSER)
+        return SERDEC_ERR_INVALID_HANDLE;
+
+    const SerdecLexer* lexer = parser->lexer;
+    if (lexer->buffer->size != index->input_size) return SERDEC_ERR_INVALID_HANDLE;
+
+    const IndexContainer* parent;
+    uint64_t offset;
+    SerdecError status = walk(index, path, depth, &parent, &offset);
+    if (status != SERDEC_OK) return status;
+
+    if (!parent) {
+        serdec_json_parser_reset(parser, 0, (size_t) index->input_size, 1);
+    } else if (lexer->start[parent->open] == '{') {
+        serdec_json_parser_reset_members(parser, (size_t) offset, (size_t) parent->close, 1);
+    } else {
+        serdec_json_parser_reset_elements(parser, (size_t) offset, (size_t) parent->close, 1);
+    }
+    return SERDEC_OK;
+}
@@ -0,0 +1,118 @@
+#include "internal.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INTERN_INITIAL_CAPACITY 64
+
+SerdecInternTable* serdec_intern_table_create(SerdecArena* arena) {
+    if (!arena || arena->magic != SERDEC_MAGIC_ARENA) return NULL;
+
+    SerdecInternTable* table = (SerdecInternTable*) malloc(sizeof(*table));
+    if (!table) return NULL;
+
+    *table = (SerdecInternTable) {
+        .magic = SERDEC_MAGIC_INTERN,
+        .arena = arena,
+        .slots = (SerdecInternEntry**) calloc(INTERN_INITIAL_CAPACITY, sizeof(*table->slots)),
+        .capacity = INTERN_INITIAL_CAPACITY,
+    };
+    if (!table->slots) {
+        free(table);
+        return NULL;
+    }
+
+    return table;
+}
+
+void serdec_intern_table_destroy(SerdecInternTable* table) {
+    if (!table || table->magic != SERDEC_MAGIC_INTERN) return;
+
+    table->magic = SERDEC_MAGIC_FREED;
+    free(table->slots);
+    free(table->scratch);
+    free(table);
+}
+
+size_t serdec_intern_table_size(const SerdecInternTable* table) {
+    if (!table || table->magic != SERDEC_MAGIC_INTERN) return 0;
+    return table->count;
+}
+
+// Doubles the slot array. Entries keep their addresses; only the slots move.
+static bool grow(SerdecInternTable* table) {
+    size_t capacity = table->capacity * 2;
+    SerdecInternEntry** slots = (SerdecInternEntry**) calloc(capacity, sizeof(*slots));
+    if (!slots) return false;
+
+    for (size_t i = 0; i < table->capacity; i++) {
+        SerdecInternEntry* entry = table->slots[i];
+        if (!entry) continue;
+        size_t slot = entry->hash & (capacity - 1);
+        while (slots[slot]) slot = (slot + 1) & (capacity - 1);
+        slots[slot] = entry;
+    }
+
+    free(table->slots);
+    table->slots = slots;
+    table->capacity = capacity;
+    return true;
+}
+
+static const char* intern(SerdecInternTable* table, const char* key, size_t len) {
+    uint64_t hash = serdec_hash(key, len);
+    size_t mask = table->capacity - 1;
+    size_t slot = hash & mask;
+
+    for (SerdecInternEntry* entry; (entry = table->slots[slot]); slot = (slot + 1) & mask) {
+        if (entry->hash == hash && entry->len == len && memcmp(entry->bytes, key, len) == 0)
+            return entry->bytes;
+    }
+
+    // Keep the load factor at or below one half
+    if (2 * (table->count + 1) > table->capacity) {
+        if (!grow(table)) return NULL;
+        mask = table->capacity - 1;
+        for (slot = hash & mask; table->slots[slot]; slot = (slot + 1) & mask) {}
+    }
+
+    SerdecInternEntry* entry = (SerdecInternEntry*) serdec_arena_alloc_aligned(
+        table->arena, sizeof(*entry) + len + 1, _Alignof(SerdecInternEntry));
+    if (!entry) return NULL;
+
+    entry->hash = hash;
+    entry->len = len;
+    memcpy(entry->bytes, key, len);
+    entry->bytes[len] = '\0';
+
+    table->slots[slot] = entry;
+    table->count++;
+    return entry->bytes;
+}
+
+const char* serdec_intern(SerdecInternTable* table, const char* key, size_t len) {
+    if (!table || table->magic != SERDEC_MAGIC_INTERN || (!key && len)) return NULL;
+    return intern(table, key ? key : "", len);
+}
+
+SerdecError serdec_intern_string(SerdecInternTable* table, SerdecString s, const char** out) {
+    if (!s.has_escapes) {
+        *out = intern(table, s.ptr, s.len);
+        return *out ? SERDEC_OK : SERDEC_ERR_OUT_OF_MEMORY;
+    }
+
+    if (s.len + 1 > table->scratch_capacity) {
+        char* scratch = (char*) realloc(table->scratch, s.len + 1);
+        if (!scratch) return SERDEC_ERR_OUT_OF_MEMORY;
+        table->scratch = scratch;
+        table->scratch_capacity = s.len + 1;
+    }
+
+    size_t len;
+    SerdecError status = serdec_string_unescape_to(table->scratch, s.ptr, s.len, &len);
+    if (status != SERDEC_OK) return status;
+
+    *out = intern(table, table->scratch, len);
+    return *out ? SERDEC_OK : SERDEC_ERR_OUT_OF_MEMORY;
+}
@@ -0,0 +1,186 @@
+#include "internal.h"
+#include <serdec/dom.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define ITER_INITIAL_FRAMES 32
+
+static bool order_valid(unsigned order) {
+    return order && !(order & ~(unsigned) SERDEC_ITER_BOTH);
+}
+
+// A container being walked.
+typedef struct {
+    const SerdecValue* container;
+    const SerdecValue* children;  // Child values, stride apart; NULL when packed or empty
+    size_t stride;
+    size_t next;                  // Next child to visit
+    size_t count;
+    size_t index;                 // Position of container in its parent
+    SerdecString key;             // Key of container in its parent
+} Frame;
+
+struct SerdecIterator {
+    uint32_t magic;               // 0x5EDEC011 for validation
+    SerdecArena* arena;
+    unsigned order;
+    const SerdecValue* root;      // Until the first step
+    Frame* frames;
+    size_t depth;
+    size_t capacity;
+    bool entered;                 // The last step entered frames[depth - 1]
+    SerdecError error;            // Sticky
+    SerdecValue scratch;          // Current element of a packed array
+};
+
+SerdecIterator* serdec_iter_create(SerdecArena* arena, const SerdecValue* root,
+                                   unsigned order) {
+    if (!arena || arena->magic != SERDEC_MAGIC_ARENA || !root || !order_valid(order))
+        return NULL;
+
+    SerdecIterator* it = (SerdecIterator*) serdec_arena_alloc_aligned(
+        arena, sizeof(*it), _Alignof(SerdecIterator));
+    Frame* frames = (Frame*) serdec_arena_alloc_aligned(
+        arena, ITER_INITIAL_FRAMES * sizeof(*frames), _Alignof(Frame));
+    if (!it || !frames) return NULL;
+
+    *it = (SerdecIterator) {
+        .magic = SERDEC_MAGIC_ITERATOR,
+        .arena = arena,
+        .order = order,
+        .root = root,
+        .frames = frames,
+        .capacity = ITER_INITIAL_FRAMES,
+    };
+    return it;
+}
+
+// Doubles the stack. The old one stays in the arena, so the stack never takes more than
+// twice its peak size.
+static bool grow(SerdecIterator* it) {
+    size_t capacity = it->capacity * 2;
+    Frame* frames = (Frame*) serdec_arena_alloc_aligned(it->arena, capacity * sizeof(*frames),
+                                                        _Alignof(Frame));
+    if (!frames) return false;
+
+    memcpy(frames, it->frames, it->depth * sizeof(*frames));
+    it->frames = frames;
+    it->capacity = capacity;
+    return true;
+}
+
+static SerdecError push(SerdecIterator* it, const SerdecValue* container, SerdecString key,
+                        size_t index) {
+    SerdecError status = serdec_dom_expand(container);
+    if (status != SERDEC_OK) return status;
+    if (it->depth == it->capacity && !grow(it)) return SERDEC_ERR_OUT_OF_MEMORY;
+
+    SerdecValueType type = serdec_tag_type(container);
+    size_t count = serdec_tag_len(container);
+    const SerdecValue* children = container->children;
+    size_t stride = 1;
+    if (!count || (type == SERDEC_TYPE_ARRAY && serdec_is_packed(container))) {
+        children = NULL;
+    } else if (type == SERDEC_TYPE_OBJECT && !serdec_object_shape(container)) {
+        children++;   // Values follow their keys
+        stride = 2;
+    }
+
+    it->frames[it->depth++] = (Frame) {
+        .container = container, .children = children, .stride = stride,
+        .count = count, .index = index, .key = key,
+    };
+    return SERDEC_OK;
+}
+
+SerdecError serdec_iter_next(SerdecIterator* it, SerdecVisit* out) {
+    if (!it || it->magic != SERDEC_MAGIC_ITERATOR || !out) return SERDEC_ERR_INVALID_HANDLE;
+    if (it->error != SERDEC_OK) return it->error;
+    it->entered = false;
+
+    for (;;) {
+        const SerdecValue* value;
+        SerdecString key = { 0 };
+        size_t index = 0;
+
+        if (it->root) {
+            value = it->root;
+            it->root = NULL;
+        } else if (it->depth) {
+            Frame* frame = &it->frames[it->depth - 1];
+            if (frame->next == frame->count) {
+                it->depth--;
+                if (!(it->order & SERDEC_ITER_POSTORDER)) continue;
+                *out = (SerdecVisit) {
+                    .value = frame->container, .key = frame->key, .index = frame->index,
+                    .depth = it->depth, .leave = true,
+                    .children = frame->children, .stride = frame->stride,
+                };
+                return SERDEC_OK;
+            }
+
+            index = frame->next++;
+            if (frame->children) {
+                value = frame->children + index * frame->stride;
+            } else {
+                it->scratch = serdec_packed_node(frame->container, index);
+                value = &it->scratch;
+            }
+            if (serdec_tag_type(frame->container) == SERDEC_TYPE_OBJECT) {
+                const SerdecValue* name = serdec_member_key(frame->container, index);
+                key = (SerdecString) { name->str, serdec_tag_len(name), false };
+            }
+        } else {
+            *out = (SerdecVisit) { 0 };
+            return SERDEC_OK;
+        }
+
+        SerdecValueType type = serdec_tag_type(value);
+        size_t depth = it->depth;
+        if (type != SERDEC_TYPE_ARRAY && type != SERDEC_TYPE_OBJECT) {
+            *out = (SerdecVisit) { .value = value, .key = key, .index = index, .depth = depth };
+            return SERDEC_OK;
+        }
+
+        SerdecError status = push(it, value, key, index);
+        if (status != SERDEC_OK) {
+            it->error = status;
+            return status;
+        }
+        if (!(it->order & SERDEC_ITER_PREORDER)) continue;
+
+        const Frame* frame = &it->frames[depth];
+        *out = (SerdecVisit) {
+            .value = value, .key = key, .index = index, .depth = depth,
+            .children = frame->children, .stride = frame->stride,
+        };
+        it->entered = true;
+        return SERDEC_OK;
+    }
+}
+
+void serdec_iter_skip(SerdecIterator* it) {
+    if (!it || it->magic != SERDEC_MAGIC_ITERATOR || !it->entered) return;
+
+    Frame* frame = &it->frames[it->depth - 1];
+    frame->next = frame->count;
+    it->entered = false;
+}
+
+SerdecError serdec_value_walk(SerdecArena* arena, const SerdecValue* root, unsigned order,
+                              SerdecVisitCallback cb, void* user) {
+    if (!arena || arena->magic != SERDEC_MAGIC_ARENA || !root || !cb || !order_valid(order))
+        return SERDEC_ERR_INVALID_HANDLE;
+
+    SerdecIterator* it = serdec_iter_create(arena, root, order);
+    if (!it) return SERDEC_ERR_OUT_OF_MEMORY;
+
+    SerdecVisit visit;
+    SerdecError status;
+    while ((status = serdec_iter_next(it, &visit)) == SERDEC_OK && visit.value) {
+        status = cb(user, &visit);
+        if (status != SERDEC_OK) break;
+    }
+    return status;
+}
@@ -278,6 +278,35 @@ const SerdecErrorInfo* serdec_lexer_get_error(const SerdecLexer* lexer) {
     return &lexer->error;
 }
 
+void serdec_lexer_reset(SerdecLexer* lexer, size_t begin, size_t end, size_t line) {
+    if (!lexer || !lexer->buffer) return;
+
+    size_t size = lexer->buffer->size;
+    if (end > size) end = size;
+    if (begin > end) begin = end;
+
+    lexer->current = lexer->start + begin;
+    lexer->end = lexer->start + end;
+    lexer->has_peeked = false;
+    lexer->error = (SerdecErrorInfo) { 0 };
+    if (!line) {
+        lexer->line = 1;
+        lexer->column = 1;
+        return;
+    }
+
+    // Column of `begin`: distance from the preceding newline. The search is bounded so a
+    // seek into one huge line stays cheap; past the bound columns count from `begin`.
+    const char* bol = lexer->current;
+    const char* limit = (begin > SERDEC_LEXER_COLUMN_SCAN) ? bol - SERDEC_LEXER_COLUMN_SCAN
+                                                            : lexer->start;
+    while (bol > limit && bol[-1] != '\n') bol--;
+    if (bol == limit && limit > lexer->start && bol[-1] != '\n') bol = lexer->current;
+
+    lexer->line = line;
+    lexer->column = (size_t) (lexer->current - bol) + 1;
+}
+
 SerdecToken serdec_lexer_next(SerdecLexer* lexer) {
     if (!lexer) return (SerdecToken) { .type = SERDEC_TOKEN_ERROR };
 
@@ -0,0 +1,347 @@
+#include "internal.h"
+#include <serdec/ndjson.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LINES_VERSION 1
+#define LINES_BLOCK   128         // Records per block
+
+// Records [n * LINES_BLOCK, (n + 1) * LINES_BLOCK) start at base plus a delta; the deltas
+// are packed `width` bits each from bit `start` of the packed words.
+typedef struct {
+    uint64_t base;
+    uint64_t start;
+    uint32_t width;
+    uint32_t reserved;
+} LineBlock;
+
+// Blank lines make line numbers drift from record numbers. From `record` until the next
+// jump, record r is on line `line + (r - record)`.
+typedef struct {
+    uint64_t record;
+    uint64_t line;
+} LineJump;
+
+struct SerdecNdjsonIndex {
+    uint32_t magic;           // 0x5EDEC013 for validation
+    uint64_t input_size;
+    uint64_t input_hash;
+    size_t count;             // Records
+    LineBlock* blocks;
+    size_t block_count;
+    uint64_t* packed;
+    size_t packed_words;
+    LineJump* jumps;          // Sorted by record
+    size_t jump_count;
+};
+
+typedef struct {
+    char magic[8];            // "SERDECL"
+    uint32_t version;
+    uint32_t byte_order;      // 0x01020304 as written
+    uint64_t input_size;
+    uint64_t input_hash;
+    uint64_t count;
+    uint64_t block_count;
+    uint64_t packed_words;
+    uint64_t jump_count;
+} LinesHeader;
+
+static const char lines_magic[8] = "SERDECL";
+
+static uint64_t read_bits(const uint64_t* words, uint64_t pos, unsigned width) {
+    if (!width) return 0;
+    size_t word = (size_t) (pos / 64);
+    unsigned shift = (unsigned) (pos % 64);
+    uint64_t value = words[word] >> shift;
+    if (shift + width > 64) value |= words[word + 1] << (64 - shift);
+    return (width == 64) ? value : value & ((1ull << width) - 1);
+}
+
+static void write_bits(uint64_t* words, uint64_t pos, unsigned width, uint64_t value) {
+    if (!width) return;
+    size_t word = (size_t) (pos / 64);
+    unsigned shift = (unsigned) (pos % 64);
+    words[word] |= value << shift;
+    if (shift + width > 64) words[word + 1] |= value >> (64 - shift);
+}
+
+// Line of record i, which may be the next record to be added.
+static size_t record_line(const SerdecNdjsonIndex* index, size_t i) {
+    size_t low = 0;
+    size_t high = index->jump_count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (index->jumps[mid].record <= i) low = mid + 1;
+        else high = mid;
+    }
+    if (!low) return i + 1;
+    const LineJump* jump = &index->jumps[low - 1];
+    return (size_t) (jump->line + (i - jump->record));
+}
+
+// --- Building ---
+
+typedef struct {
+    SerdecNdjsonIndex* index;
+    uint64_t pending[LINES_BLOCK];  // Offsets of the block being filled
+    size_t pending_count;
+    uint64_t bits;            // Packed bits used
+    size_t block_capacity;
+    size_t packed_capacity;
+    size_t jump_capacity;
+} LinesBuilder;
+
+static bool flush_block(LinesBuilder* b) {
+    SerdecNdjsonIndex* index = b->index;
+    uint64_t base = b->pending[0];
+    uint64_t span = b->pending[b->pending_count - 1] - base;
+    unsigned width = 0;
+    while (width < 64 && (span >> width)) width++;
+
+    size_t words = (size_t) ((b->bits + width * b->pending_count + 63) / 64);
+    if (words > b->packed_capacity) {
+        size_t capacity = b->packed_capacity ? b->packed_capacity * 2 : 64;
+        if (capacity < words) capacity = words;
+        uint64_t* packed = realloc(index->packed, capacity * sizeof(*packed));
+        if (!packed) return false;
+        memset(packed + b->packed_capacity, 0, (capacity - b->packed_capacity) * sizeof(*packed));
+        index->packed = packed;
+        b->packed_capacity = capacity;
+    }
+    if (!serdec_sidecar_grow((void**) &index->blocks, &b->block_capacity, index->block_count,
+                             sizeof(LineBlock)))
+        return false;
+
+    index->blocks[index->block_count++] = (LineBlock) {
+        .base = base, .start = b->bits, .width = width,
+    };
+    for (size_t i = 0; i < b->pending_count; i++, b->bits += width)
+        write_bits(index->packed, b->bits, width, b->pending[i] - base);
+    index->packed_words = words;
+    b->pending_count = 0;
+    return true;
+}
+
+static bool add_record(LinesBuilder* b, uint64_t offset, size_t line) {
+    SerdecNdjsonIndex* index = b->index;
+    if (record_line(index, index->count) != line) {
+        if (!serdec_sidecar_grow((void**) &index->jumps, &b->jump_capacity,
+                                 index->jump_count, sizeof(LineJump)))
+            return false;
+        index->jumps[index->jump_count++] = (LineJump) { index->count, line };
+    }
+
+    b->pending[b->pending_count++] = offset;
+    index->count++;
+    return b->pending_count < LINES_BLOCK || flush_block(b);
+}
+
+static bool is_blank(const char* ptr, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (ptr[i] != ' ' && ptr[i] != '\t' && ptr[i] != '\r') return false;
+    }
+    return true;
+}
+
+SerdecError serdec_ndjson_index_build(const SerdecBuffer* buf, SerdecNdjsonIndex** out) {
+    if (!buf || buf->magic != SERDEC_MAGIC_BUFFER || !out) return SERDEC_ERR_INVALID_HANDLE;
+    *out = NULL;
+
+    SerdecNdjsonIndex* index = calloc(1, sizeof(*index));
+    if (!index) return SERDEC_ERR_OUT_OF_MEMORY;
+    index->magic = SERDEC_MAGIC_LINES;
+    index->input_size = buf->size;
+    index->input_hash = serdec_input_hash(buf->data, buf->size);
+
+    LinesBuilder b = { .index = index };
+    const char* data = buf->data;
+    size_t size = buf->size;
+    size_t line = 1;
+    bool ok = true;
+    for (size_t pos = 0; ok && pos < size; line++) {
+        const char* nl = memchr(data + pos, '\n', size - pos);
+        size_t eol = nl ? (size_t) (nl - data) : size;
+        if (!is_blank(data + pos, eol - pos)) ok = add_record(&b, pos, line);
+        pos = eol + 1;
+    }
+    if (ok && b.pending_count) ok = flush_block(&b);
+
+    if (!ok) {
+        serdec_ndjson_index_destroy(index);
+        return SERDEC_ERR_OUT_OF_MEMORY;
+    }
+    *out = index;
+    return SERDEC_OK;
+}
+
+void serdec_ndjson_index_destroy(SerdecNdjsonIndex* index) {
+    if (!index || index->magic != SERDEC_MAGIC_LINES) return;
+    index->magic = SERDEC_MAGIC_FREED;
+    free(index->blocks);
+    free(index->packed);
+    free(index->jumps);
+    free(index);
+}
+
+// --- Persistence ---
+
+SerdecError serdec_ndjson_index_save(const SerdecNdjsonIndex* index, const char* path) {
+    if (!index || index->magic != SERDEC_MAGIC_LINES || !path) return SERDEC_ERR_INVALID_HANDLE;
+
+    LinesHeader header = {
+        .version = LINES_VERSION,
+        .byte_order = 0x01020304,
+        .input_size = index->input_size,
+        .input_hash = index->input_hash,
+        .count = index->count,
+        .block_count = index->block_count,
+        .packed_words = index->packed_words,
+        .jump_count = index->jump_count,
+    };
+    memcpy(header.magic, lines_magic, sizeof(header.magic));
+
+    FILE* fp = fopen(path, "wb");
+    if (!fp) return SERDEC_ERR_FILE_NOT_FOUND;
+    size_t blocks = index->block_count;
+    size_t words = index->packed_words;
+    size_t jumps = index->jump_count;
+    bool written = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+                   (!blocks || fwrite(index->blocks, sizeof(LineBlock), blocks, fp) == blocks) &&
+                   (!words || fwrite(index->packed, sizeof(uint64_t), words, fp) == words) &&
+                   (!jumps || fwrite(index->jumps, sizeof(LineJump), jumps, fp) == jumps);
+    if (fclose(fp) != 0 || !written) return SERDEC_ERR_IO;
+    return SERDEC_OK;
+}
+
+// Every record has a block and every block's deltas lie within the packed words, so
+// lookups need no bounds checks.
+static bool index_valid(const SerdecNdjsonIndex* index) {
+    size_t count = index->count;
+    if (index->block_count != count / LINES_BLOCK + (count % LINES_BLOCK != 0)) return false;
+
+    uint64_t bits = (uint64_t) index->packed_words * 64;
+    for (size_t i = 0; i < index->block_count; i++) {
+        const LineBlock* block = &index->blocks[i];
+        uint64_t records = (i + 1 < index->block_count) ? LINES_BLOCK : count - i * LINES_BLOCK;
+        if (block->width > 64 || block->start > bits ||
+            (uint64_t) block->width * records > bits - block->start)
+            return false;
+    }
+    return true;
+}
+
+// Reads count items of size bytes into a new allocation at *items.
+static SerdecError read_array(FILE* fp, void** items, size_t count, size_t size) {
+    if (!count) return SERDEC_OK;
+    *items = malloc(count * size);
+    if (!*items) return SERDEC_ERR_OUT_OF_MEMORY;
+    return (fread(*items, size, count, fp) == count) ? SERDEC_OK : SERDEC_ERR_IO;
+}
+
+static SerdecError read_index(FILE* fp, const SerdecBuffer* buf, SerdecNdjsonIndex* index) {
+    LinesHeader header;
+    if (fread(&header, sizeof(header), 1, fp) != 1) return SERDEC_ERR_IO;
+    if (memcmp(header.magic, lines_magic, sizeof(header.magic)) != 0 ||
+        header.version != LINES_VERSION || header.byte_order != 0x01020304 ||
+        header.input_size != buf->size ||
+        header.input_hash != serdec_input_hash(buf->data, buf->size))
+        return SERDEC_ERR_IO;
+
+    if (!serdec_sidecar_fits(
+            fp, (uint64_t[]) { header.block_count, header.packed_words, header.jump_count },
+            (size_t[]) { sizeof(LineBlock), sizeof(uint64_t), sizeof(LineJump) }, 3))
+        return SERDEC_ERR_IO;
+
+    index->input_size = header.input_size;
+    index->input_hash = header.input_hash;
+    index->count = (size_t) header.count;
+    index->block_count = (size_t) header.block_count;
+    index->packed_words = (size_t) header.packed_words;
+    index->jump_count = (size_t) header.jump_count;
+
+    SerdecError status = read_array(fp, (void**) &index->blocks, index->block_count,
+                                    sizeof(LineBlock));
+    if (status == SERDEC_OK)
+        status = read_array(fp, (void**) &index->packed, index->packed_words, sizeof(uint64_t));
+    if (status == SERDEC_OK)
+        status = read_array(fp, (void**) &index->jumps, index->jump_count, sizeof(LineJump));
+    if (status == SERDEC_OK && !index_valid(index)) status = SERDEC_ERR_IO;
+    return status;
+}
+
+SerdecError serdec_ndjson_index_load(const char* path, const SerdecBuffer* buf,
+                                     SerdecNdjsonIndex** out) {
+    if (!path || !buf || buf->magic != SERDEC_MAGIC_BUFFER || !out)
+        return SERDEC_ERR_INVALID_HANDLE;
+    *out = NULL;
+
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return SERDEC_ERR_FILE_NOT_FOUND;
+
+    SerdecNdjsonIndex* index = calloc(1, sizeof(*index));
+    SerdecError status = SERDEC_ERR_OUT_OF_MEMORY;
+    if (index) {
+        index->magic = SERDEC_MAGIC_LINES;
+        status = read_index(fp, buf, index);
+    }
+    fclose(fp);
+
+    if (status != SERDEC_OK) {
+        serdec_ndjson_index_destroy(index);
+        return status;
+    }
+    *out = index;
+    return SERDEC_OK;
+}
+
+// --- Queries ---
+
+// Start of record i, or the end of the input for i == count.
+static uint64_t record_offset(const SerdecNdjsonIndex* index, size_t i) {
+    if (i >= index->count) return index->input_size;
+    const LineBlock* block = &index->blocks[i / LINES_BLOCK];
+    uint64_t pos = block->start + (uint64_t) (i % LINES_BLOCK) * block->width;
+    uint64_t offset = block->base + read_bits(index->packed, pos, block->width);
+    return offset < index->input_size ? offset : index->input_size;
+}
+
+size_t serdec_ndjson_index_count(const SerdecNdjsonIndex* index) {
+    if (!index || index->magic != SERDEC_MAGIC_LINES) return 0;
+    return index->count;
+}
+
+SerdecError serdec_ndjson_index_record(const SerdecNdjsonIndex* index, size_t i,
+                                       SerdecNdjsonSpan* out) {
+    if (!index || index->magic != SERDEC_MAGIC_LINES || !out) return SERDEC_ERR_INVALID_HANDLE;
+    if (i >= index->count) return SERDEC_ERR_NOT_FOUND;
+
+    uint64_t begin = record_offset(index, i);
+    uint64_t end = record_offset(index, i + 1);
+    *out = (SerdecNdjsonSpan) {
+        .offset = (size_t) begin,
+        .length = (size_t) (end > begin ? end - begin : 0),
+        .line = record_line(index, i),
+    };
+    return SERDEC_OK;
+}
+
+SerdecError serdec_ndjson_index_seek(const SerdecNdjsonIndex* index, SerdecParser* parser,
+                                     size_t i) {
+    if (!parser || parser->magic != SERDEC_MAGIC_PARSER) return SERDEC_ERR_INVALID_HANDLE;
+
+    SerdecNdjsonSpan span;
+    SerdecError status = serdec_ndjson_index_record(index, i, &span);
+    if (status != SERDEC_OK) return status;
+    if (parser->lexer->buffer->size != index->input_size) return SERDEC_ERR_INVALID_HANDLE;
+
+    serdec_json_parser_reset(parser, span.offset, span.offset + span.length, span.line);
+    return SERDEC_OK;
+}
+
+bool serdec_ndjson_index_matches(const SerdecNdjsonIndex* index, const SerdecBuffer* buf) {
+    return index && index->magic == SERDEC_MAGIC_LINES && index->input_size == buf->size;
+}
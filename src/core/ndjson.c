@@ -0,0 +1,665 @@
+#include "internal.h"
+#include <serdec/ndjson.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SERDEC_NDJSON_DEFAULT_CHUNK  (1024 * 1024)
+#define SERDEC_NDJSON_INITIAL_EVENTS 256
+#define SERDEC_JSON_SEQ_RS           '\x1E'
+
+typedef struct {
+    size_t begin;             // First byte (start of a record, except with CONCAT framing)
+    size_t end;               // One past the last byte (after a delimiter or end of input)
+    size_t line;              // Line number of the first byte (1-indexed)
+    size_t newlines;          // Newlines inside the chunk
+
+    // CONCAT framing only: the real record boundaries are found by a structural scan
+    bool escaped_start;       // Preceded by an odd run of backslashes
+    SerdecScanState outside;  // Relative scan assuming the chunk starts outside a string
+    SerdecScanState inside;   // Relative scan assuming it starts inside a string
+    SerdecScanState start;    // Actual state at `begin`
+} NdjsonChunk;
+
+typedef struct {
+    size_t offset;
+    size_t line;
+    size_t first_event;       // Index into the worker's event tape
+    size_t count;
+} NdjsonPending;
+
+typedef struct NdjsonJob NdjsonJob;
+
+typedef struct {
+    NdjsonJob* job;
+    unsigned id;
+    pthread_t thread;
+
+    SerdecParser* parser;
+    SerdecArena* arena;
+
+    SerdecEvent* events;      // Event tape, reused across records
+    size_t event_count;
+    size_t event_capacity;
+
+    NdjsonPending* pending;   // Ordered mode: records waiting for their turn
+    size_t pending_count;
+    size_t pending_capacity;
+} NdjsonWorker;
+
+struct NdjsonJob {
+    const char* data;
+    size_t size;
+    SerdecFraming framing;
+    bool ordered;
+    SerdecNdjsonCallback cb;
+    void* user;
+    SerdecErrorList* errors;  // Recovery mode when set
+    size_t max_errors;        // Counted from first_error: the list may hold earlier errors
+    size_t first_error;
+    bool indexed;             // Chunk lines come from a line index: stage 1 is skipped
+    const SerdecNdjsonFilter* filter; // Only records that pass are delivered
+
+    NdjsonChunk* chunks;
+    size_t chunk_count;
+    atomic_size_t next_count; // Stage 1 (newline counting) work cursor
+    atomic_size_t next_parse; // Stage 2 (parsing) work cursor
+    atomic_bool abort;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    unsigned counting;        // Workers still in stage 1
+    bool scan_failed;         // CONCAT: chunk states are inconsistent, chunk 0 takes everything
+    size_t next_delivery;     // Ordered mode: chunk allowed to deliver next
+
+    SerdecError status;
+    SerdecErrorInfo error;
+};
+
+static bool is_ws(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static bool is_blank(const char* ptr, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (!is_ws(ptr[i])) return false;
+    }
+    return true;
+}
+
+static size_t count_newlines(const char* ptr, size_t len) {
+    size_t count = 0;
+    const char* end = ptr + len;
+    while (ptr < end && (ptr = memchr(ptr, '\n', end - ptr))) {
+        count++;
+        ptr++;
+    }
+    return count;
+}
+
+static bool grow(void** items, size_t* capacity, size_t item_size, size_t initial) {
+    size_t new_capacity = *capacity ? *capacity * 2 : initial;
+    void* grown = realloc(*items, new_capacity * item_size);
+    if (!grown) return false;
+
+    *items = grown;
+    *capacity = new_capacity;
+    return true;
+}
+
+static char framing_delimiter(SerdecFraming framing) {
+    return (framing == SERDEC_FRAMING_JSON_SEQ) ? SERDEC_JSON_SEQ_RS : '\n';
+}
+
+// Splits the input into chunks of at least chunk_size bytes that end on a record
+// delimiter. CONCAT chunks are cut at fixed sizes and realigned after the scan.
+static size_t split_chunks(const NdjsonJob* job, size_t chunk_size, NdjsonChunk* chunks) {
+    const char* data = job->data;
+    size_t size = job->size;
+    char delimiter = framing_delimiter(job->framing);
+    size_t count = 0;
+    size_t begin = 0;
+
+    while (begin < size) {
+        size_t end = size;
+        if (size - begin > chunk_size) {
+            if (job->framing == SERDEC_FRAMING_CONCAT) {
+                end = begin + chunk_size;
+            } else {
+                const char* nl = memchr(data + begin + chunk_size - 1, delimiter,
+                                        size - begin - chunk_size + 1);
+                if (nl) end = (nl - data) + 1;
+            }
+        }
+
+        chunks[count++] = (NdjsonChunk) { .begin = begin, .end = end };
+        begin = end;
+    }
+
+    return count;
+}
+
+// Splits records [first, last) of an indexed input into chunks of at least chunk_size
+// bytes. Each chunk ends where the first record at least chunk_size bytes past its start
+// begins, found by binary search over the index.
+static size_t split_indexed(const SerdecNdjsonIndex* index, size_t first, size_t last,
+                            size_t chunk_size, NdjsonChunk* chunks) {
+    SerdecNdjsonSpan span;
+    serdec_ndjson_index_record(index, last - 1, &span);
+    size_t range_end = span.offset + span.length;
+    serdec_ndjson_index_record(index, first, &span);
+    size_t count = 0;
+
+    while (first < last) {
+        size_t begin = span.offset;
+        size_t line = span.line;
+        size_t low = first + 1;
+        size_t high = last;
+        while (low < high) {
+            size_t mid = low + (high - low) / 2;
+            serdec_ndjson_index_record(index, mid, &span);
+            if (span.offset - begin < chunk_size) low = mid + 1;
+            else high = mid;
+        }
+
+        size_t end = range_end;
+        if (low < last) {
+            serdec_ndjson_index_record(index, low, &span);
+            end = span.offset;
+        }
+        chunks[count++] = (NdjsonChunk) { .begin = begin, .end = end, .line = line };
+        first = low;
+    }
+    return count;
+}
+
+// CONCAT: resolves the real string state and depth at each chunk start from the
+// relative scans. Fails if the structure cannot be a sequence of root values.
+static bool chain_chunks(NdjsonJob* job) {
+    SerdecScanState cur = { 0 };
+
+    for (size_t i = 0; i < job->chunk_count; i++) {
+        NdjsonChunk* chunk = &job->chunks[i];
+        const SerdecScanState* rel = &chunk->outside;
+        if (cur.in_string) {
+            if (cur.escaped != chunk->escaped_start) return false;
+            rel = &chunk->inside;
+        }
+        if (cur.depth + rel->min_depth < 0) return false;
+
+        chunk->start = cur;
+        cur.in_string = rel->in_string;
+        cur.escaped = rel->escaped;
+        cur.depth += rel->depth;
+    }
+    return true;
+}
+
+// Called with the lock held once `finished` workers leave stage 1.
+static void finish_counting(NdjsonJob* job, unsigned finished) {
+    job->counting -= finished;
+    if (job->counting) return;
+
+    size_t line = 1;
+    for (size_t i = 0; i < job->chunk_count && !job->indexed; i++) {
+        job->chunks[i].line = line;
+        line += job->chunks[i].newlines;
+    }
+    if (job->framing == SERDEC_FRAMING_CONCAT)
+        job->scan_failed = !chain_chunks(job);
+    pthread_cond_broadcast(&job->cond);
+}
+
+static void report_error(NdjsonJob* job, SerdecError status, const SerdecErrorInfo* info) {
+    pthread_mutex_lock(&job->lock);
+    if (job->status == SERDEC_OK || info->offset < job->error.offset) {
+        job->status = status;
+        job->error = *info;
+    }
+    atomic_store(&job->abort, true);
+    pthread_cond_broadcast(&job->cond);
+    pthread_mutex_unlock(&job->lock);
+}
+
+// Recovery mode: records a bad record. Returns false if the parse must stop instead.
+static bool recover(NdjsonJob* job, SerdecErrorInfo* info, size_t begin, size_t end) {
+    serdec_error_set_context(info, job->data, begin, end);
+
+    pthread_mutex_lock(&job->lock);
+    size_t added = serdec_error_list_count(job->errors) - job->first_error;
+    bool ok = (!job->max_errors || added < job->max_errors) &&
+              serdec_error_list_push(job->errors, info);
+    pthread_mutex_unlock(&job->lock);
+    return ok;
+}
+
+// Returns the next free slot of the worker's event tape, or NULL if it cannot grow.
+static SerdecEvent* next_event(NdjsonWorker* w, size_t offset, size_t line,
+                               SerdecErrorInfo* info) {
+    if (w->event_count == w->event_capacity &&
+        !grow((void**) &w->events, &w->event_capacity, sizeof(SerdecEvent),
+              SERDEC_NDJSON_INITIAL_EVENTS)) {
+        *info = (SerdecErrorInfo) {
+            .code = SERDEC_ERR_OUT_OF_MEMORY, .offset = offset, .line = line, .column = 1,
+        };
+        return NULL;
+    }
+    return &w->events[w->event_count];
+}
+
+static SerdecError parse_record(NdjsonWorker* w, size_t begin, size_t end, size_t line,
+                                SerdecErrorInfo* info) {
+    serdec_json_parser_reset(w->parser, begin, end, line);
+
+    for (;;) {
+        SerdecEvent* ev = next_event(w, begin, line, info);
+        if (!ev) return SERDEC_ERR_OUT_OF_MEMORY;
+
+        SerdecError status = serdec_json_event_next(w->parser, ev);
+        if (status != SERDEC_OK) {
+            *info = *serdec_json_parser_error(w->parser);
+            return status;
+        }
+        if (ev->kind == SERDEC_EVENT_END) return SERDEC_OK;
+        w->event_count++;
+    }
+}
+
+// Tests [begin, end) against the job's filter. The record's events are not kept: one
+// that passes is parsed again by parse_record().
+static SerdecError filter_record(NdjsonWorker* w, size_t begin, size_t end, size_t line,
+                                 bool* pass, SerdecErrorInfo* info) {
+    const SerdecNdjsonFilter* filter = w->job->filter;
+    *pass = serdec_ndjson_filter_prefilter(filter, w->job->data + begin, end - begin);
+    if (!*pass) return SERDEC_OK;
+
+    serdec_json_parser_reset(w->parser, begin, end, line);
+    SerdecError status = serdec_ndjson_filter_test(filter, w->parser, pass);
+    if (status != SERDEC_OK) *info = *serdec_json_parser_error(w->parser);
+    return status;
+}
+
+// RFC 7464 section 2.4: a top-level number that is not followed by whitespace may
+// have been cut short, so the record is rejected rather than silently accepted.
+static SerdecError check_truncated(NdjsonWorker* w, size_t first, size_t end,
+                                   SerdecErrorInfo* info) {
+    const SerdecEvent* ev = &w->events[first];
+    if (w->event_count - first != 1 || ev->kind != SERDEC_EVENT_NUMBER ||
+        ev->offset + ev->string.len < end)
+        return SERDEC_OK;
+
+    const SerdecLexer* lexer = w->parser->lexer;
+    *info = (SerdecErrorInfo) {
+        .code = SERDEC_ERR_UNEXPECTED_EOF,
+        .offset = ev->offset,
+        .line = lexer->line,
+        .column = lexer->column > ev->string.len ? lexer->column - ev->string.len : 1,
+    };
+    snprintf(info->message, sizeof(info->message), "top-level number may be truncated");
+    return SERDEC_ERR_UNEXPECTED_EOF;
+}
+
+static SerdecError deliver(NdjsonWorker* w, size_t offset, size_t line, size_t first,
+                           size_t count, SerdecErrorInfo* info) {
+    SerdecNdjsonRecord record = {
+        .offset = offset,
+        .line = line,
+        .events = w->events + first,
+        .count = count,
+        .arena = w->arena,
+        .worker = w->id,
+    };
+
+    SerdecError status = w->job->cb(w->job->user, &record);
+    if (status != SERDEC_OK) {
+        *info = (SerdecErrorInfo) { .code = status, .offset = offset, .line = line, .column = 1 };
+        snprintf(info->message, sizeof(info->message), "stopped by record callback");
+    }
+    return status;
+}
+
+static void deliver_in_order(NdjsonWorker* w, size_t chunk, SerdecError status,
+                             SerdecErrorInfo* info) {
+    NdjsonJob* job = w->job;
+
+    pthread_mutex_lock(&job->lock);
+    while (job->next_delivery != chunk && !atomic_load(&job->abort))
+        pthread_cond_wait(&job->cond, &job->lock);
+    pthread_mutex_unlock(&job->lock);
+
+    if (atomic_load(&job->abort)) return;
+
+    for (size_t i = 0; i < w->pending_count; i++) {
+        NdjsonPending* p = &w->pending[i];
+        SerdecError cb_status = deliver(w, p->offset, p->line, p->first_event, p->count, info);
+        if (cb_status != SERDEC_OK) {
+            status = cb_status;
+            break;
+        }
+    }
+
+    if (status != SERDEC_OK) {
+        report_error(job, status, info);
+        return;
+    }
+
+    pthread_mutex_lock(&job->lock);
+    job->next_delivery++;
+    pthread_cond_broadcast(&job->cond);
+    pthread_mutex_unlock(&job->lock);
+}
+
+// Hands a parsed record to the callback, or queues it in ordered mode.
+static SerdecError emit_record(NdjsonWorker* w, size_t offset, size_t line, size_t first,
+                               SerdecErrorInfo* info) {
+    if (!w->job->ordered) {
+        SerdecError status = deliver(w, offset, line, first, w->event_count - first, info);
+        w->event_count = 0;
+        return status;
+    }
+
+    if (w->pending_count == w->pending_capacity &&
+        !grow((void**) &w->pending, &w->pending_capacity, sizeof(NdjsonPending), 64)) {
+        *info = (SerdecErrorInfo) { .code = SERDEC_ERR_OUT_OF_MEMORY, .offset = offset,
+                                    .line = line };
+        return SERDEC_ERR_OUT_OF_MEMORY;
+    }
+    w->pending[w->pending_count++] = (NdjsonPending) {
+        .offset = offset, .line = line, .first_event = first, .count = w->event_count - first,
+    };
+    return SERDEC_OK;
+}
+
+// NDJSON and JSON_SEQ: every delimiter-separated segment of the chunk is one record.
+static SerdecError parse_delimited(NdjsonWorker* w, const NdjsonChunk* chunk,
+                                   SerdecErrorInfo* info) {
+    NdjsonJob* job = w->job;
+    char delimiter = framing_delimiter(job->framing);
+    SerdecError status = SERDEC_OK;
+
+    size_t pos = chunk->begin;
+    size_t line = chunk->line;
+    while (pos < chunk->end && !atomic_load_explicit(&job->abort, memory_order_relaxed)) {
+        const char* found = memchr(job->data + pos, delimiter, chunk->end - pos);
+        size_t eol = found ? (size_t) (found - job->data) : chunk->end;
+        size_t next_line = (delimiter == '\n') ? line + 1
+                         : line + count_newlines(job->data + pos, eol - pos);
+
+        if (!is_blank(job->data + pos, eol - pos)) {
+            size_t first = w->event_count;
+            bool pass = true;
+            if (job->filter) status = filter_record(w, pos, eol, line, &pass, info);
+            if (status == SERDEC_OK && pass) status = parse_record(w, pos, eol, line, info);
+            if (status == SERDEC_OK && pass && job->framing == SERDEC_FRAMING_JSON_SEQ)
+                status = check_truncated(w, first, eol, info);
+
+            if (status != SERDEC_OK && status != SERDEC_ERR_OUT_OF_MEMORY && job->errors &&
+                recover(job, info, pos, eol)) {
+                // Resynchronize at the next delimiter; drop the partial record's events
+                status = SERDEC_OK;
+                w->event_count = first;
+            } else if (status == SERDEC_OK && pass) {
+                status = emit_record(w, pos, line, first, info);
+            }
+            if (status != SERDEC_OK) break;
+        }
+
+        pos = eol + 1;
+        line = next_line;
+    }
+
+    return status;
+}
+
+// CONCAT: start of the records owned by chunk `index`, the first root-level boundary
+// at or after its nominal start. Every chunk computes its own start and its successor's
+// from the same scan state, so neighbouring ranges always agree.
+static size_t concat_boundary(const NdjsonJob* job, size_t index) {
+    if (index == 0) return 0;
+    if (index >= job->chunk_count || job->scan_failed) return job->size;
+
+    const NdjsonChunk* chunk = &job->chunks[index];
+    SerdecScanState state = chunk->start;
+    return chunk->begin + serdec_scan_find_boundary(&state, job->data + chunk->begin,
+                                                    job->size - chunk->begin);
+}
+
+// Advances (*mark, *line) to `pos` and returns the line containing it.
+static size_t line_at(const char* data, size_t* mark, size_t* line, size_t pos) {
+    *line += count_newlines(data + *mark, pos - *mark);
+    *mark = pos;
+    return *line;
+}
+
+// CONCAT: one parser pass over the chunk's range in sequence mode. A record ends
+// whenever the event depth returns to zero.
+static SerdecError parse_concat(NdjsonWorker* w, size_t index, SerdecErrorInfo* info) {
+    NdjsonJob* job = w->job;
+    const NdjsonChunk* chunk = &job->chunks[index];
+    size_t begin = concat_boundary(job, index);
+    size_t end = concat_boundary(job, index + 1);
+    size_t mark = chunk->begin;
+    size_t line = chunk->line;
+    SerdecError status = SERDEC_OK;
+
+    size_t resume = begin;
+    while (resume < end && !atomic_load_explicit(&job->abort, memory_order_relaxed)) {
+        serdec_json_parser_reset(w->parser, resume, end, line_at(job->data, &mark, &line, resume));
+
+        size_t depth = 0;
+        size_t first = w->event_count;
+        size_t offset = resume;
+        for (;;) {
+            SerdecEvent* ev = next_event(w, offset, line, info);
+            if (!ev) return SERDEC_ERR_OUT_OF_MEMORY;
+
+            status = serdec_json_event_next(w->parser, ev);
+            if (status != SERDEC_OK) {
+                *info = *serdec_json_parser_error(w->parser);
+                break;
+            }
+            if (ev->kind == SERDEC_EVENT_END) {
+                resume = end;
+                break;
+            }
+
+            if (!depth) offset = ev->offset;
+            w->event_count++;
+            if (ev->kind == SERDEC_EVENT_START_OBJECT || ev->kind == SERDEC_EVENT_START_ARRAY)
+                depth++;
+            else if (ev->kind == SERDEC_EVENT_END_OBJECT || ev->kind == SERDEC_EVENT_END_ARRAY)
+                depth--;
+            if (depth) continue;
+
+            status = emit_record(w, offset, line_at(job->data, &mark, &line, offset), first,
+                                 info);
+            if (status != SERDEC_OK) return status;
+            first = w->event_count;
+            resume = (size_t) (w->parser->lexer->current - w->parser->lexer->start);
+        }
+        if (status == SERDEC_OK) break;
+        if (status == SERDEC_ERR_OUT_OF_MEMORY || !job->errors) return status;
+
+        // Skip the bad value: scan from its start (known to be outside any string at the
+        // root level) to the next root-level boundary
+        w->event_count = first;
+        while (resume < end && is_ws(job->data[resume])) resume++;
+        SerdecScanState state = { 0 };
+        size_t skip = resume + serdec_scan_find_boundary(&state, job->data + resume,
+                                                         end - resume);
+        if (!recover(job, info, resume, skip)) return status;
+        status = SERDEC_OK;
+        resume = skip;
+    }
+
+    return status;
+}
+
+static void process_chunk(NdjsonWorker* w, size_t index) {
+    NdjsonJob* job = w->job;
+    SerdecErrorInfo info = { 0 };
+
+    serdec_arena_reset(w->arena);
+    w->event_count = 0;
+    w->pending_count = 0;
+
+    SerdecError status = (job->framing == SERDEC_FRAMING_CONCAT)
+                       ? parse_concat(w, index, &info)
+                       : parse_delimited(w, &job->chunks[index], &info);
+
+    if (job->ordered)
+        deliver_in_order(w, index, status, &info);
+    else if (status != SERDEC_OK)
+        report_error(job, status, &info);
+}
+
+static void* worker_main(void* arg) {
+    NdjsonWorker* w = (NdjsonWorker*) arg;
+    NdjsonJob* job = w->job;
+
+    // Stage 1: count newlines per chunk so every record knows its line number. CONCAT
+    // also summarizes the structure of each chunk under both string-state hypotheses.
+    while (!job->indexed) {
+        size_t i = atomic_fetch_add(&job->next_count, 1);
+        if (i >= job->chunk_count) break;
+        NdjsonChunk* chunk = &job->chunks[i];
+        const char* ptr = job->data + chunk->begin;
+        size_t len = chunk->end - chunk->begin;
+        chunk->newlines = count_newlines(ptr, len);
+
+        if (job->framing == SERDEC_FRAMING_CONCAT) {
+            chunk->escaped_start = serdec_scan_escaped_at(job->data, chunk->begin);
+            chunk->outside = (SerdecScanState) { 0 };
+            chunk->inside = (SerdecScanState) { .in_string = true,
+                                                .escaped = chunk->escaped_start };
+            serdec_scan_advance(&chunk->outside, ptr, len);
+            serdec_scan_advance(&chunk->inside, ptr, len);
+        }
+    }
+
+    pthread_mutex_lock(&job->lock);
+    finish_counting(job, 1);
+    while (job->counting)
+        pthread_cond_wait(&job->cond, &job->lock);
+    pthread_mutex_unlock(&job->lock);
+
+    // Stage 2: parse chunks
+    while (!atomic_load(&job->abort)) {
+        size_t i = atomic_fetch_add(&job->next_parse, 1);
+        if (i >= job->chunk_count) break;
+        process_chunk(w, i);
+    }
+
+    return NULL;
+}
+
+SerdecError serdec_ndjson_parallel(SerdecBuffer* buf, const SerdecNdjsonConfig* config,
+                                   SerdecNdjsonCallback cb, void* user, SerdecErrorInfo* err) {
+    if (!buf || buf->magic != SERDEC_MAGIC_BUFFER || !cb) return SERDEC_ERR_INVALID_HANDLE;
+
+    unsigned threads = (config && config->threads) ? config->threads : serdec_cpu_count();
+    size_t chunk_size = (config && config->chunk_size) ? config->chunk_size
+                                                       : SERDEC_NDJSON_DEFAULT_CHUNK;
+    const SerdecNdjsonIndex* index = config ? config->index : NULL;
+    size_t first = 0;
+    size_t last = 0;
+    if (index) {
+        if (!serdec_ndjson_index_matches(index, buf) || config->framing != SERDEC_FRAMING_NDJSON)
+            return SERDEC_ERR_INVALID_HANDLE;
+        size_t records = serdec_ndjson_index_count(index);
+        first = config->first;
+        if (first > records) return SERDEC_ERR_NOT_FOUND;
+        last = config->count ? first + config->count : records;
+        if (last > records || last < first) return SERDEC_ERR_NOT_FOUND;
+        if (first == last) return SERDEC_OK;
+    }
+    const SerdecNdjsonFilter* filter = config ? config->filter : NULL;
+    if (filter && (!serdec_ndjson_filter_valid(filter) ||
+                   config->framing == SERDEC_FRAMING_CONCAT))
+        return SERDEC_ERR_INVALID_HANDLE;
+    if (buf->size == 0) return SERDEC_OK;
+
+    NdjsonChunk* chunks = (NdjsonChunk*) malloc((buf->size / chunk_size + 1) * sizeof(*chunks));
+    if (!chunks) return SERDEC_ERR_OUT_OF_MEMORY;
+
+    NdjsonJob job = {
+        .data = buf->data,
+        .size = buf->size,
+        .framing = config ? config->framing : SERDEC_FRAMING_NDJSON,
+        .ordered = config && config->ordered,
+        .cb = cb,
+        .user = user,
+        .errors = config ? config->errors : NULL,
+        .max_errors = config ? config->max_errors : 0,
+        .first_error = serdec_error_list_count(config ? config->errors : NULL),
+        .indexed = index != NULL,
+        .filter = filter,
+        .chunks = chunks,
+        .status = SERDEC_OK,
+    };
+    job.chunk_count = index ? split_indexed(index, first, last, chunk_size, chunks)
+                            : split_chunks(&job, chunk_size, chunks);
+    atomic_init(&job.next_count, 0);
+    atomic_init(&job.next_parse, 0);
+    atomic_init(&job.abort, false);
+    pthread_mutex_init(&job.lock, NULL);
+    pthread_cond_init(&job.cond, NULL);
+
+    if (threads > job.chunk_count) threads = (unsigned) job.chunk_count;
+
+    SerdecError status = SERDEC_OK;
+    NdjsonWorker* workers = (NdjsonWorker*) calloc(threads, sizeof(*workers));
+    if (!workers) status = SERDEC_ERR_OUT_OF_MEMORY;
+
+    // Parsers are created up front, so running out of memory stops the job before it starts
+    for (unsigned i = 0; workers && i < threads; i++) {
+        workers[i] = (NdjsonWorker) {
+            .job = &job,
+            .id = i,
+            .parser = serdec_json_parser_from_buffer(buf),
+            .arena = serdec_arena_create(NULL),
+        };
+        if (!workers[i].parser || !workers[i].arena) status = SERDEC_ERR_OUT_OF_MEMORY;
+        serdec_json_parser_set_sequence(workers[i].parser, job.framing == SERDEC_FRAMING_CONCAT);
+    }
+
+    if (status == SERDEC_OK) {
+        job.counting = threads;
+
+        unsigned started = 1;
+        for (; started < threads; started++) {
+            if (pthread_create(&workers[started].thread, NULL, worker_main, &workers[started]))
+                break;
+        }
+        if (started < threads) {
+            pthread_mutex_lock(&job.lock);
+            finish_counting(&job, threads - started);
+            pthread_mutex_unlock(&job.lock);
+        }
+
+        worker_main(&workers[0]); // The calling thread is worker 0
+        for (unsigned i = 1; i < started; i++)
+            pthread_join(workers[i].thread, NULL);
+
+        status = job.status;
+        if (status != SERDEC_OK && err) *err = job.error;
+        serdec_error_list_sort(job.errors, job.first_error);
+    }
+
+    for (unsigned i = 0; workers && i < threads; i++) {
+        serdec_json_parser_destroy(workers[i].parser);
+        serdec_arena_destroy(workers[i].arena);
+        free(workers[i].events);
+        free(workers[i].pending);
+    }
+    free(workers);
+    pthread_cond_destroy(&job.cond);
+    pthread_mutex_destroy(&job.lock);
+    free(chunks);
+
+    return status;
+}
@@ -0,0 +1,135 @@
+#include "internal.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The same interned key matches by address. Keys interned in different tables match by
+// bytes, and their stored hashes rule out most mismatches first.
+static bool key_equals(const SerdecValue* node, const char* key, size_t len, bool interned) {
+    if (serdec_tag_len(node) != len) return false;
+    if (node->str == key) return true;
+    if (interned && serdec_tag_sub(node) == SERDEC_STRING_INTERNED &&
+        serdec_intern_entry(node->str)->hash != serdec_intern_entry(key)->hash)
+        return false;
+    return memcmp(node->str, key, len) == 0;
+}
+
+void serdec_key_table_fill(uint32_t* table, const SerdecValue* keys, size_t stride,
+                           size_t count) {
+    size_t mask = serdec_index_capacity(count) - 1;
+    memset(table, 0, (mask + 1) * sizeof(*table));
+
+    // Inserting in order keeps the first of several duplicate keys first in its probe
+    // sequence.
+    for (size_t i = 0; i < count; i++) {
+        size_t slot = serdec_key_hash(&keys[i * stride]) & mask;
+        while (table[slot]) slot = (slot + 1) & mask;
+        table[slot] = (uint32_t) (i + 1);
+    }
+}
+
+uint32_t* serdec_key_table_build(SerdecArena* arena, const SerdecValue* keys, size_t stride,
+                                 size_t count) {
+    uint32_t* table = (uint32_t*) serdec_arena_alloc_aligned(
+        arena, serdec_index_capacity(count) * sizeof(*table), _Alignof(uint32_t));
+    if (table) serdec_key_table_fill(table, keys, stride, count);
+    return table;
+}
+
+size_t serdec_key_find(const SerdecValue* keys, size_t stride, size_t count,
+                       const uint32_t* table, const char* key, size_t len, bool interned,
+                       const uint64_t* hash) {
+    if (table) {
+        size_t mask = serdec_index_capacity(count) - 1;
+        uint64_t start = hash       ? *hash
+                       : interned   ? serdec_intern_entry(key)->hash
+                                    : serdec_hash(key, len);
+        for (size_t slot = start & mask; table[slot]; slot = (slot + 1) & mask) {
+            size_t i = table[slot] - 1;
+            if (i < count && key_equals(&keys[i * stride], key, len, interned)) return i;
+        }
+        return SIZE_MAX;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (key_equals(&keys[i * stride], key, len, interned)) return i;
+    }
+    return SIZE_MAX;
+}
+
+static bool shape_matches(const SerdecShape* shape, uint64_t hash, const SerdecValue* keys,
+                          size_t stride, size_t count) {
+    if (shape->hash != hash || shape->count != count) return false;
+    for (size_t i = 0; i < count; i++) {
+        if (!serdec_keys_equal(&shape->keys[i], &keys[i * stride])) return false;
+    }
+    return true;
+}
+
+static bool grow(SerdecShapeSet* set) {
+    size_t capacity = set->capacity ? set->capacity * 2 : 64;
+    const SerdecShape** slots = (const SerdecShape**) calloc(capacity, sizeof(*slots));
+    if (!slots) return false;
+
+    for (size_t i = 0; i < set->capacity; i++) {
+        const SerdecShape* shape = set->slots[i];
+        if (!shape) continue;
+        size_t slot = shape->hash & (capacity - 1);
+        while (slots[slot]) slot = (slot + 1) & (capacity - 1);
+        slots[slot] = shape;
+    }
+
+    free(set->slots);
+    set->slots = slots;
+    set->capacity = capacity;
+    return true;
+}
+
+SerdecError serdec_shape_get(SerdecShapeSet* set, SerdecArena* arena, const SerdecValue* keys,
+                             size_t stride, size_t count, const SerdecShape** out) {
+    uint64_t hash = 0xCBF29CE484222325ull ^ count;
+    for (size_t i = 0; i < count; i++) hash = (hash ^ serdec_key_hash(&keys[i * stride])) * 31;
+
+    if (set->capacity) {
+        size_t mask = set->capacity - 1;
+        for (size_t slot = hash & mask; set->slots[slot]; slot = (slot + 1) & mask) {
+            if (shape_matches(set->slots[slot], hash, keys, stride, count)) {
+                *out = set->slots[slot];
+                return SERDEC_OK;
+            }
+        }
+    }
+
+    // Keep the load factor at or below one half
+    if (2 * (set->count + 1) > set->capacity && !grow(set)) return SERDEC_ERR_OUT_OF_MEMORY;
+
+    SerdecShape* shape = (SerdecShape*) serdec_arena_alloc_aligned(arena, sizeof(*shape),
+                                                                   _Alignof(SerdecShape));
+    SerdecValue* copy = (SerdecValue*) serdec_arena_alloc_aligned(
+        arena, count * sizeof(*copy), _Alignof(SerdecValue));
+    if (!shape || !copy) return SERDEC_ERR_OUT_OF_MEMORY;
+
+    for (size_t i = 0; i < count; i++) copy[i] = keys[i * stride];
+    *shape = (SerdecShape) { .count = count, .keys = copy, .hash = hash };
+
+    // Shapes are few and shared, so their index is built up front
+    if (serdec_has_index(SERDEC_TYPE_OBJECT, count)) {
+        shape->table = serdec_key_table_build(arena, copy, 1, count);
+        if (!shape->table) return SERDEC_ERR_OUT_OF_MEMORY;
+    }
+
+    size_t mask = set->capacity - 1;
+    size_t slot = hash & mask;
+    while (set->slots[slot]) slot = (slot + 1) & mask;
+    set->slots[slot] = shape;
+    set->count++;
+
+    *out = shape;
+    return SERDEC_OK;
+}
+
+void serdec_shape_set_free(SerdecShapeSet* set) {
+    free(set->slots);
+    *set = (SerdecShapeSet) { 0 };
+}
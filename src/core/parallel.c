@@ -0,0 +1,424 @@
+#include "internal.h"
+#include <serdec/parallel.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SERDEC_PARALLEL_DEFAULT_RANGE     (1024 * 1024)
+#define SERDEC_PARALLEL_CHUNKS_PER_THREAD 4
+#define SERDEC_TAPE_SEGMENT_EVENTS        4096
+
+typedef struct TapeSegment {
+    struct TapeSegment* next;
+    size_t count;
+    SerdecEvent events[];
+} TapeSegment;
+
+typedef struct {
+    TapeSegment* head;
+    TapeSegment* tail;
+    size_t segments;
+    size_t events;
+} TapeList;
+
+typedef struct {
+    const SerdecEvent* events;
+    size_t count;
+} TapeView;
+
+struct SerdecEventTape {
+    uint32_t magic;           // 0x5EDEC00D for validation
+    bool parallel;
+    SerdecBuffer* buffer;     // Retained: events borrow strings from it
+
+    SerdecArena** arenas;     // One per worker; own all segments
+    unsigned arena_count;
+
+    TapeView* segments;
+    size_t segment_count;
+    size_t event_count;
+};
+
+typedef struct {
+    size_t begin;
+    size_t end;
+    bool escaped_start;       // Preceded by an odd run of backslashes
+    SerdecScanState outside;  // Stage 1: relative scan assuming the chunk starts outside a string
+    SerdecScanState inside;   // Stage 1: relative scan assuming it starts inside a string
+    SerdecScanState start;    // Stage 2: actual state at `begin`
+    size_t split;             // Stage 3: first root-level ',' in the chunk, or SIZE_MAX
+} ScanChunk;
+
+typedef struct {
+    size_t begin;
+    size_t end;
+    TapeList list;
+} ParseRange;
+
+typedef enum {
+    STAGE_SUMMARIZE,
+    STAGE_SPLIT,
+    STAGE_PARSE,
+} ParallelStage;
+
+typedef struct {
+    const char* data;
+    ParallelStage stage;
+
+    ScanChunk* chunks;
+    size_t chunk_count;
+    ParseRange* ranges;
+    size_t range_count;
+
+    atomic_size_t cursor;
+    atomic_bool failed;
+} ParallelJob;
+
+typedef struct {
+    ParallelJob* job;
+    SerdecParser* parser;
+    SerdecArena* arena;
+} ParallelWorker;
+
+static SerdecEvent* tape_reserve(SerdecArena* arena, TapeList* list) {
+    TapeSegment* seg = list->tail;
+    if (seg && seg->count < SERDEC_TAPE_SEGMENT_EVENTS) return &seg->events[seg->count];
+
+    seg = (TapeSegment*) serdec_arena_alloc_aligned(
+        arena, sizeof(*seg) + SERDEC_TAPE_SEGMENT_EVENTS * sizeof(SerdecEvent),
+        _Alignof(TapeSegment));
+    if (!seg) return NULL;
+
+    seg->next = NULL;
+    seg->count = 0;
+    if (list->tail) list->tail->next = seg;
+    else list->head = seg;
+    list->tail = seg;
+    list->segments++;
+    return &seg->events[0];
+}
+
+static void tape_commit(TapeList* list) {
+    list->tail->count++;
+    list->events++;
+}
+
+static SerdecError tape_append(SerdecArena* arena, TapeList* list, SerdecEvent ev) {
+    SerdecEvent* slot = tape_reserve(arena, list);
+    if (!slot) return SERDEC_ERR_OUT_OF_MEMORY;
+    *slot = ev;
+    tape_commit(list);
+    return SERDEC_OK;
+}
+
+// Pulls events until END. The END event itself is not stored.
+static SerdecError tape_fill(SerdecParser* parser, SerdecArena* arena, TapeList* list) {
+    for (;;) {
+        SerdecEvent* ev = tape_reserve(arena, list);
+        if (!ev) return SERDEC_ERR_OUT_OF_MEMORY;
+
+        SerdecError status = serdec_json_event_next(parser, ev);
+        if (status != SERDEC_OK) return status;
+        if (ev->kind == SERDEC_EVENT_END) return SERDEC_OK;
+        tape_commit(list);
+    }
+}
+
+static SerdecError tape_collect(SerdecEventTape* tape, const TapeList* lists, size_t count) {
+    size_t segments = 0;
+    for (size_t i = 0; i < count; i++) segments += lists[i].segments;
+
+    tape->segments = (TapeView*) malloc((segments ? segments : 1) * sizeof(TapeView));
+    if (!tape->segments) return SERDEC_ERR_OUT_OF_MEMORY;
+
+    for (size_t i = 0; i < count; i++) {
+        for (TapeSegment* seg = lists[i].head; seg; seg = seg->next) {
+            if (!seg->count) continue;
+            tape->segments[tape->segment_count++] = (TapeView) { seg->events, seg->count };
+            tape->event_count += seg->count;
+        }
+    }
+    return SERDEC_OK;
+}
+
+static SerdecEventTape* tape_create(SerdecBuffer* buf, unsigned arena_count) {
+    SerdecEventTape* tape = (SerdecEventTape*) calloc(1, sizeof(*tape));
+    if (!tape) return NULL;
+
+    tape->arenas = (SerdecArena**) calloc(arena_count, sizeof(SerdecArena*));
+    if (!tape->arenas) {
+        free(tape);
+        return NULL;
+    }
+
+    tape->magic = SERDEC_MAGIC_TAPE;
+    tape->arena_count = arena_count;
+    tape->buffer = serdec_buffer_retain(buf);
+    return tape;
+}
+
+static SerdecError parse_sequential(SerdecEventTape* tape, const SerdecArenaConfig* arena_config,
+                                    SerdecErrorInfo* err) {
+    tape->arenas[0] = serdec_arena_create(arena_config);
+    SerdecParser* parser = serdec_json_parser_from_buffer(tape->buffer);
+    if (!tape->arenas[0] || !parser) {
+        serdec_json_parser_destroy(parser);
+        return SERDEC_ERR_OUT_OF_MEMORY;
+    }
+
+    TapeList list = { 0 };
+    SerdecError status = tape_fill(parser, tape->arenas[0], &list);
+    if (status == SERDEC_OK) {
+        status = tape_collect(tape, &list, 1);
+    } else if (err) {
+        *err = *serdec_json_parser_error(parser);
+        if (status == SERDEC_ERR_OUT_OF_MEMORY) err->code = status;
+    }
+
+    serdec_json_parser_destroy(parser);
+    return status;
+}
+
+static void* worker_main(void* arg) {
+    ParallelWorker* w = (ParallelWorker*) arg;
+    ParallelJob* job = w->job;
+
+    while (!atomic_load_explicit(&job->failed, memory_order_relaxed)) {
+        size_t i = atomic_fetch_add(&job->cursor, 1);
+
+        switch (job->stage) {
+        case STAGE_SUMMARIZE: {
+            if (i >= job->chunk_count) return NULL;
+            ScanChunk* chunk = &job->chunks[i];
+            const char* ptr = job->data + chunk->begin;
+            size_t len = chunk->end - chunk->begin;
+
+            chunk->escaped_start = serdec_scan_escaped_at(job->data, chunk->begin);
+            chunk->outside = (SerdecScanState) { 0 };
+            chunk->inside = (SerdecScanState) { .in_string = true, .escaped = chunk->escaped_start };
+            serdec_scan_advance(&chunk->outside, ptr, len);
+            serdec_scan_advance(&chunk->inside, ptr, len);
+            break;
+        }
+        case STAGE_SPLIT: {
+            if (i >= job->chunk_count) return NULL;
+            ScanChunk* chunk = &job->chunks[i];
+            SerdecScanState state = chunk->start;
+            size_t len = chunk->end - chunk->begin;
+
+            size_t pos = serdec_scan_find_comma(&state, job->data + chunk->begin, len, 1);
+            chunk->split = (pos < len) ? chunk->begin + pos : SIZE_MAX;
+            break;
+        }
+        case STAGE_PARSE: {
+            if (i >= job->range_count) return NULL;
+            ParseRange* range = &job->ranges[i];
+
+            serdec_json_parser_reset_elements(w->parser, range->begin, range->end, 1);
+            if (tape_fill(w->parser, w->arena, &range->list) != SERDEC_OK)
+                atomic_store(&job->failed, true);
+            break;
+        }
+        }
+    }
+
+    return NULL;
+}
+
+static void run_stage(ParallelJob* job, ParallelWorker* workers, unsigned threads,
+                      ParallelStage stage) {
+    job->stage = stage;
+    atomic_store(&job->cursor, 0);
+    serdec_workers_run(threads, worker_main, workers, sizeof(*workers));
+}
+
+// Resolves the real string state and depth at each chunk start from the relative scans.
+// Fails when the structure cannot be a single root array: the speculation is abandoned.
+static bool chain_chunks(ParallelJob* job) {
+    SerdecScanState cur = { .depth = 1, .min_depth = 1 };
+
+    for (size_t i = 0; i < job->chunk_count; i++) {
+        ScanChunk* chunk = &job->chunks[i];
+        const SerdecScanState* rel = &chunk->outside;
+        if (cur.in_string) {
+            if (cur.escaped != chunk->escaped_start) return false;
+            rel = &chunk->inside;
+        }
+        if (cur.depth + rel->min_depth < 1) return false;
+
+        chunk->start = cur;
+        cur.in_string = rel->in_string;
+        cur.escaped = rel->escaped;
+        cur.depth += rel->depth;
+    }
+
+    return !cur.in_string && cur.depth == 1;
+}
+
+static bool is_ws(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// Attempts the parallel path. Returns false if the input must be parsed sequentially.
+static bool parse_parallel(SerdecEventTape* tape, unsigned threads, size_t min_range,
+                           const SerdecArenaConfig* arena_config) {
+    const char* data = tape->buffer->data;
+    size_t size = tape->buffer->size;
+
+    size_t open = 0;
+    while (open < size && is_ws(data[open])) open++;
+    size_t close = size;
+    while (close > open && is_ws(data[close - 1])) close--;
+    if (open >= size || data[open] != '[' || close - open < 2 || data[close - 1] != ']')
+        return false;
+    close--;
+
+    size_t begin = open + 1;
+    size_t len = close - begin;
+    size_t chunk_count = len / min_range;
+    if (chunk_count > (size_t) threads * SERDEC_PARALLEL_CHUNKS_PER_THREAD)
+        chunk_count = (size_t) threads * SERDEC_PARALLEL_CHUNKS_PER_THREAD;
+    if (chunk_count < 2) return false;
+
+    bool ok = false;
+    ParallelJob job = {
+        .data = data,
+        .chunks = (ScanChunk*) calloc(chunk_count, sizeof(ScanChunk)),
+        .chunk_count = chunk_count,
+        .ranges = (ParseRange*) calloc(chunk_count, sizeof(ParseRange)),
+    };
+    ParallelWorker* workers = (ParallelWorker*) calloc(threads, sizeof(ParallelWorker));
+    TapeList* lists = (TapeList*) calloc(chunk_count + 2, sizeof(TapeList));
+    atomic_init(&job.cursor, 0);
+    atomic_init(&job.failed, false);
+    if (!job.chunks || !job.ranges || !workers || !lists) goto done;
+
+    for (size_t i = 0; i < chunk_count; i++) {
+        job.chunks[i].begin = begin + len * i / chunk_count;
+        job.chunks[i].end = begin + len * (i + 1) / chunk_count;
+    }
+
+    for (unsigned i = 0; i < threads; i++) {
+        workers[i] = (ParallelWorker) {
+            .job = &job,
+            .parser = serdec_json_parser_from_buffer(tape->buffer),
+            .arena = serdec_arena_create(arena_config),
+        };
+        tape->arenas[i] = workers[i].arena;
+        if (!workers[i].parser || !workers[i].arena) goto done;
+    }
+
+    // Stages 1-3: find the root-level commas closest to each nominal chunk boundary
+    run_stage(&job, workers, threads, STAGE_SUMMARIZE);
+    if (!chain_chunks(&job)) goto done;
+    run_stage(&job, workers, threads, STAGE_SPLIT);
+
+    size_t prev = begin;
+    for (size_t i = 1; i < chunk_count; i++) {
+        if (job.chunks[i].split == SIZE_MAX) continue;
+        job.ranges[job.range_count++] = (ParseRange) { .begin = prev, .end = job.chunks[i].split };
+        prev = job.chunks[i].split + 1;
+    }
+    job.ranges[job.range_count++] = (ParseRange) { .begin = prev, .end = close };
+    if (job.range_count < 2) goto done;
+
+    // Stage 4: parse ranges. Any failure invalidates the speculation.
+    run_stage(&job, workers, threads, STAGE_PARSE);
+    if (atomic_load(&job.failed)) goto done;
+
+    // Stitch: '[' + ranges in order + ']'
+    SerdecArena* arena = workers[0].arena;
+    if (tape_append(arena, &lists[0],
+                    (SerdecEvent) { .kind = SERDEC_EVENT_START_ARRAY, .offset = open }) ||
+        tape_append(arena, &lists[job.range_count + 1],
+                    (SerdecEvent) { .kind = SERDEC_EVENT_END_ARRAY, .offset = close }))
+        goto done;
+    for (size_t i = 0; i < job.range_count; i++) lists[i + 1] = job.ranges[i].list;
+
+    ok = tape_collect(tape, lists, job.range_count + 2) == SERDEC_OK;
+
+done:
+    for (unsigned i = 0; workers && i < threads; i++) {
+        serdec_json_parser_destroy(workers[i].parser);
+        if (!ok) {
+            serdec_arena_destroy(workers[i].arena);
+            tape->arenas[i] = NULL;
+        }
+    }
+    if (!ok) {
+        free(tape->segments);
+        tape->segments = NULL;
+        tape->segment_count = 0;
+        tape->event_count = 0;
+    }
+    free(lists);
+    free(workers);
+    free(job.ranges);
+    free(job.chunks);
+    return ok;
+}
+
+SerdecError serdec_json_parse_parallel(SerdecBuffer* buf, const SerdecParallelConfig* config,
+                                       SerdecEventTape** out, SerdecErrorInfo* err) {
+    if (!buf || buf->magic != SERDEC_MAGIC_BUFFER || !out) return SERDEC_ERR_INVALID_HANDLE;
+    *out = NULL;
+
+    unsigned threads = (config && config->threads) ? config->threads : serdec_cpu_count();
+    size_t min_range = (config && config->min_range) ? config->min_range
+                                                     : SERDEC_PARALLEL_DEFAULT_RANGE;
+    const SerdecArenaConfig* arena_config = config ? &config->arena : NULL;
+
+    SerdecEventTape* tape = tape_create(buf, threads);
+    if (!tape) return SERDEC_ERR_OUT_OF_MEMORY;
+
+    if (threads > 1 && parse_parallel(tape, threads, min_range, arena_config)) {
+        tape->parallel = true;
+        *out = tape;
+        return SERDEC_OK;
+    }
+
+    SerdecError status = parse_sequential(tape, arena_config, err);
+    if (status != SERDEC_OK) {
+        serdec_event_tape_destroy(tape);
+        return status;
+    }
+
+    *out = tape;
+    return SERDEC_OK;
+}
+
+size_t serdec_event_tape_count(const SerdecEventTape* tape) {
+    if (!tape || tape->magic != SERDEC_MAGIC_TAPE) return 0;
+    return tape->event_count;
+}
+
+size_t serdec_event_tape_segments(const SerdecEventTape* tape) {
+    if (!tape || tape->magic != SERDEC_MAGIC_TAPE) return 0;
+    return tape->segment_count;
+}
+
+const SerdecEvent* serdec_event_tape_segment(const SerdecEventTape* tape, size_t index,
+                                             size_t* count) {
+    if (!tape || tape->magic != SERDEC_MAGIC_TAPE || index >= tape->segment_count) return NULL;
+    if (count) *count = tape->segments[index].count;
+    return tape->segments[index].events;
+}
+
+bool serdec_event_tape_is_parallel(const SerdecEventTape* tape) {
+    if (!tape || tape->magic != SERDEC_MAGIC_TAPE) return false;
+    return tape->parallel;
+}
+
+void serdec_event_tape_destroy(SerdecEventTape* tape) {
+    if (!tape || tape->magic != SERDEC_MAGIC_TAPE) return;
+
+    tape->magic = SERDEC_MAGIC_FREED;
+    for (unsigned i = 0; i < tape->arena_count; i++)
+        serdec_arena_destroy(tape->arenas[i]);
+    serdec_buffer_release(tape->buffer);
+    free(tape->arenas);
+    free(tape->segments);
+    free(tape);
+}
@@ -1 +1,351 @@
 #include "internal.h"
+#include "serdec/error.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Byte offset of a token. String tokens start after the opening quote.
+static size_t token_offset(const SerdecParser* parser, const SerdecToken* tok) {
+    const SerdecLexer* lexer = parser->lexer;
+    if (!tok->start) return lexer->current - lexer->start;
+    if (tok->type == SERDEC_TOKEN_STRING) return (tok->start - 1) - lexer->start;
+    return tok->start - lexer->start;
+}
+
+static SerdecError fail(SerdecParser* parser, SerdecEvent* ev, SerdecError code,
+                        const SerdecToken* tok, const char* message) {
+    const SerdecLexer* lexer = parser->lexer;
+    size_t offset = tok ? token_offset(parser, tok) : (size_t) (lexer->current - lexer->start);
+    size_t consumed = (lexer->start + offset <= lexer->current)
+                    ? (size_t) (lexer->current - (lexer->start + offset)) : 0;
+
+    parser->error = (SerdecErrorInfo) {
+        .code = code,
+        .offset = offset,
+        .line = lexer->line,
+        // Tokens never span lines, so the column can be rewound to the token start
+        .column = lexer->column > consumed ? lexer->column - consumed : 1,
+    };
+    if (message)
+        snprintf(parser->error.message, sizeof(parser->error.message), "%s", message);
+
+    parser->state = SERDEC_PARSER_ERROR;
+    ev->kind = SERDEC_EVENT_ERROR;
+    ev->offset = offset;
+    return code;
+}
+
+static SerdecError fail_lexer(SerdecParser* parser, SerdecEvent* ev) {
+    parser->error = parser->lexer->error;
+    parser->state = SERDEC_PARSER_ERROR;
+    ev->kind = SERDEC_EVENT_ERROR;
+    ev->offset = parser->error.offset;
+    return parser->error.code;
+}
+
+static SerdecError fail_token(SerdecParser* parser, SerdecEvent* ev, const SerdecToken* tok,
+                              const char* message) {
+    if (tok->type == SERDEC_TOKEN_ERROR) return fail_lexer(parser, ev);
+    if (tok->type == SERDEC_TOKEN_EOF)
+        return fail(parser, ev, SERDEC_ERR_UNEXPECTED_EOF, tok, message);
+    return fail(parser, ev, SERDEC_ERR_UNEXPECTED_CHAR, tok, message);
+}
+
+// A value just finished: decide what comes next.
+static void value_done(SerdecParser* parser) {
+    parser->state = parser->depth ? SERDEC_PARSER_AFTER_VALUE : SERDEC_PARSER_DONE;
+}
+
+static SerdecError open_container(SerdecParser* parser, SerdecEvent* ev,
+                                  const SerdecToken* tok, uint8_t kind) {
+    if (parser->depth >= parser->max_depth)
+        return fail(parser, ev, SERDEC_ERR_DEPTH_LIMIT, tok, "nesting depth limit exceeded");
+
+    parser->stack[parser->depth++] = kind;
+    parser->state = (kind == '{') ? SERDEC_PARSER_OBJECT_FIRST : SERDEC_PARSER_ARRAY_FIRST;
+    ev->kind = (kind == '{') ? SERDEC_EVENT_START_OBJECT : SERDEC_EVENT_START_ARRAY;
+    ev->offset = token_offset(parser, tok);
+    return SERDEC_OK;
+}
+
+static SerdecError close_container(SerdecParser* parser, SerdecEvent* ev,
+                                   const SerdecToken* tok) {
+    parser->depth--;
+    ev->kind = (tok->type == SERDEC_TOKEN_RBRACE) ? SERDEC_EVENT_END_OBJECT
+                                                  : SERDEC_EVENT_END_ARRAY;
+    ev->offset = token_offset(parser, tok);
+    value_done(parser);
+    return SERDEC_OK;
+}
+
+static SerdecError emit_value(SerdecParser* parser, SerdecEvent* ev, const SerdecToken* tok) {
+    ev->offset = token_offset(parser, tok);
+
+    switch (tok->type) {
+    case SERDEC_TOKEN_LBRACE:   return open_container(parser, ev, tok, '{');
+    case SERDEC_TOKEN_LBRACKET: return open_container(parser, ev, tok, '[');
+
+    case SERDEC_TOKEN_STRING:
+        ev->kind = SERDEC_EVENT_STRING;
+        ev->string = (SerdecString) { tok->start, tok->length, tok->string.has_escapes };
+        break;
+    case SERDEC_TOKEN_NUMBER:
+        parser->token = *tok;
+        ev->kind = SERDEC_EVENT_NUMBER;
+        ev->string = (SerdecString) { tok->start, tok->length, false };
+        break;
+    case SERDEC_TOKEN_TRUE:
+    case SERDEC_TOKEN_FALSE:
+        ev->kind = SERDEC_EVENT_BOOL;
+        ev->boolean = (tok->type == SERDEC_TOKEN_TRUE);
+        break;
+    case SERDEC_TOKEN_NULL:
+        ev->kind = SERDEC_EVENT_NULL;
+        break;
+
+    default: return fail_token(parser, ev, tok, "expected a value");
+    }
+
+    value_done(parser);
+    return SERDEC_OK;
+}
+
+static SerdecError emit_key(SerdecParser* parser, SerdecEvent* ev, const SerdecToken* tok) {
+    if (tok->type != SERDEC_TOKEN_STRING)
+        return fail_token(parser, ev, tok, "expected a string key");
+
+    SerdecToken colon = serdec_lexer_next(parser->lexer);
+    if (colon.type != SERDEC_TOKEN_COLON)
+        return fail_token(parser, ev, &colon, "expected ':' after object key");
+
+    ev->kind = SERDEC_EVENT_KEY;
+    ev->offset = token_offset(parser, tok);
+    ev->string = (SerdecString) { tok->start, tok->length, tok->string.has_escapes };
+    parser->state = SERDEC_PARSER_VALUE;
+    return SERDEC_OK;
+}
+
+SerdecParser* serdec_json_parser_from_buffer(SerdecBuffer* buf) {
+    if (!buf || buf->magic != SERDEC_MAGIC_BUFFER) return NULL;
+
+    SerdecParser* parser = (SerdecParser*) malloc(sizeof(*parser));
+    if (!parser) return NULL;
+
+    *parser = (SerdecParser) {
+        .magic = SERDEC_MAGIC_PARSER,
+        .lexer = serdec_lexer_create(buf),
+        .state = SERDEC_PARSER_VALUE,
+        .stack = (uint8_t*) malloc(SERDEC_DEFAULT_MAX_DEPTH),
+        .depth = 0,
+        .max_depth = SERDEC_DEFAULT_MAX_DEPTH,
+    };
+
+    if (!parser->lexer || !parser->stack) {
+        serdec_lexer_destroy(parser->lexer);
+        free(parser->stack);
+        free(parser);
+        return NULL;
+    }
+
+    return parser;
+}
+
+SerdecParser* serdec_json_parser_create(const char* input, size_t len) {
+    SerdecBuffer* buf = serdec_buffer_from_string(input, len);
+    if (!buf) return NULL;
+
+    SerdecParser* parser = serdec_json_parser_from_buffer(buf);
+    serdec_buffer_release(buf); // parser retains it
+    return parser;
+}
+
+void serdec_json_parser_destroy(SerdecParser* parser) {
+    if (!parser || parser->magic != SERDEC_MAGIC_PARSER) return;
+
+    parser->magic = SERDEC_MAGIC_FREED;
+    serdec_lexer_destroy(parser->lexer);
+    free(parser->stack);
+    free(parser);
+}
+
+bool serdec_json_parser_set_max_depth(SerdecParser* parser, size_t max_depth) {
+    if (!parser || parser->magic != SERDEC_MAGIC_PARSER || !max_depth ||
+        max_depth < parser->depth) return false;
+
+    uint8_t* stack = (uint8_t*) realloc(parser->stack, max_depth);
+    if (!stack) return false;
+
+    parser->stack = stack;
+    parser->max_depth = max_depth;
+    return true;
+}
+
+SerdecError serdec_json_parser_fail(SerdecParser* parser, SerdecError code, size_t offset,
+                                    const char* message) {
+    SerdecToken tok = { .type = SERDEC_TOKEN_NULL, .start = parser->lexer->start + offset };
+    SerdecEvent ev;
+    return fail(parser, &ev, code, &tok, message);
+}
+
+void serdec_json_parser_reset(SerdecParser* parser, size_t begin, size_t end, size_t line) {
+    if (!parser || parser->magic != SERDEC_MAGIC_PARSER) return;
+
+    serdec_lexer_reset(parser->lexer, begin, end, line);
+    // In sequence mode DONE means "between root values", which also allows empty input
+    parser->state = parser->sequence ? SERDEC_PARSER_DONE : SERDEC_PARSER_VALUE;
+    parser->depth = 0;
+    parser->floor = 0;
+    parser->error = (SerdecErrorInfo) { 0 };
+}
+
+void serdec_json_parser_reset_elements(SerdecParser* parser, size_t begin, size_t end,
+                                       size_t line) {
+    if (!parser || parser->magic != SERDEC_MAGIC_PARSER) return;
+
+    serdec_json_parser_reset(parser, begin, end, line);
+    parser->state = SERDEC_PARSER_VALUE;
+    parser->stack[0] = '[';
+    parser->depth = 1;
+    parser->floor = 1;
+}
+
+void serdec_json_parser_reset_members(SerdecParser* parser, size_t begin, size_t end,
+                                      size_t line) {
+    if (!parser || parser->magic != SERDEC_MAGIC_PARSER) return;
+
+    serdec_json_parser_reset(parser, begin, end, line);
+    parser->state = SERDEC_PARSER_KEY;
+    parser->stack[0] = '{';
+    parser->depth = 1;
+    parser->floor = 1;
+}
+
+SerdecError serdec_json_skip(SerdecParser* parser) {
+    if (!parser || parser->magic != SERDEC_MAGIC_PARSER) return SERDEC_ERR_INVALID_HANDLE;
+    if (parser->state != SERDEC_PARSER_ARRAY_FIRST && parser->state != SERDEC_PARSER_OBJECT_FIRST)
+        return (parser->state == SERDEC_PARSER_ERROR) ? parser->error.code : SERDEC_OK;
+
+    SerdecLexer* lexer = parser->lexer;
+    SerdecScanState scan = { .depth = 1 };
+    size_t len = lexer->end - lexer->current;
+    size_t n = serdec_scan_find_boundary(&scan, lexer->current, len);
+
+    // Keep line/column in step with the bytes jumped over
+    const char* bol = NULL;
+    for (const char* p = lexer->current; (p = memchr(p, '\n', lexer->current + n - p)); p++) {
+        lexer->line++;
+        bol = p + 1;
+    }
+    lexer->column = bol ? (size_t) (lexer->current + n - bol) + 1 : lexer->column + n;
+    lexer->current += n;
+
+    SerdecEvent ev;
+    if (scan.depth != 0)
+        return fail(parser, &ev, SERDEC_ERR_UNEXPECTED_EOF, NULL, "unterminated container");
+
+    uint8_t open = parser->stack[parser->depth - 1];
+    if (lexer->current[-1] != ((open == '{') ? '}' : ']')) {
+        SerdecToken tok = { .type = SERDEC_TOKEN_RBRACKET, .start = lexer->current - 1 };
+        return fail(parser, &ev, SERDEC_ERR_UNEXPECTED_CHAR, &tok, "mismatched closing bracket");
+    }
+
+    parser->depth--;
+    value_done(parser);
+    return SERDEC_OK;
+}
+
+void serdec_json_parser_set_sequence(SerdecParser* parser, bool sequence) {
+    if (!parser || parser->magic != SERDEC_MAGIC_PARSER) return;
+    parser->sequence = sequence;
+    if (!parser->depth &&
+        (parser->state == SERDEC_PARSER_VALUE || parser->state == SERDEC_PARSER_DONE))
+        parser->state = sequence ? SERDEC_PARSER_DONE : SERDEC_PARSER_VALUE;
+}
+
+const SerdecErrorInfo* serdec_json_parser_error(const SerdecParser* parser) {
+    if (!parser || parser->magic != SERDEC_MAGIC_PARSER) return NULL;
+    return &parser->error;
+}
+
+SerdecError serdec_json_event_next(SerdecParser* parser, SerdecEvent* ev) {
+    if (!ev) return SERDEC_ERR_INVALID_HANDLE;
+    if (!parser || parser->magic != SERDEC_MAGIC_PARSER) {
+        ev->kind = SERDEC_EVENT_ERROR;
+        return SERDEC_ERR_INVALID_HANDLE;
+    }
+
+    switch (parser->state) {
+    case SERDEC_PARSER_ERROR:
+        ev->kind = SERDEC_EVENT_ERROR;
+        ev->offset = parser->error.offset;
+        return parser->error.code;
+    case SERDEC_PARSER_END:
+        ev->kind = SERDEC_EVENT_END;
+        ev->offset = parser->lexer->current - parser->lexer->start;
+        return SERDEC_OK;
+    default:
+        break;
+    }
+
+    SerdecToken tok = serdec_lexer_next(parser->lexer);
+    if (tok.type == SERDEC_TOKEN_ERROR) return fail_lexer(parser, ev);
+
+    switch (parser->state) {
+    case SERDEC_PARSER_VALUE:
+        return emit_value(parser, ev, &tok);
+
+    case SERDEC_PARSER_ARRAY_FIRST:
+        if (tok.type == SERDEC_TOKEN_RBRACKET) return close_container(parser, ev, &tok);
+        return emit_value(parser, ev, &tok);
+
+    case SERDEC_PARSER_OBJECT_FIRST:
+        if (tok.type == SERDEC_TOKEN_RBRACE) return close_container(parser, ev, &tok);
+        return emit_key(parser, ev, &tok);
+
+    case SERDEC_PARSER_KEY:
+        return emit_key(parser, ev, &tok);
+
+    case SERDEC_PARSER_AFTER_VALUE: {
+        uint8_t top = parser->stack[parser->depth - 1];
+
+        if (tok.type == SERDEC_TOKEN_COMMA) {
+            tok = serdec_lexer_next(parser->lexer);
+            if (tok.type == SERDEC_TOKEN_ERROR) return fail_lexer(parser, ev);
+            return (top == '{') ? emit_key(parser, ev, &tok) : emit_value(parser, ev, &tok);
+        }
+
+        // Element range: the enclosing array is implicit and never closes
+        if (parser->depth == parser->floor) {
+            if (tok.type != SERDEC_TOKEN_EOF)
+                return fail_token(parser, ev, &tok, "expected ',' or end of element range");
+            parser->state = SERDEC_PARSER_END;
+            ev->kind = SERDEC_EVENT_END;
+            ev->offset = token_offset(parser, &tok);
+            return SERDEC_OK;
+        }
+
+        if ((top == '{' && tok.type == SERDEC_TOKEN_RBRACE) ||
+            (top == '[' && tok.type == SERDEC_TOKEN_RBRACKET))
+            return close_container(parser, ev, &tok);
+
+        return fail_token(parser, ev, &tok, (top == '{') ? "expected ',' or '}' after object member"
+                                                         : "expected ',' or ']' after array element");
+    }
+
+    case SERDEC_PARSER_DONE:
+        if (parser->sequence && tok.type != SERDEC_TOKEN_EOF)
+            return emit_value(parser, ev, &tok);
+        if (tok.type != SERDEC_TOKEN_EOF)
+            return fail(parser, ev, SERDEC_ERR_TRAILING_CHARS, &tok,
+                        "unexpected data after root value");
+        parser->state = SERDEC_PARSER_END;
+        ev->kind = SERDEC_EVENT_END;
+        ev->offset = token_offset(parser, &tok);
+        return SERDEC_OK;
+
+    default:
+        return fail(parser, ev, SERDEC_ERR_INVALID_HANDLE, NULL, "corrupted parser state");
+    }
+}
@@ -0,0 +1,156 @@
+#include "internal.h"
+#include <serdec/pointer.h>
+#include <serdec/dom.h>
+#include <serdec/json.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// One reference token, decoded.
+typedef struct {
+    const char* key;          // NUL-terminated, in the pointer's allocation
+    size_t len;
+    uint64_t hash;            // serdec_hash() of key
+    size_t index;             // Array index, or SIZE_MAX if the token is not one
+} PointerStep;
+
+struct SerdecPointer {
+    uint32_t magic;           // 0x5EDEC014 for validation
+    size_t count;
+    PointerStep steps[];      // Followed by the decoded keys
+};
+
+// "0" or digits without a leading zero. Indices too large for size_t cannot exist.
+static size_t token_index(const char* key, size_t len) {
+    if (!len || (key[0] == '0' && len > 1)) return SIZE_MAX;
+
+    size_t index = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (key[i] < '0' || key[i] > '9') return SIZE_MAX;
+        if (index > (SIZE_MAX - 9) / 10) return SIZE_MAX;
+        index = index * 10 + (size_t) (key[i] - '0');
+    }
+    return index;
+}
+
+SerdecError serdec_pointer_compile(const char* text, SerdecPointer** out) {
+    if (!text || !out) return SERDEC_ERR_INVALID_HANDLE;
+    *out = NULL;
+    if (text[0] && text[0] != '/') return SERDEC_ERR_INVALID_PATH;
+
+    // Each token decodes to at most its own length, plus a NUL in place of its '/'
+    size_t len = strlen(text);
+    size_t count = 0;
+    for (const char* p = text; *p; p++) count += (*p == '/');
+    SerdecPointer* pointer = (SerdecPointer*) malloc(sizeof(*pointer) +
+                                                     count * sizeof(PointerStep) + len);
+    if (!pointer) return SERDEC_ERR_OUT_OF_MEMORY;
+    pointer->magic = SERDEC_MAGIC_POINTER;
+    pointer->count = count;
+
+    char* keys = (char*) &pointer->steps[count];
+    const char* p = text;
+    for (size_t i = 0; i < count; i++) {
+        char* key = keys;
+        for (p++; *p && *p != '/'; p++) {
+            if (*p != '~') {
+                *keys++ = *p;
+            } else if (p[1] == '0' || p[1] == '1') {
+                *keys++ = (p[1] == '0') ? '~' : '/';
+                p++;
+            } else {
+                free(pointer);
+                return SERDEC_ERR_INVALID_PATH;
+            }
+        }
+        size_t key_len = (size_t) (keys - key);
+        *keys++ = '\0';
+        pointer->steps[i] = (PointerStep) {
+            .key = key,
+            .len = key_len,
+            .hash = serdec_hash(key, key_len),
+            .index = token_index(key, key_len),
+        };
+    }
+
+    *out = pointer;
+    return SERDEC_OK;
+}
+
+void serdec_pointer_destroy(SerdecPointer* pointer) {
+    if (!pointer || pointer->magic != SERDEC_MAGIC_POINTER) return;
+    pointer->magic = SERDEC_MAGIC_FREED;
+    free(pointer);
+}
+
+SerdecError serdec_pointer_get(const SerdecPointer* pointer, const SerdecValue* root,
+                               const SerdecValue** out) {
+    if (!pointer || pointer->magic != SERDEC_MAGIC_POINTER || !root || !out)
+        return SERDEC_ERR_INVALID_HANDLE;
+
+    const SerdecValue* value = root;
+    for (size_t i = 0; i < pointer->count; i++) {
+        const PointerStep* step = &pointer->steps[i];
+        SerdecError status;
+        switch (serdec_tag_type(value)) {
+        case SERDEC_TYPE_OBJECT:
+            status = serdec_dom_find(value, step->key, step->len, false, &step->hash, &value);
+            break;
+        case SERDEC_TYPE_ARRAY:
+            if (step->index == SIZE_MAX) return SERDEC_ERR_NOT_FOUND;
+            status = serdec_index(value, step->index, &value);
+            break;
+        default:
+            return SERDEC_ERR_TYPE_MISMATCH;
+        }
+        if (status != SERDEC_OK) return status;
+    }
+
+    *out = value;
+    return SERDEC_OK;
+}
+
+// With *ev the first event of a container, reads up to the first event of the member or
+// element step refers to, skipping the ones before it.
+static SerdecError enter(const PointerStep* step, SerdecParser* parser, SerdecEvent* ev) {
+    bool object = (ev->kind == SERDEC_EVENT_START_OBJECT);
+    if (!object && ev->kind != SERDEC_EVENT_START_ARRAY) return SERDEC_ERR_TYPE_MISMATCH;
+    if (!object && step->index == SIZE_MAX) return SERDEC_ERR_NOT_FOUND;
+
+    for (size_t i = 0;; i++) {
+        SerdecError status = serdec_json_event_next(parser, ev);
+        if (status != SERDEC_OK) return status;
+        if (ev->kind == SERDEC_EVENT_END_OBJECT || ev->kind == SERDEC_EVENT_END_ARRAY)
+            return SERDEC_ERR_NOT_FOUND;
+
+        bool match = (i == step->index);
+        if (object) {
+            match = serdec_string_equals(ev->string, step->key, step->len);
+            status = serdec_json_event_next(parser, ev);
+            if (status != SERDEC_OK) return status;
+        }
+        if (match) return SERDEC_OK;
+
+        if (ev->kind == SERDEC_EVENT_START_OBJECT || ev->kind == SERDEC_EVENT_START_ARRAY) {
+            status = serdec_json_skip(parser);
+            if (status != SERDEC_OK) return status;
+        }
+    }
+}
+
+SerdecError serdec_pointer_find(const SerdecPointer* pointer, SerdecParser* parser,
+                                SerdecEvent* out) {
+    if (!pointer || pointer->magic != SERDEC_MAGIC_POINTER || !parser ||
+        parser->magic != SERDEC_MAGIC_PARSER || !out)
+        return SERDEC_ERR_INVALID_HANDLE;
+
+    SerdecEvent ev;
+    SerdecError status = serdec_json_event_next(parser, &ev);
+    for (size_t i = 0; status == SERDEC_OK && i < pointer->count; i++)
+        status = enter(&pointer->steps[i], parser, &ev);
+    if (status != SERDEC_OK) return status;
+
+    *out = ev;
+    return SERDEC_OK;
+}
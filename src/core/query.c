@@ -0,0 +1,610 @@
+#include "internal.h"
+#include <serdec/query.h>
+#include <serdec/buffer.h>
+#include <serdec/json.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Automaton states 0 through the step count, one bit each
+#define QUERY_MAX_STEPS 63
+
+typedef enum {
+    STEP_KEY,                 // .name or ['name']
+    STEP_SLICE,               // [n] or [start:end:step]
+    STEP_ANY,                 // .* or [*]
+    STEP_FILTER,              // [?(@.name op literal)]
+} QueryStepKind;
+
+typedef struct {
+    QueryStepKind kind;
+    bool descend;             // After "..": applies to all descendants, not only children
+    const char* key;          // STEP_KEY; for a filter, the member tested, or NULL for @
+    size_t len;
+    size_t start;             // STEP_SLICE
+    size_t end;               // SIZE_MAX if open
+    size_t stride;
+    SerdecComparison compare; // STEP_FILTER
+} QueryStep;
+
+struct SerdecQuery {
+    uint32_t magic;           // 0x5EDEC015 for validation
+    size_t count;
+    QueryStep steps[];        // Followed by decoded keys and literals
+};
+
+static uint64_t bit(size_t state) {
+    return (uint64_t) 1 << state;
+}
+
+void serdec_query_skip_space(SerdecQueryText* c) {
+    while (*c->p == ' ' || *c->p == '\t') c->p++;
+}
+
+// Digits, saturating at SIZE_MAX. False if there are none.
+static bool read_uint(SerdecQueryText* c, size_t* out) {
+    if (*c->p < '0' || *c->p > '9') return false;
+
+    size_t value = 0;
+    for (; *c->p >= '0' && *c->p <= '9'; c->p++)
+        value = (value > (SIZE_MAX - 9) / 10) ? SIZE_MAX : value * 10 + (size_t) (*c->p - '0');
+    *out = value;
+    return true;
+}
+
+SerdecError serdec_query_read_name(SerdecQueryText* c, const char* stop, const char** out,
+                                  size_t* len) {
+    size_t n = strcspn(c->p, stop);
+    if (!n) return SERDEC_ERR_INVALID_PATH;
+
+    memcpy(c->strings, c->p, n);
+    c->strings[n] = '\0';
+    *out = c->strings;
+    *len = n;
+    c->strings += n + 1;
+    c->p += n;
+    return SERDEC_OK;
+}
+
+SerdecError serdec_query_read_quoted(SerdecQueryText* c, const char** out, size_t* len) {
+    char quote = *c->p++;
+    char* start = c->strings;
+
+    while (*c->p != quote) {
+        if (!*c->p) return SERDEC_ERR_INVALID_PATH;
+        if (*c->p != '\\') {
+            *c->strings++ = *c->p++;
+            continue;
+        }
+        if (c->p[1] == '\'') {
+            *c->strings++ = '\'';
+            c->p += 2;
+            continue;
+        }
+
+        // One escape, or a surrogate pair
+        size_t span = 2;
+        if (c->p[1] == 'u') {
+            span = 6;
+            if ((c->p[2] == 'd' || c->p[2] == 'D') && c->p[3] && strchr("89abAB", c->p[3]) &&
+                strnlen(c->p, 12) == 12 && c->p[6] == '\\' && c->p[7] == 'u')
+                span = 12;
+        }
+        size_t count;
+        if (strnlen(c->p, span) < span ||
+            serdec_string_unescape_to(c->strings, c->p, span, &count) != SERDEC_OK)
+            return SERDEC_ERR_INVALID_PATH;
+        c->strings += count;
+        c->p += span;
+    }
+
+    c->p++;
+    *out = start;
+    *len = (size_t) (c->strings - start);
+    *c->strings++ = '\0';
+    return SERDEC_OK;
+}
+
+static SerdecError read_literal(SerdecQueryText* c, SerdecComparison* cmp) {
+    if (*c->p == '\'' || *c->p == '"') {
+        cmp->type = SERDEC_EVENT_STRING;
+        return serdec_query_read_quoted(c, &cmp->text, &cmp->text_len);
+    }
+
+    static const struct {
+        const char* word;
+        SerdecEventKind type;
+        bool boolean;
+    } words[] = {
+        { "true", SERDEC_EVENT_BOOL, true },
+        { "false", SERDEC_EVENT_BOOL, false },
+        { "null", SERDEC_EVENT_NULL, false },
+    };
+    for (size_t i = 0; i < sizeof(words) / sizeof(*words); i++) {
+        size_t n = strlen(words[i].word);
+        if (strncmp(c->p, words[i].word, n) == 0) {
+            cmp->type = words[i].type;
+            cmp->boolean = words[i].boolean;
+            c->p += n;
+            return SERDEC_OK;
+        }
+    }
+
+    // Numbers are read by the lexer, so they compare exactly as numbers in the input
+    size_t n = strcspn(c->p, " \t)]&");
+    SerdecBuffer* buf = serdec_buffer_from_string(c->p, n);
+    SerdecLexer* lexer = buf ? serdec_lexer_create(buf) : NULL;
+    serdec_buffer_release(buf);
+    if (!lexer) return SERDEC_ERR_OUT_OF_MEMORY;
+
+    SerdecToken tok = serdec_lexer_next(lexer);
+    serdec_lexer_destroy(lexer);
+    if (tok.type != SERDEC_TOKEN_NUMBER || tok.length != n) return SERDEC_ERR_INVALID_PATH;
+
+    cmp->type = SERDEC_EVENT_NUMBER;
+    cmp->number = tok;
+    cmp->number.start = NULL;
+    c->p += n;
+    return SERDEC_OK;
+}
+
+SerdecError serdec_query_read_comparison(SerdecQueryText* c, SerdecComparison* cmp) {
+    static const struct {
+        const char* text;
+        SerdecCompareOp op;
+    } ops[] = {
+        { "==", SERDEC_COMPARE_EQ }, { "!=", SERDEC_COMPARE_NE }, { "<=", SERDEC_COMPARE_LE },
+        { ">=", SERDEC_COMPARE_GE }, { "<", SERDEC_COMPARE_LT }, { ">", SERDEC_COMPARE_GT },
+    };
+
+    *cmp = (SerdecComparison) { .op = SERDEC_COMPARE_EXISTS };
+    serdec_query_skip_space(c);
+    for (size_t i = 0; i < sizeof(ops) / sizeof(*ops); i++) {
+        size_t n = strlen(ops[i].text);
+        if (strncmp(c->p, ops[i].text, n) == 0) {
+            cmp->op = ops[i].op;
+            c->p += n;
+            break;
+        }
+    }
+    if (cmp->op == SERDEC_COMPARE_EXISTS) return SERDEC_OK;
+
+    serdec_query_skip_space(c);
+    SerdecError status = read_literal(c, cmp);
+    serdec_query_skip_space(c);
+    return status;
+}
+
+// "?", then "@", "@.name" or "@['name']", then optionally an operator and a literal.
+static SerdecError read_filter(SerdecQueryText* c, QueryStep* step) {
+    c->p++;
+    serdec_query_skip_space(c);
+    bool parens = (*c->p == '(');
+    if (parens) {
+        c->p++;
+        serdec_query_skip_space(c);
+    }
+    if (*c->p++ != '@') return SERDEC_ERR_INVALID_PATH;
+
+    SerdecError status = SERDEC_OK;
+    if (*c->p == '.') {
+        c->p++;
+        status = serdec_query_read_name(c, " \t.[]()<>=!", &step->key, &step->len);
+    } else if (*c->p == '[') {
+        c->p++;
+        serdec_query_skip_space(c);
+        if (*c->p != '\'' && *c->p != '"') return SERDEC_ERR_INVALID_PATH;
+        status = serdec_query_read_quoted(c, &step->key, &step->len);
+        serdec_query_skip_space(c);
+        if (*c->p++ != ']') return SERDEC_ERR_INVALID_PATH;
+    }
+    if (status != SERDEC_OK) return status;
+
+    status = serdec_query_read_comparison(c, &step->compare);
+    if (status != SERDEC_OK) return status;
+    if (parens && *c->p++ != ')') return SERDEC_ERR_INVALID_PATH;
+    return SERDEC_OK;
+}
+
+static SerdecError read_slice(SerdecQueryText* c, QueryStep* step) {
+    step->start = 0;
+    step->end = SIZE_MAX;
+    step->stride = 1;
+
+    bool start = read_uint(c, &step->start);
+    serdec_query_skip_space(c);
+    if (*c->p != ':') {
+        if (!start) return SERDEC_ERR_INVALID_PATH;
+        step->end = (step->start == SIZE_MAX) ? SIZE_MAX : step->start + 1;
+        return SERDEC_OK;
+    }
+
+    c->p++;
+    serdec_query_skip_space(c);
+    read_uint(c, &step->end);
+    serdec_query_skip_space(c);
+    if (*c->p == ':') {
+        c->p++;
+        serdec_query_skip_space(c);
+        if (read_uint(c, &step->stride) && !step->stride) return SERDEC_ERR_INVALID_PATH;
+    }
+    return SERDEC_OK;
+}
+
+static SerdecError read_step(SerdecQueryText* c, QueryStep* step) {
+    *step = (QueryStep) { .kind = STEP_ANY };
+
+    bool bracket;
+    if (c->p[0] == '.' && c->p[1] == '.') {
+        step->descend = true;
+        c->p += 2;
+        bracket = (*c->p == '[');
+    } else if (c->p[0] == '.') {
+        c->p++;
+        bracket = false;
+    } else if (c->p[0] == '[') {
+        bracket = true;
+    } else {
+        return SERDEC_ERR_INVALID_PATH;
+    }
+
+    if (!bracket) {
+        if (*c->p == '*') {
+            c->p++;
+            return SERDEC_OK;
+        }
+        step->kind = STEP_KEY;
+        return serdec_query_read_name(c, ".[", &step->key, &step->len);
+    }
+
+    c->p++;
+    serdec_query_skip_space(c);
+    SerdecError status = SERDEC_OK;
+    if (*c->p == '*') {
+        c->p++;
+    } else if (*c->p == '\'' || *c->p == '"') {
+        step->kind = STEP_KEY;
+        status = serdec_query_read_quoted(c, &step->key, &step->len);
+    } else if (*c->p == '?') {
+        step->kind = STEP_FILTER;
+        status = read_filter(c, step);
+    } else {
+        step->kind = STEP_SLICE;
+        status = read_slice(c, step);
+    }
+    if (status != SERDEC_OK) return status;
+
+    serdec_query_skip_space(c);
+    if (*c->p++ != ']') return SERDEC_ERR_INVALID_PATH;
+    return SERDEC_OK;
+}
+
+SerdecError serdec_query_compile(const char* text, SerdecQuery** out) {
+    if (!text || !out) return SERDEC_ERR_INVALID_HANDLE;
+    *out = NULL;
+    if (text[0] != '$') return SERDEC_ERR_INVALID_PATH;
+
+    // Every step starts with '.' or '[', except one that fails. Decoded strings are no longer
+    // than their source, plus a NUL each and one serdec_string_unescape_to() may write.
+    size_t len = strlen(text);
+    size_t capacity = 0;
+    for (const char* p = text; *p; p++) capacity += (*p == '.' || *p == '[');
+    size_t steps = capacity + 1;
+    SerdecQuery* query = (SerdecQuery*) malloc(sizeof(*query) + steps * sizeof(QueryStep) +
+                                               len + 2 * steps);
+    if (!query) return SERDEC_ERR_OUT_OF_MEMORY;
+    query->magic = SERDEC_MAGIC_QUERY;
+    query->count = 0;
+
+    SerdecQueryText c = { .p = text + 1, .strings = (char*) &query->steps[steps] };
+    SerdecError status = SERDEC_OK;
+    while (status == SERDEC_OK && *c.p) {
+        if (query->count == QUERY_MAX_STEPS) status = SERDEC_ERR_INVALID_PATH;
+        else status = read_step(&c, &query->steps[query->count++]);
+    }
+    if (status != SERDEC_OK) {
+        free(query);
+        return status;
+    }
+
+    *out = query;
+    return SERDEC_OK;
+}
+
+void serdec_query_destroy(SerdecQuery* query) {
+    if (!query || query->magic != SERDEC_MAGIC_QUERY) return;
+    query->magic = SERDEC_MAGIC_FREED;
+    free(query);
+}
+
+// Open container being read.
+typedef struct {
+    uint64_t states;          // Bit i: steps [0, i) lead here
+    uint64_t pending;         // States behind a filter on members, not decided yet
+    uint64_t passed;          // Pending states whose filter held
+    size_t offset;            // Offset of the opening bracket
+    size_t index;             // Arrays: position of the current element
+    SerdecString key;         // Objects: key of the current member
+    bool object;
+} QueryFrame;
+
+typedef struct {
+    const SerdecQuery* query;
+    SerdecQueryCallback cb;
+    void* user;
+    SerdecParser* parser;     // Parser the query runs on
+    // Parsers reading filtered elements again, one per level of nesting
+    SerdecParser* rescan[QUERY_MAX_STEPS];
+    QueryFrame* frames;       // Shared by nested evaluations, each above the last
+    size_t depth;
+    size_t capacity;
+} QueryRun;
+
+static double number_value(const SerdecToken* tok) {
+    if (!tok->number.is_integer) return tok->number.value.f64;
+    return tok->number.is_negative ? (double) tok->number.value.i64
+                                   : (double) tok->number.value.u64;
+}
+
+static int compare_numbers(const SerdecToken* a, const SerdecToken* b) {
+    if (a->number.is_integer && b->number.is_integer) {
+        // -0 is stored as a negative zero in i64, which reads as 0 in u64
+        bool a_negative = a->number.is_negative && a->number.value.i64 < 0;
+        bool b_negative = b->number.is_negative && b->number.value.i64 < 0;
+        if (a_negative != b_negative) return a_negative ? -1 : 1;
+        if (a_negative)
+            return (a->number.value.i64 > b->number.value.i64) -
+                   (a->number.value.i64 < b->number.value.i64);
+        return (a->number.value.u64 > b->number.value.u64) -
+               (a->number.value.u64 < b->number.value.u64);
+    }
+    double x = number_value(a);
+    double y = number_value(b);
+    return (x > y) - (x < y);
+}
+
+bool serdec_comparison_test(const SerdecComparison* cmp, const SerdecEvent* ev,
+                            const SerdecParser* parser) {
+    if (cmp->op == SERDEC_COMPARE_EXISTS) return ev != NULL;
+
+    bool equal = false;
+    bool ordered = false;
+    int order = 0;
+    switch (ev ? ev->kind : SERDEC_EVENT_END) {
+    case SERDEC_EVENT_STRING:
+        if (cmp->type != SERDEC_EVENT_STRING) break;
+        order = serdec_string_compare(ev->string, cmp->text, cmp->text_len);
+        ordered = true;
+        equal = (order == 0);
+        break;
+    case SERDEC_EVENT_NUMBER:
+        if (cmp->type != SERDEC_EVENT_NUMBER) break;
+        order = compare_numbers(&parser->token, &cmp->number);
+        ordered = true;
+        equal = (order == 0);
+        break;
+    case SERDEC_EVENT_BOOL:
+        equal = (cmp->type == SERDEC_EVENT_BOOL && ev->boolean == cmp->boolean);
+        break;
+    case SERDEC_EVENT_NULL:
+        equal = (cmp->type == SERDEC_EVENT_NULL);
+        break;
+    default:
+        break;
+    }
+
+    switch (cmp->op) {
+    case SERDEC_COMPARE_EQ: return equal;
+    case SERDEC_COMPARE_NE: return !equal;
+    case SERDEC_COMPARE_LT: return ordered && order < 0;
+    case SERDEC_COMPARE_LE: return equal || (ordered && order < 0);
+    case SERDEC_COMPARE_GT: return ordered && order > 0;
+    default:    return equal || (ordered && order > 0);
+    }
+}
+
+// States of the value whose first event is ev, the current child of parent. States
+// that depend on a filter over the value's members are left in *pending.
+static uint64_t advance(const SerdecQuery* query, const QueryFrame* parent,
+                        const SerdecParser* parser, const SerdecEvent* ev, uint64_t* pending) {
+    uint64_t next = 0;
+    *pending = 0;
+
+    uint64_t rest = parent->states & (bit(query->count) - 1);
+    for (size_t i = 0; rest; i++, rest >>= 1) {
+        if (!(rest & 1)) continue;
+        const QueryStep* step = &query->steps[i];
+        if (step->descend) next |= bit(i);
+
+        bool match;
+        switch (step->kind) {
+        case STEP_KEY:
+            match = parent->object && serdec_string_equals(parent->key, step->key, step->len);
+            break;
+        case STEP_SLICE:
+            match = !parent->object && parent->index >= step->start &&
+                    parent->index < step->end && (parent->index - step->start) % step->stride == 0;
+            break;
+        case STEP_ANY:
+            match = true;
+            break;
+        default:
+            if (step->key && ev->kind == SERDEC_EVENT_START_OBJECT) {
+                *pending |= bit(i + 1);
+                match = false;
+            } else {
+                // @ itself, or a member of something that has none
+                match = serdec_comparison_test(&step->compare, step->key ? NULL : ev, parser);
+            }
+            break;
+        }
+        if (match) next |= bit(i + 1);
+    }
+    return next;
+}
+
+// Decides the pending filters of frame that test the member starting with ev.
+static void decide(const SerdecQuery* query, QueryFrame* frame, const SerdecParser* parser,
+                   const SerdecEvent* ev) {
+    uint64_t rest = frame->pending;
+    for (size_t i = 0; rest; i++, rest >>= 1) {
+        if (!(rest & 1)) continue;
+        const QueryStep* step = &query->steps[i - 1];
+        if (!serdec_string_equals(frame->key, step->key, step->len)) continue;
+        frame->pending &= ~bit(i);
+        if (serdec_comparison_test(&step->compare, ev, parser)) frame->passed |= bit(i);
+    }
+}
+
+static SerdecError report(const QueryRun* run, const SerdecParser* parser, SerdecEventKind kind,
+                          size_t offset) {
+    const SerdecLexer* lexer = parser->lexer;
+    SerdecQueryMatch match = {
+        .kind = kind,
+        .offset = offset,
+        .ptr = lexer->start + offset,
+        .len = (size_t) (lexer->current - lexer->start) - offset,
+    };
+    return run->cb(run->user, &match);
+}
+
+static SerdecError evaluate(QueryRun* run, SerdecParser* parser, size_t level, SerdecEvent* ev,
+                            uint64_t states);
+
+// Reads [begin, end) again, a value in `states`.
+static SerdecError rescan(QueryRun* run, size_t level, size_t begin, size_t end,
+                          uint64_t states) {
+    SerdecParser** parser = &run->rescan[level];
+    if (!*parser) {
+        *parser = serdec_json_parser_from_buffer(run->parser->lexer->buffer);
+        if (!*parser || !serdec_json_parser_set_max_depth(*parser, run->parser->max_depth))
+            return SERDEC_ERR_OUT_OF_MEMORY;
+    }
+    // The first pass read this already, so no error can point into it
+    serdec_json_parser_reset(*parser, begin, end, 0);
+
+    SerdecEvent ev;
+    SerdecError status = serdec_json_event_next(*parser, &ev);
+    if (status != SERDEC_OK) return status;
+    return evaluate(run, *parser, level + 1, &ev, states);
+}
+
+// The innermost container just closed.
+static SerdecError close_frame(QueryRun* run, SerdecParser* parser, size_t level) {
+    const SerdecQuery* query = run->query;
+    QueryFrame frame = run->frames[--run->depth];
+    uint64_t done = bit(query->count);
+
+    // Filters on members that never appeared
+    uint64_t rest = frame.pending;
+    for (size_t i = 0; rest; i++, rest >>= 1) {
+        if ((rest & 1) && serdec_comparison_test(&query->steps[i - 1].compare, NULL, parser))
+            frame.passed |= bit(i);
+    }
+
+    SerdecError status = SERDEC_OK;
+    if ((frame.states | frame.passed) & done) {
+        status = report(run, parser, frame.object ? SERDEC_EVENT_START_OBJECT
+                                                  : SERDEC_EVENT_START_ARRAY, frame.offset);
+    }
+
+    // Steps after a filter apply to what the element holds, which has been read already
+    uint64_t again = frame.passed & ~frame.states & ~done;
+    if (status == SERDEC_OK && again) {
+        size_t end = (size_t) (parser->lexer->current - parser->lexer->start);
+        status = rescan(run, level, frame.offset, end, again);
+    }
+    return status;
+}
+
+static SerdecError push_frame(QueryRun* run, const QueryFrame* frame) {
+    if (run->depth == run->capacity) {
+        size_t grown = run->capacity ? run->capacity * 2 : 16;
+        QueryFrame* frames = realloc(run->frames, grown * sizeof(*frames));
+        if (!frames) return SERDEC_ERR_OUT_OF_MEMORY;
+        run->frames = frames;
+        run->capacity = grown;
+    }
+    run->frames[run->depth++] = *frame;
+    return SERDEC_OK;
+}
+
+// Reads the value whose first event is ev, in `states`, and reports the matches in it.
+static SerdecError evaluate(QueryRun* run, SerdecParser* parser, size_t level, SerdecEvent* ev,
+                            uint64_t states) {
+    const SerdecQuery* query = run->query;
+    uint64_t done = bit(query->count);
+    size_t base = run->depth;
+    uint64_t pending = 0;
+    SerdecError status;
+
+    for (;;) {
+        // A value starts at ev
+        bool container = (ev->kind == SERDEC_EVENT_START_OBJECT ||
+                          ev->kind == SERDEC_EVENT_START_ARRAY);
+        if (!container) {
+            status = (states & done) ? report(run, parser, ev->kind, ev->offset) : SERDEC_OK;
+        } else if (!(states & ~done) && !pending) {
+            // Nothing inside can match
+            size_t offset = ev->offset;
+            status = serdec_json_skip(parser);
+            if (status == SERDEC_OK && (states & done))
+                status = report(run, parser, ev->kind, offset);
+        } else {
+            QueryFrame frame = {
+                .states = states,
+                .pending = pending,
+                .offset = ev->offset,
+                .index = SIZE_MAX,  // Incremented to 0 by the first element
+                .object = (ev->kind == SERDEC_EVENT_START_OBJECT),
+            };
+            status = push_frame(run, &frame);
+        }
+        if (status != SERDEC_OK) return status;
+
+        // Up to the next value, closing containers on the way
+        for (;;) {
+            if (run->depth == base) return SERDEC_OK;
+            status = serdec_json_event_next(parser, ev);
+            if (status != SERDEC_OK) return status;
+
+            if (ev->kind == SERDEC_EVENT_KEY) {
+                run->frames[run->depth - 1].key = ev->string;
+            } else if (ev->kind == SERDEC_EVENT_END_OBJECT || ev->kind == SERDEC_EVENT_END_ARRAY) {
+                status = close_frame(run, parser, level);
+                if (status != SERDEC_OK) return status;
+            } else {
+                break;
+            }
+        }
+
+        QueryFrame* parent = &run->frames[run->depth - 1];
+        if (parent->object) {
+            if (parent->pending) decide(query, parent, parser, ev);
+        } else {
+            parent->index++;
+        }
+        states = advance(query, parent, parser, ev, &pending);
+    }
+}
+
+SerdecError serdec_query_run(const SerdecQuery* query, SerdecParser* parser,
+                             SerdecQueryCallback cb, void* user) {
+    if (!query || query->magic != SERDEC_MAGIC_QUERY || !parser ||
+        parser->magic != SERDEC_MAGIC_PARSER || !cb)
+        return SERDEC_ERR_INVALID_HANDLE;
+
+    QueryRun run = { .query = query, .cb = cb, .user = user, .parser = parser };
+    SerdecEvent ev;
+    SerdecError status;
+    while ((status = serdec_json_event_next(parser, &ev)) == SERDEC_OK &&
+           ev.kind != SERDEC_EVENT_END) {
+        status = evaluate(&run, parser, 0, &ev, bit(0));
+        if (status != SERDEC_OK) break;
+    }
+
+    for (size_t i = 0; i < QUERY_MAX_STEPS; i++) serdec_json_parser_destroy(run.rescan[i]);
+    free(run.frames);
+    return status;
+}
@@ -0,0 +1,232 @@
+#include "internal.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+enum {
+    SCAN_OTHER = 0,
+    SCAN_QUOTE,
+    SCAN_BACKSLASH,
+    SCAN_OPEN,
+    SCAN_CLOSE,
+    SCAN_COMMA,
+    SCAN_COLON,
+    SCAN_SPACE,
+};
+
+static const uint8_t scan_class[256] = {
+    ['"'] = SCAN_QUOTE,
+    ['\\'] = SCAN_BACKSLASH,
+    ['{'] = SCAN_OPEN,
+    ['['] = SCAN_OPEN,
+    ['}'] = SCAN_CLOSE,
+    [']'] = SCAN_CLOSE,
+    [','] = SCAN_COMMA,
+    [':'] = SCAN_COLON,
+    [' '] = SCAN_SPACE,
+    ['\t'] = SCAN_SPACE,
+    ['\n'] = SCAN_SPACE,
+    ['\r'] = SCAN_SPACE,
+};
+
+// Advances over data[*pos..len). With `find`, stops at the first ',' at `target` depth.
+static bool scan(SerdecScanState* state, const char* data, size_t len, size_t* pos,
+                 bool find, int64_t target) {
+    size_t i = *pos;
+
+    while (i < len) {
+        uint8_t cls = scan_class[(uint8_t) data[i]];
+
+        if (state->in_string) {
+            if (state->escaped) {
+                state->escaped = false;
+            } else if (cls == SCAN_BACKSLASH) {
+                state->escaped = true;
+            } else if (cls == SCAN_QUOTE) {
+                state->in_string = false;
+            }
+            i++;
+            continue;
+        }
+
+        switch (cls) {
+        case SCAN_QUOTE:
+            state->in_string = true;
+            break;
+        case SCAN_OPEN:
+            state->depth++;
+            break;
+        case SCAN_CLOSE:
+            state->depth--;
+            if (state->depth < state->min_depth) state->min_depth = state->depth;
+            break;
+        case SCAN_COMMA:
+            if (find && state->depth == target) {
+                *pos = i;
+                return true;
+            }
+            break;
+        default:
+            break;
+        }
+        i++;
+    }
+
+    *pos = len;
+    return false;
+}
+
+void serdec_scan_advance(SerdecScanState* state, const char* data, size_t len) {
+    size_t pos = 0;
+    scan(state, data, len, &pos, false, 0);
+}
+
+size_t serdec_scan_find_comma(SerdecScanState* state, const char* data, size_t len,
+                              int64_t depth) {
+    size_t pos = 0;
+    scan(state, data, len, &pos, true, depth);
+    return pos;
+}
+
+size_t serdec_scan_find_boundary(SerdecScanState* state, const char* data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        uint8_t cls = scan_class[(uint8_t) data[i]];
+
+        if (state->in_string) {
+            if (state->escaped) {
+                state->escaped = false;
+            } else if (cls == SCAN_BACKSLASH) {
+                state->escaped = true;
+            } else if (cls == SCAN_QUOTE) {
+                state->in_string = false;
+            }
+            continue;
+        }
+
+        switch (cls) {
+        case SCAN_QUOTE:
+            state->in_string = true;
+            break;
+        case SCAN_OPEN:
+            state->depth++;
+            break;
+        case SCAN_CLOSE:
+            state->depth--;
+            if (state->depth < state->min_depth) state->min_depth = state->depth;
+            if (state->depth == 0) return i + 1;
+            break;
+        default:
+            if (state->depth == 0 && (data[i] == ' ' || data[i] == '\t' || data[i] == '\n' ||
+                                      data[i] == '\r'))
+                return i;
+            break;
+        }
+    }
+
+    return len;
+}
+
+static bool grow(size_t** items, size_t* capacity, size_t count) {
+    if (count < *capacity) return true;
+    size_t grown = *capacity ? *capacity * 2 : 64;
+    size_t* resized = realloc(*items, grown * sizeof(*resized));
+    if (!resized) return false;
+    *items = resized;
+    *capacity = grown;
+    return true;
+}
+
+bool serdec_scan_measure(const char* data, size_t len, SerdecDomSize* size) {
+    size_t* open = NULL;      // Index into size->children of each open container
+    size_t depth = 0;
+    size_t open_capacity = 0;
+    size_t capacity = 0;
+    size_t string_start = 0;
+    size_t pending_key = 0;   // Bytes for the last string if it turns out to be a key
+    bool in_string = false;
+    bool escaped = false;
+    bool escapes = false;
+    bool in_literal = false;
+    char prev = 0;            // Last significant byte; 'v' after a complete token
+    bool ok = true;
+
+    *size = (SerdecDomSize) { 0 };
+
+    for (size_t i = 0; i < len && ok; i++) {
+        uint8_t cls = scan_class[(uint8_t) data[i]];
+
+        if (in_string) {
+            if (escaped) {
+                escaped = false;
+            } else if (cls == SCAN_BACKSLASH) {
+                escaped = escapes = true;
+            } else if (cls == SCAN_QUOTE) {
+                in_string = false;
+                if (escapes) pending_key = i - string_start;  // Raw length + NUL
+            }
+            continue;
+        }
+
+        // Literals (numbers, true, false, null) are runs of unclassified bytes
+        bool literal = (cls == SCAN_OTHER);
+        bool token = (cls == SCAN_QUOTE || cls == SCAN_OPEN || (literal && !in_literal));
+        in_literal = literal;
+
+        if (token) {
+            size->nodes++;
+            if (depth && (prev == '[' || prev == '{' || prev == ','))
+                size->children[open[depth - 1]]++;
+            prev = 'v';
+            pending_key = 0;
+        }
+
+        switch (cls) {
+        case SCAN_QUOTE:
+            in_string = true;
+            escapes = false;
+            string_start = i;
+            break;
+        case SCAN_OPEN:
+            ok = grow(&size->children, &capacity, size->containers) &&
+                 grow(&open, &open_capacity, depth);
+            if (!ok) break;
+            size->children[size->containers] = 0;
+            open[depth++] = size->containers++;
+            prev = data[i];
+            break;
+        case SCAN_CLOSE:
+            if (depth) {
+                size_t members = size->children[open[--depth]];
+                if (data[i] == '}' && serdec_has_index(SERDEC_TYPE_OBJECT, members))
+                    size->nodes++;
+            }
+            prev = 'v';
+            pending_key = 0;
+            break;
+        case SCAN_COMMA:
+            prev = ',';
+            pending_key = 0;
+            break;
+        case SCAN_COLON:
+            size->key_bytes += pending_key;
+            prev = ':';
+            pending_key = 0;
+            break;
+        default:
+            break;
+        }
+    }
+
+    free(open);
+    if (!ok) {
+        free(size->children);
+        size->children = NULL;
+    }
+    return ok;
+}
+
+bool serdec_scan_escaped_at(const char* data, size_t pos) {
+    size_t run = 0;
+    while (run < pos && data[pos - run - 1] == '\\') run++;
+    return run % 2 == 1;
+}
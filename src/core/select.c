@@ -0,0 +1,247 @@
+#include "internal.h"
+#include <serdec/dom.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum {
+    STEP_KEY,                 // .name
+    STEP_INDEX,               // [3]
+    STEP_ANY,                 // .* or [*]
+} SelectStepKind;
+
+typedef struct {
+    SelectStepKind kind;
+    const char* key;          // STEP_KEY: slice of the path string
+    size_t len;
+    size_t index;             // STEP_INDEX
+} SelectStep;
+
+typedef struct {
+    SelectStep* steps;
+    size_t count;
+} SelectPath;
+
+typedef struct {
+    bool object;
+    size_t index;             // Arrays: index of the current element
+    SerdecString key;         // Objects: key of the current member, decoded
+} SelectFrame;
+
+typedef struct {
+    SelectPath* paths;
+    size_t path_count;
+    SerdecSelectCallback cb;
+    void* user;
+} SelectJob;
+
+// Parses "$", then ".key", "[n]", ".*" and "[*]" steps.
+static SerdecError compile_path(const char* text, SelectPath* path) {
+    if (!text || text[0] != '$') return SERDEC_ERR_INVALID_PATH;
+
+    size_t capacity = 0;
+    for (const char* p = text; *p; p++) capacity += (*p == '.' || *p == '[');
+    path->steps = (SelectStep*) malloc((capacity ? capacity : 1) * sizeof(SelectStep));
+    if (!path->steps) return SERDEC_ERR_OUT_OF_MEMORY;
+
+    const char* p = text + 1;
+    while (*p) {
+        SelectStep* step = &path->steps[path->count++];
+
+        if (p[0] == '.' && p[1] == '*') {
+            *step = (SelectStep) { .kind = STEP_ANY };
+            p += 2;
+        } else if (p[0] == '.') {
+            size_t len = strcspn(p + 1, ".[");
+            if (!len) return SERDEC_ERR_INVALID_PATH;
+            *step = (SelectStep) { .kind = STEP_KEY, .key = p + 1, .len = len };
+            p += 1 + len;
+        } else if (p[0] == '[' && p[1] == '*' && p[2] == ']') {
+            *step = (SelectStep) { .kind = STEP_ANY };
+            p += 3;
+        } else if (p[0] == '[' && p[1] >= '0' && p[1] <= '9') {
+            size_t index = 0;
+            for (p++; *p >= '0' && *p <= '9'; p++) {
+                if (index > (SIZE_MAX - 9) / 10) return SERDEC_ERR_INVALID_PATH;
+                index = index * 10 + (size_t) (*p - '0');
+            }
+            if (*p++ != ']') return SERDEC_ERR_INVALID_PATH;
+            *step = (SelectStep) { .kind = STEP_INDEX, .index = index };
+        } else {
+            return SERDEC_ERR_INVALID_PATH;
+        }
+    }
+
+    return SERDEC_OK;
+}
+
+static bool step_matches(const SelectStep* step, const SelectFrame* frame) {
+    switch (step->kind) {
+    case STEP_KEY:
+        return frame->object && frame->key.len == step->len &&
+               memcmp(frame->key.ptr, step->key, step->len) == 0;
+    case STEP_INDEX:
+        return !frame->object && frame->index == step->index;
+    default:
+        return true;
+    }
+}
+
+// True if the first `depth` steps of path match the current location.
+static bool prefix_matches(const SelectPath* path, const SelectFrame* frames, size_t depth) {
+    if (path->count < depth) return false;
+    for (size_t i = 0; i < depth; i++) {
+        if (!step_matches(&path->steps[i], &frames[i])) return false;
+    }
+    return true;
+}
+
+// Resolves the remaining steps of a nested path inside an already built subtree.
+static SerdecError resolve(const SelectJob* job, size_t path, const SelectStep* steps,
+                           size_t count, const SerdecValue* value) {
+    if (!count) return job->cb(job->user, path, value);
+
+    const SerdecValue* child;
+    switch (steps->kind) {
+    case STEP_KEY: {
+        if (serdec_value_type(value) != SERDEC_TYPE_OBJECT) return SERDEC_OK;
+        SerdecString key;
+        for (size_t i = 0; serdec_member(value, i, &key, &child) == SERDEC_OK; i++) {
+            if (key.len == steps->len && memcmp(key.ptr, steps->key, steps->len) == 0)
+                return resolve(job, path, steps + 1, count - 1, child);
+        }
+        return SERDEC_OK;
+    }
+    case STEP_INDEX:
+        if (serdec_index(value, steps->index, &child) != SERDEC_OK) return SERDEC_OK;
+        return resolve(job, path, steps + 1, count - 1, child);
+    default: {
+        bool object = (serdec_value_type(value) == SERDEC_TYPE_OBJECT);
+        for (size_t i = 0; i < serdec_value_size(value); i++) {
+            if (object) serdec_member(value, i, NULL, &child);
+            else serdec_index(value, i, &child);
+            SerdecError status = resolve(job, path, steps + 1, count - 1, child);
+            if (status != SERDEC_OK) return status;
+        }
+        return SERDEC_OK;
+    }
+    }
+}
+
+static SerdecError report(const SelectJob* job, const SelectFrame* frames, size_t depth,
+                          const SerdecValue* value) {
+    for (size_t i = 0; i < job->path_count; i++) {
+        const SelectPath* path = &job->paths[i];
+        if (path->count == depth && prefix_matches(path, frames, depth)) {
+            SerdecError status = job->cb(job->user, i, value);
+            if (status != SERDEC_OK) return status;
+        }
+    }
+    for (size_t i = 0; i < job->path_count; i++) {
+        const SelectPath* path = &job->paths[i];
+        if (path->count > depth && prefix_matches(path, frames, depth)) {
+            SerdecError status = resolve(job, i, path->steps + depth, path->count - depth, value);
+            if (status != SERDEC_OK) return status;
+        }
+    }
+    return SERDEC_OK;
+}
+
+static SerdecError run(SerdecParser* parser, SerdecArena* arena, const SelectJob* job) {
+    SelectFrame* frames = NULL;
+    size_t depth = 0;
+    size_t capacity = 0;
+    SerdecError status;
+    SerdecEvent ev;
+
+    while ((status = serdec_json_event_next(parser, &ev)) == SERDEC_OK) {
+        if (ev.kind == SERDEC_EVENT_END) break;
+
+        if (ev.kind == SERDEC_EVENT_KEY) {
+            const char* ptr;
+            size_t len;
+            status = serdec_string_materialize(arena, ev.string, &ptr, &len);
+            if (status != SERDEC_OK) break;
+            frames[depth - 1].key = (SerdecString) { ptr, len, false };
+            continue;
+        }
+        if (ev.kind == SERDEC_EVENT_END_OBJECT || ev.kind == SERDEC_EVENT_END_ARRAY) {
+            depth--;
+            continue;
+        }
+
+        // A value starts here
+        if (depth && !frames[depth - 1].object) frames[depth - 1].index++;
+
+        bool exact = false;
+        bool deeper = false;
+        for (size_t i = 0; i < job->path_count; i++) {
+            const SelectPath* path = &job->paths[i];
+            if (!prefix_matches(path, frames, depth)) continue;
+            if (path->count == depth) exact = true;
+            else deeper = true;
+        }
+
+        if (exact) {
+            SerdecValue* value = NULL;
+            status = serdec_dom_build(parser, arena, NULL, &ev, NULL, &value);
+            if (status == SERDEC_OK) status = report(job, frames, depth, value);
+            if (status != SERDEC_OK) break;
+            continue;
+        }
+
+        if (ev.kind != SERDEC_EVENT_START_OBJECT && ev.kind != SERDEC_EVENT_START_ARRAY)
+            continue;
+
+        if (!deeper) {
+            status = serdec_json_skip(parser);
+            if (status != SERDEC_OK) break;
+            continue;
+        }
+
+        if (depth == capacity) {
+            size_t grown = capacity ? capacity * 2 : 16;
+            SelectFrame* items = realloc(frames, grown * sizeof(*items));
+            if (!items) {
+                status = SERDEC_ERR_OUT_OF_MEMORY;
+                break;
+            }
+            frames = items;
+            capacity = grown;
+        }
+        frames[depth++] = (SelectFrame) {
+            .object = (ev.kind == SERDEC_EVENT_START_OBJECT),
+            .index = SIZE_MAX,  // Incremented to 0 by the first element
+        };
+    }
+
+    free(frames);
+    return status;
+}
+
+SerdecError serdec_json_select(SerdecParser* parser, SerdecArena* arena,
+                               const char* const* paths, size_t count,
+                               SerdecSelectCallback cb, void* user) {
+    if (!parser || parser->magic != SERDEC_MAGIC_PARSER || !arena ||
+        arena->magic != SERDEC_MAGIC_ARENA || (!paths && count) || !cb)
+        return SERDEC_ERR_INVALID_HANDLE;
+
+    SelectJob job = {
+        .paths = (SelectPath*) calloc(count ? count : 1, sizeof(SelectPath)),
+        .path_count = count,
+        .cb = cb,
+        .user = user,
+    };
+    if (!job.paths) return SERDEC_ERR_OUT_OF_MEMORY;
+
+    SerdecError status = SERDEC_OK;
+    for (size_t i = 0; i < count && status == SERDEC_OK; i++)
+        status = compile_path(paths[i], &job.paths[i]);
+
+    if (status == SERDEC_OK) status = run(parser, arena, &job);
+
+    for (size_t i = 0; i < count; i++) free(job.paths[i].steps);
+    free(job.paths);
+    return status;
+}
@@ -0,0 +1,661 @@
+#include "internal.h"
+#include <serdec/dom.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+// An image is the DOM with offsets from the start of the image in place of pointers: a
+// header, then one block per container, each on a node boundary, then the string pool.
+// String nodes hold the offset of their bytes in the pool. Container nodes are
+// SERDEC_CONTAINER_MAPPED with the offset of their block as length. Mapping an image
+// relocates only the header and the shapes; a container's block is relocated in place
+// when it is first expanded, as a lazy document parses one level at a time.
+
+#define SNAPSHOT_VERSION    1
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+
+static const char snapshot_magic[8] = "SERDECS";
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;      // SNAPSHOT_BYTE_ORDER in the writer's byte order
+    uint32_t pointer_size;
+    uint32_t reserved;
+    uint64_t size;            // Bytes in the image
+    uint64_t pool;            // Offset of the string pool
+    uint64_t shapes;          // Offset of shape_count offsets of SerdecShape records
+    uint64_t shape_count;
+    SerdecValue root;
+} SnapshotHeader;
+
+// Start of a container's block. What the container's children pointer points at
+// follows: its elements, an index or shape slot and its members, or its packed array.
+typedef struct {
+    uint64_t tag;             // The container's own tag
+    uint64_t relocated;       // 0 in the file; the block's address once it holds pointers
+} SnapshotBlock;
+
+_Static_assert(sizeof(SnapshotBlock) == sizeof(SerdecValue), "a block header is one node slot");
+
+// --- Saving ---
+
+typedef struct {
+    const SerdecValue* src;
+    size_t dst;               // Offset of the node in the image
+} SaveItem;
+
+typedef struct {
+    const SerdecShape* from;
+    size_t to;                // Offset of the record in the image; 0 until written
+} ShapeEntry;
+
+typedef struct {
+    uint64_t hash;
+    size_t offset;            // In the pool, or SIZE_MAX if the slot is empty
+    size_t len;
+} PoolEntry;
+
+typedef struct {
+    char* image;              // Header and blocks
+    size_t size;
+    size_t capacity;
+    char* pool;
+    size_t pool_size;
+    size_t pool_capacity;
+    PoolEntry* strings;       // Open-addressed by content
+    size_t string_count;
+    size_t string_capacity;
+    ShapeEntry* shapes;       // Open-addressed by address
+    size_t shape_count;
+    size_t shape_capacity;
+    SaveItem* stack;          // Containers whose block is not written yet
+    size_t depth;
+    size_t stack_capacity;
+} Saver;
+
+static bool reserve(char** data, size_t* capacity, size_t needed) {
+    if (needed <= *capacity) return true;
+    size_t grown = *capacity ? *capacity : 4096;
+    while (grown < needed) grown *= 2;
+    char* bigger = realloc(*data, grown);
+    if (!bigger) return false;
+    *data = bigger;
+    *capacity = grown;
+    return true;
+}
+
+// Appends zeroed bytes on a node boundary. Returns their offset, or 0 when out of memory;
+// the header is at 0, so no block is.
+static size_t take(Saver* s, size_t bytes) {
+    size_t offset = (s->size + sizeof(SerdecValue) - 1) & ~(sizeof(SerdecValue) - 1);
+    if (!reserve(&s->image, &s->capacity, offset + bytes)) return 0;
+    memset(s->image + s->size, 0, offset + bytes - s->size);
+    s->size = offset + bytes;
+    return offset;
+}
+
+static SerdecValue* node_at(const Saver* s, size_t offset) {
+    return (SerdecValue*) (s->image + offset);
+}
+
+static bool push(Saver* s, const SerdecValue* src, size_t dst) {
+    if (s->depth == s->stack_capacity) {
+        size_t grown = s->stack_capacity ? s->stack_capacity * 2 : 64;
+        SaveItem* items = realloc(s->stack, grown * sizeof(*items));
+        if (!items) return false;
+        s->stack = items;
+        s->stack_capacity = grown;
+    }
+    s->stack[s->depth++] = (SaveItem) { src, dst };
+    return true;
+}
+
+static bool grow_strings(Saver* s) {
+    size_t capacity = s->string_capacity ? s->string_capacity * 2 : 256;
+    PoolEntry* strings = (PoolEntry*) malloc(capacity * sizeof(*strings));
+    if (!strings) return false;
+    for (size_t i = 0; i < capacity; i++) strings[i].offset = SIZE_MAX;
+
+    for (size_t i = 0; i < s->string_capacity; i++) {
+        if (s->strings[i].offset == SIZE_MAX) continue;
+        size_t slot = s->strings[i].hash & (capacity - 1);
+        while (strings[slot].offset != SIZE_MAX) slot = (slot + 1) & (capacity - 1);
+        strings[slot] = s->strings[i];
+    }
+    free(s->strings);
+    s->strings = strings;
+    s->string_capacity = capacity;
+    return true;
+}
+
+// Adds bytes to the pool, NUL-terminated, unless the same bytes are already there.
+static bool pool_add(Saver* s, const char* str, size_t len, size_t* offset) {
+    if (2 * (s->string_count + 1) > s->string_capacity && !grow_strings(s)) return false;
+
+    uint64_t hash = serdec_hash(str, len);
+    size_t mask = s->string_capacity - 1;
+    size_t slot = hash & mask;
+    for (; s->strings[slot].offset != SIZE_MAX; slot = (slot + 1) & mask) {
+        const PoolEntry* entry = &s->strings[slot];
+        if (entry->hash == hash && entry->len == len &&
+            memcmp(s->pool + entry->offset, str, len) == 0) {
+            *offset = entry->offset;
+            return true;
+        }
+    }
+
+    if (!reserve(&s->pool, &s->pool_capacity, s->pool_size + len + 1)) return false;
+    if (len) memcpy(s->pool + s->pool_size, str, len);
+    s->pool[s->pool_size + len] = '\0';
+    s->strings[slot] = (PoolEntry) { .hash = hash, .offset = s->pool_size, .len = len };
+    s->string_count++;
+    *offset = s->pool_size;
+    s->pool_size += len + 1;
+    return true;
+}
+
+// Writes src to the node at dst. Containers are queued; their node is written with their
+// block. Interned keys become plain strings.
+static bool put_node(Saver* s, const SerdecValue* src, size_t dst) {
+    SerdecValueType type = serdec_tag_type(src);
+    SerdecValue node = { .tag = src->tag };
+
+    switch (type) {
+    case SERDEC_TYPE_ARRAY:
+    case SERDEC_TYPE_OBJECT:
+        return push(s, src, dst);
+    case SERDEC_TYPE_STRING: {
+        size_t len = serdec_tag_len(src);
+        size_t offset;
+        if (!pool_add(s, src->str, len, &offset)) return false;
+        unsigned sub = (serdec_tag_sub(src) == SERDEC_STRING_ESCAPED) ? SERDEC_STRING_ESCAPED : 0;
+        node = (SerdecValue) { .tag = serdec_tag(type, sub, len), .u64 = offset };
+        break;
+    }
+    case SERDEC_TYPE_BOOL:
+        node.boolean = src->boolean;
+        break;
+    case SERDEC_TYPE_NUMBER:
+        node.u64 = src->u64;
+        break;
+    default:
+        break;
+    }
+    *node_at(s, dst) = node;
+    return true;
+}
+
+static size_t shape_slot(const Saver* s, const SerdecShape* shape) {
+    size_t mask = s->shape_capacity - 1;
+    size_t slot = (size_t) (((uintptr_t) shape >> 4) * 0x9E3779B97F4A7C15ull) & mask;
+    while (s->shapes[slot].from && s->shapes[slot].from != shape) slot = (slot + 1) & mask;
+    return slot;
+}
+
+static ShapeEntry* add_shape(Saver* s, const SerdecShape* shape) {
+    if (s->shape_capacity && s->shapes[shape_slot(s, shape)].from)
+        return &s->shapes[shape_slot(s, shape)];
+
+    if (2 * (s->shape_count + 1) > s->shape_capacity) {
+        size_t capacity = s->shape_capacity ? s->shape_capacity * 2 : 16;
+        ShapeEntry* shapes = (ShapeEntry*) calloc(capacity, sizeof(*shapes));
+        if (!shapes) return NULL;
+
+        ShapeEntry* old = s->shapes;
+        size_t old_capacity = s->shape_capacity;
+        s->shapes = shapes;
+        s->shape_capacity = capacity;
+        for (size_t i = 0; i < old_capacity; i++) {
+            if (old[i].from) s->shapes[shape_slot(s, old[i].from)] = old[i];
+        }
+        free(old);
+    }
+
+    ShapeEntry* entry = &s->shapes[shape_slot(s, shape)];
+    entry->from = shape;
+    s->shape_count++;
+    return entry;
+}
+
+// Writes a shape record once. Returns its offset, or 0 when out of memory.
+static size_t put_shape(Saver* s, const SerdecShape* shape) {
+    ShapeEntry* entry = add_shape(s, shape);
+    if (!entry) return 0;
+    if (entry->to) return entry->to;
+
+    size_t record = take(s, sizeof(SerdecShape));
+    size_t keys = take(s, shape->count * sizeof(SerdecValue));
+    size_t table = shape->table ? take(s, serdec_index_capacity(shape->count) * sizeof(uint32_t))
+                                : 0;
+    if (!record || !keys || (shape->table && !table)) return 0;
+
+    for (size_t i = 0; i < shape->count; i++) {
+        if (!put_node(s, &shape->keys[i], keys + i * sizeof(SerdecValue))) return 0;
+    }
+    if (table) serdec_key_table_fill((uint32_t*) (s->image + table), shape->keys, 1, shape->count);
+
+    *(SerdecShape*) (s->image + record) = (SerdecShape) {
+        .count = shape->count,
+        .keys = (const SerdecValue*) (uintptr_t) keys,
+        .table = (const uint32_t*) (uintptr_t) table,
+        .hash = shape->hash,
+    };
+    entry->to = record;
+    return record;
+}
+
+// Writes the block of a container and the node at dst that refers to it. Objects with an
+// index slot get their table here, so that a mapped document never builds one.
+static SerdecError put_container(Saver* s, const SerdecValue* src, size_t dst) {
+    SerdecError status = serdec_dom_expand(src);
+    if (status != SERDEC_OK) return status;
+
+    SerdecValueType type = serdec_tag_type(src);
+    size_t count = serdec_tag_len(src);
+    const SerdecShape* shape = (type == SERDEC_TYPE_OBJECT) ? serdec_object_shape(src) : NULL;
+    bool packed = type == SERDEC_TYPE_ARRAY && serdec_is_packed(src);
+    bool indexed = !shape && serdec_has_index(type, count);
+    size_t slots = (shape || indexed) ? 1 : 0;
+    size_t run = (type == SERDEC_TYPE_OBJECT && !shape) ? 2 * count : count;
+
+    size_t shape_at = shape ? put_shape(s, shape) : 0;
+    size_t bytes = packed ? sizeof(SerdecPackedArray) + count * sizeof(uint64_t)
+                          : (slots + run) * sizeof(SerdecValue);
+    size_t block = take(s, sizeof(SnapshotBlock) + bytes);
+    size_t table = indexed ? take(s, serdec_index_capacity(count) * sizeof(uint32_t)) : 0;
+    if ((shape && !shape_at) || !block || (indexed && !table)) return SERDEC_ERR_OUT_OF_MEMORY;
+
+    // Growable arrays lose their spare capacity
+    unsigned sub = (packed || shape) ? serdec_tag_sub(src) : 0;
+    ((SnapshotBlock*) (s->image + block))->tag = serdec_tag(type, sub, count);
+    *node_at(s, dst) = (SerdecValue) {
+        .tag = serdec_tag(type, SERDEC_CONTAINER_MAPPED, block),
+    };
+
+    size_t children = block + sizeof(SnapshotBlock) + slots * sizeof(SerdecValue);
+    if (packed) {
+        memcpy(s->image + children + sizeof(SerdecPackedArray), serdec_packed_data(src->packed),
+               count * sizeof(uint64_t));
+        return SERDEC_OK;
+    }
+    if (shape) {
+        ((const SerdecShape**) (s->image + children))[-1] =
+            (const SerdecShape*) (uintptr_t) shape_at;
+    }
+    if (indexed) {
+        serdec_key_table_fill((uint32_t*) (s->image + table), src->children, 2, count);
+        ((SerdecObjectIndex*) node_at(s, children - sizeof(SerdecValue)))->table =
+            (uint32_t*) (uintptr_t) table;
+    }
+    for (size_t i = 0; i < run; i++) {
+        if (!put_node(s, &src->children[i], children + i * sizeof(SerdecValue)))
+            return SERDEC_ERR_OUT_OF_MEMORY;
+    }
+    return SERDEC_OK;
+}
+
+static SerdecError build_image(Saver* s, const SerdecValue* root) {
+    if (!reserve(&s->image, &s->capacity, sizeof(SnapshotHeader))) return SERDEC_ERR_OUT_OF_MEMORY;
+    memset(s->image, 0, sizeof(SnapshotHeader));
+    s->size = sizeof(SnapshotHeader);
+
+    if (!put_node(s, root, offsetof(SnapshotHeader, root))) return SERDEC_ERR_OUT_OF_MEMORY;
+    while (s->depth) {
+        SaveItem item = s->stack[--s->depth];
+        SerdecError status = put_container(s, item.src, item.dst);
+        if (status != SERDEC_OK) return status;
+    }
+
+    size_t list = take(s, s->shape_count * sizeof(uint64_t));
+    if (!list) return SERDEC_ERR_OUT_OF_MEMORY;
+    uint64_t* shapes = (uint64_t*) (s->image + list);
+    for (size_t i = 0; i < s->shape_capacity; i++) {
+        if (s->shapes[i].from) *shapes++ = s->shapes[i].to;
+    }
+
+    SnapshotHeader* header = (SnapshotHeader*) s->image;
+    memcpy(header->magic, snapshot_magic, sizeof(header->magic));
+    header->version = SNAPSHOT_VERSION;
+    header->byte_order = SNAPSHOT_BYTE_ORDER;
+    header->pointer_size = sizeof(void*);
+    header->size = s->size + s->pool_size;
+    header->pool = s->size;
+    header->shapes = list;
+    header->shape_count = s->shape_count;
+    return SERDEC_OK;
+}
+
+SerdecError serdec_document_save(const SerdecDocument* doc, const char* path) {
+    if (!doc || doc->magic != SERDEC_MAGIC_DOCUMENT || !path) return SERDEC_ERR_INVALID_HANDLE;
+
+    Saver s = { 0 };
+    SerdecError status = build_image(&s, doc->root);
+    if (status == SERDEC_OK) {
+        FILE* fp = fopen(path, "wb");
+        if (!fp) {
+            status = SERDEC_ERR_FILE_NOT_FOUND;
+        } else {
+            bool written = fwrite(s.image, 1, s.size, fp) == s.size &&
+                           (!s.pool_size || fwrite(s.pool, 1, s.pool_size, fp) == s.pool_size);
+            if (fclose(fp) != 0 || !written) status = SERDEC_ERR_IO;
+        }
+    }
+
+    free(s.image);
+    free(s.pool);
+    free(s.strings);
+    free(s.shapes);
+    free(s.stack);
+    return status;
+}
+
+// --- Mapping ---
+
+// Private and writable: relocation copies only the pages it touches, and nothing is
+// written back to the file.
+static SerdecError map_file(const char* path, char** data, size_t* size) {
+#ifdef _WIN32
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return SERDEC_ERR_FILE_NOT_FOUND;
+
+    SerdecError status = SERDEC_ERR_IO;
+    long end = (fseek(fp, 0, SEEK_END) == 0) ? ftell(fp) : -1;
+    if (end >= (long) sizeof(SnapshotHeader) && fseek(fp, 0, SEEK_SET) == 0) {
+        *data = (char*) serdec_aligned_alloc(sizeof(SerdecValue), (size_t) end);
+        *size = (size_t) end;
+        if (!*data) status = SERDEC_ERR_OUT_OF_MEMORY;
+        else if (fread(*data, 1, *size, fp) == *size) status = SERDEC_OK;
+        else serdec_aligned_free(*data);
+    }
+    fclose(fp);
+    return status;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return SERDEC_ERR_FILE_NOT_FOUND;
+
+    SerdecError status = SERDEC_ERR_IO;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t) sizeof(SnapshotHeader)) {
+        void* map = mmap(NULL, (size_t) st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            *data = (char*) map;
+            *size = (size_t) st.st_size;
+            status = SERDEC_OK;
+        }
+    }
+    close(fd);
+    return status;
+#endif
+}
+
+static void unmap_file(char* data, size_t size) {
+#ifdef _WIN32
+    (void) size;
+    serdec_aligned_free(data);
+#else
+    munmap(data, size);
+#endif
+}
+
+// Whether bytes bytes at offset end at or before limit.
+static bool in_range(uint64_t offset, uint64_t bytes, uint64_t limit) {
+    return offset <= limit && bytes <= limit - offset;
+}
+
+// Whether count items of unit bytes at offset lie between the header and the pool, on a
+// node boundary.
+static bool block_range(const SnapshotHeader* header, uint64_t offset, uint64_t count,
+                        size_t unit) {
+    return offset >= sizeof(SnapshotHeader) && offset % sizeof(SerdecValue) == 0 &&
+           in_range(offset, 0, header->pool) && count <= (header->pool - offset) / unit;
+}
+
+static bool header_valid(const SnapshotHeader* header, size_t size) {
+    return memcmp(header->magic, snapshot_magic, sizeof(header->magic)) == 0 &&
+           header->version == SNAPSHOT_VERSION && header->byte_order == SNAPSHOT_BYTE_ORDER &&
+           header->pointer_size == sizeof(void*) && header->size == size &&
+           header->pool >= sizeof(SnapshotHeader) && header->pool <= size &&
+           block_range(header, header->shapes, header->shape_count, sizeof(uint64_t));
+}
+
+// Whether a node of the image can be relocated: strings lie in the pool with their NUL,
+// and containers refer to a block, which is checked when it is expanded.
+static bool node_valid(const SnapshotHeader* header, const SerdecValue* node) {
+    unsigned sub = serdec_tag_sub(node);
+    switch (serdec_tag_type(node)) {
+    case SERDEC_TYPE_NULL:
+        return true;
+    case SERDEC_TYPE_BOOL:
+        return node->u64 <= 1;
+    case SERDEC_TYPE_NUMBER:
+        return sub <= SERDEC_NUMBER_DOUBLE;
+    case SERDEC_TYPE_STRING:
+        return (sub == 0 || sub == SERDEC_STRING_ESCAPED) &&
+               in_range(node->u64, (uint64_t) serdec_tag_len(node) + 1,
+                        header->size - header->pool);
+    case SERDEC_TYPE_ARRAY:
+    case SERDEC_TYPE_OBJECT:
+        return sub == SERDEC_CONTAINER_MAPPED;
+    default:
+        return false;
+    }
+}
+
+// Whether a run of nodes can be relocated; with keys, every stride-th node from the
+// first is an object key.
+static bool nodes_valid(const SnapshotHeader* header, const SerdecValue* nodes, size_t count,
+                        size_t stride) {
+    for (size_t i = 0; i < count; i++) {
+        if (!node_valid(header, &nodes[i])) return false;
+        if (stride && i % stride == 0 && serdec_tag_type(&nodes[i]) != SERDEC_TYPE_STRING)
+            return false;
+    }
+    return true;
+}
+
+// Whether the key table at offset lies in the image and leaves a slot empty for each
+// absent member, so that every probe ends.
+static bool table_valid(const SnapshotHeader* header, uint64_t offset, size_t count) {
+    size_t capacity = serdec_index_capacity(count);
+    if (!block_range(header, offset, capacity, sizeof(uint32_t))) return false;
+
+    const uint32_t* table = (const uint32_t*) ((const char*) header + offset);
+    size_t used = 0;
+    for (size_t i = 0; i < capacity; i++) used += table[i] != 0;
+    return used <= count;
+}
+
+// Turns the offsets in a run of checked nodes into pointers.
+static void relocate(SerdecDocument* doc, SerdecValue* nodes, size_t count) {
+    const char* pool = doc->input + ((const SnapshotHeader*) doc->input)->pool;
+    for (size_t i = 0; i < count; i++) {
+        SerdecValueType type = serdec_tag_type(&nodes[i]);
+        if (type == SERDEC_TYPE_STRING) nodes[i].str = pool + nodes[i].u64;
+        else if (type == SERDEC_TYPE_ARRAY || type == SERDEC_TYPE_OBJECT) nodes[i].document = doc;
+    }
+}
+
+static int compare_offsets(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*) a;
+    uint64_t y = *(const uint64_t*) b;
+    return (x > y) - (x < y);
+}
+
+// Checks and relocates the shape records, leaving their offsets sorted so that blocks can
+// look theirs up. Each run is checked just before it is relocated, so a run overlapping
+// one already relocated fails its check instead of being relocated twice.
+static bool map_shapes(SerdecDocument* doc, SnapshotHeader* header) {
+    char* image = (char*) header;
+    uint64_t* shapes = (uint64_t*) (image + header->shapes);
+    qsort(shapes, header->shape_count, sizeof(*shapes), compare_offsets);
+
+    for (size_t i = 0; i < header->shape_count; i++) {
+        if ((i && shapes[i] == shapes[i - 1]) ||
+            !block_range(header, shapes[i], 1, sizeof(SerdecShape)))
+            return false;
+        SerdecShape* shape = (SerdecShape*) (image + shapes[i]);
+        uint64_t keys = (uintptr_t) shape->keys;
+        uint64_t table = (uintptr_t) shape->table;
+        if (shape->count >= UINT32_MAX ||
+            !block_range(header, keys, shape->count, sizeof(SerdecValue)) ||
+            !nodes_valid(header, (const SerdecValue*) (image + keys), shape->count, 1) ||
+            (table && !table_valid(header, table, shape->count)))
+            return false;
+
+        shape->keys = (const SerdecValue*) (image + keys);
+        if (table) shape->table = (const uint32_t*) (image + table);
+        relocate(doc, (SerdecValue*) shape->keys, shape->count);
+    }
+    return true;
+}
+
+// The relocated shape record at offset, or NULL if no shape record is there.
+static const SerdecShape* find_shape(const SnapshotHeader* header, uint64_t offset) {
+    const char* image = (const char*) header;
+    const uint64_t* found = bsearch(&offset, image + header->shapes, header->shape_count,
+                                    sizeof(uint64_t), compare_offsets);
+    return found ? (const SerdecShape*) (image + offset) : NULL;
+}
+
+SerdecError serdec_document_map(SerdecArena* arena, const char* path, SerdecDocument** doc) {
+    if (!arena || arena->magic != SERDEC_MAGIC_ARENA || !path || !doc)
+        return SERDEC_ERR_INVALID_HANDLE;
+
+    char* image;
+    size_t size;
+    SerdecError status = map_file(path, &image, &size);
+    if (status != SERDEC_OK) return status;
+
+    SnapshotHeader* header = (SnapshotHeader*) image;
+    SerdecDocument* document = NULL;
+    if (!header_valid(header, size)) {
+        status = SERDEC_ERR_IO;
+    } else {
+        document = (SerdecDocument*) serdec_arena_alloc_aligned(arena, sizeof(*document),
+                                                                _Alignof(SerdecDocument));
+        if (!document) status = SERDEC_ERR_OUT_OF_MEMORY;
+    }
+    if (status != SERDEC_OK) {
+        unmap_file(image, size);
+        return status;
+    }
+
+    // Strings point into the image, so statistics count them as borrowed
+    *document = (SerdecDocument) {
+        .magic = SERDEC_MAGIC_DOCUMENT,
+        .arena = arena,
+        .root = &header->root,
+        .input = image,
+        .len = size,
+        .mapped = true,
+    };
+
+    if (!node_valid(header, &header->root) || !map_shapes(document, header)) {
+        unmap_file(image, size);
+        return SERDEC_ERR_IO;
+    }
+    relocate(document, &header->root, 1);
+
+    *doc = document;
+    return SERDEC_OK;
+}
+
+// Whether the block of a mapped container holds what its tag says, within the image:
+// the children run, and the shape or the key table an object refers to.
+static bool block_valid(const SnapshotHeader* header, SerdecValueType type,
+                        const SnapshotBlock* block, const SerdecValue* slots) {
+    SerdecValue node = { .tag = block->tag };
+    size_t count = serdec_tag_len(&node);
+    unsigned sub = serdec_tag_sub(&node);
+    uint64_t start = (uint64_t) ((const char*) slots - (const char*) header);
+    if (serdec_tag_type(&node) != type) return false;
+
+    if (type == SERDEC_TYPE_ARRAY && serdec_is_packed(&node)) {
+        return block_range(header, start, 1, sizeof(SerdecPackedArray)) &&
+               count <= (header->pool - start - sizeof(SerdecPackedArray)) / sizeof(uint64_t);
+    }
+    if (type == SERDEC_TYPE_ARRAY) {
+        return sub == 0 && block_range(header, start, count, sizeof(SerdecValue)) &&
+               nodes_valid(header, slots, count, 0);
+    }
+    if (sub == SERDEC_OBJECT_SHAPED) {
+        const SerdecShape* shape = find_shape(header, slots[0].u64);
+        return shape && shape->count == count &&
+               block_range(header, start, (uint64_t) count + 1, sizeof(SerdecValue)) &&
+               nodes_valid(header, slots + 1, count, 0);
+    }
+
+    bool indexed = serdec_has_index(type, count);
+    if (sub != 0 || count > SIZE_MAX / 4 ||
+        !block_range(header, start, 2 * (uint64_t) count + indexed, sizeof(SerdecValue)) ||
+        !nodes_valid(header, slots + indexed, 2 * count, 2))
+        return false;
+    return !indexed ||
+           table_valid(header, (uintptr_t) ((const SerdecObjectIndex*) slots)->table, count);
+}
+
+// Relocates the block of a mapped container and points the node at it. A block is
+// relocated once; nodes copied from the same container, e.g. by an edit, find it done.
+// The file cannot forge that mark, which is the block's own address.
+SerdecError serdec_snapshot_expand(const SerdecValue* value) {
+    SerdecDocument* doc = value->document;
+    if (!doc->mapped) return SERDEC_ERR_INVALID_HANDLE;   // Document destroyed
+
+    // The mapping is writable; only the document hands it out as const
+    char* image = (char*) doc->input;
+    const SnapshotHeader* header = (const SnapshotHeader*) image;
+    uint64_t offset = serdec_tag_len(value);
+    if (!block_range(header, offset, 1, sizeof(SnapshotBlock))) return SERDEC_ERR_IO;
+    SnapshotBlock* block = (SnapshotBlock*) (image + offset);
+    SerdecValue node = { .tag = block->tag };
+    SerdecValueType type = serdec_tag_type(&node);
+    size_t count = serdec_tag_len(&node);
+    SerdecValue* slots = (SerdecValue*) (block + 1);
+    bool pending = block->relocated != (uintptr_t) block;
+    if (pending && !block_valid(header, serdec_tag_type(value), block, slots))
+        return SERDEC_ERR_IO;
+
+    if (type == SERDEC_TYPE_ARRAY && serdec_is_packed(&node)) {
+        node.packed = (SerdecPackedArray*) slots;
+        if (pending) *node.packed = (SerdecPackedArray) { .arena = doc->arena };
+    } else if (type == SERDEC_TYPE_OBJECT && serdec_tag_sub(&node) == SERDEC_OBJECT_SHAPED) {
+        node.children = slots + 1;
+        if (pending) {
+            const SerdecShape** shape = (const SerdecShape**) node.children - 1;
+            *shape = (const SerdecShape*) (image + (uintptr_t) *shape);
+            relocate(doc, node.children, count);
+        }
+    } else if (type == SERDEC_TYPE_OBJECT) {
+        bool indexed = serdec_has_index(type, count);
+        node.children = count ? slots + indexed : NULL;
+        if (pending && indexed) {
+            SerdecObjectIndex* index = (SerdecObjectIndex*) slots;
+            index->arena = doc->arena;
+            index->table = (uint32_t*) (image + (uintptr_t) index->table);
+        }
+        if (pending) relocate(doc, node.children, 2 * count);
+    } else {
+        node.children = count ? slots : NULL;
+        if (pending) relocate(doc, slots, count);
+    }
+
+    block->relocated = (uintptr_t) block;
+    *(SerdecValue*) value = node;
+    return SERDEC_OK;
+}
+
+void serdec_snapshot_release(SerdecDocument* doc) {
+    unmap_file((char*) doc->input, doc->len);
+    doc->input = NULL;
+    doc->mapped = false;
+}
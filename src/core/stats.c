@@ -0,0 +1,155 @@
+#include "internal.h"
+#include <serdec/dom.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+typedef struct {
+    const SerdecValue* value;
+    size_t depth;
+} StatsItem;
+
+typedef struct {
+    const SerdecDocument* doc;
+    SerdecDocumentStats* out;
+    StatsItem* stack;
+    size_t depth;
+    size_t capacity;
+    const SerdecShape** shapes;   // Open-addressed by address
+    size_t shape_capacity;
+} Stats;
+
+static bool push(Stats* s, const SerdecValue* value, size_t depth) {
+    if (s->depth == s->capacity) {
+        size_t grown = s->capacity ? s->capacity * 2 : 64;
+        StatsItem* items = realloc(s->stack, grown * sizeof(*items));
+        if (!items) return false;
+        s->stack = items;
+        s->capacity = grown;
+    }
+    s->stack[s->depth++] = (StatsItem) { value, depth };
+    return true;
+}
+
+static size_t shape_slot(const Stats* s, const SerdecShape* shape) {
+    size_t mask = s->shape_capacity - 1;
+    size_t slot = (size_t) (((uintptr_t) shape >> 4) * 0x9E3779B97F4A7C15ull) & mask;
+    while (s->shapes[slot] && s->shapes[slot] != shape) slot = (slot + 1) & mask;
+    return slot;
+}
+
+// Adds shape to the set. Returns false when out of memory; *added is false if present.
+static bool add_shape(Stats* s, const SerdecShape* shape, bool* added) {
+    *added = false;
+    if (s->shape_capacity && s->shapes[shape_slot(s, shape)]) return true;
+
+    if (2 * (s->out->shapes + 1) > s->shape_capacity) {
+        size_t capacity = s->shape_capacity ? s->shape_capacity * 2 : 16;
+        const SerdecShape** shapes = (const SerdecShape**) calloc(capacity, sizeof(*shapes));
+        if (!shapes) return false;
+
+        const SerdecShape** old = s->shapes;
+        size_t old_capacity = s->shape_capacity;
+        s->shapes = shapes;
+        s->shape_capacity = capacity;
+        for (size_t i = 0; i < old_capacity; i++) {
+            if (old[i]) s->shapes[shape_slot(s, old[i])] = old[i];
+        }
+        free(old);
+    }
+
+    s->shapes[shape_slot(s, shape)] = shape;
+    s->out->shapes++;
+    *added = true;
+    return true;
+}
+
+static void count_string(Stats* s, const SerdecValue* node) {
+    size_t len = serdec_tag_len(node);
+    if (serdec_tag_sub(node) == SERDEC_STRING_INTERNED) return;
+    if (node->str >= s->doc->input && node->str < s->doc->input + s->doc->len)
+        s->out->borrowed_bytes += len;
+    else
+        s->out->copied_bytes += len;
+}
+
+// Key bytes are counted only when bytes is set, i.e. once per shape.
+static void count_keys(Stats* s, const SerdecValue* keys, size_t count, size_t stride,
+                       bool bytes) {
+    for (size_t i = 0; i < count; i++, keys += stride) {
+        if (serdec_tag_sub(keys) == SERDEC_STRING_INTERNED) s->out->interned_keys++;
+        else if (bytes) count_string(s, keys);
+    }
+}
+
+// Counts value itself. Returns true for an expanded container, whose children are next.
+static bool count_value(Stats* s, const SerdecValue* value, size_t depth) {
+    SerdecValueType type = serdec_tag_type(value);
+    s->out->nodes[type]++;
+    if (depth > s->out->max_depth) s->out->max_depth = depth;
+
+    if (type == SERDEC_TYPE_STRING) count_string(s, value);
+    if (type != SERDEC_TYPE_ARRAY && type != SERDEC_TYPE_OBJECT) return false;
+    if (serdec_tag_sub(value) < SERDEC_CONTAINER_MAPPED) return true;   // Lazy or mapped
+    s->out->unexpanded++;
+    return false;
+}
+
+static SerdecError walk(Stats* s) {
+    SerdecDocumentStats* out = s->out;
+    size_t depth = 0;
+    if (!count_value(s, s->doc->root, 0)) return SERDEC_OK;
+
+    for (const SerdecValue* value = s->doc->root;;) {
+        size_t count = serdec_tag_len(value);
+        const SerdecValue* child = value->children;
+        size_t stride = 1;
+
+        if (serdec_tag_type(value) == SERDEC_TYPE_ARRAY) {
+            if (count > out->largest_array) out->largest_array = count;
+            if (serdec_is_packed(value)) {
+                out->packed_arrays++;
+                out->nodes[SERDEC_TYPE_NUMBER] += count;
+                if (depth + 1 > out->max_depth) out->max_depth = depth + 1;
+                count = 0;
+            }
+        } else {
+            if (count > out->largest_object) out->largest_object = count;
+            out->members += count;
+
+            const SerdecShape* shape = serdec_object_shape(value);
+            if (shape) {
+                bool added;
+                if (!add_shape(s, shape, &added)) return SERDEC_ERR_OUT_OF_MEMORY;
+                count_keys(s, shape->keys, count, 1, added);
+            } else {
+                count_keys(s, child, count, 2, true);
+                child++;
+                stride = 2;
+            }
+        }
+
+        for (size_t i = 0; i < count; i++, child += stride) {
+            if (count_value(s, child, depth + 1) && !push(s, child, depth + 1))
+                return SERDEC_ERR_OUT_OF_MEMORY;
+        }
+        if (!s->depth) return SERDEC_OK;
+        StatsItem item = s->stack[--s->depth];
+        value = item.value;
+        depth = item.depth;
+    }
+}
+
+SerdecError serdec_document_stats(const SerdecDocument* doc, SerdecDocumentStats* out) {
+    if (!doc || doc->magic != SERDEC_MAGIC_DOCUMENT || !out) return SERDEC_ERR_INVALID_HANDLE;
+
+    *out = (SerdecDocumentStats) {
+        .arena_used = serdec_arena_used(doc->arena),
+        .arena_reserved = serdec_arena_reserved(doc->arena),
+    };
+    Stats s = { .doc = doc, .out = out };
+    SerdecError status = walk(&s);
+    free(s.stack);
+    free(s.shapes);
+    return status;
+}
@@ -1,11 +1,172 @@
 #include "internal.h"
 #include "serdec/error.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Reads exactly four hex digits. Returns false on truncation or a non-hex digit.
+static bool read_hex4(const char* src, const char* end, uint32_t* out) {
+    if (end - src < 4) return false;
+
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        int digit = hex_value(src[i]);
+        if (digit < 0) return false;
+        value = (value << 4) | (uint32_t) digit;
+    }
+
+    *out = value;
+    return true;
+}
+
+SerdecError serdec_string_unescape_to(char* dst, const char* src, size_t len,
+                                       size_t* out_len) {
+    if (!dst || !src || !out_len) return SERDEC_ERR_INVALID_ESCAPE;
+
+    const char* ptr = src;
+    const char* end = src + len;
+    size_t pos = 0;
+
+    while (ptr < end) {
+        const char* backslash = memchr(ptr, '\\', end - ptr);
+        size_t run = backslash ? (size_t) (backslash - ptr) : (size_t) (end - ptr);
+        memcpy(dst + pos, ptr, run);
+        pos += run;
+        ptr += run;
+
+        if (ptr >= end) break;
+
+        // Escape sequence: ptr points at the backslash
+        if (ptr + 1 >= end) return SERDEC_ERR_INVALID_ESCAPE;
+
+        char esc = ptr[1];
+        ptr += 2;
+        switch (esc) {
+        case '"':  dst[pos++] = '"';  break;
+        case '\\': dst[pos++] = '\\'; break;
+        case '/':  dst[pos++] = '/';  break;
+        case 'b':  dst[pos++] = '\b'; break;
+        case 'f':  dst[pos++] = '\f'; break;
+        case 'n':  dst[pos++] = '\n'; break;
+        case 'r':  dst[pos++] = '\r'; break;
+        case 't':  dst[pos++] = '\t'; break;
+        case 'u': {
+            uint32_t cp;
+            if (!read_hex4(ptr, end, &cp)) return SERDEC_ERR_INVALID_ESCAPE;
+            ptr += 4;
+
+            // Lone low surrogate
+            if (cp >= 0xDC00 && cp <= 0xDFFF) return SERDEC_ERR_INVALID_ESCAPE;
+
+            // High surrogate must be followed by \uXXXX low surrogate
+            if (cp >= 0xD800 && cp <= 0xDBFF) {
+                uint32_t low;
+                if (end - ptr < 2 || ptr[0] != '\\' || ptr[1] != 'u')
+                    return SERDEC_ERR_INVALID_ESCAPE;
+                if (!read_hex4(ptr + 2, end, &low)) return SERDEC_ERR_INVALID_ESCAPE;
+                if (low < 0xDC00 || low > 0xDFFF) return SERDEC_ERR_INVALID_ESCAPE;
+                ptr += 6;
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+            }
+
+            int width = serdec_utf8_encode(cp, dst + pos);
+            if (width == 0) return SERDEC_ERR_INVALID_ESCAPE;
+            pos += width;
+            break;
+        }
+        default: return SERDEC_ERR_INVALID_ESCAPE;
+        }
+    }
+
+    dst[pos] = '\0';
+    *out_len = pos;
+    return SERDEC_OK;
+}
+
+int serdec_string_compare(SerdecString s, const char* str, size_t len) {
+    const char* ptr = s.ptr;
+    const char* end = s.ptr + s.len;
+    size_t pos = 0;
+    while (ptr < end) {
+        const char* backslash = s.has_escapes ? memchr(ptr, '\\', end - ptr) : NULL;
+        size_t run = backslash ? (size_t) (backslash - ptr) : (size_t) (end - ptr);
+        size_t n = run < len - pos ? run : len - pos;
+        int order = memcmp(ptr, str + pos, n);
+        if (order != 0 || n < run) return order ? order : 1;
+        pos += run;
+        ptr += run;
+        if (ptr >= end) break;
+
+        // Decode one escape, or a surrogate pair, and compare its bytes
+        size_t span = 2;
+        uint32_t unit;
+        if (end - ptr >= 6 && ptr[1] == 'u') {
+            span = 6;
+            if (read_hex4(ptr + 2, end, &unit) && unit >= 0xD800 && unit <= 0xDBFF &&
+                end - ptr >= 12 && ptr[6] == '\\' && ptr[7] == 'u')
+                span = 12;
+        }
+        char bytes[13];
+        size_t count;
+        if (span > (size_t) (end - ptr) ||
+            serdec_string_unescape_to(bytes, ptr, span, &count) != SERDEC_OK)
+            return 1;
+        n = count < len - pos ? count : len - pos;
+        order = memcmp(bytes, str + pos, n);
+        if (order != 0 || n < count) return order ? order : 1;
+        pos += count;
+        ptr += span;
+    }
+    return pos < len ? -1 : 0;
+}
+
+bool serdec_string_equals(SerdecString s, const char* str, size_t len) {
+    if (!s.has_escapes) return s.len == len && memcmp(s.ptr, str, len) == 0;
+    return serdec_string_compare(s, str, len) == 0;
+}
 
 SerdecError serdec_string_unescape(SerdecArena* arena, const char* src, size_t len,
                                     char** out, size_t* out_len) {
     if (!arena || !src || !out || !out_len) return SERDEC_ERR_INVALID_ESCAPE;
-    const char* ptr = src;
-    while (*ptr != '\0') {
-        
+
+    // Unescaping never grows the input: every escape is at least as long as its output.
+    // Allocate one extra byte so empty strings still get a valid pointer.
+    char* dst = serdec_arena_alloc(arena, len + 1);
+    if (!dst) return SERDEC_ERR_OUT_OF_MEMORY;
+
+    SerdecError err = serdec_string_unescape_to(dst, src, len, out_len);
+    if (err != SERDEC_OK) return err;
+
+    *out = dst;
+    return SERDEC_OK;
+}
+
+SerdecError serdec_string_materialize(SerdecArena* arena, SerdecString s,
+                                      const char** out, size_t* out_len) {
+    if (!out || !out_len) return SERDEC_ERR_INVALID_HANDLE;
+
+    if (!s.has_escapes) {
+        *out = s.ptr;
+        *out_len = s.len;
+        return SERDEC_OK;
     }
+
+    char* decoded = NULL;
+    SerdecError err = serdec_string_unescape(arena, s.ptr, s.len, &decoded, out_len);
+    if (err != SERDEC_OK) return err;
+
+    *out = decoded;
+    return SERDEC_OK;
+}
+
+SerdecError serdec_json_string_materialize(SerdecArena* arena, SerdecString s,
+                                           const char** out, size_t* out_len) {
+    return serdec_string_materialize(arena, s, out, out_len);
 }
@@ -0,0 +1,28 @@
+#include "internal.h"
+#include <pthread.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+unsigned serdec_cpu_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (unsigned) n : 1;
+}
+
+void serdec_workers_run(unsigned count, void* (*fn)(void*), void* items, size_t stride) {
+    if (!count) return;
+
+    pthread_t* threads = (count > 1) ? (pthread_t*) malloc((count - 1) * sizeof(*threads)) : NULL;
+    unsigned started = 0;
+    while (threads && started < count - 1) {
+        void* item = (char*) items + (size_t) (started + 1) * stride;
+        if (pthread_create(&threads[started], NULL, fn, item)) break;
+        started++;
+    }
+
+    fn(items);
+
+    for (unsigned i = 0; i < started; i++)
+        pthread_join(threads[i], NULL);
+    free(threads);
+}
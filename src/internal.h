@@ -2,12 +2,28 @@
 
 #include "serdec/types.h"
 #include <serdec/serdec.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
-#define SERDEC_MAGIC_BUFFER 0x5EDEC00B
-#define SERDEC_MAGIC_ARENA  0x5EDEC00A
-#define SERDEC_MAGIC_FREED  0xDEADBEEF
+#define SERDEC_MAGIC_BUFFER   0x5EDEC00B
+#define SERDEC_MAGIC_ARENA    0x5EDEC00A
+#define SERDEC_MAGIC_PARSER   0x5EDEC00C
+#define SERDEC_MAGIC_TAPE     0x5EDEC00D
+#define SERDEC_MAGIC_ERRORS   0x5EDEC00E
+#define SERDEC_MAGIC_DOCUMENT 0x5EDEC00F
+#define SERDEC_MAGIC_INTERN   0x5EDEC010
+#define SERDEC_MAGIC_ITERATOR 0x5EDEC011
+#define SERDEC_MAGIC_INDEX    0x5EDEC012
+#define SERDEC_MAGIC_LINES    0x5EDEC013
+#define SERDEC_MAGIC_POINTER  0x5EDEC014
+#define SERDEC_MAGIC_QUERY    0x5EDEC015
+#define SERDEC_MAGIC_FILTER   0x5EDEC016
+#define SERDEC_MAGIC_FREED    0xDEADBEEF
 
 #define SERDEC_DEFAULT_BUFFER_CAPACITY 100
+#define SERDEC_DEFAULT_MAX_DEPTH       1024
+#define SERDEC_LEXER_COLUMN_SCAN       (64 * 1024)
 
 #ifdef _WIN32
     #include <malloc.h>                                                       
@@ -25,10 +41,18 @@
 
 struct SerdecBuffer {
     uint32_t magic;           // 0x5EDEC00B for validation
-    uint32_t ref_count;
-    char* data;               // 64-byte aligned
+    _Atomic uint32_t ref_count;
+    char* data;               // 64-byte aligned, followed by 64 zero bytes
     size_t size;
     size_t capacity;          // size + padding
+    bool mapped;              // data is a read-only file mapping; see serdec_buffer_from_file()
+};
+
+struct SerdecErrorList {
+    uint32_t magic;           // 0x5EDEC00E for validation
+    SerdecErrorInfo* items;
+    size_t count;
+    size_t capacity;
 };
 
 typedef struct ArenaBlock {
@@ -100,6 +124,322 @@ typedef struct SerdecLexer {
     SerdecErrorInfo error;
 } SerdecLexer;
 
+typedef enum SerdecParserState {
+    SERDEC_PARSER_VALUE,        // Expecting a value (root, array element, object member)
+    SERDEC_PARSER_ARRAY_FIRST,  // After '[': value or ']'
+    SERDEC_PARSER_OBJECT_FIRST, // After '{': key or '}'
+    SERDEC_PARSER_KEY,          // After ',' inside an object: key
+    SERDEC_PARSER_AFTER_VALUE,  // After a value inside a container: ',' or closing bracket
+    SERDEC_PARSER_DONE,         // Root value complete: only whitespace may follow
+    SERDEC_PARSER_END,          // SERDEC_EVENT_END emitted
+    SERDEC_PARSER_ERROR,        // Sticky error state
+} SerdecParserState;
+
+struct SerdecParser {
+    uint32_t magic;           // 0x5EDEC00C for validation
+    SerdecLexer* lexer;       // Owns a reference to the input buffer
+    SerdecParserState state;
+
+    uint8_t* stack;           // Open containers: '{' or '['
+    size_t depth;
+    size_t max_depth;
+
+    size_t floor;             // Virtual containers opened by a range reset (never closed)
+    bool sequence;            // Accept any number of root values (concatenated JSON)
+
+    SerdecToken token;        // Last scalar token (number details for the DOM builder)
+    SerdecErrorInfo error;
+};
+
+typedef enum SerdecNumberKind {
+    SERDEC_NUMBER_UINT,       // Non-negative integer in u64
+    SERDEC_NUMBER_INT,        // Negative integer in i64
+    SERDEC_NUMBER_DOUBLE,     // Anything with a fraction or exponent, in f64
+} SerdecNumberKind;
+
+// Node tag layout: type in bits 0-2, subtype in bits 3-7, length in bits 8-63.
+// The length is the byte count of a string, the element count of an array and the
+// member count of an object. The subtype is the SerdecNumberKind of a number, or for
+// a string SERDEC_STRING_ESCAPED if it still holds escape sequences, or
+// SERDEC_STRING_INTERNED if it points at the bytes of a SerdecInternEntry. Objects
+// built with shapes are SERDEC_OBJECT_SHAPED, and objects built by an edit are
+// SERDEC_OBJECT_GROWABLE. Arrays stored as packed numbers are SERDEC_ARRAY_I64 or
+// SERDEC_ARRAY_F64; arrays built by an edit are SERDEC_ARRAY_GROWABLE. A container of
+// a lazy document that has not been expanded yet is SERDEC_CONTAINER_LAZY; its length
+// is then the byte offset of its opening bracket, and it points at its document. A container of a mapped snapshot whose
+// children have not been relocated yet is SERDEC_CONTAINER_MAPPED; its length is then
+// the offset of its block in the image, and it points at its document.
+#define SERDEC_TAG_TYPE_MASK    0x07u
+#define SERDEC_TAG_SUB_SHIFT    3
+#define SERDEC_TAG_LEN_SHIFT    8
+#define SERDEC_STRING_ESCAPED   1u
+#define SERDEC_STRING_INTERNED  2u
+#define SERDEC_OBJECT_SHAPED    1u
+#define SERDEC_OBJECT_GROWABLE  2u
+#define SERDEC_ARRAY_I64        1u
+#define SERDEC_ARRAY_F64        2u
+#define SERDEC_ARRAY_GROWABLE   3u
+#define SERDEC_CONTAINER_MAPPED 30u
+#define SERDEC_CONTAINER_LAZY   31u
+
+// 16-byte DOM node. Children of a container are one contiguous run of nodes: `len`
+// elements for an array, `len` key/value pairs for an object. Object keys are string
+// nodes and are always decoded. Large objects have a SerdecObjectIndex slot in front
+// of their members. A shaped object stores only its `len` values; a pointer to its
+// SerdecShape sits just in front of them. Packed numeric arrays point at a
+// SerdecPackedArray instead of nodes. A growable array has a SerdecArrayBlock slot in
+// front of its elements; a growable object has one in front of its index slot, which it
+// always has.
+struct SerdecValue {
+    uint64_t tag;
+    union {
+        bool boolean;
+        const char* str;      // Borrowed from the input, or decoded into the arena
+        SerdecValue* children;
+        struct SerdecPackedArray* packed;
+        struct SerdecDocument* document;  // Unexpanded lazy or mapped container
+        int64_t i64;
+        uint64_t u64;
+        double f64;
+    };
+};
+
+_Static_assert(sizeof(SerdecValue) == 16, "DOM nodes must stay 16 bytes");
+
+static inline uint64_t serdec_tag(SerdecValueType type, unsigned sub, size_t len) {
+    return (uint64_t) type | ((uint64_t) sub << SERDEC_TAG_SUB_SHIFT) |
+           ((uint64_t) len << SERDEC_TAG_LEN_SHIFT);
+}
+
+static inline SerdecValueType serdec_tag_type(const SerdecValue* v) {
+    return (SerdecValueType) (v->tag & SERDEC_TAG_TYPE_MASK);
+}
+
+static inline unsigned serdec_tag_sub(const SerdecValue* v) {
+    return (unsigned) (v->tag >> SERDEC_TAG_SUB_SHIFT) & 0x1Fu;
+}
+
+static inline size_t serdec_tag_len(const SerdecValue* v) {
+    return (size_t) (v->tag >> SERDEC_TAG_LEN_SHIFT);
+}
+
+// Numeric arrays with at least this many elements are packed when typed arrays are on.
+#define SERDEC_PACKED_MIN 2
+
+// Header of a packed numeric array, followed by `len` int64_t or double values.
+typedef struct SerdecPackedArray {
+    SerdecArena* arena;       // Arena for the element nodes
+    SerdecValue* nodes;       // Element nodes, built on the first serdec_index; else NULL
+} SerdecPackedArray;
+
+static inline void* serdec_packed_data(const SerdecPackedArray* packed) {
+    return (void*) (packed + 1);
+}
+
+static inline bool serdec_is_packed(const SerdecValue* array) {
+    unsigned sub = serdec_tag_sub(array);
+    return sub == SERDEC_ARRAY_I64 || sub == SERDEC_ARRAY_F64;
+}
+
+// Node for element i of a packed array.
+static inline SerdecValue serdec_packed_node(const SerdecValue* array, size_t i) {
+    if (serdec_tag_sub(array) == SERDEC_ARRAY_F64) {
+        const double* data = (const double*) serdec_packed_data(array->packed);
+        return (SerdecValue) { .tag = serdec_tag(SERDEC_TYPE_NUMBER, SERDEC_NUMBER_DOUBLE, 0),
+                               .f64 = data[i] };
+    }
+    const int64_t* data = (const int64_t*) serdec_packed_data(array->packed);
+    if (data[i] < 0) {
+        return (SerdecValue) { .tag = serdec_tag(SERDEC_TYPE_NUMBER, SERDEC_NUMBER_INT, 0),
+                               .i64 = data[i] };
+    }
+    return (SerdecValue) { .tag = serdec_tag(SERDEC_TYPE_NUMBER, SERDEC_NUMBER_UINT, 0),
+                           .u64 = (uint64_t) data[i] };
+}
+
+// Sits in the node slot just before the elements of an array built by an edit, or before
+// the index slot of an object built by one, so that appending to the newest version can
+// fill spare capacity in place. Capacity and use count members for objects.
+typedef struct SerdecArrayBlock {
+    size_t capacity;          // Element slots after this header
+    size_t used;              // Slots filled by some version of the array
+} SerdecArrayBlock;
+
+_Static_assert(sizeof(SerdecArrayBlock) <= sizeof(SerdecValue),
+               "an array block header must fit in a node slot");
+
+static inline SerdecArrayBlock* serdec_array_block(const SerdecValue* array) {
+    return (SerdecArrayBlock*) (array->children - 1);
+}
+
+static inline SerdecArrayBlock* serdec_object_block(const SerdecValue* object) {
+    return (SerdecArrayBlock*) (object->children - 2);
+}
+
+// Objects with at least this many members get a hash index on their first lookup.
+#define SERDEC_INDEX_THRESHOLD 16
+
+// Occupies the node slot just before the members of an object with at least
+// SERDEC_INDEX_THRESHOLD members. The table is open-addressed with linear probing; each
+// slot holds a member index + 1, or 0 if empty. Its capacity follows from the member
+// count (see serdec_index_capacity), so it is not stored. All versions of a growable
+// object share one table over every member the block holds; a version skips the members
+// past its own count.
+typedef struct SerdecObjectIndex {
+    SerdecArena* arena;       // Arena the table is built in
+    uint32_t* table;          // NULL until the first lookup
+} SerdecObjectIndex;
+
+_Static_assert(sizeof(SerdecObjectIndex) <= sizeof(SerdecValue),
+               "an object index must fit in a node slot");
+
+static inline bool serdec_has_index(SerdecValueType type, size_t count) {
+    return type == SERDEC_TYPE_OBJECT && count >= SERDEC_INDEX_THRESHOLD && count < UINT32_MAX;
+}
+
+// Power of two, at least twice the member count.
+static inline size_t serdec_index_capacity(size_t count) {
+    size_t capacity = 2 * SERDEC_INDEX_THRESHOLD;
+    while (capacity < 2 * count) capacity <<= 1;
+    return capacity;
+}
+
+// FNV-1a.
+static inline uint64_t serdec_hash(const char* data, size_t len) {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (uint8_t) data[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+// Cheap check that a saved index belongs to its input: the bytes at both ends.
+#define SERDEC_INPUT_SNIFF 4096
+static inline uint64_t serdec_input_hash(const char* data, size_t size) {
+    size_t head = size < SERDEC_INPUT_SNIFF ? size : SERDEC_INPUT_SNIFF;
+    size_t tail = size - head < SERDEC_INPUT_SNIFF ? size - head : SERDEC_INPUT_SNIFF;
+    return serdec_hash(data, head) * 31 + serdec_hash(data + size - tail, tail);
+}
+
+// Makes room in a realloc'd array for item count + 1, doubling the capacity from 64.
+// Shared by the builders of the sidecar indexes.
+static inline bool serdec_sidecar_grow(void** items, size_t* capacity, size_t count,
+                                       size_t size) {
+    if (count < *capacity) return true;
+    size_t grown = *capacity ? *capacity * 2 : 64;
+    void* larger = realloc(*items, grown * size);
+    if (!larger) return false;
+    *items = larger;
+    *capacity = grown;
+    return true;
+}
+
+// Whether the rest of a sidecar index file holds exactly counts[i] items of sizes[i] bytes
+// for each i. Arrays are sized from the header, so loaders check the file really holds
+// that much before allocating. Leaves fp where it was.
+static inline bool serdec_sidecar_fits(FILE* fp, const uint64_t* counts, const size_t* sizes,
+                                       size_t n) {
+    long start = ftell(fp);
+    if (start < 0 || fseek(fp, 0, SEEK_END) != 0) return false;
+    long end = ftell(fp);
+    if (end < start || fseek(fp, start, SEEK_SET) != 0) return false;
+
+    uint64_t available = (uint64_t) (end - start);
+    for (size_t i = 0; i < n; i++) {
+        if (counts[i] > available / sizes[i]) return false;
+        available -= counts[i] * sizes[i];
+    }
+    return available == 0;
+}
+
+// Interned key. Callers get a pointer to `bytes`; the hash and length sit in front of it.
+typedef struct SerdecInternEntry {
+    uint64_t hash;            // serdec_hash() of the bytes
+    size_t len;
+    char bytes[];             // NUL-terminated
+} SerdecInternEntry;
+
+struct SerdecInternTable {
+    uint32_t magic;           // 0x5EDEC010 for validation
+    SerdecArena* arena;       // Owns the entries
+    SerdecInternEntry** slots;  // Open-addressed, linear probing
+    size_t count;
+    size_t capacity;          // Power of two
+    char* scratch;            // Decoding space for keys with escapes
+    size_t scratch_capacity;
+};
+
+static inline const SerdecInternEntry* serdec_intern_entry(const char* interned) {
+    return (const SerdecInternEntry*) (interned - offsetof(SerdecInternEntry, bytes));
+}
+
+// Key list shared by every object with the same keys in the same order.
+typedef struct SerdecShape {
+    size_t count;
+    const SerdecValue* keys;  // count string nodes
+    const uint32_t* table;    // Hash index over keys for large shapes, else NULL
+    uint64_t hash;            // Of the key sequence
+} SerdecShape;
+
+static inline const SerdecShape* serdec_object_shape(const SerdecValue* object) {
+    if (serdec_tag_sub(object) != SERDEC_OBJECT_SHAPED) return NULL;
+    return ((const SerdecShape* const*) object->children)[-1];
+}
+
+// Key and value of member i of an expanded object, shaped or not.
+static inline const SerdecValue* serdec_member_key(const SerdecValue* object, size_t i) {
+    const SerdecShape* shape = serdec_object_shape(object);
+    return shape ? &shape->keys[i] : &object->children[2 * i];
+}
+
+static inline const SerdecValue* serdec_member_value(const SerdecValue* object, size_t i) {
+    return serdec_object_shape(object) ? &object->children[i] : &object->children[2 * i + 1];
+}
+
+static inline uint64_t serdec_key_hash(const SerdecValue* key) {
+    if (serdec_tag_sub(key) == SERDEC_STRING_INTERNED) return serdec_intern_entry(key->str)->hash;
+    return serdec_hash(key->str, serdec_tag_len(key));
+}
+
+// The same interned key is equal by address; keys from different tables compare by bytes.
+static inline bool serdec_keys_equal(const SerdecValue* a, const SerdecValue* b) {
+    if (serdec_tag_len(a) != serdec_tag_len(b)) return false;
+    if (a->str == b->str) return true;
+    if (serdec_tag_sub(a) == SERDEC_STRING_INTERNED &&
+        serdec_tag_sub(b) == SERDEC_STRING_INTERNED &&
+        serdec_intern_entry(a->str)->hash != serdec_intern_entry(b->str)->hash)
+        return false;
+    return memcmp(a->str, b->str, serdec_tag_len(a)) == 0;
+}
+
+// Shapes seen by one build, open-addressed by hash.
+typedef struct SerdecShapeSet {
+    const SerdecShape** slots;
+    size_t count;
+    size_t capacity;
+} SerdecShapeSet;
+
+struct SerdecDocument {
+    uint32_t magic;           // 0x5EDEC00F for validation
+    SerdecArena* arena;       // Owns the document, its nodes and decoded keys
+    const SerdecValue* root;
+    const char* input;        // Borrowed; strings point into it
+    size_t len;
+    SerdecParser* parser;     // Lazy documents: re-parses spans from a padded copy; else NULL
+    SerdecParseConfig config; // Options for containers expanded later
+    SerdecShapeSet shapes;    // Shared by every expansion
+    bool frozen;              // No deferred writes left; see serdec_document_freeze()
+    bool mapped;              // input is a snapshot image from serdec_document_map()
+};
+
+// Error list API
+bool serdec_error_list_push(SerdecErrorList* list, const SerdecErrorInfo* info);
+// Sort errors [from, count) by offset.
+void serdec_error_list_sort(SerdecErrorList* list, size_t from);
+// Fill info->context with the input around info->offset, limited to [begin, end).
+void serdec_error_set_context(SerdecErrorInfo* info, const char* data, size_t begin, size_t end);
+
 // UTF-8 API
 
 // Returns byte count (1–4) on success, 0 on error.
@@ -112,14 +452,188 @@ bool serdec_utf8_validate(const char* data, size_t len);
 SerdecError serdec_string_unescape(SerdecArena* arena, const char* src, size_t len,
                                     char** out, size_t* out_len);
 
+// Same as serdec_string_unescape, but decodes into dst, which must hold len + 1 bytes.
+SerdecError serdec_string_unescape_to(char* dst, const char* src, size_t len,
+                                       size_t* out_len);
+
+// True if s, once its escapes are decoded, is exactly [str, str + len). Decodes one escape
+// at a time, without allocating.
+bool serdec_string_equals(SerdecString s, const char* str, size_t len);
+// Orders s, once decoded, against [str, str + len) bytewise, which for UTF-8 is code point
+// order: negative, zero or positive as with memcmp(). A bad escape orders s after str.
+int serdec_string_compare(SerdecString s, const char* str, size_t len);
+
 // Decode a borrowed string slice into arena-owned bytes.
 // Only allocates if s.has_escapes is true; otherwise points into the input.
 SerdecError serdec_string_materialize(SerdecArena* arena, SerdecString s,
                                       const char** out, size_t* out_len);
 
+// Intern API
+// Decodes s if it has escapes, then interns it.
+SerdecError serdec_intern_string(SerdecInternTable* table, SerdecString s, const char** out);
+
+// Object keys
+// Fills table, serdec_index_capacity(count) entries, with a hash index over count key
+// nodes spaced `stride` nodes apart.
+void serdec_key_table_fill(uint32_t* table, const SerdecValue* keys, size_t stride,
+                           size_t count);
+// Same, into a table allocated from arena.
+uint32_t* serdec_key_table_build(SerdecArena* arena, const SerdecValue* keys, size_t stride,
+                                 size_t count);
+// Returns the position of the first key equal to key, or SIZE_MAX. table may be NULL.
+// With `interned`, key came from serdec_intern() and carries its hash. hash, if not NULL,
+// is serdec_hash() of a key computed ahead of time.
+size_t serdec_key_find(const SerdecValue* keys, size_t stride, size_t count,
+                       const uint32_t* table, const char* key, size_t len, bool interned,
+                       const uint64_t* hash);
+// Returns the shape for count key nodes spaced `stride` apart, creating it in arena the
+// first time that key sequence is seen.
+SerdecError serdec_shape_get(SerdecShapeSet* set, SerdecArena* arena, const SerdecValue* keys,
+                             size_t stride, size_t count, const SerdecShape** out);
+void serdec_shape_set_free(SerdecShapeSet* set);
+
 // Lexer API
 SerdecLexer* serdec_lexer_create(SerdecBuffer* buf);
 void serdec_lexer_destroy(SerdecLexer* lexer);
 SerdecToken serdec_lexer_next(SerdecLexer* lexer);
 SerdecToken serdec_lexer_peek(SerdecLexer* lexer);
 const SerdecErrorInfo* serdec_lexer_get_error(const SerdecLexer* lexer);
+// Reposition the lexer to [begin, end) of its buffer. `line` is the line containing begin.
+// Its column is found by looking back at most SERDEC_LEXER_COLUMN_SCAN bytes for a newline.
+// With line 0, where the position is not needed, lines and columns count from begin.
+void serdec_lexer_reset(SerdecLexer* lexer, size_t begin, size_t end, size_t line);
+
+// Quote-aware structural scan. Tracks string state and bracket depth, nothing else;
+// the input is assumed to be well-formed and a real parse validates it afterwards.
+typedef struct SerdecScanState {
+    bool in_string;
+    bool escaped;             // Previous byte was an unescaped backslash inside a string
+    int64_t depth;
+    int64_t min_depth;        // Lowest depth reached so far
+} SerdecScanState;
+
+void serdec_scan_advance(SerdecScanState* state, const char* data, size_t len);
+// Returns the offset of the first ',' outside strings at `depth`, or len if there is none.
+size_t serdec_scan_find_comma(SerdecScanState* state, const char* data, size_t len,
+                              int64_t depth);
+// Returns the offset of the first point outside strings at depth 0 where one root value
+// can end and the next begin: before whitespace, or just after a closing bracket. Returns
+// len if there is none.
+size_t serdec_scan_find_boundary(SerdecScanState* state, const char* data, size_t len);
+// True if data[pos] is preceded by an odd run of backslashes.
+bool serdec_scan_escaped_at(const char* data, size_t pos);
+
+// Sizes of the DOM for a document, measured before building it.
+typedef struct SerdecDomSize {
+    size_t nodes;             // Values, object keys and object index slots
+    size_t key_bytes;         // Raw length + 1 of every key containing escapes
+    size_t containers;
+    size_t* children;         // Per container, in order of opening: elements or members
+} SerdecDomSize;
+
+// Counts nodes, per-container children and decoded key bytes in one pass. The counts
+// are exact for valid input; the parse that follows rejects anything else. Returns false
+// if out of memory. The caller frees size->children.
+bool serdec_scan_measure(const char* data, size_t len, SerdecDomSize* size);
+
+// Worker threads
+unsigned serdec_cpu_count(void);
+// Runs fn on `count` items spaced `stride` bytes apart; item 0 runs on the calling thread.
+// Work must be claimed from a shared cursor: fewer threads may start than requested.
+void serdec_workers_run(unsigned count, void* (*fn)(void*), void* items, size_t stride);
+
+// Parser API
+// Restart the parser on a single value in [begin, end) of its buffer. Offsets stay
+// relative to the start of the buffer; line numbering starts at `line`, which may be 0 as
+// for serdec_lexer_reset.
+void serdec_json_parser_reset(SerdecParser* parser, size_t begin, size_t end, size_t line);
+// Resize the container stack. Fails if max_depth is 0 or below the current depth.
+bool serdec_json_parser_set_max_depth(SerdecParser* parser, size_t max_depth);
+// Puts the parser in its error state with an error at offset, a position already consumed
+// on the current line, e.g. a key rejected by the DOM builder.
+SerdecError serdec_json_parser_fail(SerdecParser* parser, SerdecError code, size_t offset,
+                                    const char* message);
+// Like serdec_json_parser_reset, but [begin, end) holds comma-separated array elements
+// without the enclosing brackets. SERDEC_EVENT_END follows the last element.
+void serdec_json_parser_reset_elements(SerdecParser* parser, size_t begin, size_t end,
+                                       size_t line);
+// Same for comma-separated object members: the first event is the KEY at begin.
+void serdec_json_parser_reset_members(SerdecParser* parser, size_t begin, size_t end,
+                                      size_t line);
+
+// Query text, shared by serdec_query_compile() and serdec_ndjson_filter_compile()
+typedef struct SerdecQueryText {
+    const char* p;            // Next character of the text
+    char* strings;            // Free space for decoded keys and literals: as many bytes as
+                              // the text, plus 2 per key or literal
+} SerdecQueryText;
+
+typedef enum SerdecCompareOp {
+    SERDEC_COMPARE_EXISTS,    // No operator: the value is present
+    SERDEC_COMPARE_EQ,
+    SERDEC_COMPARE_NE,
+    SERDEC_COMPARE_LT,
+    SERDEC_COMPARE_LE,
+    SERDEC_COMPARE_GT,
+    SERDEC_COMPARE_GE,
+} SerdecCompareOp;
+
+// An operator and a literal, as in the filter "@.name >= 10".
+typedef struct SerdecComparison {
+    SerdecCompareOp op;
+    SerdecEventKind type;     // Literal: STRING, NUMBER, BOOL or NULL
+    const char* text;         // STRING literal, decoded
+    size_t text_len;
+    SerdecToken number;       // NUMBER literal, as the lexer reads input
+    bool boolean;
+} SerdecComparison;
+
+void serdec_query_skip_space(SerdecQueryText* text);
+// Copies the name up to the first character in `stop`. It must not be empty.
+SerdecError serdec_query_read_name(SerdecQueryText* text, const char* stop, const char** out,
+                                   size_t* len);
+// Decodes a name or string in single or double quotes: JSON escapes, plus \' for a single
+// quote. The result is NUL-terminated.
+SerdecError serdec_query_read_quoted(SerdecQueryText* text, const char** out, size_t* len);
+// Reads an operator and a literal, or leaves SERDEC_COMPARE_EXISTS if no operator follows.
+SerdecError serdec_query_read_comparison(SerdecQueryText* text, SerdecComparison* out);
+// Applies cmp to the value whose first event, ev, parser just produced, or to a missing
+// value if ev is NULL. As in RFC 9535, values of other types are unequal, and only numbers
+// and strings are ordered.
+bool serdec_comparison_test(const SerdecComparison* cmp, const SerdecEvent* ev,
+                            const SerdecParser* parser);
+
+// NDJSON line index
+// True if index is a valid handle built from an input of buf's size.
+bool serdec_ndjson_index_matches(const SerdecNdjsonIndex* index, const SerdecBuffer* buf);
+
+// NDJSON filters
+bool serdec_ndjson_filter_valid(const SerdecNdjsonFilter* filter);
+// False if no record in [data, data + len) can pass: bytes every passing record holds are
+// missing, and the record has no escapes that could spell them differently.
+bool serdec_ndjson_filter_prefilter(const SerdecNdjsonFilter* filter, const char* data,
+                                    size_t len);
+
+// DOM API
+// Builds the value whose first event is `first` (already pulled from the parser) and
+// consumes events through its end. If origin is set, string slices are rebased from
+// the parser's buffer onto origin, a copy of the same bytes. config may be NULL; its
+// keys and shapes options apply.
+SerdecError serdec_dom_build(SerdecParser* parser, SerdecArena* arena,
+                             const SerdecParseConfig* config, const SerdecEvent* first,
+                             const char* origin, SerdecValue** out);
+
+// Parses a lazy container in place; a no-op for every other value. Callers check that
+// value is a container first.
+SerdecError serdec_dom_expand(const SerdecValue* value);
+
+// Relocates the children of a mapped container in place; see snapshot.c.
+SerdecError serdec_snapshot_expand(const SerdecValue* value);
+// Unmaps the image of a mapped document.
+void serdec_snapshot_release(SerdecDocument* doc);
+
+// Finds the first member with the given decoded key in an object, expanding it if lazy.
+// With interned, key came from serdec_intern() and interned keys match by address.
+// hash is as for serdec_key_find().
+SerdecError serdec_dom_find(const SerdecValue* object, const char* key, size_t len,
+                            bool interned, const uint64_t* hash, const SerdecValue** out);
@@ -88,8 +88,11 @@ TEST(arena_reset) {
     }
     size_t used_before = serdec_arena_used(arena);
     ASSERT(used_before > 0);
+    ASSERT(serdec_arena_reserved(arena) > used_before);
 
     serdec_arena_reset(arena);
+    ASSERT_EQ(serdec_arena_used(arena), 0);
+    ASSERT_EQ(serdec_arena_reserved(arena), 1024);
 
     void* p = serdec_arena_alloc(arena, 100);
     ASSERT_NOT_NULL(p);
@@ -127,6 +130,7 @@ TEST(arena_null_safety) {
     ASSERT_NULL(serdec_arena_strdup(NULL, "hi", 2));
     serdec_arena_reset(NULL);
     ASSERT_EQ(serdec_arena_used(NULL), SIZE_MAX);
+    ASSERT_EQ(serdec_arena_reserved(NULL), SIZE_MAX);
 }
 
 TEST(arena_zero_size_alloc) {
@@ -1,5 +1,7 @@
 #include "test.h"
+#include "../src/internal.h"
 #include <serdec/serdec.h>
+#include <stdatomic.h>
 
 TEST(buffer_create_from_string) {
     const char* json = "{\"test\": 123}";
@@ -50,6 +52,27 @@ TEST(buffer_refcount) {
     serdec_buffer_release(ref2);
 }
 
+static void* retain_release(void* item) {
+    SerdecBuffer* buf = *(SerdecBuffer**) item;
+    for (int i = 0; i < 10000; i++) {
+        serdec_buffer_retain(buf);
+        serdec_buffer_release(buf);
+    }
+    return NULL;
+}
+
+TEST(buffer_refcount_threads) {
+    SerdecBuffer* buf = serdec_buffer_from_string("test", 4);
+    SerdecBuffer* items[8];
+    for (int i = 0; i < 8; i++) items[i] = buf;
+
+    serdec_workers_run(8, retain_release, items, sizeof(items[0]));
+    ASSERT_EQ(atomic_load(&buf->ref_count), 1);
+    ASSERT_EQ(serdec_buffer_size(buf), 4);
+
+    serdec_buffer_release(buf);
+}
+
 TEST(buffer_null_safety) {
     serdec_buffer_release(NULL);
     ASSERT_NULL(serdec_buffer_retain(NULL));
@@ -95,6 +118,41 @@ TEST(buffer_binary_data) {
     serdec_buffer_release(buf);
 }
 
+TEST(buffer_from_file) {
+    char path[64];
+    int local;
+    snprintf(path, sizeof(path), "serdec_buffer_%p.json", (void*) &local);
+    const char json[] = "{\"from\": \"file\"}";
+    FILE* fp = fopen(path, "wb");
+    ASSERT_NOT_NULL(fp);
+    fwrite(json, 1, sizeof(json) - 1, fp);
+    fclose(fp);
+
+    SerdecBuffer* buf = serdec_buffer_from_file(path, 0);
+    ASSERT_NOT_NULL(buf);
+    ASSERT_EQ(serdec_buffer_size(buf), sizeof(json) - 1);
+    ASSERT(memcmp(serdec_buffer_data(buf), json, sizeof(json) - 1) == 0);
+    for (size_t i = 0; i < 64; i++) ASSERT_EQ(serdec_buffer_data(buf)[sizeof(json) - 1 + i], 0);
+
+    SerdecParser* parser = serdec_json_parser_from_buffer(buf);
+    serdec_buffer_release(buf);   // The parser keeps it alive
+    SerdecEvent event;
+    ASSERT_EQ(serdec_json_event_next(parser, &event), SERDEC_OK);
+    ASSERT_EQ(event.kind, SERDEC_EVENT_START_OBJECT);
+    serdec_json_parser_destroy(parser);
+
+    ASSERT_NULL(serdec_buffer_from_file(path, 4));
+    fp = fopen(path, "wb");
+    fclose(fp);
+    buf = serdec_buffer_from_file(path, 0);
+    ASSERT_NOT_NULL(buf);
+    ASSERT_EQ(serdec_buffer_size(buf), 0);
+    serdec_buffer_release(buf);
+
+    remove(path);
+    ASSERT_NULL(serdec_buffer_from_file(path, 0));
+}
+
 int test_buffer(void) {
     printf("  Buffer tests:\n");
 
@@ -102,11 +160,13 @@ int test_buffer(void) {
     RUN(buffer_padding_is_zero);
     RUN(buffer_alignment);
     RUN(buffer_refcount);
+    RUN(buffer_refcount_threads);
     RUN(buffer_null_safety);
     RUN(buffer_empty_input);
     RUN(buffer_null_string);
     RUN(buffer_large_input);
     RUN(buffer_binary_data);
+    RUN(buffer_from_file);
 
     TEST_SUMMARY();
 }
@@ -0,0 +1,2159 @@
+#include "test.h"
+#include "../src/internal.h"
+#include <serdec/serdec.h>
+
+static const SerdecValue* parse(SerdecArena* arena, const char* json) {
+    const SerdecValue* root = NULL;
+    if (serdec_parse(arena, json, strlen(json), &root, NULL) != SERDEC_OK) return NULL;
+    return root;
+}
+
+static bool string_is(const SerdecValue* value, const char* expected) {
+    SerdecString s;
+    return serdec_as_string(value, &s) == SERDEC_OK && s.len == strlen(expected) &&
+           memcmp(s.ptr, expected, s.len) == 0;
+}
+
+// --- Builder + accessors ---
+
+TEST(dom_object_lookup) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    const char* json = "{\"name\": \"serdec\", \"tags\": [\"a\", \"b\"], \"ok\": true, "
+                       "\"n\": null}";
+    const SerdecValue* root = parse(arena, json);
+    const SerdecValue* v;
+
+    ASSERT_NOT_NULL(root);
+    ASSERT_EQ(serdec_value_type(root), SERDEC_TYPE_OBJECT);
+    ASSERT_EQ(serdec_value_size(root), 4);
+
+    ASSERT_EQ(serdec_get(root, "name", &v), SERDEC_OK);
+    ASSERT(string_is(v, "serdec"));
+    // Strings borrow from the caller's input
+    SerdecString s;
+    serdec_as_string(v, &s);
+    ASSERT(s.ptr == json + 10);
+
+    ASSERT_EQ(serdec_get(root, "tags", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_value_size(v), 2);
+    ASSERT_EQ(serdec_index(v, 1, &v), SERDEC_OK);
+    ASSERT(string_is(v, "b"));
+
+    bool b = false;
+    ASSERT_EQ(serdec_get(root, "ok", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_bool(v, &b), SERDEC_OK);
+    ASSERT(b);
+
+    ASSERT_EQ(serdec_get(root, "n", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_value_type(v), SERDEC_TYPE_NULL);
+
+    ASSERT_EQ(serdec_get(root, "missing", &v), SERDEC_ERR_NOT_FOUND);
+    serdec_arena_destroy(arena);
+}
+
+TEST(dom_numbers) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    const SerdecValue* root = parse(arena, "[-5, 18446744073709551615, 2.5e1, 7]");
+    const SerdecValue* v;
+    int64_t i;
+    uint64_t u;
+    double d;
+
+    ASSERT_EQ(serdec_index(root, 0, &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_int64(v, &i), SERDEC_OK);
+    ASSERT_EQ(i, -5);
+    ASSERT_EQ(serdec_as_uint64(v, &u), SERDEC_ERR_NUMBER_OVERFLOW);
+
+    ASSERT_EQ(serdec_index(root, 1, &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_uint64(v, &u), SERDEC_OK);
+    ASSERT(u == UINT64_MAX);
+    ASSERT_EQ(serdec_as_int64(v, &i), SERDEC_ERR_NUMBER_OVERFLOW);
+
+    ASSERT_EQ(serdec_index(root, 2, &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_double(v, &d), SERDEC_OK);
+    ASSERT(d == 25.0);
+    ASSERT_EQ(serdec_as_int64(v, &i), SERDEC_ERR_TYPE_MISMATCH);
+
+    ASSERT_EQ(serdec_index(root, 3, &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_double(v, &d), SERDEC_OK);
+    ASSERT(d == 7.0);
+    serdec_arena_destroy(arena);
+}
+
+TEST(dom_escaped_keys_decoded) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    const SerdecValue* root = parse(arena, "{\"a\\nb\": 1, \"\\u00e9\": 2}");
+    const SerdecValue* v;
+    SerdecString key;
+
+    ASSERT_EQ(serdec_get(root, "a\nb", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_get(root, "\xc3\xa9", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_member(root, 1, &key, &v), SERDEC_OK);
+    ASSERT(!key.has_escapes);
+    ASSERT_EQ(key.len, 2);
+    serdec_arena_destroy(arena);
+}
+
+TEST(dom_type_mismatch) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    const SerdecValue* root = parse(arena, "[\"x\"]");
+    const SerdecValue* v;
+    bool b;
+
+    ASSERT_EQ(serdec_get(root, "x", &v), SERDEC_ERR_TYPE_MISMATCH);
+    ASSERT_EQ(serdec_index(root, 1, &v), SERDEC_ERR_NOT_FOUND);
+    ASSERT_EQ(serdec_index(root, 0, &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_bool(v, &b), SERDEC_ERR_TYPE_MISMATCH);
+    ASSERT_EQ(serdec_value_size(v), 0);
+    serdec_arena_destroy(arena);
+}
+
+TEST(dom_parse_error) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    const SerdecValue* root = NULL;
+    SerdecErrorInfo err;
+
+    ASSERT_EQ(serdec_parse(arena, "{\"a\": [1, }", 11, &root, &err), SERDEC_ERR_UNEXPECTED_CHAR);
+    ASSERT_EQ(err.offset, 10);
+    ASSERT_NULL(root);
+
+    ASSERT_EQ(serdec_parse(arena, "{} 1", 4, &root, &err), SERDEC_ERR_TRAILING_CHARS);
+    serdec_arena_destroy(arena);
+}
+
+TEST(dom_contiguous_children) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    const SerdecValue* root = parse(arena, "[[1, 2], {\"a\": 3, \"b\": [4]}, \"x\", null]");
+    const SerdecValue* first;
+    const SerdecValue* v;
+
+    ASSERT_EQ(serdec_index(root, 0, &first), SERDEC_OK);
+    for (size_t i = 1; i < 4; i++) {
+        ASSERT_EQ(serdec_index(root, i, &v), SERDEC_OK);
+        ASSERT((const char*) v == (const char*) first + i * 16);
+    }
+
+    // Object members are stored as key/value node pairs
+    const SerdecValue* a;
+    const SerdecValue* b;
+    ASSERT_EQ(serdec_index(root, 1, &v), SERDEC_OK);
+    ASSERT_EQ(serdec_get(v, "a", &a), SERDEC_OK);
+    ASSERT_EQ(serdec_get(v, "b", &b), SERDEC_OK);
+    ASSERT((const char*) b == (const char*) a + 2 * 16);
+    serdec_arena_destroy(arena);
+}
+
+TEST(dom_node_size) {
+    enum { COUNT = 1000 };
+    char* json = malloc(COUNT * 8 + 2);
+    size_t len = 0;
+    json[len++] = '[';
+    for (int i = 0; i < COUNT; i++) len += (size_t) sprintf(json + len, "%s%d", i ? "," : "", i);
+    json[len++] = ']';
+
+    SerdecArenaConfig config = { .block_size = 1 << 20 };
+    SerdecArena* arena = serdec_arena_create(&config);
+    SerdecDocument* doc = NULL;
+    ASSERT_EQ(serdec_document_parse(arena, json, len, NULL, &doc, NULL), SERDEC_OK);
+
+    // One 16-byte node per element, plus the root and the document header
+    ASSERT(serdec_arena_used(arena) <= COUNT * 16 + 128);
+    ASSERT_EQ(serdec_value_size(serdec_document_root(doc)), COUNT);
+
+    const SerdecValue* v;
+    int64_t n;
+    ASSERT_EQ(serdec_index(serdec_document_root(doc), 777, &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_int64(v, &n), SERDEC_OK);
+    ASSERT_EQ(n, 777);
+
+    serdec_arena_destroy(arena);
+    free(json);
+}
+
+TEST(dom_document_max_depth) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    SerdecDocument* doc = NULL;
+    SerdecErrorInfo err;
+    SerdecParseConfig config = { .max_depth = 2 };
+
+    ASSERT_EQ(serdec_document_parse(arena, "[[1]]", 5, &config, &doc, NULL), SERDEC_OK);
+    ASSERT_EQ(serdec_document_parse(arena, "[[[1]]]", 7, &config, &doc, &err),
+              SERDEC_ERR_DEPTH_LIMIT);
+    ASSERT_EQ(err.offset, 2);
+
+    char deep[2 * 2000];
+    memset(deep, '[', 2000);
+    memset(deep + 2000, ']', 2000);
+    ASSERT_EQ(serdec_document_parse(arena, deep, sizeof(deep), NULL, &doc, NULL),
+              SERDEC_ERR_DEPTH_LIMIT);
+    config.max_depth = 4096;
+    ASSERT_EQ(serdec_document_parse(arena, deep, sizeof(deep), &config, &doc, NULL), SERDEC_OK);
+    ASSERT_EQ(serdec_value_size(serdec_document_root(doc)), 1);
+
+    ASSERT_NULL(serdec_document_root(NULL));
+    serdec_arena_destroy(arena);
+}
+
+// --- Exact-size build ---
+
+// Structural comparison through the API. With same_input, strings must also be the same
+// slices, as for two parses of one input.
+static bool compare(const SerdecValue* a, const SerdecValue* b, bool same_input) {
+    SerdecValueType type = serdec_value_type(a);
+    if (type != serdec_value_type(b) || serdec_value_size(a) != serdec_value_size(b))
+        return false;
+
+    switch (type) {
+    case SERDEC_TYPE_BOOL: {
+        bool x, y;
+        serdec_as_bool(a, &x);
+        serdec_as_bool(b, &y);
+        return x == y;
+    }
+    case SERDEC_TYPE_NUMBER: {
+        double x, y;
+        serdec_as_double(a, &x);
+        serdec_as_double(b, &y);
+        return x == y;
+    }
+    case SERDEC_TYPE_STRING: {
+        SerdecString x, y;
+        serdec_as_string(a, &x);
+        serdec_as_string(b, &y);
+        if (x.len != y.len || x.has_escapes != y.has_escapes) return false;
+        return same_input ? x.ptr == y.ptr : memcmp(x.ptr, y.ptr, x.len) == 0;
+    }
+    case SERDEC_TYPE_ARRAY:
+        for (size_t i = 0; i < serdec_value_size(a); i++) {
+            const SerdecValue *x, *y;
+            serdec_index(a, i, &x);
+            serdec_index(b, i, &y);
+            if (!compare(x, y, same_input)) return false;
+        }
+        return true;
+    case SERDEC_TYPE_OBJECT:
+        for (size_t i = 0; i < serdec_value_size(a); i++) {
+            const SerdecValue *x, *y;
+            SerdecString kx, ky;
+            serdec_member(a, i, &kx, &x);
+            serdec_member(b, i, &ky, &y);
+            if (kx.len != ky.len || memcmp(kx.ptr, ky.ptr, kx.len) != 0) return false;
+            if (!compare(x, y, same_input)) return false;
+        }
+        return true;
+    default:
+        return true;
+    }
+}
+
+static bool same_value(const SerdecValue* a, const SerdecValue* b) {
+    return compare(a, b, true);
+}
+
+static bool same_content(const SerdecValue* a, const SerdecValue* b) {
+    return compare(a, b, false);
+}
+
+static const char* exact_doc =
+    "{\"a\\n\": [1, -2, 3.5, {\"b\": null, \"\\u00e9t\\u00e9\": [[], {}]}],"
+    " \"c\": \"x\\ty\", \"d\": [true, false, \"]\", \"{\\\"\"], \"e\": {\"f\": {\"g\": []}}}";
+
+TEST(dom_exact_measure) {
+    SerdecDomSize size;
+    ASSERT(serdec_scan_measure(exact_doc, strlen(exact_doc), &size));
+    ASSERT_EQ(size.nodes, 27);
+    ASSERT_EQ(size.containers, 10);
+    ASSERT_EQ(size.children[0], 4);   // Root object members
+    ASSERT_EQ(size.children[1], 4);   // "a"
+    ASSERT_EQ(size.children[2], 2);
+    ASSERT_EQ(size.children[3], 2);
+    ASSERT_EQ(size.children[4], 0);
+    ASSERT_EQ(size.key_bytes, 4 + 14);
+    free(size.children);
+
+    ASSERT(serdec_scan_measure("  7 ", 4, &size));
+    ASSERT_EQ(size.nodes, 1);
+    ASSERT_EQ(size.containers, 0);
+    free(size.children);
+}
+
+TEST(dom_exact_matches_incremental) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    SerdecParseConfig exact = { .exact_size = true };
+    SerdecDocument* a = NULL;
+    SerdecDocument* b = NULL;
+    size_t len = strlen(exact_doc);
+
+    ASSERT_EQ(serdec_document_parse(arena, exact_doc, len, NULL, &a, NULL), SERDEC_OK);
+    ASSERT_EQ(serdec_document_parse(arena, exact_doc, len, &exact, &b, NULL), SERDEC_OK);
+    ASSERT(same_value(serdec_document_root(a), serdec_document_root(b)));
+
+    const SerdecValue* v;
+    ASSERT_EQ(serdec_get(serdec_document_root(b), "\xc3\xa9t\xc3\xa9", &v), SERDEC_ERR_NOT_FOUND);
+    ASSERT_EQ(serdec_get(serdec_document_root(b), "a\n", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_index(v, 3, &v), SERDEC_OK);
+    ASSERT_EQ(serdec_get(v, "\xc3\xa9t\xc3\xa9", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_value_size(v), 2);
+
+    // Scalars and errors
+    ASSERT_EQ(serdec_document_parse(arena, " \"s\" ", 5, &exact, &b, NULL), SERDEC_OK);
+    ASSERT_EQ(serdec_value_type(serdec_document_root(b)), SERDEC_TYPE_STRING);
+    SerdecErrorInfo err;
+    ASSERT_EQ(serdec_document_parse(arena, "[1, 2,]", 7, &exact, &b, &err),
+              SERDEC_ERR_UNEXPECTED_CHAR);
+    ASSERT_EQ(err.offset, 6);
+    ASSERT_EQ(serdec_document_parse(arena, "[1 2]", 5, &exact, &b, NULL),
+              SERDEC_ERR_UNEXPECTED_CHAR);
+    ASSERT_EQ(serdec_document_parse(arena, "", 0, &exact, &b, NULL), SERDEC_ERR_UNEXPECTED_EOF);
+    serdec_arena_destroy(arena);
+}
+
+static size_t alloc_calls;
+
+static void* counting_alloc(size_t size) {
+    alloc_calls++;
+    return malloc(size);
+}
+
+TEST(dom_exact_single_allocation) {
+    enum { COUNT = 200 };
+    char* json = malloc(COUNT * 32);
+    size_t len = 0;
+    json[len++] = '[';
+    for (int i = 0; i < COUNT; i++)
+        len += (size_t) sprintf(json + len, "%s{\"id\": %d, \"v\": [%d]}", i ? "," : "", i, i);
+    json[len++] = ']';
+
+    SerdecArenaConfig config = { .block_size = 256, .alloc = counting_alloc };
+    SerdecParseConfig exact = { .exact_size = true };
+    SerdecDocument* doc = NULL;
+
+    SerdecArena* arena = serdec_arena_create(&config);
+    alloc_calls = 0;
+    ASSERT_EQ(serdec_document_parse(arena, json, len, NULL, &doc, NULL), SERDEC_OK);
+    size_t incremental = alloc_calls;
+    serdec_arena_destroy(arena);
+
+    arena = serdec_arena_create(&config);
+    alloc_calls = 0;
+    ASSERT_EQ(serdec_document_parse(arena, json, len, &exact, &doc, NULL), SERDEC_OK);
+    // One block for the nodes, at most one more for the document header
+    ASSERT(alloc_calls <= 2);
+    ASSERT(incremental > 10);
+    ASSERT_EQ(serdec_value_size(serdec_document_root(doc)), COUNT);
+    serdec_arena_destroy(arena);
+    free(json);
+}
+
+// --- Hash index ---
+
+static char* make_wide_object(size_t count, size_t* len) {
+    char* json = malloc(count * 32 + 16);
+    size_t n = 0;
+    json[n++] = '{';
+    for (size_t i = 0; i < count; i++)
+        n += (size_t) sprintf(json + n, "%s\"key%zu\": %zu", i ? ", " : "", i, i);
+    // Duplicate of the first key: the first member must keep winning
+    n += (size_t) sprintf(json + n, ", \"key0\": -1}");
+    *len = n;
+    return json;
+}
+
+TEST(dom_index_large_object) {
+    size_t len;
+    char* json = make_wide_object(10000, &len);
+    SerdecArena* arena = serdec_arena_create(NULL);
+    const SerdecValue* root = NULL;
+    const SerdecValue* v;
+    uint64_t n;
+    char key[32];
+
+    ASSERT_EQ(serdec_parse(arena, json, len, &root, NULL), SERDEC_OK);
+    ASSERT_EQ(serdec_value_size(root), 10001);
+
+    size_t before = serdec_arena_used(arena);
+    ASSERT_EQ(serdec_get(root, "key9999", &v), SERDEC_OK);
+    size_t built = serdec_arena_used(arena);
+    ASSERT(built > before);
+
+    for (size_t i = 0; i < 10000; i++) {
+        sprintf(key, "key%zu", i);
+        ASSERT_EQ(serdec_get(root, key, &v), SERDEC_OK);
+        ASSERT_EQ(serdec_as_uint64(v, &n), SERDEC_OK);
+        ASSERT_EQ(n, i);
+    }
+    ASSERT_EQ(serdec_get(root, "key10000", &v), SERDEC_ERR_NOT_FOUND);
+    ASSERT_EQ(serdec_get(root, "", &v), SERDEC_ERR_NOT_FOUND);
+    // The index is built once
+    ASSERT_EQ(serdec_arena_used(arena), built);
+
+    // Insertion order is kept for iteration
+    SerdecString k;
+    ASSERT_EQ(serdec_member(root, 5000, &k, &v), SERDEC_OK);
+    ASSERT(k.len == 7 && memcmp(k.ptr, "key5000", 7) == 0);
+
+    serdec_arena_destroy(arena);
+    free(json);
+}
+
+TEST(dom_index_threshold) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    SerdecParseConfig exact = { .exact_size = true };
+    const SerdecValue* v;
+
+    for (size_t count = SERDEC_INDEX_THRESHOLD - 1; count <= SERDEC_INDEX_THRESHOLD; count++) {
+        size_t len;
+        char* json = make_wide_object(count - 1, &len);   // Plus the duplicate key0
+        SerdecDocument* doc = NULL;
+        ASSERT_EQ(serdec_document_parse(arena, json, len, &exact, &doc, NULL), SERDEC_OK);
+        const SerdecValue* root = serdec_document_root(doc);
+        ASSERT_EQ(serdec_value_size(root), count);
+
+        // Small objects never allocate on lookup
+        size_t before = serdec_arena_used(arena);
+        ASSERT_EQ(serdec_get(root, "key0", &v), SERDEC_OK);
+        int64_t first;
+        ASSERT_EQ(serdec_as_int64(v, &first), SERDEC_OK);
+        ASSERT_EQ(first, 0);
+        ASSERT(count < SERDEC_INDEX_THRESHOLD ? serdec_arena_used(arena) == before
+                                              : serdec_arena_used(arena) > before);
+
+        SerdecDomSize size;
+        ASSERT(serdec_scan_measure(json, len, &size));
+        ASSERT_EQ(size.nodes, 1 + 2 * count + (count >= SERDEC_INDEX_THRESHOLD));
+        free(size.children);
+        free(json);
+    }
+    serdec_arena_destroy(arena);
+}
+
+// --- Duplicate keys ---
+
+static int64_t int_member(const SerdecValue* object, const char* key) {
+    const SerdecValue* v;
+    int64_t n = INT64_MIN;
+    if (serdec_get(object, key, &v) == SERDEC_OK) serdec_as_int64(v, &n);
+    return n;
+}
+
+TEST(dom_duplicates_policies) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    const char* json = "{\"a\": 1, \"b\": {\"a\": 2}, \"a\": [3], \"a\": 4}";
+    SerdecParseConfig config = { 0 };
+    SerdecDocument* doc = NULL;
+    SerdecErrorInfo err;
+    SerdecString key;
+    const SerdecValue *root, *v;
+
+    ASSERT_EQ(serdec_document_parse(arena, json, strlen(json), &config, &doc, NULL), SERDEC_OK);
+    root = serdec_document_root(doc);
+    ASSERT_EQ(serdec_value_size(root), 4);
+    ASSERT_EQ(int_member(root, "a"), 1);
+
+    config.duplicates = SERDEC_DUPLICATES_FIRST_WINS;
+    ASSERT_EQ(serdec_document_parse(arena, json, strlen(json), &config, &doc, NULL), SERDEC_OK);
+    root = serdec_document_root(doc);
+    ASSERT_EQ(serdec_value_size(root), 2);
+    ASSERT_EQ(int_member(root, "a"), 1);
+    ASSERT_EQ(serdec_member(root, 1, &key, &v), SERDEC_OK);
+    ASSERT(key.len == 1 && key.ptr[0] == 'b');
+    ASSERT_EQ(int_member(v, "a"), 2);   // Other objects' keys do not count
+
+    // The last value takes the first key's place
+    config.duplicates = SERDEC_DUPLICATES_LAST_WINS;
+    ASSERT_EQ(serdec_document_parse(arena, json, strlen(json), &config, &doc, NULL), SERDEC_OK);
+    root = serdec_document_root(doc);
+    ASSERT_EQ(serdec_value_size(root), 2);
+    ASSERT_EQ(serdec_member(root, 0, &key, &v), SERDEC_OK);
+    ASSERT(key.len == 1 && key.ptr[0] == 'a');
+    ASSERT_EQ(int_member(root, "a"), 4);
+
+    config.duplicates = SERDEC_DUPLICATES_REJECT;
+    ASSERT_EQ(serdec_document_parse(arena, json, strlen(json), &config, &doc, &err),
+              SERDEC_ERR_DUPLICATE_KEY);
+    ASSERT_EQ(err.code, SERDEC_ERR_DUPLICATE_KEY);
+    ASSERT_EQ(err.offset, 24);
+    ASSERT_EQ(err.column, 25);
+    json = "{\"a\": {\"a\": 1}, \"\\u0061b\": 2, \"ab\": 3}";
+    ASSERT_EQ(serdec_document_parse(arena, json, strlen(json), &config, &doc, &err),
+              SERDEC_ERR_DUPLICATE_KEY);
+    ASSERT_EQ(err.offset, 30);   // Keys compare decoded
+
+    // exact_size yields to the policy
+    config.exact_size = true;
+    ASSERT_EQ(serdec_document_parse(arena, json, strlen(json), &config, &doc, NULL),
+              SERDEC_ERR_DUPLICATE_KEY);
+    serdec_arena_destroy(arena);
+}
+
+TEST(dom_duplicates_wide_and_lazy) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    SerdecInternTable* table = serdec_intern_table_create(arena);
+    size_t len;
+    char* json = make_wide_object(1000, &len);   // key0 repeats at the end
+    SerdecParseConfig config = { .duplicates = SERDEC_DUPLICATES_REJECT };
+    SerdecDocument* doc = NULL;
+    SerdecErrorInfo err;
+
+    ASSERT_EQ(serdec_document_parse(arena, json, len, &config, &doc, &err),
+              SERDEC_ERR_DUPLICATE_KEY);
+    ASSERT_EQ(err.offset, len - 11);
+
+    // Wide objects through the key hash, with and without interning and shapes
+    SerdecParseConfig variants[] = {
+        { .duplicates = SERDEC_DUPLICATES_LAST_WINS },
+        { .duplicates = SERDEC_DUPLICATES_LAST_WINS, .keys = table },
+        { .duplicates = SERDEC_DUPLICATES_LAST_WINS, .keys = table, .shapes = true },
+    };
+    for (size_t i = 0; i < sizeof(variants) / sizeof(variants[0]); i++) {
+        ASSERT_EQ(serdec_document_parse(arena, json, len, &variants[i], &doc, NULL), SERDEC_OK);
+        const SerdecValue* root = serdec_document_root(doc);
+        ASSERT_EQ(serdec_value_size(root), 1000);
+        ASSERT_EQ(int_member(root, "key0"), -1);
+        ASSERT_EQ(int_member(root, "key999"), 999);
+    }
+
+    // Lazy documents check each object when it is expanded
+    const char* nested = "{\"ok\": {\"a\": 1, \"b\": 2}, \"bad\": {\"a\": 1, \"a\": 2}}";
+    config.lazy = true;
+    ASSERT_EQ(serdec_document_parse(arena, nested, strlen(nested), &config, &doc, NULL),
+              SERDEC_OK);
+    const SerdecValue* v;
+    ASSERT_EQ(serdec_get(serdec_document_root(doc), "ok", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_value_size(v), 2);
+    ASSERT_EQ(serdec_get(serdec_document_root(doc), "bad", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_get(v, "a", &v), SERDEC_ERR_DUPLICATE_KEY);
+
+    serdec_document_destroy(doc);
+    serdec_intern_table_destroy(table);
+    serdec_arena_destroy(arena);
+    free(json);
+}
+
+// --- Key interning ---
+
+TEST(dom_intern_table) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    SerdecInternTable* table = serdec_intern_table_create(arena);
+    ASSERT_NOT_NULL(table);
+
+    const char* a = serdec_intern(table, "name", 4);
+    ASSERT_NOT_NULL(a);
+    ASSERT(strcmp(a, "name") == 0);
+    ASSERT(serdec_intern(table, "name!", 4) == a);
+    ASSERT(serdec_intern(table, "nam", 3) != a);
+    ASSERT_NOT_NULL(serdec_intern(table, NULL, 0));
+    ASSERT_EQ(serdec_intern_table_size(table), 3);
+
+    // Growing the table keeps earlier pointers
+    char key[16];
+    for (int i = 0; i < 1000; i++) {
+        sprintf(key, "k%d", i);
+        ASSERT_NOT_NULL(serdec_intern(table, key, strlen(key)));
+    }
+    ASSERT_EQ(serdec_intern_table_size(table), 1003);
+    ASSERT(serdec_intern(table, "name", 4) == a);
+
+    ASSERT_NULL(serdec_intern(NULL, "x", 1));
+    ASSERT_NULL(serdec_intern_table_create(NULL));
+    ASSERT_EQ(serdec_intern_table_size(NULL), 0);
+    serdec_intern_table_destroy(table);
+    serdec_intern_table_destroy(NULL);
+    serdec_arena_destroy(arena);
+}
+
+TEST(dom_intern_shared_between_documents) {
+    SerdecArena* keys_arena = serdec_arena_create(NULL);
+    SerdecArena* arena = serdec_arena_create(NULL);
+    SerdecInternTable* table = serdec_intern_table_create(keys_arena);
+    SerdecParseConfig config = { .keys = table };
+    SerdecDocument* d1 = NULL;
+    SerdecDocument* d2 = NULL;
+    const char* j1 = "[{\"id\": 1, \"a\\u0062\": 2}, {\"id\": 3, \"ab\": 4}]";
+    const char* j2 = "{\"ab\": 5, \"id\": 6}";
+
+    ASSERT_EQ(serdec_document_parse(arena, j1, strlen(j1), &config, &d1, NULL), SERDEC_OK);
+    config.exact_size = true;
+    ASSERT_EQ(serdec_document_parse(arena, j2, strlen(j2), &config, &d2, NULL), SERDEC_OK);
+    ASSERT_EQ(serdec_intern_table_size(table), 2);
+
+    const SerdecValue *r0, *r1, *v;
+    SerdecString k0, k1, k2;
+    ASSERT_EQ(serdec_index(serdec_document_root(d1), 0, &r0), SERDEC_OK);
+    ASSERT_EQ(serdec_index(serdec_document_root(d1), 1, &r1), SERDEC_OK);
+    ASSERT_EQ(serdec_member(r0, 1, &k0, &v), SERDEC_OK);
+    ASSERT_EQ(serdec_member(r1, 1, &k1, &v), SERDEC_OK);
+    ASSERT_EQ(serdec_member(serdec_document_root(d2), 0, &k2, &v), SERDEC_OK);
+    ASSERT(k0.ptr == k1.ptr && k1.ptr == k2.ptr);
+
+    const char* id = serdec_intern(table, "id", 2);
+    const char* ab = serdec_intern(table, "ab", 2);
+    const char* missing = serdec_intern(table, "zz", 2);
+    uint64_t n;
+    ASSERT_EQ(serdec_get_interned(r1, id, &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_uint64(v, &n), SERDEC_OK);
+    ASSERT_EQ(n, 3);
+    ASSERT_EQ(serdec_get_interned(serdec_document_root(d2), ab, &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_uint64(v, &n), SERDEC_OK);
+    ASSERT_EQ(n, 5);
+    ASSERT_EQ(serdec_get_interned(r0, missing, &v), SERDEC_ERR_NOT_FOUND);
+    ASSERT_EQ(serdec_get(r0, "ab", &v), SERDEC_OK);
+
+    // Documents parsed without the table still match by bytes
+    const SerdecValue* plain = parse(arena, j2);
+    ASSERT_EQ(serdec_get_interned(plain, id, &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_uint64(v, &n), SERDEC_OK);
+    ASSERT_EQ(n, 6);
+
+    // So do documents parsed with another table, small and indexed
+    SerdecInternTable* other = serdec_intern_table_create(keys_arena);
+    config = (SerdecParseConfig) { .keys = other };
+    SerdecDocument* d3 = NULL;
+    ASSERT_EQ(serdec_document_parse(arena, j2, strlen(j2), &config, &d3, NULL), SERDEC_OK);
+    ASSERT_EQ(serdec_get_interned(serdec_document_root(d3), id, &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_uint64(v, &n), SERDEC_OK);
+    ASSERT_EQ(n, 6);
+    ASSERT_EQ(serdec_get_interned(serdec_document_root(d3), missing, &v), SERDEC_ERR_NOT_FOUND);
+
+    size_t len;
+    char* wide = make_wide_object(100, &len);
+    SerdecDocument* d4 = NULL;
+    ASSERT_EQ(serdec_document_parse(arena, wide, len, &config, &d4, NULL), SERDEC_OK);
+    ASSERT_EQ(serdec_get_interned(serdec_document_root(d4), serdec_intern(table, "key42", 5),
+                                  &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_uint64(v, &n), SERDEC_OK);
+    ASSERT_EQ(n, 42);
+    free(wide);
+    serdec_intern_table_destroy(other);
+
+    serdec_intern_table_destroy(table);
+    serdec_arena_destroy(arena);
+    serdec_arena_destroy(keys_arena);
+}
+
+TEST(dom_intern_large_object) {
+    size_t len;
+    char* json = make_wide_object(1000, &len);
+    SerdecArena* arena = serdec_arena_create(NULL);
+    SerdecInternTable* table = serdec_intern_table_create(arena);
+    SerdecParseConfig config = { .keys = table };
+    SerdecDocument* doc = NULL;
+    const SerdecValue* v;
+    int64_t n;
+    char key[32];
+
+    ASSERT_EQ(serdec_document_parse(arena, json, len, &config, &doc, NULL), SERDEC_OK);
+    ASSERT_EQ(serdec_intern_table_size(table), 1000);
+    for (size_t i = 0; i < 1000; i++) {
+        sprintf(key, "key%zu", i);
+        ASSERT_EQ(serdec_get_interned(serdec_document_root(doc),
+                                      serdec_intern(table, key, strlen(key)), &v), SERDEC_OK);
+        ASSERT_EQ(serdec_as_int64(v, &n), SERDEC_OK);
+        ASSERT_EQ(n, (int64_t) i);
+        ASSERT_EQ(serdec_get(serdec_document_root(doc), key, &v), SERDEC_OK);
+    }
+
+    serdec_intern_table_destroy(table);
+    serdec_arena_destroy(arena);
+    free(json);
+}
+
+// --- Shapes ---
+
+static char* make_records(size_t count, size_t* len) {
+    char* json = malloc(count * 64 + 2);
+    size_t n = 0;
+    json[n++] = '[';
+    for (size_t i = 0; i < count; i++)
+        n += (size_t) sprintf(json + n, "%s{\"id\": %zu, \"ok\": true, \"x\": 1.5, \"s\": \"v\"}",
+                              i ? "," : "", i);
+    json[n++] = ']';
+    *len = n;
+    return json;
+}
+
+TEST(dom_shapes_records) {
+    size_t len;
+    char* json = make_records(1000, &len);
+    SerdecArenaConfig arena_config = { .block_size = 1 << 20 };
+    SerdecArena* plain = serdec_arena_create(&arena_config);
+    SerdecArena* shaped = serdec_arena_create(&arena_config);
+    SerdecParseConfig config = { .shapes = true };
+    SerdecDocument* a = NULL;
+    SerdecDocument* b = NULL;
+
+    ASSERT_EQ(serdec_document_parse(plain, json, len, NULL, &a, NULL), SERDEC_OK);
+    ASSERT_EQ(serdec_document_parse(shaped, json, len, &config, &b, NULL), SERDEC_OK);
+    ASSERT(same_value(serdec_document_root(a), serdec_document_root(b)));
+    ASSERT(serdec_arena_used(shaped) * 3 < serdec_arena_used(plain) * 2);
+
+    // Every record shares one shape
+    const SerdecValue *r0, *r1, *v;
+    ASSERT_EQ(serdec_index(serdec_document_root(b), 0, &r0), SERDEC_OK);
+    ASSERT_EQ(serdec_index(serdec_document_root(b), 999, &r1), SERDEC_OK);
+    ASSERT_NOT_NULL(serdec_object_shape(r0));
+    ASSERT(serdec_object_shape(r0) == serdec_object_shape(r1));
+
+    uint64_t id;
+    ASSERT_EQ(serdec_get(r1, "id", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_uint64(v, &id), SERDEC_OK);
+    ASSERT_EQ(id, 999);
+    ASSERT_EQ(serdec_get(r1, "nope", &v), SERDEC_ERR_NOT_FOUND);
+
+    SerdecString key;
+    ASSERT_EQ(serdec_member(r1, 3, &key, &v), SERDEC_OK);
+    ASSERT(key.len == 1 && key.ptr[0] == 's');
+    ASSERT(string_is(v, "v"));
+
+    serdec_arena_destroy(plain);
+    serdec_arena_destroy(shaped);
+    free(json);
+}
+
+TEST(dom_shapes_distinct_and_large) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    SerdecParseConfig config = { .shapes = true, .exact_size = true };
+    const char* json = "[{\"a\": 1, \"b\": 2}, {\"b\": 3, \"a\": 4}, {\"a\": 5, \"b\": 6},"
+                       " {}, {\"a\": 7, \"a\": 8}]";
+    SerdecDocument* doc = NULL;
+    const SerdecValue* items[5];
+    const SerdecValue* v;
+    int64_t n;
+
+    ASSERT_EQ(serdec_document_parse(arena, json, strlen(json), &config, &doc, NULL), SERDEC_OK);
+    for (size_t i = 0; i < 5; i++)
+        ASSERT_EQ(serdec_index(serdec_document_root(doc), i, &items[i]), SERDEC_OK);
+
+    // Key order is part of the shape
+    ASSERT(serdec_object_shape(items[0]) == serdec_object_shape(items[2]));
+    ASSERT(serdec_object_shape(items[0]) != serdec_object_shape(items[1]));
+    ASSERT_NULL(serdec_object_shape(items[3]));
+    ASSERT_EQ(serdec_value_size(items[3]), 0);
+
+    ASSERT_EQ(serdec_get(items[1], "a", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_int64(v, &n), SERDEC_OK);
+    ASSERT_EQ(n, 4);
+    ASSERT_EQ(serdec_get(items[4], "a", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_int64(v, &n), SERDEC_OK);
+    ASSERT_EQ(n, 7);
+
+    // Large shapes carry a prebuilt index; lookups never allocate
+    size_t wide_len;
+    char* wide = make_wide_object(100, &wide_len);
+    ASSERT_EQ(serdec_document_parse(arena, wide, wide_len, &config, &doc, NULL), SERDEC_OK);
+    const SerdecValue* root = serdec_document_root(doc);
+    ASSERT_NOT_NULL(serdec_object_shape(root)->table);
+    size_t before = serdec_arena_used(arena);
+    ASSERT_EQ(serdec_get(root, "key42", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_int64(v, &n), SERDEC_OK);
+    ASSERT_EQ(n, 42);
+    ASSERT_EQ(serdec_get(root, "key0", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_int64(v, &n), SERDEC_OK);
+    ASSERT_EQ(n, 0);
+    ASSERT_EQ(serdec_arena_used(arena), before);
+    free(wide);
+
+    serdec_arena_destroy(arena);
+}
+
+TEST(dom_shapes_with_interned_keys) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    SerdecInternTable* table = serdec_intern_table_create(arena);
+    SerdecParseConfig config = { .shapes = true, .keys = table };
+    size_t len;
+    char* json = make_records(50, &len);
+    SerdecDocument* doc = NULL;
+    const SerdecValue *r, *v;
+    bool ok;
+
+    ASSERT_EQ(serdec_document_parse(arena, json, len, &config, &doc, NULL), SERDEC_OK);
+    ASSERT_EQ(serdec_index(serdec_document_root(doc), 20, &r), SERDEC_OK);
+    ASSERT_EQ(serdec_get_interned(r, serdec_intern(table, "ok", 2), &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_bool(v, &ok), SERDEC_OK);
+    ASSERT(ok);
+
+    serdec_intern_table_destroy(table);
+    serdec_arena_destroy(arena);
+    free(json);
+}
+
+// --- Typed arrays ---
+
+TEST(dom_typed_arrays) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    SerdecParseConfig config = { .typed_arrays = true };
+    const char* json = "[[1, -2, 3, 4], [1.5, 2, -3, 4e2], [7], [1, \"x\", 3],"
+                       " [18446744073709551615, 1], [-9007199254740993, 0.5]]";
+    SerdecDocument* doc = NULL;
+    const SerdecValue* items[6];
+    const int64_t* ints;
+    const double* doubles;
+    size_t count;
+
+    ASSERT_EQ(serdec_document_parse(arena, json, strlen(json), &config, &doc, NULL), SERDEC_OK);
+    for (size_t i = 0; i < 6; i++)
+        ASSERT_EQ(serdec_index(serdec_document_root(doc), i, &items[i]), SERDEC_OK);
+
+    ASSERT_EQ(serdec_as_int64_array(items[0], &ints, &count), SERDEC_OK);
+    ASSERT_EQ(count, 4);
+    ASSERT(ints[0] == 1 && ints[1] == -2 && ints[3] == 4);
+    ASSERT_EQ(serdec_as_double_array(items[0], &doubles, &count), SERDEC_ERR_TYPE_MISMATCH);
+
+    ASSERT_EQ(serdec_as_double_array(items[1], &doubles, &count), SERDEC_OK);
+    ASSERT_EQ(count, 4);
+    ASSERT(doubles[0] == 1.5 && doubles[2] == -3.0 && doubles[3] == 400.0);
+
+    // Too short, mixed, or not representable without loss: one node per element
+    for (size_t i = 2; i < 6; i++) {
+        ASSERT_EQ(serdec_as_int64_array(items[i], &ints, &count), SERDEC_ERR_TYPE_MISMATCH);
+        ASSERT_EQ(serdec_as_double_array(items[i], &doubles, &count), SERDEC_ERR_TYPE_MISMATCH);
+    }
+    ASSERT_EQ(serdec_as_int64_array(serdec_document_root(doc), &ints, &count),
+              SERDEC_ERR_TYPE_MISMATCH);
+
+    // Generic access still works, and matches a plain parse
+    const SerdecValue* v;
+    int64_t n;
+    uint64_t u;
+    ASSERT_EQ(serdec_index(items[0], 1, &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_int64(v, &n), SERDEC_OK);
+    ASSERT_EQ(n, -2);
+    ASSERT_EQ(serdec_index(items[0], 2, &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_uint64(v, &u), SERDEC_OK);
+    ASSERT_EQ(u, 3);
+    ASSERT_EQ(serdec_index(items[0], 4, &v), SERDEC_ERR_NOT_FOUND);
+    ASSERT(same_value(serdec_document_root(doc), parse(arena, json)));
+
+    serdec_arena_destroy(arena);
+}
+
+TEST(dom_typed_arrays_memory) {
+    enum { COUNT = 2000 };
+    char* json = malloc(COUNT * 24 + 2);
+    size_t len = 0;
+    json[len++] = '[';
+    for (int i = 0; i < COUNT; i++) len += (size_t) sprintf(json + len, "%s%d.25", i ? "," : "", i);
+    json[len++] = ']';
+
+    SerdecArenaConfig arena_config = { .block_size = 1 << 20 };
+    SerdecArena* plain = serdec_arena_create(&arena_config);
+    SerdecArena* packed = serdec_arena_create(&arena_config);
+    SerdecParseConfig config = { .typed_arrays = true };
+    SerdecDocument* doc = NULL;
+    const SerdecValue* root = NULL;
+
+    ASSERT_EQ(serdec_parse(plain, json, len, &root, NULL), SERDEC_OK);
+    ASSERT_EQ(serdec_document_parse(packed, json, len, &config, &doc, NULL), SERDEC_OK);
+    ASSERT(serdec_arena_used(packed) * 2 < serdec_arena_used(plain) + 256);
+
+    const double* data;
+    size_t count;
+    ASSERT_EQ(serdec_as_double_array(serdec_document_root(doc), &data, &count), SERDEC_OK);
+    ASSERT_EQ(count, COUNT);
+    ASSERT(data[1999] == 1999.25);
+
+    serdec_arena_destroy(plain);
+    serdec_arena_destroy(packed);
+    free(json);
+}
+
+// --- Lazy DOM ---
+
+static bool is_lazy(const SerdecValue* value) {
+    return serdec_tag_sub(value) == SERDEC_CONTAINER_LAZY;
+}
+
+TEST(dom_lazy_expands_on_access) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    SerdecParseConfig config = { .lazy = true };
+    SerdecDocument* doc = NULL;
+    const SerdecValue *a, *b, *c, *v;
+
+    ASSERT_EQ(serdec_document_parse(arena, exact_doc, strlen(exact_doc), &config, &doc, NULL),
+              SERDEC_OK);
+    const SerdecValue* root = serdec_document_root(doc);
+    ASSERT(!is_lazy(root));
+    ASSERT_EQ(serdec_get(root, "e", &a), SERDEC_OK);
+    ASSERT(is_lazy(a));
+    ASSERT_EQ(serdec_value_type(a), SERDEC_TYPE_OBJECT);
+
+    // Descending expands one level at a time
+    ASSERT_EQ(serdec_get(a, "f", &b), SERDEC_OK);
+    ASSERT(!is_lazy(a));
+    ASSERT(is_lazy(b));
+    ASSERT_EQ(serdec_get(b, "g", &c), SERDEC_OK);
+    ASSERT(!is_lazy(b));
+    ASSERT_EQ(serdec_value_type(c), SERDEC_TYPE_ARRAY);
+    ASSERT_EQ(serdec_value_size(c), 0);
+    ASSERT(!is_lazy(c));
+    ASSERT_EQ(serdec_get(a, "f", &v), SERDEC_OK);
+    ASSERT(v == b);
+
+    // A full walk matches an eager parse
+    ASSERT(same_value(root, parse(arena, exact_doc)));
+    serdec_document_destroy(doc);
+
+    // Shapes and packed arrays apply to expanded containers
+    size_t len;
+    char* json = make_records(20, &len);
+    config = (SerdecParseConfig) { .lazy = true, .shapes = true, .typed_arrays = true };
+    ASSERT_EQ(serdec_document_parse(arena, json, len, &config, &doc, NULL), SERDEC_OK);
+    ASSERT_EQ(serdec_index(serdec_document_root(doc), 3, &a), SERDEC_OK);
+    ASSERT_EQ(serdec_index(serdec_document_root(doc), 17, &b), SERDEC_OK);
+    ASSERT_EQ(serdec_value_size(a), 4);
+    ASSERT_EQ(serdec_value_size(b), 4);
+    ASSERT_NOT_NULL(serdec_object_shape(a));
+    ASSERT(serdec_object_shape(a) == serdec_object_shape(b));
+    serdec_document_destroy(doc);
+    free(json);
+
+    const int64_t* ints;
+    const char* nested = "{\"n\": [[1, 2, 3]]}";
+    ASSERT_EQ(serdec_document_parse(arena, nested, strlen(nested), &config, &doc, NULL),
+              SERDEC_OK);
+    ASSERT_EQ(serdec_get(serdec_document_root(doc), "n", &a), SERDEC_OK);
+    ASSERT_EQ(serdec_index(a, 0, &b), SERDEC_OK);
+    ASSERT_EQ(serdec_as_int64_array(b, &ints, &len), SERDEC_OK);
+    ASSERT(len == 3 && ints[2] == 3);
+    serdec_document_destroy(doc);
+
+    serdec_arena_destroy(arena);
+}
+
+TEST(dom_lazy_skips_untouched) {
+    size_t len;
+    char* json = make_records(2000, &len);
+    char* wrapped = malloc(len + 32);
+    len = (size_t) sprintf(wrapped, "{\"items\": %.*s, \"id\": 7}", (int) len, json);
+
+    SerdecArenaConfig arena_config = { .block_size = 1 << 20 };
+    SerdecArena* eager = serdec_arena_create(&arena_config);
+    SerdecArena* lazy = serdec_arena_create(&arena_config);
+    SerdecParseConfig config = { .lazy = true };
+    SerdecDocument* doc = NULL;
+    const SerdecValue* root = NULL;
+    const SerdecValue* v;
+    int64_t id;
+
+    ASSERT_EQ(serdec_parse(eager, wrapped, len, &root, NULL), SERDEC_OK);
+    ASSERT_EQ(serdec_document_parse(lazy, wrapped, len, &config, &doc, NULL), SERDEC_OK);
+    ASSERT_EQ(serdec_get(serdec_document_root(doc), "id", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_int64(v, &id), SERDEC_OK);
+    ASSERT_EQ(id, 7);
+    ASSERT(serdec_arena_used(lazy) * 100 < serdec_arena_used(eager));
+
+    serdec_document_destroy(doc);
+    serdec_arena_destroy(eager);
+    serdec_arena_destroy(lazy);
+    free(wrapped);
+    free(json);
+}
+
+TEST(dom_lazy_errors) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    SerdecParseConfig config = { .lazy = true };
+    SerdecDocument* doc = NULL;
+    const SerdecValue *bad, *v;
+
+    // Brackets are checked up front
+    const char* json = "{\"a\": [1, {\"b\": 2]}";
+    ASSERT(serdec_document_parse(arena, json, strlen(json), &config, &doc, NULL) != SERDEC_OK);
+    json = "{\"a\": [1]} x";
+    ASSERT(serdec_document_parse(arena, json, strlen(json), &config, &doc, NULL) != SERDEC_OK);
+
+    // Syntax inside a container is checked when it is expanded, every time
+    json = "{\"ok\": 1, \"bad\": {\"x\": tru}}";
+    ASSERT_EQ(serdec_document_parse(arena, json, strlen(json), &config, &doc, NULL), SERDEC_OK);
+    ASSERT_EQ(serdec_get(serdec_document_root(doc), "ok", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_get(serdec_document_root(doc), "bad", &bad), SERDEC_OK);
+    ASSERT(serdec_get(bad, "x", &v) != SERDEC_OK);
+    ASSERT(serdec_get(bad, "x", &v) != SERDEC_OK);
+    ASSERT_EQ(serdec_value_size(bad), 0);
+    ASSERT_EQ(serdec_index(bad, 0, &v), SERDEC_ERR_TYPE_MISMATCH);
+    serdec_document_destroy(doc);
+
+    // Unexpanded containers outlive their document only as dead ends
+    json = "[[1], [2]]";
+    ASSERT_EQ(serdec_document_parse(arena, json, strlen(json), &config, &doc, NULL), SERDEC_OK);
+    const SerdecValue *first, *second;
+    ASSERT_EQ(serdec_index(serdec_document_root(doc), 0, &first), SERDEC_OK);
+    ASSERT_EQ(serdec_index(serdec_document_root(doc), 1, &second), SERDEC_OK);
+    ASSERT_EQ(serdec_index(first, 0, &v), SERDEC_OK);
+    serdec_document_destroy(doc);
+    ASSERT_EQ(serdec_index(first, 0, &v), SERDEC_OK);
+    ASSERT_EQ(serdec_index(second, 0, &v), SERDEC_ERR_INVALID_HANDLE);
+
+    serdec_arena_destroy(arena);
+}
+
+// --- Frozen documents ---
+
+TEST(dom_freeze) {
+    size_t len;
+    char* wide = make_wide_object(40, &len);
+    char* json = malloc(len + 64);
+    len = (size_t) sprintf(json, "{\"w\": [%s], \"n\": [[1, 2, 3]], \"e\": {}}", wide);
+
+    SerdecArena* arena = serdec_arena_create(NULL);
+    SerdecParseConfig config = { .lazy = true, .typed_arrays = true };
+    SerdecDocument* doc = NULL;
+    const SerdecValue *w, *n, *v;
+    int64_t x;
+
+    ASSERT_EQ(serdec_document_parse(arena, json, len, &config, &doc, NULL), SERDEC_OK);
+    ASSERT_EQ(serdec_document_freeze(doc), SERDEC_OK);
+    ASSERT_EQ(serdec_document_freeze(doc), SERDEC_OK);
+
+    // Every deferred write is done: reads no longer allocate or change a node
+    size_t used = serdec_arena_used(arena);
+    ASSERT_EQ(serdec_get(serdec_document_root(doc), "w", &w), SERDEC_OK);
+    ASSERT(!is_lazy(w));
+    ASSERT_EQ(serdec_index(w, 0, &w), SERDEC_OK);
+    ASSERT(!is_lazy(w));
+    ASSERT_NOT_NULL(((const SerdecObjectIndex*) (w->children - 1))->table);
+    ASSERT_EQ(serdec_get(w, "key31", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_int64(v, &x), SERDEC_OK);
+    ASSERT_EQ(x, 31);
+    ASSERT_EQ(serdec_get(serdec_document_root(doc), "n", &n), SERDEC_OK);
+    ASSERT_EQ(serdec_index(n, 0, &n), SERDEC_OK);
+    ASSERT_NOT_NULL(n->packed->nodes);
+    ASSERT_EQ(serdec_index(n, 2, &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_int64(v, &x), SERDEC_OK);
+    ASSERT_EQ(x, 3);
+    ASSERT_EQ(serdec_arena_used(arena), used);
+    ASSERT(same_value(serdec_document_root(doc), parse(arena, json)));
+    serdec_document_destroy(doc);
+
+    // A syntax error found while expanding leaves the document unfrozen
+    const char* bad = "[[1], [tru]]";
+    ASSERT_EQ(serdec_document_parse(arena, bad, strlen(bad), &config, &doc, NULL), SERDEC_OK);
+    ASSERT(serdec_document_freeze(doc) != SERDEC_OK);
+    ASSERT_EQ(serdec_index(serdec_document_root(doc), 0, &v), SERDEC_OK);
+    ASSERT_EQ(serdec_value_size(v), 1);
+    serdec_document_destroy(doc);
+    ASSERT_EQ(serdec_document_freeze(NULL), SERDEC_ERR_INVALID_HANDLE);
+
+    serdec_arena_destroy(arena);
+    free(json);
+    free(wide);
+}
+
+typedef struct {
+    const SerdecDocument* doc;
+    size_t errors;
+} FrozenReader;
+
+static void* read_frozen(void* item) {
+    FrozenReader* reader = (FrozenReader*) item;
+    const SerdecValue* root = serdec_document_root(reader->doc);
+    char key[16];
+
+    for (size_t round = 0; round < 20; round++) {
+        for (size_t i = 0; i < 40; i++) {
+            const SerdecValue *r, *v;
+            uint64_t id;
+            snprintf(key, sizeof(key), "key%zu", i);
+            if (serdec_index(root, i * 7, &r) != SERDEC_OK ||
+                serdec_get(r, "id", &v) != SERDEC_OK || serdec_as_uint64(v, &id) != SERDEC_OK ||
+                id != i * 7)
+                reader->errors++;
+            if (serdec_index(root, 300, &r) != SERDEC_OK || serdec_get(r, key, &v) != SERDEC_OK)
+                reader->errors++;
+        }
+    }
+    return NULL;
+}
+
+TEST(dom_freeze_concurrent_reads) {
+    size_t records_len, wide_len;
+    char* records = make_records(300, &records_len);
+    char* wide = make_wide_object(40, &wide_len);
+    char* json = malloc(records_len + wide_len + 2);
+    size_t len = records_len - 1;
+    memcpy(json, records, len);
+    json[len++] = ',';
+    memcpy(json + len, wide, wide_len);
+    len += wide_len;
+    json[len++] = ']';
+
+    SerdecArena* arena = serdec_arena_create(NULL);
+    SerdecParseConfig config = { .lazy = true, .shapes = true };
+    SerdecDocument* doc = NULL;
+    ASSERT_EQ(serdec_document_parse(arena, json, len, &config, &doc, NULL), SERDEC_OK);
+    ASSERT_EQ(serdec_document_freeze(doc), SERDEC_OK);
+
+    FrozenReader readers[8];
+    for (size_t i = 0; i < 8; i++) readers[i] = (FrozenReader) { .doc = doc };
+    serdec_workers_run(8, read_frozen, readers, sizeof(readers[0]));
+    for (size_t i = 0; i < 8; i++) ASSERT_EQ(readers[i].errors, 0);
+
+    serdec_document_destroy(doc);
+    serdec_arena_destroy(arena);
+    free(json);
+    free(wide);
+    free(records);
+}
+
+// --- Editing ---
+
+TEST(dom_edit_object) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    const char* json = "{\"a\": 1, \"b\": {\"c\": [1, 2]}, \"a\": 3}";
+    const SerdecValue* root = parse(arena, json);
+    const SerdecValue *v, *b, *edited, *nested;
+
+    // Replace, then append; the original is unchanged
+    ASSERT_EQ(serdec_object_set(arena, root, "a", parse(arena, "\"x\""), &edited), SERDEC_OK);
+    ASSERT_EQ(serdec_object_set(arena, edited, "d", parse(arena, "null"), &edited), SERDEC_OK);
+    ASSERT(same_content(edited, parse(arena, "{\"a\": \"x\", \"b\": {\"c\": [1, 2]},"
+                                           " \"a\": 3, \"d\": null}")));
+    ASSERT(same_content(root, parse(arena, json)));
+
+    // Unchanged subtrees are shared, not copied
+    ASSERT_EQ(serdec_get(root, "b", &b), SERDEC_OK);
+    ASSERT_EQ(serdec_get(edited, "b", &v), SERDEC_OK);
+    ASSERT(v->children == b->children);
+
+    // A nested edit rebuilds the path to it
+    ASSERT_EQ(serdec_object_set(arena, b, "e", parse(arena, "true"), &nested), SERDEC_OK);
+    ASSERT_EQ(serdec_object_set(arena, root, "b", nested, &edited), SERDEC_OK);
+    ASSERT_EQ(serdec_get(edited, "b", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_get(v, "e", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_get(b, "e", &v), SERDEC_ERR_NOT_FOUND);
+
+    // Remove drops every member with the key
+    ASSERT_EQ(serdec_object_remove(arena, root, "a", &edited), SERDEC_OK);
+    ASSERT(same_content(edited, parse(arena, "{\"b\": {\"c\": [1, 2]}}")));
+    ASSERT_EQ(serdec_object_remove(arena, edited, "a", &v), SERDEC_ERR_NOT_FOUND);
+    ASSERT_EQ(serdec_object_remove(arena, edited, "b", &edited), SERDEC_OK);
+    ASSERT_EQ(serdec_value_size(edited), 0);
+    ASSERT_EQ(serdec_object_set(arena, edited, "k", root, &edited), SERDEC_OK);
+    ASSERT_EQ(serdec_get(edited, "k", &v), SERDEC_OK);
+    ASSERT(v->children == root->children);
+
+    ASSERT_EQ(serdec_object_set(arena, b, "c", NULL, &v), SERDEC_ERR_INVALID_HANDLE);
+    ASSERT_EQ(serdec_object_set(arena, parse(arena, "[]"), "c", b, &v), SERDEC_ERR_TYPE_MISMATCH);
+    serdec_arena_destroy(arena);
+}
+
+TEST(dom_edit_large_and_shaped_objects) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    SerdecParseConfig config = { .shapes = true, .lazy = true };
+    size_t len;
+    char* json = make_records(3, &len);
+    SerdecDocument* doc = NULL;
+    const SerdecValue *r, *edited, *v;
+    int64_t n;
+
+    ASSERT_EQ(serdec_document_parse(arena, json, len, &config, &doc, NULL), SERDEC_OK);
+    ASSERT_EQ(serdec_index(serdec_document_root(doc), 1, &r), SERDEC_OK);
+    ASSERT_EQ(serdec_object_set(arena, r, "x", parse(arena, "7"), &edited), SERDEC_OK);
+    ASSERT(same_content(edited, parse(arena, "{\"id\": 1, \"ok\": true, \"x\": 7,"
+                                           " \"s\": \"v\"}")));
+    ASSERT_NOT_NULL(serdec_object_shape(r));
+    serdec_document_destroy(doc);
+
+    // Growing past the index threshold keeps lookups working
+    char* wide = make_wide_object(15, &len);
+    const SerdecValue* object = parse(arena, wide);
+    ASSERT_EQ(serdec_object_set(arena, object, "new", parse(arena, "99"), &edited), SERDEC_OK);
+    ASSERT_EQ(serdec_value_size(edited), 17);
+    ASSERT_EQ(serdec_get(edited, "new", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_int64(v, &n), SERDEC_OK);
+    ASSERT_EQ(n, 99);
+    ASSERT_EQ(serdec_get(edited, "key0", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_int64(v, &n), SERDEC_OK);
+    ASSERT_EQ(n, 0);
+
+    serdec_arena_destroy(arena);
+    free(wide);
+    free(json);
+}
+
+TEST(dom_edit_array) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    SerdecParseConfig config = { .typed_arrays = true };
+    SerdecDocument* doc = NULL;
+    const char* json = "[1, 2, 3]";
+    const SerdecValue *edited, *v;
+
+    ASSERT_EQ(serdec_document_parse(arena, json, strlen(json), &config, &doc, NULL), SERDEC_OK);
+    const SerdecValue* root = serdec_document_root(doc);
+    ASSERT_EQ(serdec_array_insert(arena, root, 1, parse(arena, "\"x\""), &edited), SERDEC_OK);
+    ASSERT(same_content(edited, parse(arena, "[1, \"x\", 2, 3]")));
+    ASSERT_EQ(serdec_array_replace(arena, edited, 3, parse(arena, "{}"), &edited), SERDEC_OK);
+    ASSERT_EQ(serdec_array_remove(arena, edited, 0, &edited), SERDEC_OK);
+    ASSERT(same_content(edited, parse(arena, "[\"x\", 2, {}]")));
+    ASSERT(same_content(root, parse(arena, json)));
+
+    ASSERT_EQ(serdec_array_insert(arena, root, 4, root, &v), SERDEC_ERR_NOT_FOUND);
+    ASSERT_EQ(serdec_array_replace(arena, root, 3, root, &v), SERDEC_ERR_NOT_FOUND);
+    ASSERT_EQ(serdec_array_remove(arena, parse(arena, "{}"), 0, &v), SERDEC_ERR_TYPE_MISMATCH);
+    serdec_arena_destroy(arena);
+}
+
+TEST(dom_edit_append_in_place) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    const SerdecValue* array = parse(arena, "[]");
+    const SerdecValue* versions[1000];
+    size_t copies = 0;
+
+    for (size_t i = 0; i < 1000; i++) {
+        char text[16];
+        snprintf(text, sizeof(text), "%zu", i);
+        const SerdecValue* next;
+        ASSERT_EQ(serdec_array_insert(arena, array, i, parse(arena, text), &next), SERDEC_OK);
+        copies += (next->children != array->children);
+        versions[i] = array = next;
+    }
+    ASSERT(copies < 12);
+
+    // Every version keeps its own length and sees the same leading elements
+    const SerdecValue* v;
+    uint64_t n;
+    ASSERT_EQ(serdec_value_size(versions[9]), 10);
+    ASSERT_EQ(serdec_index(versions[9], 10, &v), SERDEC_ERR_NOT_FOUND);
+    ASSERT_EQ(serdec_index(versions[999], 500, &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_uint64(v, &n), SERDEC_OK);
+    ASSERT_EQ(n, 500);
+
+    // Appending to an older version must not clobber the newer one
+    const SerdecValue* fork;
+    ASSERT_EQ(serdec_array_insert(arena, versions[9], 10, parse(arena, "-1"), &fork), SERDEC_OK);
+    ASSERT(fork->children != versions[9]->children);
+    ASSERT_EQ(serdec_index(versions[999], 10, &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_uint64(v, &n), SERDEC_OK);
+    ASSERT_EQ(n, 10);
+
+    serdec_arena_destroy(arena);
+}
+
+TEST(dom_edit_object_append_in_place) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    const SerdecValue* object = parse(arena, "{}");
+    const SerdecValue* versions[1000];
+    const SerdecValue* v;
+    size_t copies = 0;
+    char key[16];
+    uint64_t n;
+
+    for (size_t i = 0; i < 1000; i++) {
+        snprintf(key, sizeof(key), "k%zu", i);
+        const SerdecValue* next;
+        ASSERT_EQ(serdec_object_set(arena, object, key, parse(arena, key + 1), &next), SERDEC_OK);
+        copies += (next->children != object->children);
+        versions[i] = object = next;
+
+        // Lookups along the way build the shared index, which later appends extend
+        if (i % 7 == 0) ASSERT_EQ(serdec_get(object, "k0", &v), SERDEC_OK);
+    }
+    ASSERT(copies < 12);
+
+    // Every version sees its own members only, through the index it shares
+    ASSERT_EQ(serdec_value_size(versions[99]), 100);
+    ASSERT_EQ(serdec_get(versions[99], "k99", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_get(versions[99], "k100", &v), SERDEC_ERR_NOT_FOUND);
+    ASSERT_EQ(serdec_get(versions[20], "k21", &v), SERDEC_ERR_NOT_FOUND);
+    for (size_t i = 0; i < 1000; i += 37) {
+        snprintf(key, sizeof(key), "k%zu", i);
+        ASSERT_EQ(serdec_get(versions[999], key, &v), SERDEC_OK);
+        ASSERT_EQ(serdec_as_uint64(v, &n), SERDEC_OK);
+        ASSERT_EQ(n, i);
+    }
+
+    // Setting a member of an older version, or an existing member, copies
+    const SerdecValue* fork;
+    ASSERT_EQ(serdec_object_set(arena, versions[99], "k100", parse(arena, "-1"), &fork),
+              SERDEC_OK);
+    ASSERT(fork->children != versions[99]->children);
+    ASSERT_EQ(serdec_get(versions[999], "k100", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_uint64(v, &n), SERDEC_OK);
+    ASSERT_EQ(n, 100);
+    ASSERT_EQ(serdec_object_set(arena, versions[999], "k5", parse(arena, "-5"), &fork),
+              SERDEC_OK);
+    ASSERT_EQ(serdec_value_size(fork), 1000);
+    ASSERT_EQ(serdec_get(versions[999], "k5", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_uint64(v, &n), SERDEC_OK);
+    ASSERT_EQ(n, 5);
+
+    // A clone of an older version has an index of its own
+    const SerdecValue* clone;
+    ASSERT_EQ(serdec_value_clone(arena, versions[40], SERDEC_CLONE_BORROW_STRINGS, &clone),
+              SERDEC_OK);
+    ASSERT(same_content(clone, versions[40]));
+    ASSERT_EQ(serdec_get(clone, "k40", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_get(clone, "k41", &v), SERDEC_ERR_NOT_FOUND);
+
+    serdec_arena_destroy(arena);
+}
+
+// --- Cloning ---
+
+TEST(dom_clone_copy_strings) {
+    SerdecArenaConfig counting = { .block_size = 256, .alloc = counting_alloc };
+    SerdecArena* source = serdec_arena_create(NULL);
+    SerdecArena* cache = serdec_arena_create(&counting);
+    char* json = strdup(exact_doc);
+    const SerdecValue* root = parse(source, json);
+    const SerdecValue *clone, *v;
+    SerdecString s;
+
+    alloc_calls = 0;
+    ASSERT_EQ(serdec_value_clone(cache, root, SERDEC_CLONE_COPY_STRINGS, &clone), SERDEC_OK);
+    ASSERT(alloc_calls <= 1);
+    ASSERT(same_content(clone, root));
+    ASSERT_EQ(serdec_get(clone, "c", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_string(v, &s), SERDEC_OK);
+    ASSERT((s.ptr < json || s.ptr >= json + strlen(json)) && s.has_escapes);
+
+    // The clone depends on neither the input nor the source arena
+    serdec_arena_destroy(source);
+    memset(json, ' ', strlen(json));
+    free(json);
+    source = serdec_arena_create(NULL);
+    ASSERT(same_content(clone, parse(source, exact_doc)));
+
+    // Scalars and empty containers
+    const SerdecValue* scalar;
+    ASSERT_EQ(serdec_value_clone(cache, parse(source, "\"abc\""), SERDEC_CLONE_COPY_STRINGS,
+                                 &scalar), SERDEC_OK);
+    ASSERT(string_is(scalar, "abc"));
+    ASSERT_EQ(serdec_value_clone(cache, parse(source, "[{}, []]"), 0, &clone), SERDEC_OK);
+    ASSERT(same_content(clone, parse(source, "[{}, []]")));
+    ASSERT_EQ(serdec_value_clone(NULL, scalar, 0, &clone), SERDEC_ERR_INVALID_HANDLE);
+
+    serdec_arena_destroy(source);
+    serdec_arena_destroy(cache);
+}
+
+TEST(dom_clone_keeps_layout) {
+    SerdecArena* source = serdec_arena_create(NULL);
+    SerdecArena* cache = serdec_arena_create(NULL);
+    SerdecParseConfig config = { .lazy = true, .shapes = true, .typed_arrays = true };
+    size_t records_len, wide_len;
+    char* records = make_records(100, &records_len);
+    char* wide = make_wide_object(40, &wide_len);
+    char* json = malloc(records_len + wide_len + 32);
+    size_t len = (size_t) sprintf(json, "{\"r\": %.*s, \"w\": %s, \"n\": [1, 2, 3]}",
+                                  (int) records_len, records, wide);
+    SerdecDocument* doc = NULL;
+    const SerdecValue *clone, *a, *b, *v;
+
+    ASSERT_EQ(serdec_document_parse(source, json, len, &config, &doc, NULL), SERDEC_OK);
+    const SerdecValue* root = serdec_document_root(doc);
+    ASSERT_EQ(serdec_get(root, "w", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_get(v, "key7", &v), SERDEC_OK);   // Builds the index
+    ASSERT_EQ(serdec_value_clone(cache, root, 0, &clone), SERDEC_OK);
+    ASSERT(same_value(clone, root));
+
+    // Shapes are copied once and still shared; packed arrays and indexes carry over
+    ASSERT_EQ(serdec_get(clone, "r", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_index(v, 0, &a), SERDEC_OK);
+    ASSERT_EQ(serdec_index(v, 99, &b), SERDEC_OK);
+    ASSERT_NOT_NULL(serdec_object_shape(a));
+    ASSERT(serdec_object_shape(a) == serdec_object_shape(b));
+    ASSERT_EQ(serdec_get(root, "r", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_index(v, 0, &b), SERDEC_OK);
+    ASSERT(serdec_object_shape(a) != serdec_object_shape(b));
+
+    const int64_t* ints;
+    ASSERT_EQ(serdec_get(clone, "n", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_int64_array(v, &ints, &len), SERDEC_OK);
+    ASSERT(len == 3 && ints[2] == 3);
+
+    ASSERT_EQ(serdec_get(clone, "w", &v), SERDEC_OK);
+    ASSERT_NOT_NULL(((const SerdecObjectIndex*) (v->children - 1))->table);
+    size_t used = serdec_arena_used(cache);
+    ASSERT_EQ(serdec_get(v, "key39", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_arena_used(cache), used);
+
+    serdec_document_destroy(doc);
+    serdec_arena_destroy(source);
+    serdec_arena_destroy(cache);
+    free(json);
+    free(wide);
+    free(records);
+}
+
+// --- Equality and hashing ---
+
+static bool equal_and_same_hash(const SerdecValue* a, const SerdecValue* b) {
+    return serdec_value_equal(a, b) && serdec_value_equal(b, a) &&
+           serdec_value_hash(a) == serdec_value_hash(b);
+}
+
+TEST(dom_equal_by_content) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    const SerdecValue* a = parse(arena, "{\"a\": 1, \"b\": [true, null, \"x\"], \"c\": {}}");
+    const SerdecValue* b = parse(arena, "{\"c\": {}, \"b\": [true, null, \"\\u0078\"], "
+                                        "\"a\": 1.0}");
+
+    // Member order, number spelling and escapes do not matter
+    ASSERT(equal_and_same_hash(a, b));
+    ASSERT(equal_and_same_hash(parse(arena, "[1, -2, 3e2]"), parse(arena, "[1.0, -2e0, 300]")));
+    ASSERT(equal_and_same_hash(parse(arena, "\"tab\\there\""), parse(arena, "\"tab\\u0009here\"")));
+    ASSERT(equal_and_same_hash(parse(arena, "0.5"), parse(arena, "5e-1")));
+
+    // Array order, types and sizes do
+    ASSERT(!serdec_value_equal(parse(arena, "[1, 2]"), parse(arena, "[2, 1]")));
+    ASSERT(serdec_value_hash(parse(arena, "[1, 2]")) != serdec_value_hash(parse(arena, "[2, 1]")));
+    ASSERT(!serdec_value_equal(parse(arena, "1"), parse(arena, "\"1\"")));
+    ASSERT(!serdec_value_equal(parse(arena, "1"), parse(arena, "1.5")));
+    ASSERT(!serdec_value_equal(parse(arena, "-1"), parse(arena, "18446744073709551615")));
+    ASSERT(!serdec_value_equal(parse(arena, "{\"a\": 1}"), parse(arena, "{\"a\": 1, \"b\": 2}")));
+    ASSERT(!serdec_value_equal(parse(arena, "{\"a\": 1, \"b\": 2}"), parse(arena, "{\"a\": 1}")));
+    ASSERT(!serdec_value_equal(parse(arena, "{\"a\": 1}"), parse(arena, "{\"b\": 1}")));
+    ASSERT(!serdec_value_equal(parse(arena, "\"ab\""), parse(arena, "\"a\\u0062c\"")));
+    ASSERT(serdec_value_hash(parse(arena, "{}")) != serdec_value_hash(parse(arena, "[]")));
+
+    // Shadowed duplicates are ignored, as they are by lookups
+    const SerdecValue* dup = parse(arena, "{\"a\": 1, \"b\": 2, \"a\": 3}");
+    ASSERT(equal_and_same_hash(dup, parse(arena, "{\"b\": 2, \"a\": 1}")));
+    ASSERT(!serdec_value_equal(dup, parse(arena, "{\"b\": 2, \"a\": 3}")));
+    ASSERT(!serdec_value_equal(dup, parse(arena, "{\"a\": 1, \"b\": 2, \"c\": 3}")));
+
+    // Keys interned in different tables compare by their bytes
+    SerdecInternTable* t1 = serdec_intern_table_create(arena);
+    SerdecInternTable* t2 = serdec_intern_table_create(arena);
+    const char* keyed = "{\"a\": 1, \"b\": {\"c\": 2}}";
+    SerdecParseConfig config = { .keys = t1 };
+    SerdecDocument *d1 = NULL, *d2 = NULL;
+    ASSERT_EQ(serdec_document_parse(arena, keyed, strlen(keyed), &config, &d1, NULL), SERDEC_OK);
+    config.keys = t2;
+    ASSERT_EQ(serdec_document_parse(arena, keyed, strlen(keyed), &config, &d2, NULL), SERDEC_OK);
+    ASSERT(equal_and_same_hash(serdec_document_root(d1), serdec_document_root(d2)));
+    ASSERT(equal_and_same_hash(serdec_document_root(d1), parse(arena, keyed)));
+    serdec_intern_table_destroy(t1);
+    serdec_intern_table_destroy(t2);
+
+    // Nesting is walked without recursion
+    enum { DEPTH = 100000 };
+    char* deep = malloc(2 * DEPTH + 3);
+    memset(deep, '[', DEPTH);
+    strcpy(deep + DEPTH, "1");
+    memset(deep + DEPTH + 1, ']', DEPTH);
+    deep[2 * DEPTH + 1] = '\0';
+    config = (SerdecParseConfig) { .max_depth = DEPTH };
+    ASSERT_EQ(serdec_document_parse(arena, deep, strlen(deep), &config, &d1, NULL), SERDEC_OK);
+    ASSERT_EQ(serdec_document_parse(arena, deep, strlen(deep), &config, &d2, NULL), SERDEC_OK);
+    ASSERT(equal_and_same_hash(serdec_document_root(d1), serdec_document_root(d2)));
+    deep[DEPTH] = '2';
+    ASSERT_EQ(serdec_document_parse(arena, deep, strlen(deep), &config, &d2, NULL), SERDEC_OK);
+    ASSERT(!serdec_value_equal(serdec_document_root(d1), serdec_document_root(d2)));
+    ASSERT(serdec_value_hash(serdec_document_root(d1)) !=
+           serdec_value_hash(serdec_document_root(d2)));
+    free(deep);
+
+    ASSERT(serdec_value_equal(NULL, NULL));
+    ASSERT(!serdec_value_equal(a, NULL));
+    ASSERT_EQ(serdec_value_hash(NULL), serdec_value_hash(parse(arena, "null")));
+
+    serdec_arena_destroy(arena);
+}
+
+TEST(dom_equal_across_layouts) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    SerdecParseConfig packed = { .typed_arrays = true, .shapes = true };
+    SerdecParseConfig lazy = { .lazy = true };
+    SerdecDocument *x = NULL, *y = NULL;
+
+    // Large objects with indexes, in opposite member orders
+    char forward[1024], backward[1024];
+    size_t f = 0, r = 0;
+    for (int i = 0; i < 40; i++) {
+        f += (size_t) sprintf(forward + f, "%s\"k%d\": [%d, %d.5]", i ? ", " : "{", i, i, i);
+        r += (size_t) sprintf(backward + r, "%s\"k%d\": [%d, %d.5]", i ? ", " : "{", 39 - i,
+                              39 - i, 39 - i);
+    }
+    strcpy(forward + f, "}");
+    strcpy(backward + r, "}");
+
+    ASSERT_EQ(serdec_document_parse(arena, forward, strlen(forward), &packed, &x, NULL),
+              SERDEC_OK);
+    ASSERT_EQ(serdec_document_parse(arena, backward, strlen(backward), &lazy, &y, NULL),
+              SERDEC_OK);
+    ASSERT(equal_and_same_hash(serdec_document_root(x), serdec_document_root(y)));
+    ASSERT(equal_and_same_hash(serdec_document_root(x), parse(arena, backward)));
+
+    // Packed and plain arrays of the same numbers
+    SerdecDocument* ints = NULL;
+    const char* json = "[1, 2, 3, 4]";
+    ASSERT_EQ(serdec_document_parse(arena, json, strlen(json), &packed, &ints, NULL), SERDEC_OK);
+    ASSERT(serdec_is_packed(serdec_document_root(ints)));
+    ASSERT(equal_and_same_hash(serdec_document_root(ints), parse(arena, "[1, 2, 3, 4.0]")));
+
+    // Shared subtrees and edited copies
+    const SerdecValue* root = serdec_document_root(x);
+    const SerdecValue *edited, *v;
+    ASSERT_EQ(serdec_get(root, "k3", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_object_set(arena, root, "k3", v, &edited), SERDEC_OK);
+    ASSERT(equal_and_same_hash(root, edited));
+    ASSERT_EQ(serdec_object_set(arena, root, "k3", parse(arena, "[3, 3.25]"), &edited),
+              SERDEC_OK);
+    ASSERT(!serdec_value_equal(root, edited));
+
+    const SerdecValue* clone;
+    ASSERT_EQ(serdec_value_clone(arena, root, SERDEC_CLONE_COPY_STRINGS, &clone), SERDEC_OK);
+    ASSERT(equal_and_same_hash(root, clone));
+
+    serdec_document_destroy(x);
+    serdec_document_destroy(y);
+    serdec_arena_destroy(arena);
+}
+
+// --- Iteration ---
+
+// Appends one token per step: the key or index, then the type letter, with a trailing
+// '/' on postorder visits.
+static void trace_step(char* trace, const SerdecVisit* visit) {
+    static const char letters[] = "nbnsao";
+    size_t n = strlen(trace);
+    if (n) trace[n++] = ' ';
+    if (visit->key.ptr) n += (size_t) sprintf(trace + n, "%.*s:", (int) visit->key.len,
+                                              visit->key.ptr);
+    else if (visit->depth) n += (size_t) sprintf(trace + n, "%zu:", visit->index);
+    trace[n++] = letters[serdec_value_type(visit->value)];
+    if (visit->leave) trace[n++] = '/';
+    trace[n] = '\0';
+}
+
+static bool trace_is(SerdecArena* arena, const SerdecValue* root, unsigned order,
+                     const char* expected) {
+    char trace[256] = "";
+    SerdecIterator* it = serdec_iter_create(arena, root, order);
+    SerdecVisit visit;
+    while (serdec_iter_next(it, &visit) == SERDEC_OK && visit.value) trace_step(trace, &visit);
+    return strcmp(trace, expected) == 0;
+}
+
+TEST(dom_iter_orders) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    const SerdecValue* root = parse(arena, "{\"a\": [1, {\"b\": null}], \"c\": \"x\", \"d\": []}");
+
+    ASSERT(trace_is(arena, root, SERDEC_ITER_PREORDER, "o a:a 0:n 1:o b:n c:s d:a"));
+    ASSERT(trace_is(arena, root, SERDEC_ITER_POSTORDER, "0:n b:n 1:o/ a:a/ c:s d:a/ o/"));
+    ASSERT(trace_is(arena, root, SERDEC_ITER_BOTH,
+                    "o a:a 0:n 1:o b:n 1:o/ a:a/ c:s d:a d:a/ o/"));
+    ASSERT(trace_is(arena, parse(arena, "true"), SERDEC_ITER_BOTH, "b"));
+
+    // The orders are flags; their union is both, and an order without either is invalid
+    ASSERT(trace_is(arena, parse(arena, "[[1]]"), SERDEC_ITER_PREORDER | SERDEC_ITER_POSTORDER,
+                    "a 0:a 0:n 0:a/ a/"));
+    ASSERT_NULL(serdec_iter_create(arena, root, 0));
+    ASSERT_NULL(serdec_iter_create(arena, root, 1u << 2));
+
+    // Skipping the children of the container just entered
+    SerdecIterator* it = serdec_iter_create(arena, root, SERDEC_ITER_BOTH);
+    SerdecVisit visit;
+    char trace[256] = "";
+    while (serdec_iter_next(it, &visit) == SERDEC_OK && visit.value) {
+        trace_step(trace, &visit);
+        if (visit.key.ptr && visit.key.ptr[0] == 'a') serdec_iter_skip(it);
+    }
+    ASSERT(strcmp(trace, "o a:a a:a/ c:s d:a d:a/ o/") == 0);
+
+    ASSERT_NULL(serdec_iter_create(NULL, root, 0));
+    ASSERT_EQ(serdec_iter_next(NULL, &visit), SERDEC_ERR_INVALID_HANDLE);
+    serdec_arena_destroy(arena);
+}
+
+TEST(dom_iter_child_storage) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    SerdecParseConfig config = { .shapes = true, .typed_arrays = true };
+    const char* json = "[{\"x\": 1, \"y\": \"s\"}, {\"x\": 2, \"y\": \"t\"}, [1.5, 2.5], {}]";
+    SerdecDocument* doc = NULL;
+    ASSERT_EQ(serdec_document_parse(arena, json, strlen(json), &config, &doc, NULL), SERDEC_OK);
+    const SerdecValue* root = serdec_document_root(doc);
+
+    // Child storage holds the same nodes as the accessors return
+    SerdecIterator* it = serdec_iter_create(arena, root, SERDEC_ITER_PREORDER);
+    SerdecVisit visit;
+    size_t nodes = 0, packed = 0;
+    while (serdec_iter_next(it, &visit) == SERDEC_OK && visit.value) {
+        nodes++;
+        size_t count = serdec_value_size(visit.value);
+        if (serdec_value_type(visit.value) < SERDEC_TYPE_ARRAY || !count) {
+            ASSERT_NULL(visit.children);
+            continue;
+        }
+        if (!visit.children) {
+            packed++;
+            continue;
+        }
+        for (size_t i = 0; i < count; i++) {
+            const SerdecValue* child;
+            if (serdec_value_type(visit.value) == SERDEC_TYPE_ARRAY)
+                ASSERT_EQ(serdec_index(visit.value, i, &child), SERDEC_OK);
+            else
+                ASSERT_EQ(serdec_member(visit.value, i, NULL, &child), SERDEC_OK);
+            ASSERT(visit.children + i * visit.stride == child);
+        }
+    }
+    ASSERT_EQ(nodes, 11);
+    ASSERT_EQ(packed, 1);
+
+    // Packed elements come through the iterator's own node
+    ASSERT(trace_is(arena, root, SERDEC_ITER_PREORDER,
+                    "a 0:o x:n y:s 1:o x:n y:s 2:a 0:n 1:n 3:o"));
+    ASSERT_EQ(serdec_index(root, 0, &root), SERDEC_OK);
+    ASSERT_NOT_NULL(serdec_object_shape(root));   // Shaped objects were covered
+    serdec_arena_destroy(arena);
+}
+
+typedef struct {
+    size_t nodes;
+    size_t max_depth;
+    size_t stop_at;
+} WalkCounts;
+
+static SerdecError count_node(void* user, const SerdecVisit* visit) {
+    WalkCounts* counts = (WalkCounts*) user;
+    if (++counts->nodes == counts->stop_at) return SERDEC_ERR_NOT_FOUND;
+    if (visit->depth > counts->max_depth) counts->max_depth = visit->depth;
+    return SERDEC_OK;
+}
+
+TEST(dom_walk_deep_and_lazy) {
+    enum { DEPTH = 100000 };
+    SerdecArena* arena = serdec_arena_create(NULL);
+    char* json = malloc(2 * DEPTH + 1);
+    memset(json, '[', DEPTH);
+    memset(json + DEPTH, ']', DEPTH);
+    json[2 * DEPTH] = '\0';
+
+    // Far deeper than a recursive walker could go
+    SerdecParseConfig config = { .max_depth = DEPTH };
+    SerdecDocument* doc = NULL;
+    ASSERT_EQ(serdec_document_parse(arena, json, 2 * DEPTH, &config, &doc, NULL), SERDEC_OK);
+    WalkCounts counts = { 0 };
+    ASSERT_EQ(serdec_value_walk(arena, serdec_document_root(doc), SERDEC_ITER_BOTH, count_node,
+                                &counts), SERDEC_OK);
+    ASSERT_EQ(counts.nodes, 2 * DEPTH);
+    ASSERT_EQ(counts.max_depth, DEPTH - 1);
+
+    // The callback's error stops the walk
+    counts = (WalkCounts) { .stop_at = 10 };
+    ASSERT_EQ(serdec_value_walk(arena, serdec_document_root(doc), SERDEC_ITER_PREORDER,
+                                count_node, &counts), SERDEC_ERR_NOT_FOUND);
+    ASSERT_EQ(counts.nodes, 10);
+    ASSERT_EQ(serdec_value_walk(arena, serdec_document_root(doc), 1u << 2, count_node, &counts),
+              SERDEC_ERR_INVALID_HANDLE);
+
+    // Lazy containers are expanded on the way; a bad one ends the traversal
+    const char* lazy_json = "{\"a\": {\"b\": [1, 2]}, \"c\": [1, tru]}";
+    config = (SerdecParseConfig) { .lazy = true };
+    ASSERT_EQ(serdec_document_parse(arena, lazy_json, strlen(lazy_json), &config, &doc, NULL),
+              SERDEC_OK);
+    counts = (WalkCounts) { 0 };
+    ASSERT(serdec_value_walk(arena, serdec_document_root(doc), SERDEC_ITER_PREORDER,
+                             count_node, &counts) != SERDEC_OK);
+    ASSERT_EQ(counts.nodes, 5);
+
+    serdec_document_destroy(doc);
+    serdec_arena_destroy(arena);
+    free(json);
+}
+
+// --- Statistics ---
+
+TEST(dom_stats_counts) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    const char* json = "{\"name\": \"abc\", \"k\\u0065y\": [1, 2.5, null, true, [\"de\"]], "
+                       "\"o\": {}}";
+    SerdecDocument* doc = NULL;
+    SerdecDocumentStats stats;
+
+    ASSERT_EQ(serdec_document_parse(arena, json, strlen(json), NULL, &doc, NULL), SERDEC_OK);
+    ASSERT_EQ(serdec_document_stats(doc, &stats), SERDEC_OK);
+    ASSERT_EQ(stats.nodes[SERDEC_TYPE_OBJECT], 2);
+    ASSERT_EQ(stats.nodes[SERDEC_TYPE_ARRAY], 2);
+    ASSERT_EQ(stats.nodes[SERDEC_TYPE_STRING], 2);
+    ASSERT_EQ(stats.nodes[SERDEC_TYPE_NUMBER], 2);
+    ASSERT_EQ(stats.nodes[SERDEC_TYPE_BOOL], 1);
+    ASSERT_EQ(stats.nodes[SERDEC_TYPE_NULL], 1);
+    ASSERT_EQ(stats.members, 3);
+    ASSERT_EQ(stats.largest_object, 3);
+    ASSERT_EQ(stats.largest_array, 5);
+    ASSERT_EQ(stats.max_depth, 3);
+    // "name", "abc", "o", "de" borrow from the input; the decoded "key" was copied
+    ASSERT_EQ(stats.borrowed_bytes, 10);
+    ASSERT_EQ(stats.copied_bytes, 3);
+    ASSERT_EQ(stats.unexpanded + stats.shapes + stats.packed_arrays + stats.interned_keys, 0);
+    ASSERT_EQ(stats.arena_used, serdec_arena_used(arena));
+    ASSERT(stats.arena_reserved >= stats.arena_used);
+
+    ASSERT_EQ(serdec_document_stats(NULL, &stats), SERDEC_ERR_INVALID_HANDLE);
+    serdec_arena_destroy(arena);
+}
+
+TEST(dom_stats_layouts) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    SerdecInternTable* table = serdec_intern_table_create(arena);
+    SerdecParseConfig config = { .lazy = true, .shapes = true, .typed_arrays = true,
+                                 .keys = table };
+    const char* json = "{\"r\": [{\"id\": 1, \"v\": [1, 2, 3]}, {\"id\": 2, \"v\": [4.5, 5]}], "
+                       "\"skip\": {\"a\": [1]}}";
+    SerdecDocument* doc = NULL;
+    SerdecDocumentStats stats;
+    const SerdecValue* v;
+
+    ASSERT_EQ(serdec_document_parse(arena, json, strlen(json), &config, &doc, NULL), SERDEC_OK);
+    ASSERT_EQ(serdec_document_stats(doc, &stats), SERDEC_OK);
+    ASSERT_EQ(stats.unexpanded, 2);
+    ASSERT_EQ(stats.members, 2);
+    ASSERT_EQ(stats.shapes, 1);
+
+    // Statistics do not expand anything; accessors do
+    ASSERT_EQ(serdec_get(serdec_document_root(doc), "r", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_index(v, 1, &v), SERDEC_OK);
+    ASSERT_EQ(serdec_get(v, "v", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_index(v, 1, &v), SERDEC_OK);
+
+    ASSERT_EQ(serdec_document_stats(doc, &stats), SERDEC_OK);
+    ASSERT_EQ(stats.unexpanded, 2);                  // "skip" and the first record
+    ASSERT_EQ(stats.shapes, 2);                      // The root and the second record
+    ASSERT_EQ(stats.packed_arrays, 1);
+    ASSERT_EQ(stats.nodes[SERDEC_TYPE_NUMBER], 3);
+    ASSERT_EQ(stats.members, 4);
+    ASSERT_EQ(stats.interned_keys, 4);
+    ASSERT_EQ(stats.borrowed_bytes + stats.copied_bytes, 0);
+    ASSERT_EQ(stats.max_depth, 4);
+    ASSERT_EQ(stats.largest_array, 2);
+
+    serdec_document_destroy(doc);
+    serdec_intern_table_destroy(table);
+    serdec_arena_destroy(arena);
+}
+
+// --- Snapshots ---
+
+// Unique per process and call, so that concurrent runs of the suite do not collide.
+static void snapshot_path(char* path, size_t size) {
+    static unsigned calls;
+    int local;
+    snprintf(path, size, "serdec_snapshot_%p_%u.img", (void*) &local, calls++);
+}
+
+TEST(dom_snapshot_round_trip) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    SerdecArena* mapped = serdec_arena_create(NULL);
+    size_t wide_len;
+    char* wide = make_wide_object(40, &wide_len);
+    char* json = malloc(wide_len + 256);
+    size_t len = (size_t) sprintf(json, "{\"w\": %s, \"s\": [\"a\\nb\", \"x\", \"x\", \"\"], "
+                                        "\"k\\u0065y\": [1, -2, 2.5, 18446744073709551615], "
+                                        "\"b\": [true, false, null], \"e\": [{}, []]}", wide);
+    SerdecDocument *doc = NULL, *image = NULL;
+    SerdecDocumentStats stats;
+    SerdecString s;
+    const SerdecValue *root, *v;
+    char path[64];
+    snapshot_path(path, sizeof(path));
+
+    ASSERT_EQ(serdec_document_parse(arena, json, len, NULL, &doc, NULL), SERDEC_OK);
+    ASSERT_EQ(serdec_document_save(doc, path), SERDEC_OK);
+    ASSERT_EQ(serdec_document_map(mapped, path, &image), SERDEC_OK);
+    root = serdec_document_root(image);
+
+    // Nothing but the root is touched until it is accessed
+    ASSERT_EQ(serdec_document_stats(image, &stats), SERDEC_OK);
+    ASSERT_EQ(stats.unexpanded, 1);
+    ASSERT_EQ(serdec_value_size(root), 5);
+    ASSERT_EQ(serdec_document_stats(image, &stats), SERDEC_OK);
+    ASSERT_EQ(stats.unexpanded, 5);
+
+    ASSERT_EQ(serdec_get(root, "key", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_index(v, 3, &v), SERDEC_OK);
+    uint64_t u;
+    ASSERT_EQ(serdec_as_uint64(v, &u), SERDEC_OK);
+    ASSERT(u == UINT64_MAX);
+    ASSERT_EQ(serdec_get(root, "s", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_index(v, 0, &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_string(v, &s), SERDEC_OK);
+    ASSERT(s.has_escapes && s.len == 4);
+
+    // Strings are stored once; the index of a wide object is stored with it
+    const SerdecValue *x1, *x2;
+    ASSERT_EQ(serdec_get(root, "s", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_index(v, 1, &x1), SERDEC_OK);
+    ASSERT_EQ(serdec_index(v, 2, &x2), SERDEC_OK);
+    ASSERT(x1->str == x2->str);
+    ASSERT_EQ(serdec_get(root, "w", &v), SERDEC_OK);
+    size_t used = serdec_arena_used(mapped);
+    ASSERT_EQ(serdec_get(v, "key39", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_arena_used(mapped), used);
+
+    ASSERT(serdec_value_equal(root, serdec_document_root(doc)));
+    ASSERT_EQ(serdec_value_hash(root), serdec_value_hash(serdec_document_root(doc)));
+    ASSERT_EQ(serdec_document_freeze(image), SERDEC_OK);
+    ASSERT_EQ(serdec_document_stats(image, &stats), SERDEC_OK);
+    ASSERT_EQ(stats.unexpanded + stats.copied_bytes, 0);
+
+    serdec_document_destroy(image);
+    ASSERT_NULL(serdec_document_root(image));
+    remove(path);
+    serdec_arena_destroy(mapped);
+    serdec_arena_destroy(arena);
+    free(json);
+    free(wide);
+}
+
+TEST(dom_snapshot_layouts) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    SerdecArena* mapped = serdec_arena_create(NULL);
+    SerdecInternTable* table = serdec_intern_table_create(arena);
+    SerdecParseConfig config = { .lazy = true, .shapes = true, .typed_arrays = true,
+                                 .keys = table };
+    size_t records_len;
+    char* records = make_records(100, &records_len);
+    char* json = malloc(records_len + 64);
+    size_t len = (size_t) sprintf(json, "{\"r\": %.*s, \"n\": [1, 2, 3], \"f\": [0.5, 2]}",
+                                  (int) records_len, records);
+    SerdecDocument *doc = NULL, *image = NULL;
+    const SerdecValue *root, *v, *a, *b;
+    char path[64];
+    snapshot_path(path, sizeof(path));
+
+    // Saving expands every lazy container
+    ASSERT_EQ(serdec_document_parse(arena, json, len, &config, &doc, NULL), SERDEC_OK);
+    ASSERT_EQ(serdec_document_save(doc, path), SERDEC_OK);
+    ASSERT_EQ(serdec_document_map(mapped, path, &image), SERDEC_OK);
+    root = serdec_document_root(image);
+
+    // Records still share one shape; keys are plain strings now
+    ASSERT_EQ(serdec_get(root, "r", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_index(v, 0, &a), SERDEC_OK);
+    ASSERT_EQ(serdec_index(v, 99, &b), SERDEC_OK);
+    ASSERT_EQ(serdec_value_size(a) + serdec_value_size(b), 8);
+    ASSERT_NOT_NULL(serdec_object_shape(a));
+    ASSERT(serdec_object_shape(a) == serdec_object_shape(b));
+    ASSERT_EQ(serdec_tag_sub(&serdec_object_shape(a)->keys[0]), 0);
+    ASSERT_EQ(serdec_get(b, "id", &v), SERDEC_OK);
+    int64_t id;
+    ASSERT_EQ(serdec_as_int64(v, &id), SERDEC_OK);
+    ASSERT_EQ(id, 99);
+
+    const int64_t* ints;
+    const double* doubles;
+    ASSERT_EQ(serdec_get(root, "n", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_int64_array(v, &ints, &len), SERDEC_OK);
+    ASSERT(len == 3 && ints[2] == 3);
+    ASSERT_EQ(serdec_index(v, 1, &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_int64(v, &id), SERDEC_OK);
+    ASSERT_EQ(id, 2);
+    ASSERT_EQ(serdec_get(root, "f", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_double_array(v, &doubles, &len), SERDEC_OK);
+    ASSERT(len == 2 && doubles[0] == 0.5);
+
+    // Edits copy mapped nodes; a copy expands from the same block
+    const SerdecValue* edited;
+    ASSERT_EQ(serdec_get(root, "r", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_array_remove(mapped, v, 0, &edited), SERDEC_OK);
+    ASSERT_EQ(serdec_index(edited, 98, &a), SERDEC_OK);
+    ASSERT(serdec_value_equal(a, b));
+    ASSERT(serdec_value_equal(root, serdec_document_root(doc)));
+
+    serdec_document_destroy(image);
+    serdec_document_destroy(doc);
+    remove(path);
+
+    // A scalar root
+    ASSERT_EQ(serdec_document_parse(arena, "\"a\\tb\"", 6, NULL, &doc, NULL), SERDEC_OK);
+    ASSERT_EQ(serdec_document_save(doc, path), SERDEC_OK);
+    ASSERT_EQ(serdec_document_map(mapped, path, &image), SERDEC_OK);
+    ASSERT(serdec_value_equal(serdec_document_root(image), serdec_document_root(doc)));
+    serdec_document_destroy(image);
+    remove(path);
+
+    serdec_intern_table_destroy(table);
+    serdec_arena_destroy(mapped);
+    serdec_arena_destroy(arena);
+    free(json);
+    free(records);
+}
+
+TEST(dom_snapshot_errors) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    SerdecDocument *doc = NULL, *image = NULL;
+    char path[64];
+    snapshot_path(path, sizeof(path));
+
+    ASSERT_EQ(serdec_document_map(arena, "no/such/file.img", &image),
+              SERDEC_ERR_FILE_NOT_FOUND);
+    ASSERT_EQ(serdec_document_parse(arena, "[1, 2]", 6, NULL, &doc, NULL), SERDEC_OK);
+    ASSERT_EQ(serdec_document_save(doc, "no/such/file.img"), SERDEC_ERR_FILE_NOT_FOUND);
+    ASSERT_EQ(serdec_document_save(NULL, path), SERDEC_ERR_INVALID_HANDLE);
+    ASSERT_EQ(serdec_document_map(NULL, path, &image), SERDEC_ERR_INVALID_HANDLE);
+
+    // Not an image, and a truncated one
+    FILE* fp = fopen(path, "wb");
+    ASSERT_NOT_NULL(fp);
+    for (int i = 0; i < 16; i++) fputs("[1, 2, 3, 4, 5]\n", fp);
+    fclose(fp);
+    ASSERT_EQ(serdec_document_map(arena, path, &image), SERDEC_ERR_IO);
+
+    ASSERT_EQ(serdec_document_save(doc, path), SERDEC_OK);
+    fp = fopen(path, "rb");
+    char bytes[512];
+    size_t size = fread(bytes, 1, sizeof(bytes), fp);
+    fclose(fp);
+    fp = fopen(path, "wb");
+    fwrite(bytes, 1, size - 1, fp);
+    fclose(fp);
+    ASSERT_EQ(serdec_document_map(arena, path, &image), SERDEC_ERR_IO);
+
+    remove(path);
+    serdec_arena_destroy(arena);
+}
+
+// Walks and hashes everything in a mapped image, returning the first error.
+static SerdecError read_all(SerdecArena* arena, const SerdecValue* root) {
+    WalkCounts counts = { 0 };
+    SerdecError status = serdec_value_walk(arena, root, SERDEC_ITER_PREORDER, count_node,
+                                           &counts);
+    (void) serdec_value_hash(root);
+    return status;
+}
+
+TEST(dom_snapshot_damaged) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    SerdecParseConfig config = { .shapes = true, .typed_arrays = true };
+    size_t wide_len;
+    char* wide = make_wide_object(20, &wide_len);
+    char json[1024];
+    size_t len = (size_t) snprintf(json, sizeof(json),
+                                   "[{\"a\": \"x\\ny\", \"b\": [1, 2]}, {\"a\": null, "
+                                   "\"b\": [0.5, true]}, %.*s, \"tail\"]",
+                                   (int) wide_len, wide);
+    free(wide);
+    SerdecDocument *doc = NULL, *image = NULL;
+    char path[64];
+    snapshot_path(path, sizeof(path));
+    ASSERT_EQ(serdec_document_parse(arena, json, len, &config, &doc, NULL), SERDEC_OK);
+    ASSERT_EQ(serdec_document_save(doc, path), SERDEC_OK);
+
+    FILE* fp = fopen(path, "rb");
+    ASSERT_NOT_NULL(fp);
+    fseek(fp, 0, SEEK_END);
+    size_t size = (size_t) ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char* bytes = malloc(size);
+    ASSERT_EQ(fread(bytes, 1, size, fp), size);
+    fclose(fp);
+
+    // Damage each word of the image in turn. Every open or access either fails or
+    // reads within the mapping; the sanitizers catch any that does not.
+    const uint64_t damage[] = { 1, 16, 1u << 12, UINT64_MAX };
+    size_t failures = 0;
+    for (size_t word = 0; word + sizeof(uint64_t) <= size; word += sizeof(uint64_t)) {
+        for (size_t d = 0; d < sizeof(damage) / sizeof(*damage); d++) {
+            uint64_t value;
+            memcpy(&value, bytes + word, sizeof(value));
+            value = (d == 0) ? value ^ damage[d] : value + damage[d];
+            fp = fopen(path, "wb");
+            fwrite(bytes, 1, word, fp);
+            fwrite(&value, sizeof(value), 1, fp);
+            fwrite(bytes + word + sizeof(value), 1, size - word - sizeof(value), fp);
+            fclose(fp);
+
+            SerdecArena* mapped = serdec_arena_create(NULL);
+            SerdecError status = serdec_document_map(mapped, path, &image);
+            if (status == SERDEC_OK) {
+                status = read_all(mapped, serdec_document_root(image));
+                serdec_document_destroy(image);
+            }
+            failures += status != SERDEC_OK;
+            serdec_arena_destroy(mapped);
+        }
+    }
+    ASSERT(failures > 0);
+
+    // A string past the pool is reported when its container is expanded
+    fp = fopen(path, "wb");
+    fwrite(bytes, 1, size, fp);
+    fclose(fp);
+    SerdecArena* mapped = serdec_arena_create(NULL);
+    ASSERT_EQ(serdec_document_map(mapped, path, &image), SERDEC_OK);
+    ASSERT_EQ(read_all(mapped, serdec_document_root(image)), SERDEC_OK);
+    serdec_document_destroy(image);
+
+    // The root's block comes first, so the first four-byte string is "tail"
+    const uint64_t tag = serdec_tag(SERDEC_TYPE_STRING, 0, 4);
+    size_t node = 0;
+    while (memcmp(bytes + node, &tag, sizeof(tag)) != 0) node += sizeof(SerdecValue);
+    uint64_t past = size;
+    memcpy(bytes + node + sizeof(tag), &past, sizeof(past));
+    fp = fopen(path, "wb");
+    fwrite(bytes, 1, size, fp);
+    fclose(fp);
+    ASSERT_EQ(serdec_document_map(mapped, path, &image), SERDEC_OK);
+    ASSERT_EQ(read_all(mapped, serdec_document_root(image)), SERDEC_ERR_IO);
+    serdec_document_destroy(image);
+    serdec_arena_destroy(mapped);
+
+    free(bytes);
+    remove(path);
+    serdec_arena_destroy(arena);
+}
+
+// --- Selective DOM ---
+
+typedef struct {
+    size_t calls;
+    size_t paths[16];
+    const SerdecValue* values[16];
+} Matches;
+
+static SerdecError on_match(void* user, size_t path, const SerdecValue* value) {
+    Matches* m = (Matches*) user;
+    if (m->calls < 16) {
+        m->paths[m->calls] = path;
+        m->values[m->calls] = value;
+    }
+    m->calls++;
+    return SERDEC_OK;
+}
+
+static const char* select_doc =
+    "{\"meta\": {\"skip\": [1, 2, {\"deep\": \"]}\"}]},"
+    " \"users\": [{\"name\": \"ann\", \"age\": 31}, {\"name\": \"bob\", \"tags\": [\"x\"]}],"
+    " \"count\": 2}";
+
+TEST(dom_select_paths) {
+    SerdecParser* parser = serdec_json_parser_create(select_doc, strlen(select_doc));
+    SerdecArena* arena = serdec_arena_create(NULL);
+    const char* paths[] = { "$.users[*].name", "$.count", "$.users[1].tags[0]" };
+    Matches m = { 0 };
+
+    ASSERT_EQ(serdec_json_select(parser, arena, paths, 3, on_match, &m), SERDEC_OK);
+    ASSERT_EQ(m.calls, 4);
+    ASSERT_EQ(m.paths[0], 0);
+    ASSERT(string_is(m.values[0], "ann"));
+    ASSERT_EQ(m.paths[1], 0);
+    ASSERT(string_is(m.values[1], "bob"));
+    ASSERT_EQ(m.paths[2], 2);
+    ASSERT(string_is(m.values[2], "x"));
+    ASSERT_EQ(m.paths[3], 1);
+
+    uint64_t count;
+    ASSERT_EQ(serdec_as_uint64(m.values[3], &count), SERDEC_OK);
+    ASSERT_EQ(count, 2);
+
+    serdec_arena_destroy(arena);
+    serdec_json_parser_destroy(parser);
+}
+
+TEST(dom_select_nested_paths) {
+    SerdecParser* parser = serdec_json_parser_create(select_doc, strlen(select_doc));
+    SerdecArena* arena = serdec_arena_create(NULL);
+    const char* paths[] = { "$.users[0].age", "$.users" };
+    Matches m = { 0 };
+
+    ASSERT_EQ(serdec_json_select(parser, arena, paths, 2, on_match, &m), SERDEC_OK);
+    ASSERT_EQ(m.calls, 2);
+    ASSERT_EQ(m.paths[0], 1);
+    ASSERT_EQ(serdec_value_type(m.values[0]), SERDEC_TYPE_ARRAY);
+    ASSERT_EQ(m.paths[1], 0);
+    ASSERT_EQ(serdec_value_type(m.values[1]), SERDEC_TYPE_NUMBER);
+
+    serdec_arena_destroy(arena);
+    serdec_json_parser_destroy(parser);
+}
+
+TEST(dom_select_root_and_errors) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    Matches m = { 0 };
+
+    SerdecParser* parser = serdec_json_parser_create("[1, 2]", 6);
+    const char* root[] = { "$" };
+    ASSERT_EQ(serdec_json_select(parser, arena, root, 1, on_match, &m), SERDEC_OK);
+    ASSERT_EQ(m.calls, 1);
+    ASSERT_EQ(serdec_value_size(m.values[0]), 2);
+    serdec_json_parser_destroy(parser);
+
+    // Errors after the last match still surface
+    parser = serdec_json_parser_create("{\"a\": 1, \"b\": [} ", 17);
+    const char* a[] = { "$.a" };
+    ASSERT_EQ(serdec_json_select(parser, arena, a, 1, on_match, &m),
+              SERDEC_ERR_UNEXPECTED_CHAR);
+    serdec_json_parser_destroy(parser);
+
+    parser = serdec_json_parser_create("{}", 2);
+    const char* bad[] = { "$.a[x]" };
+    ASSERT_EQ(serdec_json_select(parser, arena, bad, 1, on_match, &m), SERDEC_ERR_INVALID_PATH);
+    const char* empty_key[] = { "$..a" };
+    ASSERT_EQ(serdec_json_select(parser, arena, empty_key, 1, on_match, &m),
+              SERDEC_ERR_INVALID_PATH);
+    serdec_json_parser_destroy(parser);
+
+    serdec_arena_destroy(arena);
+}
+
+TEST(dom_null_safety) {
+    const SerdecValue* v;
+    SerdecString s;
+    ASSERT_EQ(serdec_parse(NULL, "1", 1, &v, NULL), SERDEC_ERR_INVALID_HANDLE);
+    ASSERT_EQ(serdec_get(NULL, "a", &v), SERDEC_ERR_INVALID_HANDLE);
+    ASSERT_EQ(serdec_index(NULL, 0, &v), SERDEC_ERR_INVALID_HANDLE);
+    ASSERT_EQ(serdec_as_string(NULL, &s), SERDEC_ERR_INVALID_HANDLE);
+    ASSERT_EQ(serdec_value_type(NULL), SERDEC_TYPE_NULL);
+    ASSERT_EQ(serdec_value_size(NULL), 0);
+    ASSERT_EQ(serdec_json_select(NULL, NULL, NULL, 0, on_match, NULL), SERDEC_ERR_INVALID_HANDLE);
+}
+
+int test_dom(void) {
+    printf("\n  DOM tests:\n");
+
+    RUN(dom_object_lookup);
+    RUN(dom_numbers);
+    RUN(dom_escaped_keys_decoded);
+    RUN(dom_type_mismatch);
+    RUN(dom_parse_error);
+    RUN(dom_contiguous_children);
+    RUN(dom_node_size);
+    RUN(dom_document_max_depth);
+    RUN(dom_exact_measure);
+    RUN(dom_exact_matches_incremental);
+    RUN(dom_exact_single_allocation);
+    RUN(dom_index_large_object);
+    RUN(dom_index_threshold);
+    RUN(dom_duplicates_policies);
+    RUN(dom_duplicates_wide_and_lazy);
+    RUN(dom_intern_table);
+    RUN(dom_intern_shared_between_documents);
+    RUN(dom_intern_large_object);
+    RUN(dom_shapes_records);
+    RUN(dom_shapes_distinct_and_large);
+    RUN(dom_shapes_with_interned_keys);
+    RUN(dom_typed_arrays);
+    RUN(dom_typed_arrays_memory);
+    RUN(dom_lazy_expands_on_access);
+    RUN(dom_lazy_skips_untouched);
+    RUN(dom_lazy_errors);
+    RUN(dom_freeze);
+    RUN(dom_freeze_concurrent_reads);
+    RUN(dom_edit_object);
+    RUN(dom_edit_large_and_shaped_objects);
+    RUN(dom_edit_array);
+    RUN(dom_edit_append_in_place);
+    RUN(dom_edit_object_append_in_place);
+    RUN(dom_clone_copy_strings);
+    RUN(dom_clone_keeps_layout);
+    RUN(dom_equal_by_content);
+    RUN(dom_equal_across_layouts);
+    RUN(dom_iter_orders);
+    RUN(dom_iter_child_storage);
+    RUN(dom_walk_deep_and_lazy);
+    RUN(dom_stats_counts);
+    RUN(dom_stats_layouts);
+    RUN(dom_snapshot_round_trip);
+    RUN(dom_snapshot_layouts);
+    RUN(dom_snapshot_errors);
+    RUN(dom_snapshot_damaged);
+    RUN(dom_select_paths);
+    RUN(dom_select_nested_paths);
+    RUN(dom_select_root_and_errors);
+    RUN(dom_null_safety);
+
+    TEST_SUMMARY();
+}
@@ -11,6 +11,7 @@ TEST(error_string_codes) {
     ASSERT(strstr(serdec_error_string(SERDEC_ERR_UNEXPECTED_EOF), "EOF") != NULL);
     ASSERT(strstr(serdec_error_string(SERDEC_ERR_INVALID_VALUE), "Value") != NULL);
     ASSERT(strstr(serdec_error_string(SERDEC_ERR_TRAILING_CHARS), "Trailing") != NULL);
+    ASSERT(strstr(serdec_error_string(SERDEC_ERR_DUPLICATE_KEY), "Duplicate") != NULL);
 
     // String errors
     ASSERT(strstr(serdec_error_string(SERDEC_ERR_INVALID_ESCAPE), "Escape") != NULL);
@@ -32,6 +33,11 @@ TEST(error_string_codes) {
 
     // Handle error
     ASSERT(strstr(serdec_error_string(SERDEC_ERR_INVALID_HANDLE), "Handle") != NULL);
+
+    // Query errors
+    ASSERT(strstr(serdec_error_string(SERDEC_ERR_TYPE_MISMATCH), "Type") != NULL);
+    ASSERT(strstr(serdec_error_string(SERDEC_ERR_NOT_FOUND), "Found") != NULL);
+    ASSERT(strstr(serdec_error_string(SERDEC_ERR_INVALID_PATH), "Path") != NULL);
 }
 
 TEST(error_string_unknown) {
@@ -111,6 +117,24 @@ TEST(error_format_null_safety) {
     serdec_error_format(&info, NULL, 0);
 }
 
+TEST(error_list_empty) {
+    SerdecErrorList* list = serdec_error_list_create();
+    ASSERT_NOT_NULL(list);
+    ASSERT_EQ(serdec_error_list_count(list), 0);
+    ASSERT_NULL(serdec_error_list_get(list, 0));
+
+    serdec_error_list_clear(list);
+    ASSERT_EQ(serdec_error_list_count(list), 0);
+    serdec_error_list_destroy(list);
+}
+
+TEST(error_list_null_safety) {
+    ASSERT_EQ(serdec_error_list_count(NULL), 0);
+    ASSERT_NULL(serdec_error_list_get(NULL, 0));
+    serdec_error_list_clear(NULL);
+    serdec_error_list_destroy(NULL);
+}
+
 int test_error(void) {
     printf("\n  Error tests:\n");
 
@@ -122,6 +146,8 @@ int test_error(void) {
     RUN(error_format_empty_fields);
     RUN(error_format_no_overflow);
     RUN(error_format_null_safety);
+    RUN(error_list_empty);
+    RUN(error_list_null_safety);
 
     TEST_SUMMARY();
 }
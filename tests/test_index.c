@@ -0,0 +1,355 @@
+#include "test.h"
+#include <serdec/serdec.h>
+
+static const char document[] =
+    "[{\"a\": [1, 2]}, \"x,]\\\"[\", [3, [4]],\n"
+    " {\"k\": 5, \"m\": {}}, 7]";
+
+static void index_path(char* path, size_t size) {
+    static unsigned calls;
+    int local;
+    snprintf(path, size, "serdec_index_%p_%u.idx", (void*) &local, calls++);
+}
+
+static size_t offset_of(const char* needle) {
+    return (size_t) (strstr(document, needle) - document);
+}
+
+// Pulls the next event, returning its kind.
+static SerdecEventKind next_kind(SerdecParser* parser, SerdecEvent* ev) {
+    if (serdec_json_event_next(parser, ev) != SERDEC_OK) return SERDEC_EVENT_ERROR;
+    return ev->kind;
+}
+
+// Overwrites the 64-bit field at position in a saved index, returning its old value.
+static uint64_t patch_index(const char* path, long position, uint64_t value) {
+    uint64_t old = 0;
+    FILE* fp = fopen(path, "r+b");
+    if (!fp) return 0;
+    fseek(fp, position, SEEK_SET);
+    if (fread(&old, sizeof(old), 1, fp) != 1) old = 0;
+    fseek(fp, position, SEEK_SET);
+    fwrite(&value, sizeof(value), 1, fp);
+    fclose(fp);
+    return old;
+}
+
+TEST(index_offsets) {
+    SerdecBuffer* buf = serdec_buffer_from_string(document, sizeof(document) - 1);
+    SerdecJsonIndex* index;
+    SerdecJsonIndexConfig config = { .depth = 2 };
+    size_t count, offset;
+
+    ASSERT_EQ(serdec_json_index_build(buf, &config, &index), SERDEC_OK);
+    ASSERT_EQ(serdec_json_index_count(index, NULL, 0, &count), SERDEC_OK);
+    ASSERT_EQ(count, 5);
+    ASSERT_EQ(serdec_json_index_offset(index, NULL, 0, &offset), SERDEC_OK);
+    ASSERT_EQ(offset, 0);
+
+    ASSERT_EQ(serdec_json_index_offset(index, (size_t[]) { 0 }, 1, &offset), SERDEC_OK);
+    ASSERT_EQ(offset, 1);
+    ASSERT_EQ(serdec_json_index_offset(index, (size_t[]) { 1 }, 1, &offset), SERDEC_OK);
+    ASSERT_EQ(offset, offset_of("\"x,"));
+    ASSERT_EQ(serdec_json_index_offset(index, (size_t[]) { 2 }, 1, &offset), SERDEC_OK);
+    ASSERT_EQ(offset, offset_of("[3"));
+    ASSERT_EQ(serdec_json_index_offset(index, (size_t[]) { 4 }, 1, &offset), SERDEC_OK);
+    ASSERT_EQ(offset, offset_of("7]"));
+
+    ASSERT_EQ(serdec_json_index_count(index, (size_t[]) { 2 }, 1, &count), SERDEC_OK);
+    ASSERT_EQ(count, 2);
+    ASSERT_EQ(serdec_json_index_offset(index, (size_t[]) { 2, 1 }, 2, &offset), SERDEC_OK);
+    ASSERT_EQ(offset, offset_of("[4"));
+    ASSERT_EQ(serdec_json_index_count(index, (size_t[]) { 3 }, 1, &count), SERDEC_OK);
+    ASSERT_EQ(count, 2);
+    ASSERT_EQ(serdec_json_index_offset(index, (size_t[]) { 3, 1 }, 2, &offset), SERDEC_OK);
+    ASSERT_EQ(offset, offset_of("\"m\""));
+
+    ASSERT_EQ(serdec_json_index_count(index, (size_t[]) { 4 }, 1, &count),
+              SERDEC_ERR_TYPE_MISMATCH);
+    ASSERT_EQ(serdec_json_index_offset(index, (size_t[]) { 1, 0 }, 2, &offset),
+              SERDEC_ERR_TYPE_MISMATCH);
+    ASSERT_EQ(serdec_json_index_offset(index, (size_t[]) { 5 }, 1, &offset),
+              SERDEC_ERR_NOT_FOUND);
+    ASSERT_EQ(serdec_json_index_count(index, (size_t[]) { 2, 1 }, 2, &count),
+              SERDEC_ERR_INVALID_PATH);
+    ASSERT_EQ(serdec_json_index_offset(index, (size_t[]) { 2, 1, 0 }, 3, &offset),
+              SERDEC_ERR_INVALID_PATH);
+
+    serdec_json_index_destroy(index);
+    serdec_buffer_release(buf);
+}
+
+TEST(index_seek) {
+    SerdecBuffer* buf = serdec_buffer_from_string(document, sizeof(document) - 1);
+    SerdecParser* parser = serdec_json_parser_from_buffer(buf);
+    SerdecJsonIndex* index;
+    SerdecJsonIndexConfig config = { .depth = 2 };
+    SerdecEvent ev;
+    ASSERT_EQ(serdec_json_index_build(buf, &config, &index), SERDEC_OK);
+
+    // Element 2 and its later siblings, then END where the root closes
+    ASSERT_EQ(serdec_json_index_seek(index, parser, (size_t[]) { 2 }, 1), SERDEC_OK);
+    ASSERT_EQ(next_kind(parser, &ev), SERDEC_EVENT_START_ARRAY);
+    ASSERT_EQ(ev.offset, offset_of("[3"));
+    ASSERT_EQ(next_kind(parser, &ev), SERDEC_EVENT_NUMBER);
+    ASSERT_EQ(next_kind(parser, &ev), SERDEC_EVENT_START_ARRAY);
+    ASSERT_EQ(next_kind(parser, &ev), SERDEC_EVENT_NUMBER);
+    ASSERT_EQ(next_kind(parser, &ev), SERDEC_EVENT_END_ARRAY);
+    ASSERT_EQ(next_kind(parser, &ev), SERDEC_EVENT_END_ARRAY);
+    ASSERT_EQ(next_kind(parser, &ev), SERDEC_EVENT_START_OBJECT);
+    ASSERT_EQ(next_kind(parser, &ev), SERDEC_EVENT_KEY);
+    ASSERT_EQ(next_kind(parser, &ev), SERDEC_EVENT_NUMBER);
+    ASSERT_EQ(next_kind(parser, &ev), SERDEC_EVENT_KEY);
+    ASSERT_EQ(next_kind(parser, &ev), SERDEC_EVENT_START_OBJECT);
+    ASSERT_EQ(next_kind(parser, &ev), SERDEC_EVENT_END_OBJECT);
+    ASSERT_EQ(next_kind(parser, &ev), SERDEC_EVENT_END_OBJECT);
+    ASSERT_EQ(next_kind(parser, &ev), SERDEC_EVENT_NUMBER);
+    ASSERT(ev.string.len == 1 && ev.string.ptr[0] == '7');
+    ASSERT_EQ(next_kind(parser, &ev), SERDEC_EVENT_END);
+
+    // A member starts with its key and ends where its object closes
+    ASSERT_EQ(serdec_json_index_seek(index, parser, (size_t[]) { 3, 1 }, 2), SERDEC_OK);
+    ASSERT_EQ(next_kind(parser, &ev), SERDEC_EVENT_KEY);
+    ASSERT(ev.string.len == 1 && ev.string.ptr[0] == 'm');
+    ASSERT_EQ(next_kind(parser, &ev), SERDEC_EVENT_START_OBJECT);
+    ASSERT_EQ(next_kind(parser, &ev), SERDEC_EVENT_END_OBJECT);
+    ASSERT_EQ(next_kind(parser, &ev), SERDEC_EVENT_END);
+
+    ASSERT_EQ(serdec_json_index_seek(index, parser, NULL, 0), SERDEC_OK);
+    ASSERT_EQ(next_kind(parser, &ev), SERDEC_EVENT_START_ARRAY);
+    ASSERT_EQ(ev.offset, 0);
+
+    SerdecParser* other = serdec_json_parser_create("[]", 2);
+    ASSERT_EQ(serdec_json_index_seek(index, other, (size_t[]) { 0 }, 1),
+              SERDEC_ERR_INVALID_HANDLE);
+    serdec_json_parser_destroy(other);
+
+    serdec_json_index_destroy(index);
+    serdec_json_parser_destroy(parser);
+    serdec_buffer_release(buf);
+}
+
+TEST(index_large_array) {
+    size_t n = 100000;
+    char* text = malloc(n * 24 + 2);
+    size_t len = 0;
+    text[len++] = '[';
+    for (size_t i = 0; i < n; i++)
+        len += (size_t) sprintf(text + len, "%s{\"id\": %zu}", i ? ",\n" : "", i);
+    text[len++] = ']';
+    SerdecBuffer* buf = serdec_buffer_from_string(text, len);
+    free(text);
+
+    SerdecParser* parser = serdec_json_parser_from_buffer(buf);
+    SerdecJsonIndex* index;
+    SerdecEvent ev;
+    size_t count;
+    ASSERT_EQ(serdec_json_index_build(buf, NULL, &index), SERDEC_OK);
+    ASSERT_EQ(serdec_json_index_count(index, NULL, 0, &count), SERDEC_OK);
+    ASSERT_EQ(count, n);
+
+    ASSERT_EQ(serdec_json_index_seek(index, parser, (size_t[]) { 70000 }, 1), SERDEC_OK);
+    ASSERT_EQ(next_kind(parser, &ev), SERDEC_EVENT_START_OBJECT);
+    ASSERT_EQ(next_kind(parser, &ev), SERDEC_EVENT_KEY);
+    ASSERT_EQ(next_kind(parser, &ev), SERDEC_EVENT_NUMBER);
+    ASSERT(ev.string.len == 5 && memcmp(ev.string.ptr, "70000", 5) == 0);
+
+    // Members of elements are not indexed at depth 1
+    ASSERT_EQ(serdec_json_index_offset(index, (size_t[]) { 0, 0 }, 2, &count),
+              SERDEC_ERR_INVALID_PATH);
+
+    serdec_json_index_destroy(index);
+    serdec_json_parser_destroy(parser);
+    serdec_buffer_release(buf);
+}
+
+TEST(index_seek_long_line) {
+    size_t n = 20000;
+    char* text = malloc(n * 9 + 8);
+    size_t len = 0;
+    text[len++] = '[';
+    for (size_t i = 0; i < n; i++) len += (size_t) sprintf(text + len, "%08zu,", i);
+    len += (size_t) sprintf(text + len, "nul]");
+    SerdecBuffer* buf = serdec_buffer_from_string(text, len);
+    free(text);
+
+    SerdecParser* parser = serdec_json_parser_from_buffer(buf);
+    SerdecJsonIndex* index;
+    SerdecEvent ev;
+    ASSERT_EQ(serdec_json_index_build(buf, NULL, &index), SERDEC_OK);
+
+    // Far into a single line, columns count from the value instead of the line start
+    ASSERT_EQ(serdec_json_index_seek(index, parser, (size_t[]) { n }, 1), SERDEC_OK);
+    ASSERT(serdec_json_event_next(parser, &ev) != SERDEC_OK);
+    const SerdecErrorInfo* info = serdec_json_parser_error(parser);
+    ASSERT_EQ(info->offset, len - 4);
+    ASSERT_EQ(info->line, 1);
+    ASSERT_EQ(info->column, 1);
+
+    serdec_json_index_destroy(index);
+    serdec_json_parser_destroy(parser);
+    serdec_buffer_release(buf);
+}
+
+TEST(index_empty_containers) {
+    const char* cases[] = { "[]", "{}", "[ ]", "{\n}" };
+    SerdecJsonIndex* index;
+    size_t count;
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(*cases); i++) {
+        SerdecBuffer* buf = serdec_buffer_from_string(cases[i], strlen(cases[i]));
+        ASSERT_EQ(serdec_json_index_build(buf, NULL, &index), SERDEC_OK);
+        ASSERT_EQ(serdec_json_index_count(index, NULL, 0, &count), SERDEC_OK);
+        ASSERT_EQ(count, 0);
+        ASSERT_EQ(serdec_json_index_offset(index, (size_t[]) { 0 }, 1, &count),
+                  SERDEC_ERR_NOT_FOUND);
+        serdec_json_index_destroy(index);
+        serdec_buffer_release(buf);
+    }
+
+    // Empty children are counted, and have no children of their own
+    const char* nested = "[[], 1, { }]";
+    SerdecBuffer* buf = serdec_buffer_from_string(nested, strlen(nested));
+    SerdecJsonIndexConfig config = { .depth = 2 };
+    ASSERT_EQ(serdec_json_index_build(buf, &config, &index), SERDEC_OK);
+    ASSERT_EQ(serdec_json_index_count(index, NULL, 0, &count), SERDEC_OK);
+    ASSERT_EQ(count, 3);
+    ASSERT_EQ(serdec_json_index_count(index, (size_t[]) { 0 }, 1, &count), SERDEC_OK);
+    ASSERT_EQ(count, 0);
+    ASSERT_EQ(serdec_json_index_count(index, (size_t[]) { 2 }, 1, &count), SERDEC_OK);
+    ASSERT_EQ(count, 0);
+    ASSERT_EQ(serdec_json_index_offset(index, (size_t[]) { 1 }, 1, &count), SERDEC_OK);
+    ASSERT_EQ(count, 5);
+    serdec_json_index_destroy(index);
+    serdec_buffer_release(buf);
+}
+
+TEST(index_save_load) {
+    char path[64], input[64];
+    index_path(path, sizeof(path));
+    index_path(input, sizeof(input));
+    FILE* fp = fopen(input, "wb");
+    ASSERT_NOT_NULL(fp);
+    fwrite(document, 1, sizeof(document) - 1, fp);
+    fclose(fp);
+
+    SerdecBuffer* buf = serdec_buffer_from_file(input, 0);
+    SerdecJsonIndex* index;
+    SerdecJsonIndex* loaded;
+    SerdecJsonIndexConfig config = { .depth = 2 };
+    size_t a, b;
+    ASSERT_EQ(serdec_json_index_build(buf, &config, &index), SERDEC_OK);
+    ASSERT_EQ(serdec_json_index_save(index, path), SERDEC_OK);
+    ASSERT_EQ(serdec_json_index_load(path, buf, &loaded), SERDEC_OK);
+
+    ASSERT_EQ(serdec_json_index_offset(loaded, (size_t[]) { 3, 1 }, 2, &a), SERDEC_OK);
+    ASSERT_EQ(serdec_json_index_offset(index, (size_t[]) { 3, 1 }, 2, &b), SERDEC_OK);
+    ASSERT_EQ(a, b);
+    ASSERT_EQ(serdec_json_index_count(loaded, (size_t[]) { 2 }, 1, &a), SERDEC_OK);
+    ASSERT_EQ(a, 2);
+
+    SerdecParser* parser = serdec_json_parser_from_buffer(buf);
+    SerdecEvent ev;
+    ASSERT_EQ(serdec_json_index_seek(loaded, parser, (size_t[]) { 4 }, 1), SERDEC_OK);
+    ASSERT_EQ(next_kind(parser, &ev), SERDEC_EVENT_NUMBER);
+    ASSERT_EQ(next_kind(parser, &ev), SERDEC_EVENT_END);
+    serdec_json_parser_destroy(parser);
+    serdec_json_index_destroy(loaded);
+
+    // Another input of the same size is rejected
+    char changed[sizeof(document)];
+    memcpy(changed, document, sizeof(document));
+    changed[sizeof(document) - 2] = ' ';
+    SerdecBuffer* other = serdec_buffer_from_string(changed, sizeof(changed) - 1);
+    ASSERT_EQ(serdec_json_index_load(path, other, &loaded), SERDEC_ERR_IO);
+    ASSERT_NULL(loaded);
+    serdec_buffer_release(other);
+
+    // So is a file pointing outside the input. The 64-byte header is followed by the
+    // containers, each {open, close, first, count}, then the child offsets.
+    const long root = 40, containers = 64, offsets = containers + 4 * 8 * 4;
+    const uint64_t end = sizeof(document) - 1;
+    struct { long position; uint64_t value; } damage[] = {
+        { root, end + 1 },                          // Root past the end
+        { containers + 8, end },                    // Close past the end
+        { containers + 8, 0 },                      // Close before open
+        { containers + 32, 0 },                     // Containers out of order
+        { offsets, end },                           // Child past the end
+        { offsets, 0 },                             // Child outside its brackets
+    };
+    for (size_t i = 0; i < sizeof(damage) / sizeof(*damage); i++) {
+        uint64_t saved = patch_index(path, damage[i].position, damage[i].value);
+        ASSERT_EQ(serdec_json_index_load(path, buf, &loaded), SERDEC_ERR_IO);
+        ASSERT_NULL(loaded);
+        patch_index(path, damage[i].position, saved);
+    }
+    ASSERT_EQ(serdec_json_index_load(path, buf, &loaded), SERDEC_OK);
+    serdec_json_index_destroy(loaded);
+
+    // So is a truncated file
+    fp = fopen(path, "r+b");
+    ASSERT_NOT_NULL(fp);
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fclose(fp);
+    char* bytes = malloc((size_t) size);
+    fp = fopen(path, "rb");
+    ASSERT_EQ(fread(bytes, 1, (size_t) size, fp), (size_t) size);
+    fclose(fp);
+    fp = fopen(path, "wb");
+    fwrite(bytes, 1, (size_t) size - 8, fp);
+    fclose(fp);
+    free(bytes);
+    ASSERT_EQ(serdec_json_index_load(path, buf, &loaded), SERDEC_ERR_IO);
+
+    remove(path);
+    remove(input);
+    ASSERT_EQ(serdec_json_index_load(path, buf, &loaded), SERDEC_ERR_FILE_NOT_FOUND);
+
+    serdec_json_index_destroy(index);
+    serdec_buffer_release(buf);
+}
+
+TEST(index_errors) {
+    SerdecJsonIndex* index;
+    const char* cases[] = { "[1, [2]", "[\"open]", "[1]]", "{\"a\": \"\\\"}" };
+    SerdecError expected[] = {
+        SERDEC_ERR_UNEXPECTED_EOF, SERDEC_ERR_UNEXPECTED_EOF,
+        SERDEC_ERR_UNEXPECTED_CHAR, SERDEC_ERR_UNEXPECTED_EOF,
+    };
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(*cases); i++) {
+        SerdecBuffer* buf = serdec_buffer_from_string(cases[i], strlen(cases[i]));
+        ASSERT_EQ(serdec_json_index_build(buf, NULL, &index), expected[i]);
+        ASSERT_NULL(index);
+        serdec_buffer_release(buf);
+    }
+
+    // A scalar root has nothing to index
+    SerdecBuffer* buf = serdec_buffer_from_string("  42 ", 5);
+    size_t count;
+    ASSERT_EQ(serdec_json_index_build(buf, NULL, &index), SERDEC_OK);
+    ASSERT_EQ(serdec_json_index_count(index, NULL, 0, &count), SERDEC_ERR_TYPE_MISMATCH);
+    ASSERT_EQ(serdec_json_index_offset(index, NULL, 0, &count), SERDEC_OK);
+    ASSERT_EQ(count, 2);
+    serdec_json_index_destroy(index);
+    serdec_buffer_release(buf);
+
+    ASSERT_EQ(serdec_json_index_build(NULL, NULL, &index), SERDEC_ERR_INVALID_HANDLE);
+    ASSERT_EQ(serdec_json_index_count(NULL, NULL, 0, &count), SERDEC_ERR_INVALID_HANDLE);
+    serdec_json_index_destroy(NULL);
+}
+
+int test_index(void) {
+    printf("  Index tests:\n");
+
+    RUN(index_offsets);
+    RUN(index_seek);
+    RUN(index_large_array);
+    RUN(index_seek_long_line);
+    RUN(index_empty_containers);
+    RUN(index_save_load);
+    RUN(index_errors);
+
+    TEST_SUMMARY();
+}
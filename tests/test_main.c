@@ -7,6 +7,13 @@ int test_error(void);
 int test_lexer(void);
 int test_utf8(void);
 int test_string(void);
+int test_parser(void);
+int test_ndjson(void);
+int test_parallel(void);
+int test_dom(void);
+int test_index(void);
+int test_pointer(void);
+int test_query(void);
 
 static int run_all(void) {
       int fail = 0;
@@ -16,6 +23,13 @@ static int run_all(void) {
       fail |= test_lexer();
       fail |= test_utf8();
       fail |= test_string();
+      fail |= test_parser();
+      fail |= test_ndjson();
+      fail |= test_parallel();
+      fail |= test_dom();
+      fail |= test_index();
+      fail |= test_pointer();
+      fail |= test_query();
       return fail;
   }
 
@@ -34,6 +48,13 @@ int main(int argc, char** argv) {
     if (strcmp(name, "lexer") == 0) return test_lexer();
     if (strcmp(name, "utf8") == 0) return test_utf8();
     if (strcmp(name, "string") == 0) return test_string();
+    if (strcmp(name, "parser") == 0) return test_parser();
+    if (strcmp(name, "ndjson") == 0) return test_ndjson();
+    if (strcmp(name, "parallel") == 0) return test_parallel();
+    if (strcmp(name, "dom") == 0) return test_dom();
+    if (strcmp(name, "index") == 0) return test_index();
+    if (strcmp(name, "pointer") == 0) return test_pointer();
+    if (strcmp(name, "query") == 0) return test_query();
     if (strcmp(name, "all") == 0) return run_all();                           
                                                                                 
     fprintf(stderr, "Unknown: %s\n", name);                                   
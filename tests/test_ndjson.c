@@ -0,0 +1,642 @@
+#include "test.h"
+#include <serdec/serdec.h>
+#include <pthread.h>
+
+typedef struct {
+    pthread_mutex_t lock;
+    size_t records;
+    size_t events;
+    size_t line_sum;
+    size_t last_line;
+    int out_of_order;
+    size_t stop_at_line;
+} Collector;
+
+static SerdecError collect(void* user, const SerdecNdjsonRecord* record) {
+    Collector* c = (Collector*) user;
+
+    pthread_mutex_lock(&c->lock);
+    if (record->line <= c->last_line) c->out_of_order++;
+    c->last_line = record->line;
+    c->records++;
+    c->events += record->count;
+    c->line_sum += record->line;
+    pthread_mutex_unlock(&c->lock);
+
+    if (c->stop_at_line && record->line == c->stop_at_line) return SERDEC_ERR_IO;
+    return SERDEC_OK;
+}
+
+// Builds n records of the form {"id":i,"tags":["a","b"]}, one per line.
+static SerdecBuffer* make_records(size_t n) {
+    size_t cap = n * 48 + 1;
+    char* text = malloc(cap);
+    size_t len = 0;
+    for (size_t i = 0; i < n; i++)
+        len += snprintf(text + len, cap - len, "{\"id\":%zu,\"tags\":[\"a\",\"b\"]}\n", i);
+
+    SerdecBuffer* buf = serdec_buffer_from_string(text, len);
+    free(text);
+    return buf;
+}
+
+// Like make_records, but every line where i % 250 == 7 is missing a colon.
+static SerdecBuffer* make_bad_records(size_t n) {
+    size_t cap = n * 48 + 1;
+    char* text = malloc(cap);
+    size_t len = 0;
+    for (size_t i = 0; i < n; i++) {
+        const char* fmt = (i % 250 == 7) ? "{\"id\" %zu,\"tags\":[\"a\",\"b\"]}\n"
+                                         : "{\"id\":%zu,\"tags\":[\"a\",\"b\"]}\n";
+        len += snprintf(text + len, cap - len, fmt, i);
+    }
+
+    SerdecBuffer* buf = serdec_buffer_from_string(text, len);
+    free(text);
+    return buf;
+}
+
+static void collector_init(Collector* c) {
+    memset(c, 0, sizeof(*c));
+    pthread_mutex_init(&c->lock, NULL);
+}
+
+TEST(ndjson_unordered) {
+    SerdecBuffer* buf = make_records(2000);
+    SerdecNdjsonConfig cfg = { .threads = 4, .chunk_size = 512 };
+    Collector c;
+    collector_init(&c);
+
+    ASSERT_EQ(serdec_ndjson_parallel(buf, &cfg, collect, &c, NULL), SERDEC_OK);
+    ASSERT_EQ(c.records, 2000);
+    ASSERT_EQ(c.events, 2000 * 9);
+    ASSERT_EQ(c.line_sum, 2000 * 2001 / 2);
+
+    serdec_buffer_release(buf);
+}
+
+TEST(ndjson_ordered) {
+    SerdecBuffer* buf = make_records(2000);
+    SerdecNdjsonConfig cfg = { .threads = 4, .chunk_size = 256, .ordered = true };
+    Collector c;
+    collector_init(&c);
+
+    ASSERT_EQ(serdec_ndjson_parallel(buf, &cfg, collect, &c, NULL), SERDEC_OK);
+    ASSERT_EQ(c.records, 2000);
+    ASSERT_EQ(c.out_of_order, 0);
+    ASSERT_EQ(c.last_line, 2000);
+
+    serdec_buffer_release(buf);
+}
+
+TEST(ndjson_blank_lines_and_crlf) {
+    const char* text = "{\"a\":1}\r\n\n  \n[2]\n\"x\"";
+    SerdecBuffer* buf = serdec_buffer_from_string(text, strlen(text));
+    SerdecNdjsonConfig cfg = { .threads = 2, .ordered = true };
+    Collector c;
+    collector_init(&c);
+
+    ASSERT_EQ(serdec_ndjson_parallel(buf, &cfg, collect, &c, NULL), SERDEC_OK);
+    ASSERT_EQ(c.records, 3);
+    ASSERT_EQ(c.line_sum, 1 + 4 + 5);
+
+    serdec_buffer_release(buf);
+}
+
+TEST(ndjson_parse_error_location) {
+    const char* text = "{\"a\":1}\n{\"a\":2}\n{\"a\" 3}\n{\"a\":4}\n";
+    SerdecBuffer* buf = serdec_buffer_from_string(text, strlen(text));
+    SerdecNdjsonConfig cfg = { .threads = 2, .chunk_size = 8, .ordered = true };
+    SerdecErrorInfo err;
+    Collector c;
+    collector_init(&c);
+
+    ASSERT_EQ(serdec_ndjson_parallel(buf, &cfg, collect, &c, &err), SERDEC_ERR_UNEXPECTED_CHAR);
+    ASSERT_EQ(err.line, 3);
+    ASSERT_EQ(err.offset, 21);
+    ASSERT_EQ(c.records, 2);
+
+    serdec_buffer_release(buf);
+}
+
+TEST(ndjson_record_must_be_single_value) {
+    const char* text = "{} {}\n";
+    SerdecBuffer* buf = serdec_buffer_from_string(text, strlen(text));
+    SerdecErrorInfo err;
+    Collector c;
+    collector_init(&c);
+
+    ASSERT_EQ(serdec_ndjson_parallel(buf, NULL, collect, &c, &err), SERDEC_ERR_TRAILING_CHARS);
+    ASSERT_EQ(err.line, 1);
+
+    serdec_buffer_release(buf);
+}
+
+TEST(ndjson_callback_stops) {
+    SerdecBuffer* buf = make_records(500);
+    SerdecNdjsonConfig cfg = { .threads = 3, .chunk_size = 300, .ordered = true };
+    SerdecErrorInfo err;
+    Collector c;
+    collector_init(&c);
+    c.stop_at_line = 100;
+
+    ASSERT_EQ(serdec_ndjson_parallel(buf, &cfg, collect, &c, &err), SERDEC_ERR_IO);
+    ASSERT_EQ(err.line, 100);
+    ASSERT_EQ(c.records, 100);
+
+    serdec_buffer_release(buf);
+}
+
+TEST(ndjson_recovery_unordered) {
+    SerdecBuffer* buf = make_bad_records(2000);
+    SerdecErrorList* errors = serdec_error_list_create();
+    SerdecNdjsonConfig cfg = { .threads = 4, .chunk_size = 512, .errors = errors };
+    Collector c;
+    collector_init(&c);
+
+    ASSERT_EQ(serdec_ndjson_parallel(buf, &cfg, collect, &c, NULL), SERDEC_OK);
+    ASSERT_EQ(c.records, 2000 - 8);
+    ASSERT_EQ(c.events, (2000 - 8) * 9);
+    ASSERT_EQ(serdec_error_list_count(errors), 8);
+
+    for (size_t i = 0; i < 8; i++) {
+        const SerdecErrorInfo* e = serdec_error_list_get(errors, i);
+        ASSERT_EQ(e->code, SERDEC_ERR_UNEXPECTED_CHAR);
+        ASSERT_EQ(e->line, i * 250 + 8);
+        ASSERT(strstr(e->context, "{\"id\" ") != NULL);
+    }
+
+    serdec_error_list_destroy(errors);
+    serdec_buffer_release(buf);
+}
+
+TEST(ndjson_recovery_ordered) {
+    const char* text = "{\"a\":1}\n{\"a\" 2}\n[3]\n[4,]\n\"five\"\n";
+    SerdecBuffer* buf = serdec_buffer_from_string(text, strlen(text));
+    SerdecErrorList* errors = serdec_error_list_create();
+    SerdecNdjsonConfig cfg = { .threads = 2, .chunk_size = 8, .ordered = true,
+                               .errors = errors };
+    Collector c;
+    collector_init(&c);
+
+    ASSERT_EQ(serdec_ndjson_parallel(buf, &cfg, collect, &c, NULL), SERDEC_OK);
+    ASSERT_EQ(c.records, 3);
+    ASSERT_EQ(c.out_of_order, 0);
+    ASSERT_EQ(c.line_sum, 1 + 3 + 5);
+
+    ASSERT_EQ(serdec_error_list_count(errors), 2);
+    ASSERT_EQ(serdec_error_list_get(errors, 0)->line, 2);
+    ASSERT_EQ(serdec_error_list_get(errors, 0)->offset, 13);
+    ASSERT(strcmp(serdec_error_list_get(errors, 0)->context, "{\"a\" 2}") == 0);
+    ASSERT_EQ(serdec_error_list_get(errors, 1)->line, 4);
+
+    serdec_error_list_destroy(errors);
+    serdec_buffer_release(buf);
+}
+
+TEST(ndjson_recovery_max_errors) {
+    SerdecBuffer* buf = make_bad_records(2000);
+    SerdecErrorList* errors = serdec_error_list_create();
+    // One worker: with several, which errors fill the list first is timing-dependent
+    SerdecNdjsonConfig cfg = { .threads = 1, .chunk_size = 300, .ordered = true,
+                               .errors = errors, .max_errors = 3 };
+    SerdecErrorInfo err;
+    Collector c;
+    collector_init(&c);
+
+    ASSERT_EQ(serdec_ndjson_parallel(buf, &cfg, collect, &c, &err), SERDEC_ERR_UNEXPECTED_CHAR);
+    ASSERT_EQ(err.line, 3 * 250 + 8);
+    ASSERT_EQ(serdec_error_list_count(errors), 3);
+    ASSERT_EQ(c.records, 3 * 250 + 7 - 3);
+
+    // The limit applies to errors added by each call, not to the whole list
+    collector_init(&c);
+    ASSERT_EQ(serdec_ndjson_parallel(buf, &cfg, collect, &c, &err), SERDEC_ERR_UNEXPECTED_CHAR);
+    ASSERT_EQ(err.line, 3 * 250 + 8);
+    ASSERT_EQ(serdec_error_list_count(errors), 6);
+
+    serdec_error_list_destroy(errors);
+    serdec_buffer_release(buf);
+}
+
+#define RS "\x1E"
+
+TEST(ndjson_json_seq) {
+    const char* text = RS "{\"a\":1}\n" RS RS "[2,\n3]\n" RS "\"x\"\n" RS "4\n";
+    SerdecBuffer* buf = serdec_buffer_from_string(text, strlen(text));
+    SerdecNdjsonConfig cfg = { .threads = 2, .chunk_size = 4, .ordered = true,
+                               .framing = SERDEC_FRAMING_JSON_SEQ };
+    Collector c;
+    collector_init(&c);
+
+    ASSERT_EQ(serdec_ndjson_parallel(buf, &cfg, collect, &c, NULL), SERDEC_OK);
+    ASSERT_EQ(c.records, 4);
+    ASSERT_EQ(c.events, 4 + 4 + 1 + 1);
+    ASSERT_EQ(c.line_sum, 1 + 2 + 4 + 5);
+
+    serdec_buffer_release(buf);
+}
+
+TEST(ndjson_json_seq_truncated_number) {
+    const char* text = RS "{\"a\":1}\n" RS "12" RS "[3]\n";
+    SerdecBuffer* buf = serdec_buffer_from_string(text, strlen(text));
+    SerdecErrorList* errors = serdec_error_list_create();
+    SerdecNdjsonConfig cfg = { .framing = SERDEC_FRAMING_JSON_SEQ, .errors = errors };
+    Collector c;
+    collector_init(&c);
+
+    ASSERT_EQ(serdec_ndjson_parallel(buf, &cfg, collect, &c, NULL), SERDEC_OK);
+    ASSERT_EQ(c.records, 2);
+    ASSERT_EQ(serdec_error_list_count(errors), 1);
+    ASSERT_EQ(serdec_error_list_get(errors, 0)->code, SERDEC_ERR_UNEXPECTED_EOF);
+    ASSERT_EQ(serdec_error_list_get(errors, 0)->offset, 10);
+    ASSERT_EQ(serdec_error_list_get(errors, 0)->column, 2);
+
+    serdec_error_list_destroy(errors);
+    serdec_buffer_release(buf);
+}
+
+// Concatenated records with structural characters inside strings, mixed separators
+static SerdecBuffer* make_concat(size_t n) {
+    size_t cap = n * 64 + 1;
+    char* text = malloc(cap);
+    size_t len = 0;
+    for (size_t i = 0; i < n; i++) {
+        const char* fmt = (i % 3 == 0) ? "{\"id\":%zu,\"s\":\"}{ \\\"[\"}"
+                        : (i % 3 == 1) ? "[%zu,\"] [\"]\n"
+                                       : " %zu ";
+        len += snprintf(text + len, cap - len, fmt, i);
+    }
+
+    SerdecBuffer* buf = serdec_buffer_from_string(text, len);
+    free(text);
+    return buf;
+}
+
+TEST(ndjson_concat) {
+    SerdecBuffer* buf = make_concat(3000);
+    SerdecNdjsonConfig cfg = { .threads = 4, .chunk_size = 256, .ordered = true,
+                               .framing = SERDEC_FRAMING_CONCAT };
+    Collector c;
+    collector_init(&c);
+
+    ASSERT_EQ(serdec_ndjson_parallel(buf, &cfg, collect, &c, NULL), SERDEC_OK);
+    ASSERT_EQ(c.records, 3000);
+    ASSERT_EQ(c.events, 1000 * 6 + 1000 * 4 + 1000 * 1);
+    ASSERT_EQ(c.line_sum, 1502500);  // Lines hold 3 records each, the first two and last one
+    ASSERT_EQ(c.last_line, 1001);
+
+    serdec_buffer_release(buf);
+}
+
+TEST(ndjson_concat_recovery) {
+    const char* text = "{\"a\":1}{\"a\" 2}[3]\n tru [4,\"]\"]\n5";
+    SerdecBuffer* buf = serdec_buffer_from_string(text, strlen(text));
+    SerdecErrorList* errors = serdec_error_list_create();
+    SerdecNdjsonConfig cfg = { .threads = 2, .chunk_size = 8, .ordered = true,
+                               .framing = SERDEC_FRAMING_CONCAT, .errors = errors };
+    Collector c;
+    collector_init(&c);
+
+    ASSERT_EQ(serdec_ndjson_parallel(buf, &cfg, collect, &c, NULL), SERDEC_OK);
+    ASSERT_EQ(c.records, 4);
+    ASSERT_EQ(c.line_sum, 1 + 1 + 2 + 3);
+    ASSERT_EQ(serdec_error_list_count(errors), 2);
+    ASSERT_EQ(serdec_error_list_get(errors, 0)->offset, 12);
+    ASSERT_EQ(serdec_error_list_get(errors, 1)->line, 2);
+    ASSERT_EQ(serdec_error_list_get(errors, 1)->column, 2);
+
+    serdec_error_list_destroy(errors);
+    serdec_buffer_release(buf);
+}
+
+TEST(ndjson_empty_input) {
+    SerdecBuffer* buf = serdec_buffer_from_string("", 0);
+    Collector c;
+    collector_init(&c);
+
+    ASSERT_EQ(serdec_ndjson_parallel(buf, NULL, collect, &c, NULL), SERDEC_OK);
+    ASSERT_EQ(c.records, 0);
+
+    serdec_buffer_release(buf);
+}
+
+TEST(ndjson_null_safety) {
+    ASSERT_EQ(serdec_ndjson_parallel(NULL, NULL, collect, NULL, NULL), SERDEC_ERR_INVALID_HANDLE);
+}
+
+// --- Line index ---
+
+TEST(ndjson_index_records) {
+    const char* text = "{\"a\":1}\r\n\n  \n[2]\n\"x\"";
+    SerdecBuffer* buf = serdec_buffer_from_string(text, strlen(text));
+    SerdecParser* parser = serdec_json_parser_from_buffer(buf);
+    SerdecNdjsonIndex* index;
+    SerdecNdjsonSpan span;
+    SerdecEvent ev;
+
+    ASSERT_EQ(serdec_ndjson_index_build(buf, &index), SERDEC_OK);
+    ASSERT_EQ(serdec_ndjson_index_count(index), 3);
+    ASSERT_EQ(serdec_ndjson_index_record(index, 0, &span), SERDEC_OK);
+    ASSERT(span.offset == 0 && span.length == 13 && span.line == 1);
+    ASSERT_EQ(serdec_ndjson_index_record(index, 1, &span), SERDEC_OK);
+    ASSERT(span.offset == 13 && span.length == 4 && span.line == 4);
+    ASSERT_EQ(serdec_ndjson_index_record(index, 2, &span), SERDEC_OK);
+    ASSERT(span.offset == 17 && span.length == 3 && span.line == 5);
+    ASSERT_EQ(serdec_ndjson_index_record(index, 3, &span), SERDEC_ERR_NOT_FOUND);
+
+    ASSERT_EQ(serdec_ndjson_index_seek(index, parser, 1), SERDEC_OK);
+    ASSERT_EQ(serdec_json_event_next(parser, &ev), SERDEC_OK);
+    ASSERT_EQ(ev.kind, SERDEC_EVENT_START_ARRAY);
+    ASSERT_EQ(ev.offset, 13);
+    ASSERT_EQ(serdec_json_event_next(parser, &ev), SERDEC_OK);
+    ASSERT_EQ(serdec_json_event_next(parser, &ev), SERDEC_OK);
+    ASSERT_EQ(serdec_json_event_next(parser, &ev), SERDEC_OK);
+    ASSERT_EQ(ev.kind, SERDEC_EVENT_END);
+
+    serdec_ndjson_index_destroy(index);
+    serdec_json_parser_destroy(parser);
+    serdec_buffer_release(buf);
+}
+
+TEST(ndjson_index_random_access) {
+    size_t n = 50000;
+    SerdecBuffer* buf = make_records(n);
+    SerdecParser* parser = serdec_json_parser_from_buffer(buf);
+    SerdecNdjsonIndex* index;
+    SerdecNdjsonSpan span;
+    SerdecEvent ev;
+    char expected[16];
+
+    ASSERT_EQ(serdec_ndjson_index_build(buf, &index), SERDEC_OK);
+    ASSERT_EQ(serdec_ndjson_index_count(index), n);
+    for (size_t i = 0; i < n; i += 997) {
+        ASSERT_EQ(serdec_ndjson_index_record(index, i, &span), SERDEC_OK);
+        ASSERT_EQ(span.line, i + 1);
+        ASSERT_EQ(serdec_buffer_data(buf)[span.offset + span.length - 1], '\n');
+
+        ASSERT_EQ(serdec_ndjson_index_seek(index, parser, i), SERDEC_OK);
+        for (int k = 0; k < 3; k++) ASSERT_EQ(serdec_json_event_next(parser, &ev), SERDEC_OK);
+        int len = snprintf(expected, sizeof(expected), "%zu", i);
+        ASSERT(ev.string.len == (size_t) len && memcmp(ev.string.ptr, expected, len) == 0);
+    }
+
+    serdec_ndjson_index_destroy(index);
+    serdec_json_parser_destroy(parser);
+    serdec_buffer_release(buf);
+}
+
+TEST(ndjson_index_parallel_range) {
+    size_t n = 20000;
+    SerdecBuffer* buf = make_records(n);
+    SerdecNdjsonIndex* index;
+    ASSERT_EQ(serdec_ndjson_index_build(buf, &index), SERDEC_OK);
+
+    SerdecNdjsonConfig cfg = {
+        .threads = 4, .chunk_size = 4096, .index = index, .first = 5000, .count = 10000,
+    };
+    Collector c;
+    collector_init(&c);
+    ASSERT_EQ(serdec_ndjson_parallel(buf, &cfg, collect, &c, NULL), SERDEC_OK);
+    ASSERT_EQ(c.records, 10000);
+    ASSERT_EQ(c.events, 10000 * 9);
+    ASSERT_EQ(c.line_sum, (5001 + 15000) * 10000 / 2);
+
+    // The rest of the input, in order
+    cfg = (SerdecNdjsonConfig) {
+        .threads = 4, .chunk_size = 1000, .ordered = true, .index = index, .first = 15000,
+    };
+    collector_init(&c);
+    c.last_line = 15000;
+    ASSERT_EQ(serdec_ndjson_parallel(buf, &cfg, collect, &c, NULL), SERDEC_OK);
+    ASSERT_EQ(c.records, 5000);
+    ASSERT_EQ(c.out_of_order, 0);
+    ASSERT_EQ(c.last_line, n);
+
+    cfg = (SerdecNdjsonConfig) { .index = index, .first = 19999, .count = 2 };
+    ASSERT_EQ(serdec_ndjson_parallel(buf, &cfg, collect, &c, NULL), SERDEC_ERR_NOT_FOUND);
+    cfg = (SerdecNdjsonConfig) { .index = index, .framing = SERDEC_FRAMING_CONCAT };
+    ASSERT_EQ(serdec_ndjson_parallel(buf, &cfg, collect, &c, NULL), SERDEC_ERR_INVALID_HANDLE);
+
+    serdec_ndjson_index_destroy(index);
+    serdec_buffer_release(buf);
+}
+
+TEST(ndjson_index_save_load) {
+    size_t n = 10000;
+    SerdecBuffer* buf = make_records(n);
+    SerdecNdjsonIndex* index;
+    SerdecNdjsonIndex* loaded;
+    SerdecNdjsonSpan a, b;
+    char path[64];
+    int local;
+    snprintf(path, sizeof(path), "serdec_lines_%p.idx", (void*) &local);
+
+    ASSERT_EQ(serdec_ndjson_index_build(buf, &index), SERDEC_OK);
+    ASSERT_EQ(serdec_ndjson_index_save(index, path), SERDEC_OK);
+    ASSERT_EQ(serdec_ndjson_index_load(path, buf, &loaded), SERDEC_OK);
+    ASSERT_EQ(serdec_ndjson_index_count(loaded), n);
+    for (size_t i = 0; i < n; i += 101) {
+        ASSERT_EQ(serdec_ndjson_index_record(index, i, &a), SERDEC_OK);
+        ASSERT_EQ(serdec_ndjson_index_record(loaded, i, &b), SERDEC_OK);
+        ASSERT(a.offset == b.offset && a.length == b.length && a.line == b.line);
+    }
+    serdec_ndjson_index_destroy(loaded);
+
+    // Records of about 30 bytes take well under 4 bytes each
+    FILE* fp = fopen(path, "rb");
+    fseek(fp, 0, SEEK_END);
+    ASSERT(ftell(fp) < (long) (n * 4));
+    fclose(fp);
+
+    SerdecBuffer* other = make_records(n - 1);
+    ASSERT_EQ(serdec_ndjson_index_load(path, other, &loaded), SERDEC_ERR_IO);
+    ASSERT_NULL(loaded);
+    serdec_buffer_release(other);
+
+    remove(path);
+    ASSERT_EQ(serdec_ndjson_index_load(path, buf, &loaded), SERDEC_ERR_FILE_NOT_FOUND);
+    serdec_ndjson_index_destroy(index);
+    serdec_buffer_release(buf);
+}
+
+// --- Filter ---
+
+// 1 if json passes the filter, 0 if not, -1 if text does not compile or json fails to parse.
+static int filter_passes(const char* text, const char* json) {
+    SerdecNdjsonFilter* filter;
+    if (serdec_ndjson_filter_compile(text, &filter) != SERDEC_OK) return -1;
+
+    SerdecParser* parser = serdec_json_parser_create(json, strlen(json));
+    bool pass = false;
+    SerdecError status = serdec_ndjson_filter_test(filter, parser, &pass);
+    serdec_json_parser_destroy(parser);
+    serdec_ndjson_filter_destroy(filter);
+    return (status == SERDEC_OK) ? pass : -1;
+}
+
+TEST(ndjson_filter_compile) {
+    const char* valid[] = {
+        "@", "@.a", "@.a == 1", "@['a b'].c != 'x'", "@.a==1&&@.b<=2.5e1", "@.a && @.b",
+        "@ == null", "@.ok == true", "  @.a  ",
+    };
+    const char* invalid[] = {
+        "", "a", "@.", "@[a]", "@['a'", "@.a == ", "@.a == x", "@.a = 1", "@.a &&", "@.a @",
+        "@.a == 1 2", "$.a", "@ .a",
+    };
+    SerdecNdjsonFilter* filter;
+    for (size_t i = 0; i < sizeof(valid) / sizeof(*valid); i++) {
+        ASSERT_EQ(serdec_ndjson_filter_compile(valid[i], &filter), SERDEC_OK);
+        serdec_ndjson_filter_destroy(filter);
+    }
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(*invalid); i++) {
+        ASSERT_EQ(serdec_ndjson_filter_compile(invalid[i], &filter), SERDEC_ERR_INVALID_PATH);
+        ASSERT_NULL(filter);
+    }
+
+    // Up to 64 terms
+    char text[64 * 8 + 1] = "@.a";
+    for (int i = 1; i < 64; i++) strcat(text, " && @.a");
+    ASSERT_EQ(serdec_ndjson_filter_compile(text, &filter), SERDEC_OK);
+    serdec_ndjson_filter_destroy(filter);
+    strcat(text, "&&@");
+    ASSERT_EQ(serdec_ndjson_filter_compile(text, &filter), SERDEC_ERR_INVALID_PATH);
+    ASSERT_EQ(serdec_ndjson_filter_compile(NULL, &filter), SERDEC_ERR_INVALID_HANDLE);
+}
+
+TEST(ndjson_filter_test) {
+    ASSERT_EQ(filter_passes("@.status == 500", "{\"status\":500}"), 1);
+    ASSERT_EQ(filter_passes("@.status == 500", "{\"status\":5e2}"), 1);
+    ASSERT_EQ(filter_passes("@.status == 500", "{\"status\":\"500\"}"), 0);
+    ASSERT_EQ(filter_passes("@.status >= 500", "{\"a\":[1,{}],\"status\":503}"), 1);
+    ASSERT_EQ(filter_passes("@.req.path == '/x'", "{\"req\":{\"path\":\"\\/x\"}}"), 1);
+    ASSERT_EQ(filter_passes("@['a.b'] == null", "{\"a.b\":null}"), 1);
+    ASSERT_EQ(filter_passes("@ == 3", "3"), 1);
+
+    // Missing members, and paths through non-objects
+    ASSERT_EQ(filter_passes("@.a != 1", "{}"), 1);
+    ASSERT_EQ(filter_passes("@.a", "{\"a\":null}"), 1);
+    ASSERT_EQ(filter_passes("@.a.b", "{\"a\":[{\"b\":1}]}"), 0);
+    ASSERT_EQ(filter_passes("@.a < 1", "{\"b\":0}"), 0);
+    ASSERT_EQ(filter_passes("@.a.b != 1", "[1]"), 1);
+
+    // Every term must hold, whatever the member order
+    ASSERT_EQ(filter_passes("@.a == 1 && @.b.c == 'x'", "{\"b\":{\"c\":\"x\"},\"a\":1}"), 1);
+    ASSERT_EQ(filter_passes("@.a == 1 && @.b.c == 'x'", "{\"b\":{\"c\":\"y\"},\"a\":1}"), 0);
+    ASSERT_EQ(filter_passes("@.a && @.a.b == true", "{\"a\":{\"b\":true}}"), 1);
+
+    // A failing term stops the read: the syntax error after it is not reached
+    ASSERT_EQ(filter_passes("@.a == 1", "{\"a\":2,\"b\" 3}"), 0);
+    ASSERT_EQ(filter_passes("@.b == 1", "{\"a\":2,\"b\" 3}"), -1);
+    ASSERT_EQ(filter_passes("@.a == 1", ""), -1);
+}
+
+// Record i is {"id":i,"level":L,"req":{"status":S}}, with level "error" and status 500 for
+// every i % 100 == 3. Every i % 1000 == 503 escapes the "e" of "error".
+static SerdecBuffer* make_log(size_t n) {
+    size_t cap = n * 80 + 1;
+    char* text = malloc(cap);
+    size_t len = 0;
+    for (size_t i = 0; i < n; i++) {
+        bool error = (i % 100 == 3);
+        const char* level = (i % 1000 == 503) ? "\\u0065rror" : error ? "error" : "info";
+        len += snprintf(text + len, cap - len,
+                        "{\"id\":%zu,\"tags\":[\"a\"],\"level\":\"%s\",\"req\":{\"status\":%d}}\n",
+                        i, level, error ? 500 : 200);
+    }
+
+    SerdecBuffer* buf = serdec_buffer_from_string(text, len);
+    free(text);
+    return buf;
+}
+
+TEST(ndjson_filter_parallel) {
+    size_t n = 5000;
+    SerdecBuffer* buf = make_log(n);
+    SerdecNdjsonFilter* filter;
+    ASSERT_EQ(serdec_ndjson_filter_compile("@.level == 'error' && @.req.status == 500", &filter),
+              SERDEC_OK);
+
+    SerdecNdjsonConfig cfg = { .threads = 4, .chunk_size = 4096, .ordered = true,
+                               .filter = filter };
+    Collector c;
+    collector_init(&c);
+    ASSERT_EQ(serdec_ndjson_parallel(buf, &cfg, collect, &c, NULL), SERDEC_OK);
+    ASSERT_EQ(c.records, n / 100);
+    ASSERT_EQ(c.events, n / 100 * 15);
+    ASSERT_EQ(c.line_sum, (4 + 4904) * (n / 100) / 2);
+    ASSERT_EQ(c.out_of_order, 0);
+
+    // With an index, over part of the input
+    SerdecNdjsonIndex* index;
+    ASSERT_EQ(serdec_ndjson_index_build(buf, &index), SERDEC_OK);
+    cfg = (SerdecNdjsonConfig) { .index = index, .first = 1000, .count = 1000, .filter = filter };
+    collector_init(&c);
+    ASSERT_EQ(serdec_ndjson_parallel(buf, &cfg, collect, &c, NULL), SERDEC_OK);
+    ASSERT_EQ(c.records, 10);
+    serdec_ndjson_index_destroy(index);
+
+    cfg = (SerdecNdjsonConfig) { .framing = SERDEC_FRAMING_CONCAT, .filter = filter };
+    ASSERT_EQ(serdec_ndjson_parallel(buf, &cfg, collect, &c, NULL), SERDEC_ERR_INVALID_HANDLE);
+    serdec_ndjson_filter_destroy(filter);
+
+    serdec_buffer_release(buf);
+}
+
+TEST(ndjson_filter_errors) {
+    const char* text = "{\"a\":1}\n{\"a\" 1}\n{\"a\":2,\"b\" 1}\n{\"a\":1,\"b\" 1}\n{\"a\":1}\n";
+    SerdecBuffer* buf = serdec_buffer_from_string(text, strlen(text));
+    SerdecNdjsonFilter* filter;
+    ASSERT_EQ(serdec_ndjson_filter_compile("@.a == 1", &filter), SERDEC_OK);
+
+    // Line 3 is rejected before its error; line 4 passes and fails to parse
+    SerdecErrorList* errors = serdec_error_list_create();
+    SerdecNdjsonConfig cfg = { .errors = errors, .filter = filter };
+    Collector c;
+    collector_init(&c);
+    ASSERT_EQ(serdec_ndjson_parallel(buf, &cfg, collect, &c, NULL), SERDEC_OK);
+    ASSERT_EQ(c.records, 2);
+    ASSERT_EQ(c.line_sum, 1 + 5);
+    ASSERT_EQ(serdec_error_list_count(errors), 2);
+    ASSERT_EQ(serdec_error_list_get(errors, 0)->line, 2);
+    ASSERT_EQ(serdec_error_list_get(errors, 1)->line, 4);
+
+    SerdecErrorInfo info;
+    cfg = (SerdecNdjsonConfig) { .threads = 1, .filter = filter };
+    ASSERT_EQ(serdec_ndjson_parallel(buf, &cfg, collect, &c, &info), SERDEC_ERR_UNEXPECTED_CHAR);
+    ASSERT_EQ(info.line, 2);
+
+    serdec_error_list_destroy(errors);
+    serdec_ndjson_filter_destroy(filter);
+    serdec_buffer_release(buf);
+}
+
+int test_ndjson(void) {
+    printf("\n  NDJSON tests:\n");
+
+    RUN(ndjson_unordered);
+    RUN(ndjson_ordered);
+    RUN(ndjson_blank_lines_and_crlf);
+    RUN(ndjson_parse_error_location);
+    RUN(ndjson_record_must_be_single_value);
+    RUN(ndjson_callback_stops);
+    RUN(ndjson_recovery_unordered);
+    RUN(ndjson_recovery_ordered);
+    RUN(ndjson_recovery_max_errors);
+    RUN(ndjson_json_seq);
+    RUN(ndjson_json_seq_truncated_number);
+    RUN(ndjson_concat);
+    RUN(ndjson_concat_recovery);
+    RUN(ndjson_empty_input);
+    RUN(ndjson_null_safety);
+    RUN(ndjson_index_records);
+    RUN(ndjson_index_random_access);
+    RUN(ndjson_index_parallel_range);
+    RUN(ndjson_index_save_load);
+    RUN(ndjson_filter_compile);
+    RUN(ndjson_filter_test);
+    RUN(ndjson_filter_parallel);
+    RUN(ndjson_filter_errors);
+
+    TEST_SUMMARY();
+}
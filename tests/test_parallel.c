@@ -0,0 +1,180 @@
+#include "test.h"
+#include "../src/internal.h"
+#include <serdec/serdec.h>
+
+// Builds a large root array whose strings contain structural characters and escapes.
+static char* make_array(size_t n, size_t* len) {
+    size_t cap = n * 96 + 16;
+    char* text = malloc(cap);
+    size_t pos = 0;
+    text[pos++] = '[';
+    for (size_t i = 0; i < n; i++) {
+        pos += snprintf(text + pos, cap - pos,
+                        "%s{\"id\":%zu,\"s\":\"a,]}[{\\\"q\\\\\",\"n\":[%zu,{\"x\":null}]}",
+                        i ? ",\n " : "", i, i * 3);
+    }
+    text[pos++] = ']';
+    text[pos] = '\0';
+    *len = pos;
+    return text;
+}
+
+// Compares every tape event against a sequential parse of the same buffer.
+static int tape_matches_sequential(SerdecEventTape* tape, SerdecBuffer* buf) {
+    SerdecParser* parser = serdec_json_parser_from_buffer(buf);
+    SerdecEvent ev;
+    int ok = 1;
+
+    for (size_t s = 0; ok && s < serdec_event_tape_segments(tape); s++) {
+        size_t count;
+        const SerdecEvent* events = serdec_event_tape_segment(tape, s, &count);
+        for (size_t i = 0; ok && i < count; i++) {
+            if (serdec_json_event_next(parser, &ev) != SERDEC_OK) ok = 0;
+            else if (ev.kind != events[i].kind || ev.offset != events[i].offset) ok = 0;
+        }
+    }
+    if (ok && (serdec_json_event_next(parser, &ev) != SERDEC_OK || ev.kind != SERDEC_EVENT_END))
+        ok = 0;
+
+    serdec_json_parser_destroy(parser);
+    return ok;
+}
+
+TEST(parallel_array_matches_sequential) {
+    size_t len;
+    char* text = make_array(3000, &len);
+    SerdecBuffer* buf = serdec_buffer_from_string(text, len);
+    SerdecParallelConfig cfg = { .threads = 4, .min_range = 4096 };
+    SerdecEventTape* tape = NULL;
+
+    ASSERT_EQ(serdec_json_parse_parallel(buf, &cfg, &tape, NULL), SERDEC_OK);
+    ASSERT(serdec_event_tape_is_parallel(tape));
+    ASSERT(serdec_event_tape_segments(tape) > 2);
+    ASSERT_EQ(serdec_event_tape_count(tape), 2 + 3000 * 14);
+    ASSERT(tape_matches_sequential(tape, buf));
+
+    serdec_event_tape_destroy(tape);
+    serdec_buffer_release(buf);
+    free(text);
+}
+
+TEST(parallel_error_matches_sequential) {
+    size_t len;
+    char* text = make_array(3000, &len);
+    // Corrupt an element near the middle: "id":<n> becomes "id":+<n>
+    char* bad = strstr(text + len / 2, "\"id\":") + 5;
+    *bad = '+';
+
+    SerdecBuffer* buf = serdec_buffer_from_string(text, len);
+    SerdecParallelConfig cfg = { .threads = 4, .min_range = 4096 };
+    SerdecEventTape* tape = NULL;
+    SerdecErrorInfo err;
+
+    ASSERT_EQ(serdec_json_parse_parallel(buf, &cfg, &tape, &err), SERDEC_ERR_UNEXPECTED_CHAR);
+    ASSERT_NULL(tape);
+    ASSERT_EQ(err.offset, (size_t) (bad - text));
+    ASSERT(err.line > 1);
+
+    serdec_buffer_release(buf);
+    free(text);
+}
+
+TEST(parallel_single_element_falls_back) {
+    // One huge element: no root-level commas to split on
+    size_t n = 20000;
+    char* text = malloc(n * 2 + 8);
+    size_t pos = 0;
+    text[pos++] = '[';
+    text[pos++] = '[';
+    for (size_t i = 0; i < n; i++) {
+        text[pos++] = i ? ',' : ' ';
+        text[pos++] = '1';
+    }
+    text[pos++] = ']';
+    text[pos++] = ']';
+
+    SerdecBuffer* buf = serdec_buffer_from_string(text, pos);
+    SerdecParallelConfig cfg = { .threads = 4, .min_range = 1024 };
+    SerdecEventTape* tape = NULL;
+
+    ASSERT_EQ(serdec_json_parse_parallel(buf, &cfg, &tape, NULL), SERDEC_OK);
+    ASSERT(!serdec_event_tape_is_parallel(tape));
+    ASSERT_EQ(serdec_event_tape_count(tape), n + 4);
+    ASSERT(tape_matches_sequential(tape, buf));
+
+    serdec_event_tape_destroy(tape);
+    serdec_buffer_release(buf);
+    free(text);
+}
+
+TEST(parallel_root_closed_early) {
+    size_t len;
+    char* text = make_array(2000, &len);
+    // "[...], [...]" has a ']' at the end but is two values
+    char* mid = strstr(text + len / 2, ",\n ");
+    mid[0] = ']';
+    mid[1] = ',';
+    mid[2] = '[';
+
+    SerdecBuffer* buf = serdec_buffer_from_string(text, len);
+    SerdecParallelConfig cfg = { .threads = 4, .min_range = 4096 };
+    SerdecEventTape* tape = NULL;
+
+    ASSERT_EQ(serdec_json_parse_parallel(buf, &cfg, &tape, NULL), SERDEC_ERR_TRAILING_CHARS);
+    ASSERT_NULL(tape);
+
+    serdec_buffer_release(buf);
+    free(text);
+}
+
+TEST(parallel_non_array_root) {
+    const char* text = "{\"a\": [1, 2, 3]}";
+    SerdecBuffer* buf = serdec_buffer_from_string(text, strlen(text));
+    SerdecParallelConfig cfg = { .threads = 4, .min_range = 1 };
+    SerdecEventTape* tape = NULL;
+
+    ASSERT_EQ(serdec_json_parse_parallel(buf, &cfg, &tape, NULL), SERDEC_OK);
+    ASSERT(!serdec_event_tape_is_parallel(tape));
+    ASSERT_EQ(serdec_event_tape_count(tape), 8);
+    ASSERT(tape_matches_sequential(tape, buf));
+
+    serdec_event_tape_destroy(tape);
+    serdec_buffer_release(buf);
+}
+
+TEST(parallel_scan_string_state) {
+    const char* text = "[\"a,\\\"]\", {\"b\": [1, 2]}, 3]";
+    SerdecScanState state = { 0 };
+    size_t pos = serdec_scan_find_comma(&state, text, strlen(text), 1);
+    ASSERT_EQ(pos, 8);
+
+    state = (SerdecScanState) { 0 };
+    serdec_scan_advance(&state, text, strlen(text));
+    ASSERT(!state.in_string);
+    ASSERT_EQ(state.depth, 0);
+
+    ASSERT(serdec_scan_escaped_at("a\\\\\\b", 4));
+    ASSERT(!serdec_scan_escaped_at("a\\\\b", 3));
+}
+
+TEST(parallel_null_safety) {
+    SerdecEventTape* tape = NULL;
+    ASSERT_EQ(serdec_json_parse_parallel(NULL, NULL, &tape, NULL), SERDEC_ERR_INVALID_HANDLE);
+    ASSERT_EQ(serdec_event_tape_count(NULL), 0);
+    ASSERT_NULL(serdec_event_tape_segment(NULL, 0, NULL));
+    serdec_event_tape_destroy(NULL);
+}
+
+int test_parallel(void) {
+    printf("\n  Parallel parse tests:\n");
+
+    RUN(parallel_array_matches_sequential);
+    RUN(parallel_error_matches_sequential);
+    RUN(parallel_single_element_falls_back);
+    RUN(parallel_root_closed_early);
+    RUN(parallel_non_array_root);
+    RUN(parallel_scan_string_state);
+    RUN(parallel_null_safety);
+
+    TEST_SUMMARY();
+}
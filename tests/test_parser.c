@@ -0,0 +1,282 @@
+#include "test.h"
+#include <serdec/serdec.h>
+
+static SerdecParser* make_parser(const char* json) {
+    return serdec_json_parser_create(json, strlen(json));
+}
+
+// Pulls the next event and returns its kind.
+static SerdecEventKind next_kind(SerdecParser* parser) {
+    SerdecEvent ev;
+    serdec_json_event_next(parser, &ev);
+    return ev.kind;
+}
+
+// Pulls events until END or ERROR and returns the final status.
+static SerdecError drain(SerdecParser* parser) {
+    SerdecEvent ev;
+    SerdecError status;
+    do {
+        status = serdec_json_event_next(parser, &ev);
+    } while (status == SERDEC_OK && ev.kind != SERDEC_EVENT_END);
+    return status;
+}
+
+// --- Scalars ---
+
+TEST(parser_scalar_root) {
+    SerdecParser* parser = make_parser("  true ");
+    SerdecEvent ev;
+    ASSERT_EQ(serdec_json_event_next(parser, &ev), SERDEC_OK);
+    ASSERT_EQ(ev.kind, SERDEC_EVENT_BOOL);
+    ASSERT(ev.boolean);
+    ASSERT_EQ(ev.offset, 2);
+    ASSERT_EQ(next_kind(parser), SERDEC_EVENT_END);
+    ASSERT_EQ(next_kind(parser), SERDEC_EVENT_END);
+    serdec_json_parser_destroy(parser);
+}
+
+TEST(parser_string_borrowed) {
+    SerdecParser* parser = make_parser("\"a\\nb\"");
+    SerdecEvent ev;
+    ASSERT_EQ(serdec_json_event_next(parser, &ev), SERDEC_OK);
+    ASSERT_EQ(ev.kind, SERDEC_EVENT_STRING);
+    ASSERT_EQ(ev.string.len, 4);
+    ASSERT(ev.string.has_escapes);
+    ASSERT(memcmp(ev.string.ptr, "a\\nb", 4) == 0);
+    ASSERT_EQ(ev.offset, 0);
+    serdec_json_parser_destroy(parser);
+}
+
+TEST(parser_number_raw_slice) {
+    SerdecParser* parser = make_parser("-12.5e3");
+    SerdecEvent ev;
+    ASSERT_EQ(serdec_json_event_next(parser, &ev), SERDEC_OK);
+    ASSERT_EQ(ev.kind, SERDEC_EVENT_NUMBER);
+    ASSERT_EQ(ev.string.len, 7);
+    ASSERT(memcmp(ev.string.ptr, "-12.5e3", 7) == 0);
+    serdec_json_parser_destroy(parser);
+}
+
+// --- Containers ---
+
+TEST(parser_object) {
+    SerdecParser* parser = make_parser("{\"a\": 1, \"b\": [null, false]}");
+    SerdecEvent ev;
+
+    ASSERT_EQ(next_kind(parser), SERDEC_EVENT_START_OBJECT);
+    ASSERT_EQ(serdec_json_event_next(parser, &ev), SERDEC_OK);
+    ASSERT_EQ(ev.kind, SERDEC_EVENT_KEY);
+    ASSERT(ev.string.len == 1 && ev.string.ptr[0] == 'a');
+    ASSERT_EQ(next_kind(parser), SERDEC_EVENT_NUMBER);
+    ASSERT_EQ(next_kind(parser), SERDEC_EVENT_KEY);
+    ASSERT_EQ(next_kind(parser), SERDEC_EVENT_START_ARRAY);
+    ASSERT_EQ(next_kind(parser), SERDEC_EVENT_NULL);
+    ASSERT_EQ(next_kind(parser), SERDEC_EVENT_BOOL);
+    ASSERT_EQ(next_kind(parser), SERDEC_EVENT_END_ARRAY);
+    ASSERT_EQ(next_kind(parser), SERDEC_EVENT_END_OBJECT);
+    ASSERT_EQ(next_kind(parser), SERDEC_EVENT_END);
+    serdec_json_parser_destroy(parser);
+}
+
+TEST(parser_empty_containers) {
+    SerdecParser* parser = make_parser("[{}, []]");
+    ASSERT_EQ(next_kind(parser), SERDEC_EVENT_START_ARRAY);
+    ASSERT_EQ(next_kind(parser), SERDEC_EVENT_START_OBJECT);
+    ASSERT_EQ(next_kind(parser), SERDEC_EVENT_END_OBJECT);
+    ASSERT_EQ(next_kind(parser), SERDEC_EVENT_START_ARRAY);
+    ASSERT_EQ(next_kind(parser), SERDEC_EVENT_END_ARRAY);
+    ASSERT_EQ(next_kind(parser), SERDEC_EVENT_END_ARRAY);
+    ASSERT_EQ(next_kind(parser), SERDEC_EVENT_END);
+    serdec_json_parser_destroy(parser);
+}
+
+// --- Errors ---
+
+TEST(parser_trailing_comma) {
+    SerdecParser* parser = make_parser("[1,]");
+    ASSERT_EQ(drain(parser), SERDEC_ERR_UNEXPECTED_CHAR);
+    ASSERT_EQ(serdec_json_parser_error(parser)->offset, 3);
+    ASSERT_EQ(serdec_json_parser_error(parser)->column, 4);
+    serdec_json_parser_destroy(parser);
+}
+
+TEST(parser_mismatched_bracket) {
+    SerdecParser* parser = make_parser("[1}");
+    ASSERT_EQ(drain(parser), SERDEC_ERR_UNEXPECTED_CHAR);
+    serdec_json_parser_destroy(parser);
+}
+
+TEST(parser_missing_colon) {
+    SerdecParser* parser = make_parser("{\"a\" 1}");
+    ASSERT_EQ(drain(parser), SERDEC_ERR_UNEXPECTED_CHAR);
+    ASSERT_EQ(serdec_json_parser_error(parser)->offset, 5);
+    serdec_json_parser_destroy(parser);
+}
+
+TEST(parser_non_string_key) {
+    SerdecParser* parser = make_parser("{1: 2}");
+    ASSERT_EQ(drain(parser), SERDEC_ERR_UNEXPECTED_CHAR);
+    serdec_json_parser_destroy(parser);
+}
+
+TEST(parser_unexpected_eof) {
+    SerdecParser* parser = make_parser("{\"a\": [1, 2");
+    ASSERT_EQ(drain(parser), SERDEC_ERR_UNEXPECTED_EOF);
+    serdec_json_parser_destroy(parser);
+
+    parser = make_parser("");
+    ASSERT_EQ(drain(parser), SERDEC_ERR_UNEXPECTED_EOF);
+    serdec_json_parser_destroy(parser);
+}
+
+TEST(parser_trailing_chars) {
+    SerdecParser* parser = make_parser("{} {}");
+    ASSERT_EQ(drain(parser), SERDEC_ERR_TRAILING_CHARS);
+    ASSERT_EQ(serdec_json_parser_error(parser)->offset, 3);
+    serdec_json_parser_destroy(parser);
+}
+
+TEST(parser_sequence_mode) {
+    SerdecParser* parser = make_parser("{\"a\":1}[2]\"x\" 3\n{}");
+    serdec_json_parser_set_sequence(parser, true);
+
+    SerdecEventKind expected[] = {
+        SERDEC_EVENT_START_OBJECT, SERDEC_EVENT_KEY, SERDEC_EVENT_NUMBER, SERDEC_EVENT_END_OBJECT,
+        SERDEC_EVENT_START_ARRAY, SERDEC_EVENT_NUMBER, SERDEC_EVENT_END_ARRAY,
+        SERDEC_EVENT_STRING, SERDEC_EVENT_NUMBER,
+        SERDEC_EVENT_START_OBJECT, SERDEC_EVENT_END_OBJECT, SERDEC_EVENT_END,
+    };
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++)
+        ASSERT_EQ(next_kind(parser), expected[i]);
+    serdec_json_parser_destroy(parser);
+}
+
+TEST(parser_sequence_empty_and_errors) {
+    SerdecParser* parser = make_parser("  \n ");
+    serdec_json_parser_set_sequence(parser, true);
+    ASSERT_EQ(next_kind(parser), SERDEC_EVENT_END);
+    serdec_json_parser_destroy(parser);
+
+    parser = make_parser("{} :");
+    serdec_json_parser_set_sequence(parser, true);
+    ASSERT_EQ(drain(parser), SERDEC_ERR_UNEXPECTED_CHAR);
+    ASSERT_EQ(serdec_json_parser_error(parser)->offset, 3);
+    serdec_json_parser_destroy(parser);
+}
+
+TEST(parser_skip_container) {
+    SerdecParser* parser = make_parser("{\"a\": [1, \"]\", {\"b\": 2}],\n \"c\": 3}");
+    SerdecEvent ev;
+    ASSERT_EQ(next_kind(parser), SERDEC_EVENT_START_OBJECT);
+    ASSERT_EQ(next_kind(parser), SERDEC_EVENT_KEY);
+    ASSERT_EQ(next_kind(parser), SERDEC_EVENT_START_ARRAY);
+    ASSERT_EQ(serdec_json_skip(parser), SERDEC_OK);
+
+    ASSERT_EQ(serdec_json_event_next(parser, &ev), SERDEC_OK);
+    ASSERT_EQ(ev.kind, SERDEC_EVENT_KEY);
+    ASSERT_EQ(ev.offset, 27);
+    ASSERT_EQ(next_kind(parser), SERDEC_EVENT_NUMBER);
+    ASSERT_EQ(next_kind(parser), SERDEC_EVENT_END_OBJECT);
+    ASSERT_EQ(next_kind(parser), SERDEC_EVENT_END);
+    serdec_json_parser_destroy(parser);
+}
+
+TEST(parser_skip_errors) {
+    SerdecParser* parser = make_parser("[{\"a\": 1]");
+    ASSERT_EQ(next_kind(parser), SERDEC_EVENT_START_ARRAY);
+    ASSERT_EQ(next_kind(parser), SERDEC_EVENT_START_OBJECT);
+    ASSERT_EQ(serdec_json_skip(parser), SERDEC_ERR_UNEXPECTED_CHAR);
+    ASSERT_EQ(serdec_json_parser_error(parser)->offset, 8);
+    ASSERT_EQ(serdec_json_parser_error(parser)->column, 9);
+    serdec_json_parser_destroy(parser);
+
+    parser = make_parser("{\"a\": [1, 2");
+    ASSERT_EQ(next_kind(parser), SERDEC_EVENT_START_OBJECT);
+    ASSERT_EQ(serdec_json_skip(parser), SERDEC_ERR_UNEXPECTED_EOF);
+    serdec_json_parser_destroy(parser);
+
+    // No-op after a scalar
+    parser = make_parser("1");
+    ASSERT_EQ(next_kind(parser), SERDEC_EVENT_NUMBER);
+    ASSERT_EQ(serdec_json_skip(parser), SERDEC_OK);
+    ASSERT_EQ(next_kind(parser), SERDEC_EVENT_END);
+    serdec_json_parser_destroy(parser);
+}
+
+TEST(parser_lexer_error_propagates) {
+    SerdecParser* parser = make_parser("[01]");
+    ASSERT_EQ(drain(parser), SERDEC_ERR_INVALID_NUMBER);
+    ASSERT_EQ(serdec_json_parser_error(parser)->code, SERDEC_ERR_INVALID_NUMBER);
+    serdec_json_parser_destroy(parser);
+}
+
+TEST(parser_error_is_sticky) {
+    SerdecParser* parser = make_parser("[,]");
+    SerdecEvent ev;
+    ASSERT_EQ(next_kind(parser), SERDEC_EVENT_START_ARRAY);
+    ASSERT_EQ(serdec_json_event_next(parser, &ev), SERDEC_ERR_UNEXPECTED_CHAR);
+    ASSERT_EQ(ev.kind, SERDEC_EVENT_ERROR);
+    ASSERT_EQ(serdec_json_event_next(parser, &ev), SERDEC_ERR_UNEXPECTED_CHAR);
+    ASSERT_EQ(ev.kind, SERDEC_EVENT_ERROR);
+    serdec_json_parser_destroy(parser);
+}
+
+TEST(parser_depth_limit) {
+    char deep[2100];
+    memset(deep, '[', 2000);
+    deep[2000] = '\0';
+    SerdecParser* parser = make_parser(deep);
+    ASSERT_EQ(drain(parser), SERDEC_ERR_DEPTH_LIMIT);
+    serdec_json_parser_destroy(parser);
+}
+
+// --- Buffers ---
+
+TEST(parser_from_buffer_zero_copy) {
+    const char* json = "[\"x\"]";
+    SerdecBuffer* buf = serdec_buffer_from_string(json, strlen(json));
+    SerdecParser* parser = serdec_json_parser_from_buffer(buf);
+    serdec_buffer_release(buf); // parser retains it
+
+    SerdecEvent ev;
+    ASSERT_EQ(next_kind(parser), SERDEC_EVENT_START_ARRAY);
+    ASSERT_EQ(serdec_json_event_next(parser, &ev), SERDEC_OK);
+    ASSERT(ev.string.ptr == serdec_buffer_data(buf) + 2);
+    serdec_json_parser_destroy(parser);
+}
+
+TEST(parser_null_safety) {
+    SerdecEvent ev;
+    ASSERT_EQ(serdec_json_event_next(NULL, &ev), SERDEC_ERR_INVALID_HANDLE);
+    ASSERT_NULL(serdec_json_parser_error(NULL));
+    ASSERT_NULL(serdec_json_parser_from_buffer(NULL));
+    serdec_json_parser_destroy(NULL);
+}
+
+int test_parser(void) {
+    printf("\n  Parser tests:\n");
+
+    RUN(parser_scalar_root);
+    RUN(parser_string_borrowed);
+    RUN(parser_number_raw_slice);
+    RUN(parser_object);
+    RUN(parser_empty_containers);
+    RUN(parser_trailing_comma);
+    RUN(parser_mismatched_bracket);
+    RUN(parser_missing_colon);
+    RUN(parser_non_string_key);
+    RUN(parser_unexpected_eof);
+    RUN(parser_trailing_chars);
+    RUN(parser_sequence_mode);
+    RUN(parser_sequence_empty_and_errors);
+    RUN(parser_skip_container);
+    RUN(parser_skip_errors);
+    RUN(parser_lexer_error_propagates);
+    RUN(parser_error_is_sticky);
+    RUN(parser_depth_limit);
+    RUN(parser_from_buffer_zero_copy);
+    RUN(parser_null_safety);
+
+    TEST_SUMMARY();
+}
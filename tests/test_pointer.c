@@ -0,0 +1,209 @@
+#include "test.h"
+#include <serdec/serdec.h>
+
+// RFC 6901 section 5.
+static const char rfc_document[] =
+    "{\"foo\": [\"bar\", \"baz\"], \"\": 0, \"a/b\": 1, \"c%d\": 2, \"e^f\": 3, \"g|h\": 4,"
+    " \"i\\\\j\": 5, \"k\\\"l\": 6, \" \": 7, \"m~n\": 8}";
+
+static const struct {
+    const char* pointer;
+    const char* number;
+} rfc_numbers[] = {
+    { "/", "0" }, { "/a~1b", "1" }, { "/c%d", "2" }, { "/e^f", "3" }, { "/g|h", "4" },
+    { "/i\\j", "5" }, { "/k\"l", "6" }, { "/ ", "7" }, { "/m~0n", "8" },
+};
+
+// Text of the last event find() returned; the parser's copy of the input does not outlive it.
+static char found[64];
+
+// Resolves text against a fresh parser over json.
+static SerdecError find(const char* json, const char* text, SerdecEvent* ev) {
+    SerdecPointer* pointer;
+    SerdecError status = serdec_pointer_compile(text, &pointer);
+    if (status != SERDEC_OK) return status;
+    SerdecParser* parser = serdec_json_parser_create(json, strlen(json));
+    status = serdec_pointer_find(pointer, parser, ev);
+    if (status == SERDEC_OK &&
+        (ev->kind == SERDEC_EVENT_STRING || ev->kind == SERDEC_EVENT_NUMBER)) {
+        size_t len = ev->string.len < sizeof(found) - 1 ? ev->string.len : sizeof(found) - 1;
+        memcpy(found, ev->string.ptr, len);
+        found[len] = '\0';
+        ev->string.ptr = found;
+    }
+    serdec_json_parser_destroy(parser);
+    serdec_pointer_destroy(pointer);
+    return status;
+}
+
+static SerdecError get(const SerdecValue* root, const char* text, const SerdecValue** out) {
+    SerdecPointer* pointer;
+    SerdecError status = serdec_pointer_compile(text, &pointer);
+    if (status != SERDEC_OK) return status;
+    status = serdec_pointer_get(pointer, root, out);
+    serdec_pointer_destroy(pointer);
+    return status;
+}
+
+TEST(pointer_rfc_examples) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    const SerdecValue* root;
+    const SerdecValue* v;
+    SerdecEvent ev;
+    uint64_t n;
+    ASSERT_EQ(serdec_parse(arena, rfc_document, strlen(rfc_document), &root, NULL), SERDEC_OK);
+
+    ASSERT_EQ(get(root, "", &v), SERDEC_OK);
+    ASSERT(v == root);
+    ASSERT_EQ(get(root, "/foo", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_value_size(v), 2);
+    ASSERT_EQ(get(root, "/foo/0", &v), SERDEC_OK);
+    SerdecString s;
+    ASSERT_EQ(serdec_as_string(v, &s), SERDEC_OK);
+    ASSERT(s.len == 3 && memcmp(s.ptr, "bar", 3) == 0);
+
+    for (size_t i = 0; i < sizeof(rfc_numbers) / sizeof(*rfc_numbers); i++) {
+        ASSERT_EQ(get(root, rfc_numbers[i].pointer, &v), SERDEC_OK);
+        ASSERT_EQ(serdec_as_uint64(v, &n), SERDEC_OK);
+        ASSERT_EQ(n, i);
+
+        ASSERT_EQ(find(rfc_document, rfc_numbers[i].pointer, &ev), SERDEC_OK);
+        ASSERT_EQ(ev.kind, SERDEC_EVENT_NUMBER);
+        ASSERT(ev.string.len == 1 && ev.string.ptr[0] == rfc_numbers[i].number[0]);
+    }
+
+    ASSERT_EQ(find(rfc_document, "", &ev), SERDEC_OK);
+    ASSERT_EQ(ev.kind, SERDEC_EVENT_START_OBJECT);
+    ASSERT_EQ(find(rfc_document, "/foo/1", &ev), SERDEC_OK);
+    ASSERT_EQ(ev.kind, SERDEC_EVENT_STRING);
+    ASSERT(ev.string.len == 3 && memcmp(ev.string.ptr, "baz", 3) == 0);
+
+    serdec_arena_destroy(arena);
+}
+
+TEST(pointer_errors) {
+    SerdecArena* arena = serdec_arena_create(NULL);
+    const SerdecValue* root;
+    const SerdecValue* v;
+    SerdecPointer* pointer;
+    SerdecEvent ev;
+    ASSERT_EQ(serdec_parse(arena, rfc_document, strlen(rfc_document), &root, NULL), SERDEC_OK);
+
+    const char* invalid[] = { "foo", "#/foo", "/~", "/a~2" };
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(*invalid); i++) {
+        ASSERT_EQ(serdec_pointer_compile(invalid[i], &pointer), SERDEC_ERR_INVALID_PATH);
+        ASSERT_NULL(pointer);
+    }
+
+    const struct {
+        const char* pointer;
+        SerdecError status;
+    } cases[] = {
+        { "/nope", SERDEC_ERR_NOT_FOUND },
+        { "/foo/2", SERDEC_ERR_NOT_FOUND },
+        { "/foo/-", SERDEC_ERR_NOT_FOUND },
+        { "/foo/01", SERDEC_ERR_NOT_FOUND },
+        { "/foo/bar", SERDEC_ERR_NOT_FOUND },
+        { "/foo/99999999999999999999999", SERDEC_ERR_NOT_FOUND },
+        { "/foo/0/x", SERDEC_ERR_TYPE_MISMATCH },
+        { "/a~1b/0", SERDEC_ERR_TYPE_MISMATCH },
+        { "/a/b", SERDEC_ERR_NOT_FOUND },
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(*cases); i++) {
+        ASSERT_EQ(get(root, cases[i].pointer, &v), cases[i].status);
+        ASSERT_EQ(find(rfc_document, cases[i].pointer, &ev), cases[i].status);
+    }
+
+    ASSERT_EQ(find("{\"a\": [1, }", "/b", &ev), SERDEC_ERR_UNEXPECTED_CHAR);
+    ASSERT_EQ(serdec_pointer_compile(NULL, &pointer), SERDEC_ERR_INVALID_HANDLE);
+    ASSERT_EQ(serdec_pointer_get(NULL, root, &v), SERDEC_ERR_INVALID_HANDLE);
+    serdec_pointer_destroy(NULL);
+
+    serdec_arena_destroy(arena);
+}
+
+TEST(pointer_layouts) {
+    // Indexed wide objects, shaped objects and packed arrays
+    size_t cap = 64 * 1024;
+    char* json = malloc(cap);
+    size_t len = (size_t) snprintf(json, cap, "{\"nums\": [1, 2, 3, 4.5], \"items\": [");
+    for (size_t i = 0; i < 40; i++) {
+        len += (size_t) snprintf(json + len, cap - len, "%s{", i ? ", " : "");
+        for (size_t k = 0; k < 20; k++)
+            len += (size_t) snprintf(json + len, cap - len, "%s\"k%zu\": %zu", k ? ", " : "",
+                                     k, i * 100 + k);
+        json[len++] = '}';
+    }
+    len += (size_t) snprintf(json + len, cap - len, "]}");
+
+    SerdecArena* arena = serdec_arena_create(NULL);
+    const SerdecValue* root;
+    const SerdecValue* v;
+    SerdecEvent ev;
+    uint64_t n;
+    double d;
+    ASSERT_EQ(serdec_parse(arena, json, len, &root, NULL), SERDEC_OK);
+
+    ASSERT_EQ(get(root, "/items/30/k17", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_uint64(v, &n), SERDEC_OK);
+    ASSERT_EQ(n, 3017);
+    ASSERT_EQ(get(root, "/nums/3", &v), SERDEC_OK);
+    ASSERT_EQ(serdec_as_double(v, &d), SERDEC_OK);
+    ASSERT(d == 4.5);
+    ASSERT_EQ(get(root, "/items/30/k20", &v), SERDEC_ERR_NOT_FOUND);
+
+    ASSERT_EQ(find(json, "/items/39/k19", &ev), SERDEC_OK);
+    ASSERT(ev.string.len == 4 && memcmp(ev.string.ptr, "3919", 4) == 0);
+
+    // One compiled pointer, many documents
+    SerdecPointer* pointer;
+    ASSERT_EQ(serdec_pointer_compile("/items/1/k2", &pointer), SERDEC_OK);
+    for (int i = 0; i < 3; i++) {
+        ASSERT_EQ(serdec_parse(arena, json, len, &root, NULL), SERDEC_OK);
+        ASSERT_EQ(serdec_pointer_get(pointer, root, &v), SERDEC_OK);
+        ASSERT_EQ(serdec_as_uint64(v, &n), SERDEC_OK);
+        ASSERT_EQ(n, 102);
+    }
+    serdec_pointer_destroy(pointer);
+
+    serdec_arena_destroy(arena);
+    free(json);
+}
+
+TEST(pointer_stream_escaped_keys) {
+    const char* json = "{\"skip\": {\"a/b\": [1, {\"x\": 2}]}, \"a\\u002Fb\": {\"\\uD83D\\uDE00\": "
+                       "[true, \"t\\u007e\"], \"\\\"\": null}, \"after\": 1}";
+    SerdecParser* parser = serdec_json_parser_create(json, strlen(json));
+    SerdecPointer* pointer;
+    SerdecEvent ev;
+
+    ASSERT_EQ(serdec_pointer_compile("/a~1b/\xF0\x9F\x98\x80", &pointer), SERDEC_OK);
+    ASSERT_EQ(serdec_pointer_find(pointer, parser, &ev), SERDEC_OK);
+    ASSERT_EQ(ev.kind, SERDEC_EVENT_START_ARRAY);
+    // The rest of the value follows, then the rest of the document
+    ASSERT_EQ(serdec_json_skip(parser), SERDEC_OK);
+    ASSERT_EQ(serdec_json_event_next(parser, &ev), SERDEC_OK);
+    ASSERT_EQ(ev.kind, SERDEC_EVENT_KEY);
+    ASSERT(ev.string.len == 2 && ev.string.has_escapes);
+    serdec_pointer_destroy(pointer);
+    serdec_json_parser_destroy(parser);
+
+    ASSERT_EQ(find(json, "/a~1b/\"", &ev), SERDEC_OK);
+    ASSERT_EQ(ev.kind, SERDEC_EVENT_NULL);
+    ASSERT_EQ(find(json, "/a~1b/\xF0\x9F\x98\x80/1", &ev), SERDEC_OK);
+    ASSERT_EQ(ev.kind, SERDEC_EVENT_STRING);
+    ASSERT_EQ(find(json, "/a~1b/\xF0\x9F\x98", &ev), SERDEC_ERR_NOT_FOUND);
+    ASSERT_EQ(find(json, "/after", &ev), SERDEC_OK);
+    ASSERT_EQ(ev.kind, SERDEC_EVENT_NUMBER);
+}
+
+int test_pointer(void) {
+    printf("  Pointer tests:\n");
+
+    RUN(pointer_rfc_examples);
+    RUN(pointer_errors);
+    RUN(pointer_layouts);
+    RUN(pointer_stream_escaped_keys);
+
+    TEST_SUMMARY();
+}
@@ -0,0 +1,213 @@
+#include "test.h"
+#include <serdec/serdec.h>
+
+static const char store[] =
+    "{\"store\": {\n"
+    "  \"book\": [\n"
+    "    {\"category\": \"reference\", \"author\": \"Nigel Rees\","
+    " \"title\": \"Sayings of the Century\", \"price\": 8.95},\n"
+    "    {\"category\": \"fiction\", \"author\": \"Evelyn Waugh\","
+    " \"title\": \"Sword of Honour\", \"price\": 12.99},\n"
+    "    {\"title\": \"Moby Dick\", \"category\": \"fiction\", \"author\": \"Herman Melville\","
+    " \"isbn\": \"0-553-21311-3\", \"price\": 8.99},\n"
+    "    {\"category\": \"fiction\", \"author\": \"J. R. R. Tolkien\","
+    " \"title\": \"The Lord of the Rings\", \"isbn\": \"0-395-19395-8\", \"price\": 22.99}\n"
+    "  ],\n"
+    "  \"bicycle\": {\"color\": \"red\", \"price\": 19.95}\n"
+    "}}";
+
+typedef struct {
+    char text[4096];
+    size_t len;
+    size_t count;
+    size_t offset;            // Of the last match
+    const char* base;         // Start of the input: every match must be ptr - offset
+} Matches;
+
+static SerdecError collect(void* user, const SerdecQueryMatch* match) {
+    Matches* m = (Matches*) user;
+    if (!m->base) m->base = match->ptr - match->offset;
+    if (match->ptr - match->offset != m->base) return SERDEC_ERR_INVALID_HANDLE;
+
+    size_t room = sizeof(m->text) - m->len;
+    size_t n = (size_t) snprintf(m->text + m->len, room, "%s%.*s", m->count ? "|" : "",
+                                 (int) match->len, match->ptr);
+    m->len += (n < room) ? n : room - 1;
+    m->count++;
+    m->offset = match->offset;
+    return SERDEC_OK;
+}
+
+// Runs text over json and joins the text of the matches with '|'.
+static SerdecError query(const char* json, const char* text, Matches* m) {
+    *m = (Matches) { 0 };
+    SerdecQuery* q;
+    SerdecError status = serdec_query_compile(text, &q);
+    if (status != SERDEC_OK) return status;
+
+    SerdecParser* parser = serdec_json_parser_create(json, strlen(json));
+    serdec_json_parser_set_sequence(parser, true);
+    status = serdec_query_run(q, parser, collect, m);
+    serdec_json_parser_destroy(parser);
+    serdec_query_destroy(q);
+    return status;
+}
+
+#define ASSERT_QUERY(json, path, expected) do {                                \
+    Matches _m;                                                                \
+    ASSERT_EQ(query(json, path, &_m), SERDEC_OK);                              \
+    if (strcmp(_m.text, expected) != 0) printf("\n      got: %s", _m.text);    \
+    ASSERT(strcmp(_m.text, expected) == 0);                                    \
+} while (0)
+
+TEST(query_children) {
+    ASSERT_QUERY(store, "$", store);
+    ASSERT_QUERY(store, "$.store.bicycle", "{\"color\": \"red\", \"price\": 19.95}");
+    ASSERT_QUERY(store, "$.store.bicycle.*", "\"red\"|19.95");
+    ASSERT_QUERY(store, "$['store'][\"bicycle\"]['color']", "\"red\"");
+    ASSERT_QUERY(store, "$.store.book[*].author",
+                 "\"Nigel Rees\"|\"Evelyn Waugh\"|\"Herman Melville\"|\"J. R. R. Tolkien\"");
+    ASSERT_QUERY(store, "$.store.book[2].title", "\"Moby Dick\"");
+    ASSERT_QUERY(store, "$.store.book[4].title", "");
+    ASSERT_QUERY(store, "$.store.book[1:3].price", "12.99|8.99");
+    ASSERT_QUERY(store, "$.store.book[:2].price", "8.95|12.99");
+    ASSERT_QUERY(store, "$.store.book[1:].price", "12.99|8.99|22.99");
+    ASSERT_QUERY(store, "$.store.book[::2].price", "8.95|8.99");
+    ASSERT_QUERY(store, "$.store[0]", "");
+    ASSERT_QUERY(store, "$.store.bicycle.color.x", "");
+
+    // Offsets point into the parser's input
+    Matches m;
+    ASSERT_EQ(query(store, "$.store.bicycle.price", &m), SERDEC_OK);
+    ASSERT_EQ(m.count, 1);
+    ASSERT_EQ(m.offset, strstr(store, "19.95") - store);
+}
+
+TEST(query_descendants) {
+    ASSERT_QUERY(store, "$..price", "8.95|12.99|8.99|22.99|19.95");
+    ASSERT_QUERY(store, "$..book[3].isbn", "\"0-395-19395-8\"");
+    ASSERT_QUERY(store, "$.store..color", "\"red\"");
+    ASSERT_QUERY("[[1, [2]], {\"a\": [3, 4]}]", "$..[0]", "1|2|[1, [2]]|3");
+
+    // Nested matches are reported as they end: inner ones first
+    ASSERT_QUERY("{\"a\": {\"a\": 1}}", "$..a", "1|{\"a\": 1}");
+    ASSERT_QUERY("[[1], 2]", "$..*", "1|[1]|2");
+
+    Matches m;
+    ASSERT_EQ(query(store, "$..*", &m), SERDEC_OK);
+    ASSERT_EQ(m.count, 27);
+}
+
+TEST(query_filters) {
+    ASSERT_QUERY(store, "$..book[?(@.price < 10)].title",
+                 "\"Sayings of the Century\"|\"Moby Dick\"");
+    ASSERT_QUERY(store, "$..book[?(@.isbn)].price", "8.99|22.99");
+    ASSERT_QUERY(store, "$..book[?@.category == 'fiction'].author",
+                 "\"Evelyn Waugh\"|\"Herman Melville\"|\"J. R. R. Tolkien\"");
+    ASSERT_QUERY(store, "$..book[?(@['category'] != \"fiction\")].price", "8.95");
+    ASSERT_QUERY(store, "$..book[?(@.price >= 22.99)].price", "22.99");
+    ASSERT_QUERY(store, "$.store.*[?(@ > 19)]", "19.95");
+    ASSERT_QUERY(store, "$..[?(@.color)]", "{\"color\": \"red\", \"price\": 19.95}");
+
+    // The filtered element itself, reported when it closes
+    ASSERT_QUERY("[{\"a\": 1, \"b\": 2}, {\"b\": 3}]", "$[?(@.b > 2)]", "{\"b\": 3}");
+
+    // Elements that are not objects, members that are missing or of another type
+    const char* mixed = "[1, \"2\", {\"v\": 3}, {\"v\": \"3\"}, {\"v\": [3]}, {}, true, null, -0]";
+    ASSERT_QUERY(mixed, "$[?(@ == 1)]", "1");
+    ASSERT_QUERY(mixed, "$[?(@ == 0)]", "-0");
+    ASSERT_QUERY(mixed, "$[?(@ < '3')]", "\"2\"");
+    ASSERT_QUERY(mixed, "$[?(@ == true)]", "true");
+    ASSERT_QUERY(mixed, "$[?(@ == null)]", "null");
+    ASSERT_QUERY(mixed, "$[?(@.v == 3)]", "{\"v\": 3}");
+    ASSERT_QUERY(mixed, "$[?(@.v != 3)]", "1|\"2\"|{\"v\": \"3\"}|{\"v\": [3]}|{}|true|null|-0");
+    ASSERT_QUERY(mixed, "$[?(@.v)].v", "3|\"3\"|[3]");
+    ASSERT_QUERY(mixed, "$[?(@.v <= 3)]", "{\"v\": 3}");
+
+    // Exact integer comparison, escaped strings
+    ASSERT_QUERY("[9007199254740993, 9007199254740992]", "$[?(@ > 9007199254740992)]",
+                 "9007199254740993");
+    ASSERT_QUERY("[{\"k\": \"a\\u00e9\"}, {\"k\": \"ab\"}]", "$[?(@.k == 'a\\u00E9')]",
+                 "{\"k\": \"a\\u00e9\"}");
+    ASSERT_QUERY("[\"it's\", \"its\"]", "$[?(@ == 'it\\'s')]", "\"it's\"");
+    ASSERT_QUERY("[\"b\", \"a\\u0062\", \"c\"]", "$[?(@ < \"ab\")]", "");
+    ASSERT_QUERY("[\"b\", \"a\\u0062\", \"a\"]", "$[?(@ <= \"ab\")]", "\"a\\u0062\"|\"a\"");
+}
+
+TEST(query_nested_filters) {
+    const char* json = "{\"groups\": ["
+                       "{\"items\": [{\"id\": 1, \"ok\": true}, {\"id\": 2, \"ok\": false}],"
+                       " \"name\": \"g1\"},"
+                       "{\"items\": [{\"ok\": true, \"id\": 3}], \"name\": \"g2\"},"
+                       "{\"name\": \"g3\", \"items\": [{\"id\": 4, \"ok\": true}]}]}";
+    ASSERT_QUERY(json, "$.groups[?(@.name != 'g2')].items[?(@.ok == true)].id", "1|4");
+    ASSERT_QUERY(json, "$.groups[?(@.name == 'g2')]..id", "3");
+    ASSERT_QUERY(json, "$..[?(@.ok == true)].id", "1|3|4");
+    ASSERT_QUERY(json, "$.groups[?(@.name)].name", "\"g1\"|\"g2\"|\"g3\"");
+}
+
+TEST(query_errors) {
+    SerdecQuery* q;
+    const char* invalid[] = {
+        "", "store", "$.", "$..", "$[", "$[1", "$[-1]", "$[1:2:0]", "$['a]", "$[?(@.a ==)]",
+        "$[?(@.a == 1]", "$[?(a == 1)]", "$[?(@.a == 01)]", "$[?(@.a == x)]", "$.a[?(@.b.c)]",
+        "$['\\q']", "$x",
+    };
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(*invalid); i++) {
+        ASSERT_EQ(serdec_query_compile(invalid[i], &q), SERDEC_ERR_INVALID_PATH);
+        ASSERT_NULL(q);
+    }
+
+    char deep[2 * 64 + 2] = "$";
+    for (int i = 0; i < 64; i++) strcat(deep, ".a");
+    ASSERT_EQ(serdec_query_compile(deep, &q), SERDEC_ERR_INVALID_PATH);
+    deep[2 * 63 + 1] = '\0';
+    ASSERT_EQ(serdec_query_compile(deep, &q), SERDEC_OK);
+    serdec_query_destroy(q);
+
+    Matches m;
+    ASSERT_EQ(query("{\"a\": [1, }", "$.a[*]", &m), SERDEC_ERR_UNEXPECTED_CHAR);
+    ASSERT_EQ(m.count, 1);
+    ASSERT_EQ(query("{\"a\": [1, 2]}", "$.b", &m), SERDEC_OK);
+
+    ASSERT_EQ(serdec_query_compile(NULL, &q), SERDEC_ERR_INVALID_HANDLE);
+    ASSERT_EQ(serdec_query_run(NULL, NULL, collect, &m), SERDEC_ERR_INVALID_HANDLE);
+    serdec_query_destroy(NULL);
+}
+
+static SerdecError stop_after_two(void* user, const SerdecQueryMatch* match) {
+    (void) match;
+    return ++*(int*) user == 2 ? SERDEC_ERR_NOT_FOUND : SERDEC_OK;
+}
+
+TEST(query_sequence) {
+    const char* lines = "{\"level\": \"error\", \"msg\": \"a\"}\n"
+                        "{\"level\": \"info\", \"msg\": \"b\"}\n"
+                        "{\"msg\": \"c\", \"level\": \"error\"}\n";
+    ASSERT_QUERY(lines, "$[?(@.level == 'error')].msg", "");
+    ASSERT_QUERY(lines, "$.msg", "\"a\"|\"b\"|\"c\"");
+    ASSERT_QUERY(lines, "$[?(@ == 'error')]", "\"error\"|\"error\"");
+
+    SerdecQuery* q;
+    ASSERT_EQ(serdec_query_compile("$.msg", &q), SERDEC_OK);
+    SerdecParser* parser = serdec_json_parser_create(lines, strlen(lines));
+    serdec_json_parser_set_sequence(parser, true);
+    int seen = 0;
+    ASSERT_EQ(serdec_query_run(q, parser, stop_after_two, &seen), SERDEC_ERR_NOT_FOUND);
+    ASSERT_EQ(seen, 2);
+    serdec_json_parser_destroy(parser);
+    serdec_query_destroy(q);
+}
+
+int test_query(void) {
+    printf("  Query tests:\n");
+
+    RUN(query_children);
+    RUN(query_descendants);
+    RUN(query_filters);
+    RUN(query_nested_filters);
+    RUN(query_errors);
+    RUN(query_sequence);
+
+    TEST_SUMMARY();
+}